@@ -60,6 +60,9 @@ M68K_struct * M68KCoreList[] = {
 #ifdef HAVE_Q68
 &M68KQ68,
 #endif
+#ifdef HAVE_Q68_JIT
+&M68KQ68JIT,
+#endif
 NULL
 };
 
@@ -371,6 +374,11 @@ static gboolean yui_settings_load(void) {
 	}
 	yinit.usethreads = tmp;
 
+	VIDSoftSetPipelined(g_key_file_get_boolean(keyfile, "General", "SoftPipelined", 0));
+#ifdef HAVE_LIBGTKGLEXT
+	VIDOGLSetShaderDecode(g_key_file_get_boolean(keyfile, "General", "ShaderDecode", 0));
+#endif
+
 	PerInit(yinit.percoretype);
 
 	PerPortReset();
@@ -533,6 +541,10 @@ int main(int argc, char *argv[]) {
             if (fscount > 0)
                yui_window_set_frameskip(YUI_WINDOW(yui), fsenable);
          }
+         // No rendering, for headless and benchmark runs
+         else if (strcmp(argv[i], "--no-render") == 0) {
+            RenderSkipEnable();
+         }
 	 // Binary
 	 else if (strstr(argv[i], "--binary=")) {
 	    char binname[1024];
@@ -276,6 +276,11 @@ static void disable_enable_fixed_base_time(YuiCheckButton *clocksync, YuiCheckBu
 	                         yui_check_button_get_active(clocksync));
 }
 
+static void disable_enable_soft_pipelined(YuiCheckButton *usethreads, YuiCheckButton *softpipelined) {
+	gtk_widget_set_sensitive(GTK_WIDGET(softpipelined),
+	                         yui_check_button_get_active(usethreads));
+}
+
 static void volume_changed(GtkRange * range, gpointer data) {
     g_key_file_set_integer(keyfile, "General", "Volume", (int) gtk_range_get_value(range));
 }
@@ -335,6 +340,12 @@ GtkWidget* create_dialog1(void) {
 
   box = yui_page_add(YUI_PAGE(video_sound), _("Video Core"));
   gtk_container_add(GTK_CONTAINER(box), yui_range_new(keyfile, "General", "VideoCore", vidcores));
+#ifdef HAVE_LIBGTKGLEXT
+  gtk_container_add(GTK_CONTAINER(box), yui_check_button_new(
+      _("Decode VDP2 tiles on the GPU (OpenGL only)"),
+      keyfile, "General", "ShaderDecode"
+  ));
+#endif
 
 #ifdef YAB_PORT_OSD
   box = yui_page_add(YUI_PAGE(video_sound), _("OSD Core"));
@@ -529,11 +540,24 @@ GtkWidget* create_dialog1(void) {
 
   box = yui_page_add(YUI_PAGE(advanced), _("Threads"));
   {
-    GtkWidget *button = yui_check_button_new(
+    GtkWidget *button1, *button2;
+
+    button1 = yui_check_button_new(
         _("Use multithreaded emulation (EXPERIMENTAL!)"),
         keyfile, "General", "UseThreads"
     );
-    gtk_container_add(GTK_CONTAINER(box), button);
+    gtk_container_add(GTK_CONTAINER(box), button1);
+
+    button2 = yui_check_button_new(
+        _("Draw software renderer screens on their own thread"),
+        keyfile, "General", "SoftPipelined"
+    );
+    gtk_container_add(GTK_CONTAINER(box), button2);
+    if (!yui_check_button_get_active(YUI_CHECK_BUTTON(button1)))
+      gtk_widget_set_sensitive(button2, FALSE);
+
+    g_signal_connect(button1, "changed",
+                     G_CALLBACK(disable_enable_soft_pipelined), button2);
   }
 
 #ifdef HAVE_LIBMINI18N
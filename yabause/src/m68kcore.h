@@ -26,6 +26,7 @@
 #define M68KCORE_DUMMY    0
 #define M68KCORE_C68K     1
 #define M68KCORE_Q68      2
+#define M68KCORE_Q68JIT   3
 
 typedef u32 FASTCALL M68K_READ(const u32 adr);
 typedef void FASTCALL M68K_WRITE(const u32 adr, u32 data);
@@ -72,5 +73,6 @@ int M68KInit(int coreid);
 extern M68K_struct M68KDummy;
 extern M68K_struct M68KC68K;
 extern M68K_struct M68KQ68;
+extern M68K_struct M68KQ68JIT;
 
 #endif
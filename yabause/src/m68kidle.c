@@ -0,0 +1,325 @@
+/*  Copyright 2015 Yabause team
+
+    This file is part of Yabause.
+
+    Yabause is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Yabause is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Yabause; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*! \file m68kidle.c
+    \brief 68K idle loop detection, independent of the 68K core in use.
+*/
+
+#include "m68kcore.h"
+#include "m68kidle.h"
+#include "memory.h"
+#include "scsp.h"
+
+#define MAX_LOOP_INSNS 8
+// idle loops greater than MAX_LOOP_INSNS instructions will not be detected.
+#define MAX_LOOP_BYTES 0x40
+
+/* Detection of idle loops, following the same idea as sh2idle.c: a short
+loop that does no memory write, whose only memory reads are of locations
+which can't change while the 68K spins (sound RAM and the SCSP common
+control registers other than the monitor/MIDI ones), and which only leaves
+data registers in a state independent of the number of iterations.  Such a
+loop can only be left through an interrupt or a change made by the main
+CPU, so the SCSP can stop executing it until one of those happens. */
+
+/* bDet : Bitwise data register markers. 1: register was loaded in the
+   current iteration from a deterministic source */
+
+static u32 bDet;
+
+#define destDn(n) (1 << (n))
+#define srcDn(n) (bDet & destDn(n))
+
+#define M68KIDLE_FAIL   -1
+#define M68KIDLE_INSN    0
+#define M68KIDLE_BRANCH  1
+
+//////////////////////////////////////////////////////////////////////////////
+
+static u16 M68KIdleFetch(u32 adr)
+{
+   return T2ReadWord(SoundRam, adr & 0x7FFFF);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int M68KIdleStableAddr(u32 adr)
+{
+   adr &= 0xFFFFFF;
+
+   if (adr < 0x100000)
+      return 1; // sound RAM
+
+   adr &= 0xFFF;
+
+   // MIDI buffers and the CA/SGC/EG monitor change on their own
+   if (adr >= 0x404 && adr < 0x40C)
+      return 0;
+
+   return (adr >= 0x400 && adr < 0x430);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+/* Checks a source effective address: register, immediate or a read of a
+   stable location.  *adr is moved past any extension words. */
+
+static int M68KIdleCheckEA(u32 *adr, u32 mode, u32 reg, u32 size)
+{
+   u32 ea;
+
+   switch (mode)
+   {
+      case 0: // Dn
+      case 1: // An
+         return 1;
+      case 2: // (An)
+         ea = M68K->GetAReg(reg);
+         break;
+      case 5: // d16(An)
+         ea = M68K->GetAReg(reg) + (s16)M68KIdleFetch(*adr);
+         *adr += 2;
+         break;
+      case 7:
+         switch (reg)
+         {
+            case 0: // abs.W
+               ea = (s16)M68KIdleFetch(*adr);
+               *adr += 2;
+               break;
+            case 1: // abs.L
+               ea = ((u32)M68KIdleFetch(*adr) << 16) | M68KIdleFetch(*adr + 2);
+               *adr += 4;
+               break;
+            case 2: // d16(PC)
+               ea = *adr + (s16)M68KIdleFetch(*adr);
+               *adr += 2;
+               break;
+            case 4: // #imm
+               *adr += (size == 2) ? 4 : 2;
+               return 1;
+            default:
+               return 0;
+         }
+         break;
+      default:
+         // (An)+ and -(An) modify An, indexed modes depend on an index
+         return 0;
+   }
+
+   return M68KIdleStableAddr(ea);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+/* Decodes the instruction at *adr, moving *adr to the next one.  Returns
+   M68KIDLE_BRANCH for Bcc/BRA (with the destination in *target),
+   M68KIDLE_INSN for any other instruction allowed in an idle loop, and
+   M68KIDLE_FAIL otherwise. */
+
+static int M68KIdleCheckIterate(u32 *adr, u32 *target)
+{
+   u16 op = M68KIdleFetch(*adr);
+   u32 mode = (op >> 3) & 7;
+   u32 reg = op & 7;
+   u32 dn = (op >> 9) & 7;
+   u32 size = (op >> 6) & 3;
+   s32 disp;
+
+   *adr += 2;
+
+   switch (op >> 12)
+   {
+      case 0x0:
+         if ((op & 0xFFC0) == 0x0800) // btst #imm,<ea>
+         {
+            *adr += 2;
+            return (mode != 1 && M68KIdleCheckEA(adr, mode, reg, 0)) ? M68KIDLE_INSN : M68KIDLE_FAIL;
+         }
+         if ((op & 0xF1C0) == 0x0100) // btst Dn,<ea>
+            return (mode != 1 && M68KIdleCheckEA(adr, mode, reg, 0)) ? M68KIDLE_INSN : M68KIDLE_FAIL;
+         if (size == 3)
+            break;
+         if ((op & 0xFF00) == 0x0C00) // cmpi #imm,<ea>
+         {
+            *adr += (size == 2) ? 4 : 2;
+            return (mode != 1 && M68KIdleCheckEA(adr, mode, reg, size)) ? M68KIDLE_INSN : M68KIDLE_FAIL;
+         }
+         if (((op & 0xFF00) == 0x0000 || (op & 0xFF00) == 0x0200) && mode == 0)
+         {
+            // ori/andi #imm,Dn: repeating them gives the same result
+            *adr += (size == 2) ? 4 : 2;
+            return M68KIDLE_INSN;
+         }
+         break;
+      case 0x1: // move.b <ea>,Dn
+      case 0x2: // move.l <ea>,Dn
+      case 0x3: // move.w <ea>,Dn
+         if (((op >> 6) & 7) != 0)
+            break;
+         if (!M68KIdleCheckEA(adr, mode, reg, (op >> 12) == 2 ? 2 : 0))
+            break;
+         bDet |= destDn(dn);
+         return M68KIDLE_INSN;
+      case 0x4:
+         if (op == 0x4E71) // nop
+            return M68KIDLE_INSN;
+         if ((op & 0xFF00) == 0x4A00 && size != 3) // tst <ea>
+            return M68KIdleCheckEA(adr, mode, reg, size) ? M68KIDLE_INSN : M68KIDLE_FAIL;
+         if ((op & 0xFFF8) == 0x4840 || (op & 0xFFB8) == 0x4880) // swap/ext Dn
+            return srcDn(reg) ? M68KIDLE_INSN : M68KIDLE_FAIL;
+         break;
+      case 0x6:
+         if (((op >> 8) & 0xF) == 1) // bsr
+            break;
+         disp = (s8)op;
+         if (disp == 0)
+         {
+            disp = (s16)M68KIdleFetch(*adr);
+            *adr += 2;
+         }
+         else if (disp == -1)
+            break;
+         *target = (op & 0xFF) ? (*adr + disp) : (*adr - 2 + disp);
+         return M68KIDLE_BRANCH;
+      case 0x7:
+         if (op & 0x100)
+            break;
+         bDet |= destDn(dn); // moveq
+         return M68KIDLE_INSN;
+      case 0x8: // or <ea>,Dn
+      case 0xC: // and <ea>,Dn
+         if (((op >> 6) & 7) > 2 || mode == 1)
+            break;
+         // like ori/andi, repeating them only gives the same result if
+         // the source doesn't change from one iteration to the next
+         if (mode == 0 && !srcDn(reg))
+            break;
+         return M68KIdleCheckEA(adr, mode, reg, size) ? M68KIDLE_INSN : M68KIDLE_FAIL;
+      case 0xB:
+         switch ((op >> 6) & 7)
+         {
+            case 0: case 1: case 2: // cmp <ea>,Dn
+               return M68KIdleCheckEA(adr, mode, reg, size) ? M68KIDLE_INSN : M68KIDLE_FAIL;
+            case 3: // cmpa.w <ea>,An
+               return M68KIdleCheckEA(adr, mode, reg, 1) ? M68KIDLE_INSN : M68KIDLE_FAIL;
+            case 7: // cmpa.l <ea>,An
+               return M68KIdleCheckEA(adr, mode, reg, 2) ? M68KIDLE_INSN : M68KIDLE_FAIL;
+         }
+         break;
+      case 0xE:
+         // register shifts/rotates only give the same result every
+         // iteration on a value loaded in that iteration; roxl/roxr
+         // also depend on X
+         if (size != 3 && ((op >> 3) & 3) != 2 && srcDn(reg))
+            return M68KIDLE_INSN;
+         break;
+   }
+
+   return M68KIDLE_FAIL;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int M68KIdleCheckLoop(u32 pc)
+{
+   u32 adr, next, target = 0, start = 0, end = 0;
+   int i, onpc = 0;
+
+   if ((pc & 1) || pc >= 0x100000)
+      return 0;
+
+   // find the branch closing the loop pc is in
+   bDet = 0xFF;
+   adr = pc;
+   for (i = 0; i < MAX_LOOP_INSNS; i++)
+   {
+      next = adr;
+      switch (M68KIdleCheckIterate(&next, &target))
+      {
+         case M68KIDLE_FAIL:
+            return 0;
+         case M68KIDLE_BRANCH:
+            if (target <= pc && pc - target < MAX_LOOP_BYTES)
+            {
+               start = target;
+               end = adr;
+            }
+            else if (target < pc || ((M68KIdleFetch(adr) >> 8) & 0xF) == 0)
+               return 0; // leaves the loop for good
+            break;
+      }
+      if (end)
+         break;
+      adr = next;
+   }
+
+   if (!end)
+      return 0;
+
+   // check the whole body, with data registers starting undetermined
+   bDet = 0;
+   adr = start;
+   for (i = 0; i < MAX_LOOP_INSNS && adr < end; i++)
+   {
+      if (adr == pc)
+         onpc = 1;
+      switch (M68KIdleCheckIterate(&adr, &target))
+      {
+         case M68KIDLE_FAIL:
+            return 0;
+         case M68KIDLE_BRANCH:
+            // only exits are allowed before the closing branch
+            if (target >= start && target <= end)
+               return 0;
+            break;
+      }
+   }
+
+   return adr == end && (onpc || pc == end);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int M68KIdleCheck(s32 *cycles)
+{
+   u32 pc = M68K->GetPC();
+   int i;
+
+   *cycles = 0;
+
+   if (!M68KIdleCheckLoop(pc))
+      return 0;
+
+   /* The code can sit there with its exit condition already true, so run
+      one iteration to make sure the loop is actually being taken. */
+   for (i = 0; i < MAX_LOOP_INSNS * 2; i++)
+   {
+      u32 newpc;
+
+      *cycles += M68K->Exec(1);
+      newpc = M68K->GetPC();
+      if (newpc == pc)
+         return 1;
+      if (newpc > pc + MAX_LOOP_BYTES || pc > newpc + MAX_LOOP_BYTES)
+         return 0;
+   }
+
+   return 0;
+}
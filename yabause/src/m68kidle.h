@@ -0,0 +1,30 @@
+/*  Copyright 2015 Yabause team
+
+    This file is part of Yabause.
+
+    Yabause is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Yabause is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Yabause; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+#ifndef M68KIDLE_H
+#define M68KIDLE_H
+
+#include "core.h"
+
+/* Returns nonzero if the 68K is spinning in an idle loop which only an
+   interrupt or a main CPU write can end.  *cycles receives the cycles
+   spent running one iteration of the loop to confirm it. */
+int M68KIdleCheck(s32 *cycles);
+
+#endif
@@ -23,6 +23,16 @@
 
 #include "q68/q68.h"
 
+#ifdef HAVE_Q68_JIT
+# include <stdlib.h>
+# include <string.h>
+# ifdef _WIN32
+#  include <windows.h>
+# else
+#  include <sys/mman.h>
+# endif
+#endif
+
 /*************************************************************************/
 
 /**
@@ -52,6 +62,9 @@
 /* Interface function declarations (must come before interface definition) */
 
 static int m68kq68_init(void);
+#ifdef HAVE_Q68_JIT
+static int m68kq68_jit_init(void);
+#endif
 static void m68kq68_deinit(void);
 static void m68kq68_reset(void);
 
@@ -81,9 +94,17 @@ static void m68kq68_set_readw(M68K_READ *func);
 static void m68kq68_set_writeb(M68K_WRITE *func);
 static void m68kq68_set_writew(M68K_WRITE *func);
 
+static int init_common(void);
+
 static uint32_t dummy_read(uint32_t address);
 static void dummy_write(uint32_t address, uint32_t data);
 
+#ifdef HAVE_Q68_JIT
+static void *exec_malloc(size_t size);
+static void *exec_realloc(void *ptr, size_t size);
+static void exec_free(void *ptr);
+#endif
+
 #ifdef NEED_TRAMPOLINE
 static uint32_t readb_trampoline(uint32_t address);
 static uint32_t readw_trampoline(uint32_t address);
@@ -130,6 +151,48 @@ M68K_struct M68KQ68 = {
     .SetWriteW   = m68kq68_set_writew,
 };
 
+#ifdef HAVE_Q68_JIT
+
+/* The same interface with dynamic translation enabled; only the
+ * initialization routine differs */
+
+M68K_struct M68KQ68JIT = {
+    .id          = M68KCORE_Q68JIT,
+    .Name        = "Q68 68k Emulator Interface (dynamic translation)",
+
+    .Init        = m68kq68_jit_init,
+    .DeInit      = m68kq68_deinit,
+    .Reset       = m68kq68_reset,
+
+    .Exec        = m68kq68_exec,
+    .Sync        = m68kq68_sync,
+
+    .GetDReg     = m68kq68_get_dreg,
+    .GetAReg     = m68kq68_get_areg,
+    .GetPC       = m68kq68_get_pc,
+    .GetSR       = m68kq68_get_sr,
+    .GetUSP      = m68kq68_get_usp,
+    .GetMSP      = m68kq68_get_ssp,
+
+    .SetDReg     = m68kq68_set_dreg,
+    .SetAReg     = m68kq68_set_areg,
+    .SetPC       = m68kq68_set_pc,
+    .SetSR       = m68kq68_set_sr,
+    .SetUSP      = m68kq68_set_usp,
+    .SetMSP      = m68kq68_set_ssp,
+
+    .SetIRQ      = m68kq68_set_irq,
+    .WriteNotify = m68kq68_write_notify,
+
+    .SetFetch    = m68kq68_set_fetch,
+    .SetReadB    = m68kq68_set_readb,
+    .SetReadW    = m68kq68_set_readw,
+    .SetWriteB   = m68kq68_set_writeb,
+    .SetWriteW   = m68kq68_set_writew,
+};
+
+#endif
+
 /*-----------------------------------------------------------------------*/
 
 /* Virtual processor state block */
@@ -163,15 +226,40 @@ static int m68kq68_init(void)
     if (!(state = q68_create())) {
         return -1;
     }
-    q68_set_irq(state, 0);
-    q68_set_readb_func(state, dummy_read);
-    q68_set_readw_func(state, dummy_read);
-    q68_set_writeb_func(state, dummy_write);
-    q68_set_writew_func(state, dummy_write);
+    return init_common();
+}
 
-    return 0;
+/*-----------------------------------------------------------------------*/
+
+#ifdef HAVE_Q68_JIT
+
+/**
+ * m68kq68_jit_init:  Initialize the virtual processor with dynamic
+ * translation enabled.  Translated code is stored in memory obtained from
+ * exec_malloc() and friends, since the ordinary heap is not executable;
+ * everything else stays in the ordinary heap.
+ *
+ * [Parameters]
+ *     None
+ * [Return value]
+ *     Zero on success, negative on failure
+ */
+static int m68kq68_jit_init(void)
+{
+    if (!(state = q68_create())) {
+        return -1;
+    }
+    q68_set_jit_memory_funcs(state, exec_malloc, exec_realloc, exec_free);
+    if (!q68_set_jit(state, 1)) {
+        q68_destroy(state);
+        state = NULL;
+        return -1;
+    }
+    return init_common();
 }
 
+#endif  // HAVE_Q68_JIT
+
 /*-----------------------------------------------------------------------*/
 
 /**
@@ -459,6 +547,28 @@ static void m68kq68_set_writew(M68K_WRITE *func)
 
 /*************************************************************************/
 
+/**
+ * init_common:  Set up the default IRQ level and memory access functions
+ * for a newly created virtual processor.
+ *
+ * [Parameters]
+ *     None
+ * [Return value]
+ *     Zero (always succeeds)
+ */
+static int init_common(void)
+{
+    q68_set_irq(state, 0);
+    q68_set_readb_func(state, dummy_read);
+    q68_set_readw_func(state, dummy_read);
+    q68_set_writeb_func(state, dummy_write);
+    q68_set_writew_func(state, dummy_write);
+
+    return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+
 /**
  * dummy_read:  Default read function, always returning 0 for any address.
  *
@@ -520,6 +630,261 @@ static void writew_trampoline(uint32_t address, uint32_t data) {
 
 #endif  // NEED_TRAMPOLINE
 
+/*-----------------------------------------------------------------------*/
+
+#ifdef HAVE_Q68_JIT
+
+/**
+ * exec_malloc, exec_realloc, exec_free:  Memory allocation functions for
+ * translated code, passed to q68_set_jit_memory_funcs().  These return
+ * memory which the native CPU can execute.  Rather than mapping each
+ * block separately, blocks are carved out of large executable chunks
+ * (see ExecChunk below); each block is preceded by a header recording its
+ * size, padded to keep the data 16-byte aligned.
+ *
+ * [Parameters]
+ *      ptr: Block to reallocate or free (exec_realloc(), exec_free() only)
+ *     size: Size of block to allocate (exec_malloc(), exec_realloc() only)
+ * [Return value]
+ *     Pointer to allocated block, or NULL on failure (exec_malloc(),
+ *     exec_realloc() only)
+ */
+
+#define EXEC_HEADER_SIZE  16
+#define EXEC_MIN_BLOCK    (EXEC_HEADER_SIZE * 2)
+#define EXEC_CHUNK_SIZE   (4*1024*1024)
+
+/* Block header.  The free list links are only present in free blocks,
+ * where they overlap the (unused) data area. */
+typedef struct ExecBlock_ ExecBlock;
+struct ExecBlock_ {
+    size_t size;       // Total size including header; low bit set if free
+    size_t prev_size;  // Total size of the preceding block, 0 if first
+    ExecBlock *next_free, *prev_free;
+};
+
+#define EXEC_FREE          1
+#define EXEC_SIZE(block)   ((block)->size & ~(size_t)EXEC_FREE)
+#define EXEC_IS_FREE(block)  ((block)->size & EXEC_FREE)
+#define EXEC_NEXT(block)   ((ExecBlock *)((uint8_t *)(block) + EXEC_SIZE(block)))
+#define EXEC_PREV(block)   ((ExecBlock *)((uint8_t *)(block) - (block)->prev_size))
+
+/* Executable chunk.  The block list of each chunk is terminated by a
+ * header of size 0 which is never free, so merging stops there.  The
+ * chunk list itself lives in the ordinary heap. */
+typedef struct ExecChunk_ ExecChunk;
+struct ExecChunk_ {
+    ExecChunk *next;
+    uint8_t *base;
+    size_t size;
+};
+
+static ExecChunk *exec_chunks;
+static ExecBlock *exec_free_list;
+
+/*----------------------------------*/
+
+static void exec_unlink(ExecBlock *block)
+{
+    if (block->prev_free) {
+        block->prev_free->next_free = block->next_free;
+    } else {
+        exec_free_list = block->next_free;
+    }
+    if (block->next_free) {
+        block->next_free->prev_free = block->prev_free;
+    }
+}
+
+static void exec_link(ExecBlock *block)
+{
+    block->size |= EXEC_FREE;
+    block->prev_free = NULL;
+    block->next_free = exec_free_list;
+    if (exec_free_list) {
+        exec_free_list->prev_free = block;
+    }
+    exec_free_list = block;
+}
+
+/* Cut a used block down to "size" bytes, freeing the rest if it's big
+ * enough to be a block of its own. */
+static void exec_split(ExecBlock *block, size_t size)
+{
+    const size_t total = EXEC_SIZE(block);
+    ExecBlock *rest, *next;
+
+    if (total - size < EXEC_MIN_BLOCK) {
+        return;
+    }
+    block->size = size;
+    rest = EXEC_NEXT(block);
+    rest->size = total - size;
+    rest->prev_size = size;
+    EXEC_NEXT(rest)->prev_size = EXEC_SIZE(rest);
+    next = EXEC_NEXT(rest);
+    if (EXEC_IS_FREE(next)) {
+        exec_unlink(next);
+        rest->size += EXEC_SIZE(next);
+        EXEC_NEXT(rest)->prev_size = EXEC_SIZE(rest);
+    }
+    exec_link(rest);
+}
+
+static ExecChunk *exec_new_chunk(size_t size)
+{
+    ExecChunk *chunk;
+    ExecBlock *block;
+
+    if (!(chunk = malloc(sizeof(*chunk)))) {
+        return NULL;
+    }
+#ifdef _WIN32
+    chunk->base = VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE,
+                               PAGE_EXECUTE_READWRITE);
+    if (!chunk->base) {
+        free(chunk);
+        return NULL;
+    }
+#else
+    chunk->base = mmap(NULL, size, PROT_READ | PROT_WRITE | PROT_EXEC,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (chunk->base == MAP_FAILED) {
+        free(chunk);
+        return NULL;
+    }
+#endif
+    chunk->size = size;
+    chunk->next = exec_chunks;
+    exec_chunks = chunk;
+
+    block = (ExecBlock *)chunk->base;
+    block->size = size - EXEC_HEADER_SIZE;
+    block->prev_size = 0;
+    EXEC_NEXT(block)->size = 0;
+    EXEC_NEXT(block)->prev_size = EXEC_SIZE(block);
+    exec_link(block);
+    return chunk;
+}
+
+static void exec_release_chunk(ExecBlock *block)
+{
+    ExecChunk **pchunk;
+
+    for (pchunk = &exec_chunks; *pchunk; pchunk = &(*pchunk)->next) {
+        ExecChunk *chunk = *pchunk;
+        if ((uint8_t *)block == chunk->base) {
+            exec_unlink(block);
+            *pchunk = chunk->next;
+#ifdef _WIN32
+            VirtualFree(chunk->base, 0, MEM_RELEASE);
+#else
+            munmap(chunk->base, chunk->size);
+#endif
+            free(chunk);
+            return;
+        }
+    }
+}
+
+/*----------------------------------*/
+
+static void *exec_malloc(size_t size)
+{
+    size_t need = (size + EXEC_HEADER_SIZE + 15) & ~(size_t)15;
+    ExecBlock *block;
+
+    if (need < EXEC_MIN_BLOCK) {
+        need = EXEC_MIN_BLOCK;
+    }
+    for (block = exec_free_list; block; block = block->next_free) {
+        if (EXEC_SIZE(block) >= need) {
+            break;
+        }
+    }
+    if (!block) {
+        size_t chunksize = EXEC_CHUNK_SIZE;
+        if (chunksize < need + EXEC_HEADER_SIZE) {
+            chunksize = (need + EXEC_HEADER_SIZE + 0xFFFF) & ~(size_t)0xFFFF;
+        }
+        if (!exec_new_chunk(chunksize)) {
+            return NULL;
+        }
+        block = exec_free_list;
+    }
+    exec_unlink(block);
+    block->size &= ~(size_t)EXEC_FREE;
+    exec_split(block, need);
+    return (uint8_t *)block + EXEC_HEADER_SIZE;
+}
+
+static void *exec_realloc(void *ptr, size_t size)
+{
+    size_t need = (size + EXEC_HEADER_SIZE + 15) & ~(size_t)15;
+    ExecBlock *block, *next;
+    void *newptr;
+
+    if (!ptr) {
+        return exec_malloc(size);
+    }
+    if (need < EXEC_MIN_BLOCK) {
+        need = EXEC_MIN_BLOCK;
+    }
+    block = (ExecBlock *)((uint8_t *)ptr - EXEC_HEADER_SIZE);
+
+    /* Grow in place if the following block is free and big enough */
+    next = EXEC_NEXT(block);
+    if (need > EXEC_SIZE(block) && EXEC_IS_FREE(next)
+     && EXEC_SIZE(block) + EXEC_SIZE(next) >= need) {
+        exec_unlink(next);
+        block->size += EXEC_SIZE(next);
+        EXEC_NEXT(block)->prev_size = EXEC_SIZE(block);
+    }
+    if (need <= EXEC_SIZE(block)) {
+        exec_split(block, need);
+        return ptr;
+    }
+
+    if (!(newptr = exec_malloc(size))) {
+        return NULL;
+    }
+    memcpy(newptr, ptr, EXEC_SIZE(block) - EXEC_HEADER_SIZE);
+    exec_free(ptr);
+    return newptr;
+}
+
+static void exec_free(void *ptr)
+{
+    ExecBlock *block, *next;
+
+    if (!ptr) {
+        return;
+    }
+    block = (ExecBlock *)((uint8_t *)ptr - EXEC_HEADER_SIZE);
+
+    next = EXEC_NEXT(block);
+    if (EXEC_IS_FREE(next)) {
+        exec_unlink(next);
+        block->size += EXEC_SIZE(next);
+    }
+    if (block->prev_size && EXEC_IS_FREE(EXEC_PREV(block))) {
+        ExecBlock *prev = EXEC_PREV(block);
+        exec_unlink(prev);
+        prev->size += EXEC_SIZE(block);
+        block = prev;
+    }
+    block->size &= ~(size_t)EXEC_FREE;
+    EXEC_NEXT(block)->prev_size = EXEC_SIZE(block);
+    exec_link(block);
+
+    /* Give the chunk back once nothing in it is used */
+    if (!block->prev_size && EXEC_NEXT(block)->size == 0) {
+        exec_release_chunk(block);
+    }
+}
+
+#endif  // HAVE_Q68_JIT
+
 /*************************************************************************/
 /*************************************************************************/
 
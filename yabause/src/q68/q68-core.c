@@ -243,6 +243,8 @@ void q68_reset(Q68State *state)
  */
 int q68_run(Q68State *state, int cycles)
 {
+    unsigned int opcode, index;
+
     /* Check for pending interrupts */
     check_interrupt(state);
 
@@ -263,7 +265,7 @@ int q68_run(Q68State *state, int cycles)
             }
         }
 #ifdef Q68_USE_JIT
-        if (!state->jit_running) {
+        if (!state->jit_running && state->jit_enabled) {
             state->jit_running = q68_jit_find(state, state->PC);
             if (UNLIKELY(!state->jit_running)) {
                 state->jit_running = q68_jit_translate(state, state->PC);
@@ -285,12 +287,12 @@ int q68_run(Q68State *state, int cycles)
 #ifdef Q68_TRACE
             q68_trace();
 #endif
-            const unsigned int opcode = IFETCH(state);
+            opcode = IFETCH(state);
             state->current_PC = state->PC;
 #ifndef Q68_DISABLE_ADDRESS_ERROR
             state->fault_opcode = opcode;
 #endif
-            const unsigned int index = (opcode>>9 & 0x78) | (opcode>>6 & 0x07);
+            index = (opcode>>9 & 0x78) | (opcode>>6 & 0x07);
 #ifdef COUNT_OPCODES
             q68_ops[index]++;
 #endif
@@ -549,12 +551,12 @@ static int ea_resolve(Q68State *state, uint32_t opcode, int size,
             if (access_type != ACCESS_READ) {
                 return -1;
             } else {
-                cycles += 10;
                 const uint16_t ext = IFETCH(state);
                 const unsigned int ireg = ext >> 12;  // 0..15
                 const int32_t index = (ext & 0x0800) ? (int32_t)state->DA[ireg]
                                                      : (int16_t)state->DA[ireg];
                 const int32_t disp = (int32_t)((int8_t)ext);
+                cycles += 10;
                 state->ea_addr = state->current_PC + index + disp;
             }
             break;
@@ -715,8 +717,17 @@ static void ea_set(Q68State *state, uint32_t opcode, int size, uint32_t data)
  */
 static int op_imm(Q68State *state, uint32_t opcode)
 {
-    /* Check for bit-twiddling and illegal opcodes first */
     enum {OR = 0, AND, SUB, ADD, _BIT, EOR, CMP, _ILL} aluop;
+    INSN_GET_SIZE;
+    int bytes, shift;
+    uint32_t valuemask;
+    uint32_t imm;
+    int use_SR;
+    int cycles;
+    uint32_t ea_val;
+    uint32_t result;
+
+    /* Check for bit-twiddling and illegal opcodes first */
     aluop = opcode>>9 & 7;
     if (aluop == _BIT) {
         return op_bit(state, opcode);
@@ -724,17 +735,16 @@ static int op_imm(Q68State *state, uint32_t opcode)
         return op_ill(state, opcode);
     }
 
-    /* Get the instruction size */
-    INSN_GET_SIZE;
+    /* Check the instruction size */
     if (size == 3) {
         return op_ill(state, opcode);
     }
-    const int bytes = SIZE_TO_BYTES(size);
-    const int shift = bytes*8 - 1;
-    const uint32_t valuemask = ~(~1 << shift);
+    bytes = SIZE_TO_BYTES(size);
+    shift = bytes*8 - 1;
+    valuemask = ~(~1 << shift);
 
     /* Fetch the immediate value */
-    uint32_t imm = (uint16_t)IFETCH(state);
+    imm = (uint16_t)IFETCH(state);
     if (size == SIZE_B) {
         imm &= 0xFF;
     } else if (size == SIZE_L) {
@@ -742,9 +752,6 @@ static int op_imm(Q68State *state, uint32_t opcode)
     }
 
     /* Fetch the EA operand (which may be SR or CCR) */
-    int use_SR;
-    int cycles;
-    uint32_t ea_val;
     if ((aluop==OR || aluop==AND || aluop==EOR) && (opcode & 0x3F) == 0x3C) {
         /* xxxI #imm,SR (or CCR) use the otherwise-invalid form of an
          * immediate value destination */
@@ -768,7 +775,6 @@ static int op_imm(Q68State *state, uint32_t opcode)
     }
 
     /* Perform the operation */
-    uint32_t result;
     if (aluop == ADD || aluop == SUB) {
         INSN_CLEAR_XCC();
     } else {
@@ -846,6 +852,13 @@ static int op_imm(Q68State *state, uint32_t opcode)
  */
 static int op_bit(Q68State *state, uint32_t opcode)
 {
+    enum {BTST = 0, BCHG = 1, BCLR = 2, BSET = 3} op = opcode>>6 & 3;
+    int cycles;
+    unsigned int bitnum;
+    int size;
+    int cycles_tmp;
+    uint32_t value;
+
     /* Check early for MOVEP (coded as BTST/BCHG/BCLR/BSET Dn,An) */
     if (EA_MODE(opcode) == EA_ADDRESS_REG) {
         if (opcode & 0x0100) {
@@ -855,11 +868,7 @@ static int op_bit(Q68State *state, uint32_t opcode)
         }
     }
 
-    enum {BTST = 0, BCHG = 1, BCLR = 2, BSET = 3} op = opcode>>6 & 3;
-    int cycles;
-
     /* Get the bit number to operate on */
-    unsigned int bitnum;
     if (opcode & 0x0100) {
         /* Bit number in register */
         INSN_GET_REG;
@@ -871,7 +880,6 @@ static int op_bit(Q68State *state, uint32_t opcode)
     }
 
     /* EA operand is 32 bits when coming from a register, 8 when from memory */
-    int size;
     switch (EA_MODE(opcode)) {
       case EA_DATA_REG:
         size = SIZE_L;
@@ -882,8 +890,7 @@ static int op_bit(Q68State *state, uint32_t opcode)
         bitnum %= 8;
         break;
     }
-    int cycles_tmp;
-    uint32_t value = ea_get(state, opcode, size, 1, &cycles_tmp);
+    value = ea_get(state, opcode, size, 1, &cycles_tmp);
     if (cycles_tmp < 0) {
         return 0;
     }
@@ -923,17 +930,18 @@ static int op_bit(Q68State *state, uint32_t opcode)
 static int opMOVE(Q68State *state, uint32_t opcode)
 {
     const int size = (opcode>>12==1 ? SIZE_B : opcode>>12==2 ? SIZE_L : SIZE_W);
-
     int cycles_src;
     const uint32_t data = ea_get(state, opcode, size, 0, &cycles_src);
+    uint32_t dummy_opcode;
+    int cycles_dest;
+
     if (cycles_src < 0) {
         return 0;
     }
 
     /* Rearrange the opcode bits so we can pass the destination EA to
      * ea_resolve() */
-    const uint32_t dummy_opcode = (opcode>>9 & 7) | (opcode>>3 & 0x38);
-    int cycles_dest;
+    dummy_opcode = (opcode>>9 & 7) | (opcode>>3 & 0x38);
     if (EA_MODE(dummy_opcode) <= EA_ADDRESS_REG) {
         cycles_dest = 0;
     } else {
@@ -981,6 +989,7 @@ static int op_CHK(Q68State *state, uint32_t opcode)
 
     int cycles;
     int32_t upper;  // Yes, it's signed
+    int32_t value;
     if (EA_MODE(opcode) == EA_ADDRESS_REG) {
         return op_ill(state, opcode);
     }
@@ -992,7 +1001,6 @@ static int op_CHK(Q68State *state, uint32_t opcode)
         upper = (int32_t)(int16_t)upper;
     }
 
-    int32_t value;
     if (size == SIZE_W) {
         value = (int32_t)(int16_t)state->D[reg];
     } else {
@@ -1019,6 +1027,7 @@ static int op_CHK(Q68State *state, uint32_t opcode)
 static int op_LEA(Q68State *state, uint32_t opcode)
 {
     INSN_GET_REG;
+    int cycles;
 
     /* Register, predecrement, postincrement, immediate modes are illegal */
     if (EA_MODE(opcode) == EA_DATA_REG
@@ -1030,7 +1039,7 @@ static int op_LEA(Q68State *state, uint32_t opcode)
         return op_ill(state, opcode);
     }
 
-    int cycles = ea_resolve(state, opcode, SIZE_W, ACCESS_READ);
+    cycles = ea_resolve(state, opcode, SIZE_W, ACCESS_READ);
     if (cycles < 0) {
         return op_ill(state, opcode);
     }
@@ -1051,19 +1060,22 @@ static int opADSQ(Q68State *state, uint32_t opcode)
     const int is_sub = opcode & 0x0100;
     INSN_GET_COUNT;
     INSN_GET_SIZE;
+    int bytes, shift;
+    uint32_t valuemask;
+    int cycles;
+    uint32_t data;
+    uint32_t result;
     if (EA_MODE(opcode) == EA_ADDRESS_REG && size == 1) {
         size = 2;  // ADDQ.W #imm,An is equivalent to ADDQ.L #imm,An
     }
-    const int bytes = SIZE_TO_BYTES(size);
-    const int shift = bytes*8 - 1;
-    const uint32_t valuemask = ~(~1 << shift);
-    int cycles;
-    uint32_t data = ea_get(state, opcode, size, 1, &cycles);
+    bytes = SIZE_TO_BYTES(size);
+    shift = bytes*8 - 1;
+    valuemask = ~(~1 << shift);
+    data = ea_get(state, opcode, size, 1, &cycles);
     if (cycles < 0) {
         return 0;
     }
 
-    uint32_t result;
     if (is_sub) {
         result = data - count;
     } else {
@@ -1093,16 +1105,18 @@ static int opADSQ(Q68State *state, uint32_t opcode)
  */
 static int op_Scc(Q68State *state, uint32_t opcode)
 {
+    INSN_GET_COND;
+    int is_true;
+    int cycles;
+
     if (EA_MODE(opcode) == EA_ADDRESS_REG) {
         /* DBcc Dn,disp is coded as Scc An with an extension word */
         return opDBcc(state, opcode);
     }
 
-    INSN_GET_COND;
-    const int is_true = INSN_COND_TRUE(cond);
+    is_true = INSN_COND_TRUE(cond);
     /* From the cycle counts, it looks like this is a standard read/write
      * access rather than a write-only access */
-    int cycles;
     if (EA_MODE(opcode) == EA_DATA_REG) {
         cycles = 0;
     } else {
@@ -1202,6 +1216,15 @@ static int op_alu(Q68State *state, uint32_t opcode)
 {
     INSN_GET_REG;
     INSN_GET_SIZE;
+    int bytes, shift;
+    uint32_t valuemask;
+    int ea_dest = opcode & 0x100;
+    int areg_dest = 0;  // For ADDA/SUBA/CMPA
+    enum {OR, AND, EOR, CMP, SUB, ADD} aluop;
+    uint32_t reg_val;
+    int cycles;
+    uint32_t ea_val;
+    uint32_t result;
 
     /* Pass off special and invalid instructions early */
     if (size != 3) {
@@ -1227,12 +1250,9 @@ static int op_alu(Q68State *state, uint32_t opcode)
         }
     }
 
-    const int bytes = SIZE_TO_BYTES(size);
-    const int shift = bytes*8 - 1;
-    const uint32_t valuemask = ~(~1 << shift);
-    int ea_dest = opcode & 0x100;
-    int areg_dest = 0;  // For ADDA/SUBA/CMPA
-    enum {OR, AND, EOR, CMP, SUB, ADD} aluop;
+    bytes = SIZE_TO_BYTES(size);
+    shift = bytes*8 - 1;
+    valuemask = ~(~1 << shift);
 
     /* Find the instruction for the opcode group */
     switch (opcode>>12) {
@@ -1251,9 +1271,8 @@ static int op_alu(Q68State *state, uint32_t opcode)
     }
 
     /* Retrieve the register and EA values */
-    uint32_t reg_val = areg_dest ? state->A[reg] : (state->D[reg] & valuemask);
-    int cycles;
-    uint32_t ea_val = ea_get(state, opcode, size, ea_dest, &cycles);
+    reg_val = areg_dest ? state->A[reg] : (state->D[reg] & valuemask);
+    ea_val = ea_get(state, opcode, size, ea_dest, &cycles);
     if (cycles < 0) {
         return 0;
     }
@@ -1271,7 +1290,6 @@ static int op_alu(Q68State *state, uint32_t opcode)
     }
 
     /* Perform the actual computation */
-    uint32_t result;
     if (!areg_dest || aluop == CMP) {
         if (aluop == ADD || aluop == SUB) {
             INSN_CLEAR_XCC();
@@ -1366,11 +1384,13 @@ static int op_DIV(Q68State *state, uint32_t opcode)
 {
     INSN_GET_REG;
     const int sign = opcode & (1<<8);
+    int cycles;
+    uint16_t divisor;
+    int32_t quotient, remainder;
 
     state->SR &= ~SR_C;  // Always cleared, even on exception
 
-    int cycles;
-    const uint16_t divisor = ea_get(state, opcode, SIZE_W, 0, &cycles);
+    divisor = ea_get(state, opcode, SIZE_W, 0, &cycles);
     if (cycles < 0) {
         return 0;
     }
@@ -1379,7 +1399,6 @@ static int op_DIV(Q68State *state, uint32_t opcode)
         return cycles;
     }
 
-    int32_t quotient, remainder;
     if (sign) {
         quotient  = (int32_t)state->D[reg] / (int16_t)divisor;
         remainder = (int32_t)state->D[reg] % (int16_t)divisor;
@@ -1658,6 +1677,9 @@ static int op4alu(Q68State *state, uint32_t opcode)
     const int shift = bytes*8 - 1;
     const uint32_t valuemask = ~(~1 << shift);
     enum {NEGX = 0, CLR = 1, NEG = 2, NOT = 3, TST = 5} aluop;
+    int cycles;
+    uint32_t value;
+    uint32_t result;
     aluop = opcode>>9 & 7;
 
     if (EA_MODE(opcode) == EA_ADDRESS_REG) {  // Address registers not allowed
@@ -1665,8 +1687,7 @@ static int op4alu(Q68State *state, uint32_t opcode)
     }
 
     /* Retrieve the EA value */
-    int cycles;
-    uint32_t value = ea_get(state, opcode, size, 1, &cycles);
+    value = ea_get(state, opcode, size, 1, &cycles);
     if (cycles < 0) {
         return 0;
     }
@@ -1681,7 +1702,6 @@ static int op4alu(Q68State *state, uint32_t opcode)
     }
 
     /* Perform the actual computation */
-    uint32_t result;
     if (aluop == NEGX) {
         state->SR &= ~(SR_N | SR_V | SR_C);  // Z is never set, only cleared
     } else {
@@ -1744,6 +1764,8 @@ static int opMVSR(Q68State *state, uint32_t opcode)
     int is_CCR;
     int ea_dest;
     int cycles;
+    int cycles_tmp;
+    uint16_t value;
     switch (opcode>>9 & 3) {
       case 0:  // MOVE SR,<ea>
         is_CCR = 0;
@@ -1775,8 +1797,7 @@ static int opMVSR(Q68State *state, uint32_t opcode)
     /* Motorola docs say the address is read before being written, even
      * for the SR,<ea> format; also, the access size is a word even for
      * CCR operations. */
-    int cycles_tmp;
-    uint16_t value = ea_get(state, opcode, SIZE_W, ea_dest, &cycles_tmp);
+    value = ea_get(state, opcode, SIZE_W, ea_dest, &cycles_tmp);
     if (cycles_tmp < 0) {
         return 0;
     }
@@ -1803,27 +1824,31 @@ static int opMVSR(Q68State *state, uint32_t opcode)
  */
 static int opNBCD(Q68State *state, uint32_t opcode)
 {
+    int cycles;
+    int value;
+    int result;
+    int X;
+    int res_low, res_high;
+    int borrow = 0;
+
     if (EA_MODE(opcode) == EA_ADDRESS_REG) {  // Address registers not allowed
         return op_ill(state, opcode);
     }
 
-    int cycles;
-    int value = ea_get(state, opcode, SIZE_B, 1, &cycles);
+    value = ea_get(state, opcode, SIZE_B, 1, &cycles);
     if (cycles < 0) {
         return 0;
     }
 
-    int result;
-    int X = (state->SR >> SR_X_SHIFT) & 1;
+    X = (state->SR >> SR_X_SHIFT) & 1;
     state->SR &= ~(SR_X | SR_C);  // Z is never set, only cleared
     /* Slightly convoluted to match what a real 68000 does (see SBCD) */
-    int res_low = 0 - (value & 0x0F) - X;
-    int borrow = 0;
+    res_low = 0 - (value & 0x0F) - X;
     if (res_low < 0) {
         res_low += 10;
         borrow = 1<<4;
     }
-    int res_high = 0 - (value & 0xF0) - borrow;
+    res_high = 0 - (value & 0xF0) - borrow;
     if (res_high < 0) {
         res_high += 10<<4;
         state->SR |= SR_X | SR_C;
@@ -1848,6 +1873,8 @@ static int opNBCD(Q68State *state, uint32_t opcode)
  */
 static int op_PEA(Q68State *state, uint32_t opcode)
 {
+    int cycles;
+
     /* SWAP is coded as PEA Dn */
     if (EA_MODE(opcode) == EA_DATA_REG) {
         return opSWAP(state, opcode);
@@ -1862,7 +1889,7 @@ static int op_PEA(Q68State *state, uint32_t opcode)
         return op_ill(state, opcode);
     }
 
-    int cycles = ea_resolve(state, opcode, SIZE_W, ACCESS_READ);
+    cycles = ea_resolve(state, opcode, SIZE_W, ACCESS_READ);
     if (cycles < 0) {
         return op_ill(state, opcode);
     }
@@ -1904,12 +1931,14 @@ static int opSWAP(Q68State *state, uint32_t opcode)
  */
 static int op_TAS(Q68State *state, uint32_t opcode)
 {
+    int cycles;
+    int8_t value;
+
     if (EA_MODE(opcode) == EA_ADDRESS_REG) {  // Address registers not allowed
         return op_ill(state, opcode);
     }
 
-    int cycles;
-    int8_t value = ea_get(state, opcode, SIZE_B, 1, &cycles);
+    value = ea_get(state, opcode, SIZE_B, 1, &cycles);
     if (cycles < 0) {
         /* Note that the ILLEGAL instruction is coded as TAS #imm, so it
          * will be rejected as unwriteable by ea_get() */
@@ -1951,13 +1980,17 @@ static int op_EXT(Q68State *state, uint32_t opcode)
  */
 static int op_STM(Q68State *state, uint32_t opcode)
 {
+    unsigned int regmask;
+    int size = (opcode & 0x0040) ? SIZE_L : SIZE_W;
+    uint16_t safe_ea;
+    int cycles;
+
     /* EXT.* is coded as MOVEM.* reglist,Dn */
     if (EA_MODE(opcode) == EA_DATA_REG) {
         return op_EXT(state, opcode);
     }
 
-    unsigned int regmask = IFETCH(state);
-    int size = (opcode & 0x0040) ? SIZE_L : SIZE_W;
+    regmask = IFETCH(state);
     if (EA_MODE(opcode) <= EA_ADDRESS_REG
      || EA_MODE(opcode) == EA_POSTINCREMENT  // Not allowed for store
     ) {
@@ -1965,13 +1998,12 @@ static int op_STM(Q68State *state, uint32_t opcode)
     }
 
     /* Avoid modifying the register during address resolution */
-    uint16_t safe_ea;
     if (EA_MODE(opcode) == EA_PREDECREMENT) {
         safe_ea = EA_INDIRECT<<3 | EA_REG(opcode);
     } else {
         safe_ea = opcode;
     }
-    int cycles = ea_resolve(state, safe_ea, SIZE_W, ACCESS_WRITE);
+    cycles = ea_resolve(state, safe_ea, SIZE_W, ACCESS_WRITE);
     if (cycles < 0) {
         return op_ill(state, opcode);
     }
@@ -2032,6 +2064,10 @@ static int op_LDM(Q68State *state, uint32_t opcode)
 {
     unsigned int regmask = IFETCH(state);
     int size = (opcode & 0x0040) ? SIZE_L : SIZE_W;
+    uint16_t safe_ea;
+    int cycles;
+    int reg;
+
     if (EA_MODE(opcode) <= EA_ADDRESS_REG
      || EA_MODE(opcode) == EA_PREDECREMENT  // Not allowed for load
     ) {
@@ -2039,13 +2075,12 @@ static int op_LDM(Q68State *state, uint32_t opcode)
     }
 
     /* Avoid modifying the register during address resolution */
-    uint16_t safe_ea;
     if (EA_MODE(opcode) == EA_POSTINCREMENT) {
         safe_ea = EA_INDIRECT<<3 | EA_REG(opcode);
     } else {
         safe_ea = opcode;
     }
-    int cycles = ea_resolve(state, safe_ea, SIZE_W, ACCESS_READ);
+    cycles = ea_resolve(state, safe_ea, SIZE_W, ACCESS_READ);
     if (cycles < 0) {
         return op_ill(state, opcode);
     }
@@ -2059,7 +2094,6 @@ static int op_LDM(Q68State *state, uint32_t opcode)
     }
 #endif
 
-    int reg;
     for (reg = 0; reg < 16; reg++, regmask >>= 1) {
         if (regmask & 1) {
             if (size == SIZE_W) {
@@ -2166,12 +2200,13 @@ static int opUNLK(Q68State *state, uint32_t opcode)
  */
 static int opMUSP(Q68State *state, uint32_t opcode)
 {
+    INSN_GET_REG0;
+
     if (!(state->SR & SR_S)) {
         state->exception = EX_PRIVILEGE_VIOLATION;
         return 0;
     }
 
-    INSN_GET_REG0;
     if (opcode & 0x0008) {
         state->USP = state->A[reg0];
     } else {
@@ -2206,6 +2241,7 @@ static int op4E7x(Q68State *state, uint32_t opcode)
         set_SR(state, IFETCH(state));
         return 4;
       case 3: {  // $4E73 RTE
+        uint16_t new_SR;
         if (!(state->SR & SR_S)) {
             state->exception = EX_PRIVILEGE_VIOLATION;
             return 0;
@@ -2219,7 +2255,7 @@ static int op4E7x(Q68State *state, uint32_t opcode)
             return 0;
         }
 #endif
-        uint16_t new_SR = POP16(state);
+        new_SR = POP16(state);
         state->PC = POP32(state);
         set_SR(state, new_SR);
         return 20;
@@ -2463,12 +2499,13 @@ static int op_BCD(Q68State *state, uint32_t opcode)
     } else {
         /* Slightly convoluted to match what a real 68000 does */
         int res_low = (dest & 0x0F) - (src & 0x0F) - X;
+        int res_high;
         int borrow = 0;
         if (res_low < 0) {
             res_low += 10;
             borrow = 1<<4;
         }
-        int res_high = (dest & 0xF0) - (src & 0xF0) - borrow;
+        res_high = (dest & 0xF0) - (src & 0xF0) - borrow;
         if (res_high < 0) {
             res_high += 10<<4;
             state->SR |= SR_X | SR_C;
@@ -388,6 +388,11 @@ const char *q68_disassemble(Q68State *state, uint32_t address,
 {
     const uint32_t base_address = address;
     static char outbuf[1000];
+    uint16_t opcode;
+    const char *format = NULL;
+    int i;
+    int outlen = 0;
+    int inpos = 0;
 
     if (address % 2 != 0) {  // Odd addresses are invalid
         if (nwords_ret) {
@@ -396,10 +401,8 @@ const char *q68_disassemble(Q68State *state, uint32_t address,
         return "???";
     }
 
-    uint16_t opcode = READU16(state, address);
+    opcode = READU16(state, address);
     address += 2;
-    const char *format = NULL;
-    int i;
     for (i = 0; i < lenof(instructions); i++) {
         if ((opcode & instructions[i].mask) == instructions[i].test) {
             format = instructions[i].format;
@@ -413,7 +416,6 @@ const char *q68_disassemble(Q68State *state, uint32_t address,
         return "???";
     }
 
-    int outlen = 0;
 #define APPEND_CHAR(ch)  do { \
     if (outlen < sizeof(outbuf)-1) { \
         outbuf[outlen++] = (ch); \
@@ -428,7 +430,6 @@ const char *q68_disassemble(Q68State *state, uint32_t address,
     } \
 } while (0)
 
-    int inpos = 0;
     while (format[inpos] != 0) {
         if (format[inpos] == '<') {
             char tagbuf[100];
@@ -479,12 +480,12 @@ const char *q68_disassemble(Q68State *state, uint32_t address,
                     break;
                   }
                   case 6: {
-                    uint16_t ext = READU16(state, address);
-                    address += 2;
+                    const uint16_t ext = READU16(state, address);
                     const int iregtype = ext>>15;
                     const int ireg     = ext>>12 & 7;
                     const int iregsize = ext>>11;
                     const int8_t disp  = ext & 0xFF;
+                    address += 2;
                     APPEND("%d(A%d,%c%d.%c)", disp, reg,
                            iregtype ? 'A' : 'D', ireg, iregsize ? 'l' : 'w');
                     break;
@@ -510,12 +511,12 @@ const char *q68_disassemble(Q68State *state, uint32_t address,
                         break;
                       }
                       case 3: {
-                        uint16_t ext = READU16(state, address);
-                        address += 2;
+                        const uint16_t ext = READU16(state, address);
                         const int iregtype = ext>>15;
                         const int ireg     = ext>>12 & 7;
                         const int iregsize = ext>>11;
                         const int8_t disp  = ext & 0xFF;
+                        address += 2;
                         APPEND("$%X(PC,%c%d.%c)", (base_address+2) + disp,
                                iregtype ? 'A' : 'D', ireg, iregsize ? 'l' : 'w');
                         break;
@@ -578,6 +579,10 @@ const char *q68_disassemble(Q68State *state, uint32_t address,
             } else if (strcmp(tagbuf,"reglist") == 0
                        || strcmp(tagbuf,"tsilger") == 0) {
                 uint16_t reglist = READU16(state, address);
+                char listbuf[3*16];  // Buffer for generating register list
+                unsigned int listlen = 0;  // strlen(listbuf)
+                unsigned int last = 0;     // State of the previous bit
+                unsigned int regnum = 0;   // Current register number (0-15)
                 address += 2;
                 if (strcmp(tagbuf,"tsilger") == 0) {  // "reglist" backwards
                     /* Predecrement-mode register list, so flip it around */
@@ -591,10 +596,6 @@ const char *q68_disassemble(Q68State *state, uint32_t address,
                         temp >>= 1;
                     }
                 }
-                char listbuf[3*16];  // Buffer for generating register list
-                unsigned int listlen = 0;  // strlen(listbuf)
-                unsigned int last = 0;     // State of the previous bit
-                unsigned int regnum = 0;   // Current register number (0-15)
                 while (reglist) {
                     if (reglist & 1) {
                         if (last) {
@@ -729,6 +730,20 @@ void q68_trace(void)
 
     } else {
 
+        int nwords = 1, i;
+        const char *disassembled = q68_disassemble(state, state->PC, &nwords);
+#ifdef PSP  // because the cleaner fprintf() version is just too slow
+        int dislen = strlen(disassembled);
+        static char buf1[] =
+            "......: .... .... ....  ..........................  SR=.... .....  [..........]\n";
+        static char buf2[] =
+            "    D: ........ ........ ........ ........ ........ ........ ........ ........\n"
+            "    A: ........ ........ ........ ........ ........ ........ ........ ........\n";
+#else
+        char hexbuf[100];
+        int hexlen = 0;
+#endif
+
         if (!logfile) {
 #ifdef __linux__
             logfile = popen("gzip -3 >q68.log.gz", "w");
@@ -742,17 +757,7 @@ void q68_trace(void)
             setvbuf(logfile, NULL, _IOFBF, 65536);
         }
 
-        int nwords = 1, i;
-        const char *disassembled = q68_disassemble(state, state->PC, &nwords);
-
-#ifdef PSP  // because the cleaner fprintf() version is just too slow
-        int dislen = strlen(disassembled);
-        static char buf1[] =
-            "......: .... .... ....  ..........................  SR=.... .....  [..........]\n";
-        static char buf2[] =
-            "    D: ........ ........ ........ ........ ........ ........ ........ ........\n"
-            "    A: ........ ........ ........ ........ ........ ........ ........ ........\n";
-
+#ifdef PSP
         if (nwords > 3) {  // We can only fit 3 words on the line
             nwords = 3;
         }
@@ -790,9 +795,6 @@ void q68_trace(void)
         }
         fwrite(buf2, 1, sizeof(buf2)-1, logfile);
 #else  // !PSP
-        char hexbuf[100];
-        int hexlen = 0;
-
         if (nwords > 3) {  // We can only fit 3 words on the line
             nwords = 3;
         }
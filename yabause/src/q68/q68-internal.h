@@ -236,6 +236,21 @@ struct Q68State_ {
     /* Buffer for tracking translated code blocks */
     uint8_t jit_pages[1<<(24-(Q68_JIT_PAGE_BITS+3))];
 
+    /* Pointer to q68_jit_clear_write(), so translated code can reach it
+     * without an absolute address (which position-independent x64 code
+     * can't embed in copied code fragments) */
+    void (*jit_clear_write)(Q68State *state, uint32_t address, uint32_t size);
+
+    /* Nonzero if dynamic translation is enabled for this processor (see
+     * q68_set_jit()) */
+    unsigned int jit_enabled;
+
+    /* Native memory allocation functions for translated code (see
+     * q68_set_jit_memory_funcs()) */
+    void *(*jit_malloc_func)(size_t size);
+    void *(*jit_realloc_func)(void *ptr, size_t size);
+    void (*jit_free_func)(void *ptr);
+
 };
 
 /*-----------------------------------------------------------------------*/
@@ -436,16 +451,18 @@ static inline uint32_t READU16(Q68State *state, uint32_t addr) {
 }
 
 static inline int32_t READS32(Q68State *state, uint32_t addr) {
+    int32_t value;
     addr &= 0xFFFFFF;
-    int32_t value = (int32_t) state->readw_func(addr) << 16;
+    value = (int32_t) state->readw_func(addr) << 16;
     addr += 2;
     addr &= 0xFFFFFF;
     value |= state->readw_func(addr);
     return value;
 }
 static inline uint32_t READU32(Q68State *state, uint32_t addr) {
+    uint32_t value;
     addr &= 0xFFFFFF;
-    uint32_t value = state->readw_func(addr) << 16;
+    value = state->readw_func(addr) << 16;
     addr += 2;
     addr &= 0xFFFFFF;
     value |= state->readw_func(addr);
@@ -395,6 +395,8 @@ static OpcodeFunc * const opcode_4E4x_table[8] = {
  */
 int q68_jit_init(Q68State *state)
 {
+    int i;
+
     state->jit_table =
         state->malloc_func(sizeof(*state->jit_table) * Q68_JIT_TABLE_SIZE);
     if (!state->jit_table) {
@@ -410,7 +412,6 @@ int q68_jit_init(Q68State *state)
 
     /* Make sure all entries are marked as unused (so we don't try to free
      * invalid pointers in q68_jit_reset()) */
-    int i;
     for (i = 0; i < Q68_JIT_TABLE_SIZE; i++) {
         state->jit_table[i].m68k_start = 0;
     }
@@ -422,6 +423,10 @@ int q68_jit_init(Q68State *state)
     /* Default to no cache flush function */
     state->jit_flush   = NULL;
 
+    /* Translated code calls back through the state block (see
+     * WRITE_CHECK_JIT in q68-jit-x86.S) */
+    state->jit_clear_write = q68_jit_clear_write;
+
 #ifdef Q68_DISABLE_ADDRESS_ERROR
     /* Hack to avoid compiler warnings about unused functions */
     if (0) {
@@ -509,7 +514,10 @@ void q68_jit_cleanup(Q68State *state)
  */
 Q68JitEntry *q68_jit_translate(Q68State *state, uint32_t address)
 {
-    int index;
+    int index, hashval, oldest, done;
+    uint32_t limit;
+    void *newptr;
+    Q68JitEntry *retval;
 
     if (address == 0) {
         /* We use address 0 to indicate an unused entry, so we can't
@@ -567,9 +575,9 @@ Q68JitEntry *q68_jit_translate(Q68State *state, uint32_t address)
     while (state->jit_total_data >= Q68_JIT_DATA_LIMIT) {
         clear_oldest_entry(state);
     }
-    const int hashval = JIT_HASH(address);
+    hashval = JIT_HASH(address);
     index = hashval;
-    int oldest = index;
+    oldest = index;
     while (state->jit_table[index].m68k_start != 0) {
         if (TIMESTAMP_COMPARE(state->jit_timestamp,
                               state->jit_table[index].timestamp,
@@ -595,7 +603,7 @@ Q68JitEntry *q68_jit_translate(Q68State *state, uint32_t address)
 
     /* Initialize the new entry */
 
-    current_entry->native_code = state->malloc_func(Q68_JIT_BLOCK_EXPAND_SIZE);
+    current_entry->native_code = state->jit_malloc_func(Q68_JIT_BLOCK_EXPAND_SIZE);
     if (!current_entry->native_code) {
         DMSG("No memory for code at $%06X", address);
         current_entry = NULL;
@@ -628,8 +636,8 @@ Q68JitEntry *q68_jit_translate(Q68State *state, uint32_t address)
     /* Translate a block of 68000 code */
 
     jit_PC = address;
-    const uint32_t limit = address + Q68_JIT_MAX_BLOCK_SIZE;
-    int done = 0;
+    limit = address + Q68_JIT_MAX_BLOCK_SIZE;
+    done = 0;
     while (!done && jit_PC < limit) {
         /* Make sure we haven't entered a blacklisted block */
         for (index = 0; index < Q68_JIT_BLACKLIST_SIZE; index++) {
@@ -663,8 +671,8 @@ Q68JitEntry *q68_jit_translate(Q68State *state, uint32_t address)
     ) {
         JIT_PAGE_SET(state, index);
     }
-    void *newptr = state->realloc_func(current_entry->native_code,
-                                       current_entry->native_length);
+    newptr = state->jit_realloc_func(current_entry->native_code,
+                                     current_entry->native_length);
     if (newptr) {
         current_entry->native_code = newptr;
         current_entry->native_size = current_entry->native_length;
@@ -674,7 +682,7 @@ Q68JitEntry *q68_jit_translate(Q68State *state, uint32_t address)
      * q68_jit_run() (see q68_jit_find() for why we do it here) */
     current_entry->exec_address = current_entry->native_code;
 
-    Q68JitEntry *retval = current_entry;
+    retval = current_entry;
     current_entry = NULL;
     if (state->jit_flush) {
         state->jit_flush();
@@ -731,13 +739,14 @@ void q68_jit_run(Q68State *state, uint32_t cycle_limit,
                  Q68JitEntry **entry_ptr)
 {
     Q68JitEntry *entry = *entry_ptr;
+    int cycles;
 
   again:
     entry->timestamp = state->jit_timestamp;
     state->jit_timestamp++;
     entry->running = 1;
-    int cycles = JIT_CALL(state, cycle_limit - state->cycles,
-                          &entry->exec_address);
+    cycles = JIT_CALL(state, cycle_limit - state->cycles,
+                      &entry->exec_address);
     entry->running = 0;
     state->jit_abort = 0;
     state->cycles += cycles & 0x3FFF;
@@ -747,9 +756,9 @@ void q68_jit_run(Q68State *state, uint32_t cycle_limit,
         entry = NULL;
     } else if (cycles & 0x8000) {  // BSR/JSR/RTS/RTR
         if (cycles & 0x4000) {  // RTS/RTR
-            entry = NULL;
             unsigned int top = state->jit_callstack_top;
             unsigned int i;
+            entry = NULL;
             for (i = Q68_JIT_CALLSTACK_SIZE; i > 0; i--) {
                 top = (top + Q68_JIT_CALLSTACK_SIZE-1) % Q68_JIT_CALLSTACK_SIZE;
                 if (state->jit_callstack[top].return_PC == state->PC) {
@@ -778,10 +787,11 @@ void q68_jit_run(Q68State *state, uint32_t cycle_limit,
     }
 
     /* If we finished a block, we still have cycles to go, there's no
-     * exception pending, and there's already a translated block at the
-     * next PC, jump right to it so we don't incur the extra overhead of
-     * returning to the caller */
-    if (!entry && state->cycles < cycle_limit && !state->exception) {
+     * exception pending, the processor wasn't stopped, and there's
+     * already a translated block at the next PC, jump right to it so we
+     * don't incur the extra overhead of returning to the caller */
+    if (!entry && state->cycles < cycle_limit && !state->exception
+     && !state->halted) {
         entry = q68_jit_find(state, state->PC);
         if (entry) {
             goto again;
@@ -870,6 +880,9 @@ void q68_jit_clear_page(Q68State *state, uint32_t address)
 void q68_jit_clear_write(Q68State *state, uint32_t address, uint32_t size)
 {
     int index;
+    uint32_t page, page_start, page_end;
+    int found;
+    uint32_t start, end;
 
     /* If the address is in a blacklisted block, we don't need to do
      * anything (but update the timestamp to extend its timeout) */
@@ -884,9 +897,9 @@ void q68_jit_clear_write(Q68State *state, uint32_t address, uint32_t size)
 
     /* Clear the translations-exist flag now; we'll set it later if we
      * find a translation on the page that we don't clear */
-    const uint32_t page       = address >> Q68_JIT_PAGE_BITS;
-    const uint32_t page_start = page << Q68_JIT_PAGE_BITS;
-    const uint32_t page_end   = ((page+1) << Q68_JIT_PAGE_BITS) - 1;
+    page       = address >> Q68_JIT_PAGE_BITS;
+    page_start = page << Q68_JIT_PAGE_BITS;
+    page_end   = ((page+1) << Q68_JIT_PAGE_BITS) - 1;
     JIT_PAGE_CLEAR(state, page);
 
     /* Clear any translations affected by the address, and determine
@@ -894,8 +907,9 @@ void q68_jit_clear_write(Q68State *state, uint32_t address, uint32_t size)
      * the last byte/word of the longest possible instruction (10 bytes:
      * MOVE.L #$12345678, ($12345678).l), but do not extend backwards past
      * the beginning of a block. */
-    int found = 0;
-    uint32_t start = address + size, end = address + (size-1);
+    found = 0;
+    start = address + size;
+    end = address + (size-1);
 #ifdef Q68_JIT_VERBOSE
     DMSG("WARNING: jit_clear_write($%06X,%d)", (int)address, (int)size);
 #endif
@@ -988,8 +1002,11 @@ void q68_jit_clear_write(Q68State *state, uint32_t address, uint32_t size)
  */
 static int translate_insn(Q68State *state, Q68JitEntry *entry)
 {
-    /* See if there are any branches to this address we can update */
     int i;
+    unsigned int opcode, index;
+    int done;
+
+    /* See if there are any branches to this address we can update */
     for (i = 0; i < lenof(unres_branches); i++) {
         if (unres_branches[i].m68k_target == jit_PC) {
             JIT_FIXUP_BRANCH(entry, unres_branches[i].native_offset,
@@ -1004,12 +1021,12 @@ static int translate_insn(Q68State *state, Q68JitEntry *entry)
     btcache_index = (btcache_index + 1) % lenof(btcache);
 
     /* Fetch the next instruction */
-    const unsigned int opcode = IFETCH(state);
+    opcode = IFETCH(state);
     state->current_PC = jit_PC;
 
     /* Emit a cycle count check if appropriate */
 #ifdef Q68_JIT_LOOSE_TIMING
-    if ((opcode & 0xFF00) == 0x6100  // Bcc
+    if ((opcode & 0xF000) == 0x6000  // Bcc
      || (opcode & 0xF0F8) == 0x50C8  // DBcc
      || (opcode & 0xFFF0) == 0x4E40  // TRAP
      || (opcode & 0xFF80) == 0x4E80  // JSR/JMP
@@ -1034,8 +1051,8 @@ static int translate_insn(Q68State *state, Q68JitEntry *entry)
 
     /* Translate the instruction itself and update the 68000 PC */
     PC_updated = 0;
-    const unsigned int index = (opcode>>9 & 0x78) | (opcode>>6 & 0x07);
-    int done = (*opcode_table[index])(state, opcode);
+    index = (opcode>>9 & 0x78) | (opcode>>6 & 0x07);
+    done = (*opcode_table[index])(state, opcode);
     /* Only update the PC if the function didn't do so itself (see e.g.
      * op_imm() to SR), but check the jit_abort flag unless we're
      * terminating anyway */
@@ -1079,7 +1096,7 @@ static void clear_entry(Q68State *state, Q68JitEntry *entry)
 
     /* Free the native code */
     state->jit_total_data -= entry->native_size;
-    state->free_func(entry->native_code);
+    state->jit_free_func(entry->native_code);
     entry->native_code = NULL;
 
     /* Clear the entry from the table and hash chain */
@@ -1144,7 +1161,7 @@ static void clear_oldest_entry(Q68State *state)
 static int expand_buffer(Q68JitEntry *entry)
 {
     const uint32_t newsize = entry->native_size + Q68_JIT_BLOCK_EXPAND_SIZE;
-    void *newptr = entry->state->realloc_func(entry->native_code, newsize);
+    void *newptr = entry->state->jit_realloc_func(entry->native_code, newsize);
     if (!newptr) {
         DMSG("Out of memory");
         return 0;
@@ -1683,8 +1700,9 @@ static int ea_resolve(Q68State *state, uint32_t opcode, int size,
             JIT_EMIT_RESOLVE_ABSOLUTE(current_entry, (int16_t)IFETCH(state));
             break;
           case EA_MISC_ABSOLUTE_L: {
+            uint32_t addr;
             cycles += 12;
-            uint32_t addr = IFETCH(state) << 16;
+            addr = IFETCH(state) << 16;
             addr |= (uint16_t)IFETCH(state);
             JIT_EMIT_RESOLVE_ABSOLUTE(current_entry, addr);
             break;
@@ -1703,10 +1721,10 @@ static int ea_resolve(Q68State *state, uint32_t opcode, int size,
             if (access_type != ACCESS_READ) {
                 return -1;
             } else {
-                cycles += 10;
                 const uint16_t ext = IFETCH(state);
                 const unsigned int ireg = ext >> 12;  // 0..15
                 const int32_t disp = (int32_t)((int8_t)ext);
+                cycles += 10;
                 if (ext & 0x0800) {
                     JIT_EMIT_RESOLVE_ABS_INDEX_L(
                         current_entry, state->current_PC + disp, ireg*4
@@ -1786,8 +1804,8 @@ static void ea_get(Q68State *state, uint32_t opcode, int size,
                 *cycles_ret = -1;
                 return;
             } else {
-                *cycles_ret = (size==SIZE_L ? 8 : 4);
                 uint32_t val;
+                *cycles_ret = (size==SIZE_L ? 8 : 4);
                 val = IFETCH(state);
                 if (size == SIZE_B) {
                     val &= 0xFF;
@@ -1917,8 +1935,14 @@ static void ea_set(Q68State *state, uint32_t opcode, int size)
  */
 static int op_imm(Q68State *state, uint32_t opcode)
 {
-    /* Check for bit-twiddling and illegal opcodes first */
     enum {OR = 0, AND, SUB, ADD, _BIT, EOR, CMP, _ILL} aluop;
+    INSN_GET_SIZE;
+    int cycles_dummy;
+    int use_SR;
+    int cycles;
+    int do_cc;
+
+    /* Check for bit-twiddling and illegal opcodes first */
     aluop = opcode>>9 & 7;
     if (aluop == _BIT) {
         return op_bit(state, opcode);
@@ -1926,19 +1950,15 @@ static int op_imm(Q68State *state, uint32_t opcode)
         return op_ill(state, opcode);
     }
 
-    /* Get the instruction size */
-    INSN_GET_SIZE;
+    /* Check the instruction size */
     if (size == 3) {
         return op_ill(state, opcode);
     }
 
     /* Fetch the immediate value */
-    int cycles_dummy;
     ea_get(state, EA_MISC<<3 | EA_MISC_IMMEDIATE, size, 0, &cycles_dummy, 1);
 
     /* Fetch the EA operand (which may be SR or CCR) */
-    int use_SR;
-    int cycles;
     if ((aluop==OR || aluop==AND || aluop==EOR) && (opcode & 0x3F) == 0x3C) {
         /* xxxI #imm,SR (or CCR) use the otherwise-invalid form of an
          * immediate value destination */
@@ -1964,7 +1984,7 @@ static int op_imm(Q68State *state, uint32_t opcode)
     }
 
     /* Check whether we need to output condition codes */
-    const int do_cc = cc_needed(state, opcode);
+    do_cc = cc_needed(state, opcode);
 
     /* Perform the operation */
     switch (aluop) {
@@ -2080,6 +2100,11 @@ static int op_imm(Q68State *state, uint32_t opcode)
  */
 static int op_bit(Q68State *state, uint32_t opcode)
 {
+    enum {BTST = 0, BCHG = 1, BCLR = 2, BSET = 3} op = opcode>>6 & 3;
+    int cycles;
+    int size;
+    int cycles_tmp;
+
     /* Check early for MOVEP (coded as BTST/BCHG/BCLR/BSET Dn,An) */
     if (EA_MODE(opcode) == EA_ADDRESS_REG) {
         if (opcode & 0x0100) {
@@ -2089,9 +2114,6 @@ static int op_bit(Q68State *state, uint32_t opcode)
         }
     }
 
-    enum {BTST = 0, BCHG = 1, BCLR = 2, BSET = 3} op = opcode>>6 & 3;
-    int cycles;
-
     /* Get the bit number to operate on */
     if (opcode & 0x0100) {
         /* Bit number in register */
@@ -2105,8 +2127,7 @@ static int op_bit(Q68State *state, uint32_t opcode)
     }
 
     /* EA operand is 32 bits when coming from a register, 8 when from memory */
-    int size = (EA_MODE(opcode)==EA_DATA_REG ? SIZE_L : SIZE_B);
-    int cycles_tmp;
+    size = (EA_MODE(opcode)==EA_DATA_REG ? SIZE_L : SIZE_B);
     ea_get(state, opcode, size, 1, &cycles_tmp, 2);
     if (cycles_tmp < 0) {
         return 1;
@@ -2151,8 +2172,11 @@ static int op_bit(Q68State *state, uint32_t opcode)
 static int opMOVE(Q68State *state, uint32_t opcode)
 {
     const int size = (opcode>>12==1 ? SIZE_B : opcode>>12==2 ? SIZE_L : SIZE_W);
-
     int cycles_src;
+    uint32_t dummy_opcode;
+    int cycles_dest;
+    int do_cc;
+
     ea_get(state, opcode, size, 0, &cycles_src, 1);
     if (cycles_src < 0) {
         return 1;
@@ -2160,8 +2184,7 @@ static int opMOVE(Q68State *state, uint32_t opcode)
 
     /* Rearrange the opcode bits so we can pass the destination EA to
      * ea_resolve() */
-    const uint32_t dummy_opcode = (opcode>>9 & 7) | (opcode>>3 & 0x38);
-    int cycles_dest;
+    dummy_opcode = (opcode>>9 & 7) | (opcode>>3 & 0x38);
     if (EA_MODE(dummy_opcode) <= EA_ADDRESS_REG) {
         cycles_dest = 0;
     } else {
@@ -2172,7 +2195,7 @@ static int opMOVE(Q68State *state, uint32_t opcode)
     }
 
     /* Copy the operand to the result and set flags (if needed) */
-    const int do_cc = cc_needed(state, opcode);
+    do_cc = cc_needed(state, opcode);
     if (EA_MODE(dummy_opcode) == EA_ADDRESS_REG) {
         if (size == SIZE_W) {
             JIT_EMIT_EXT_L(current_entry);
@@ -2218,9 +2241,9 @@ static int op4xxx(Q68State *state, uint32_t opcode)
 static int op_CHK(Q68State *state, uint32_t opcode)
 {
     INSN_GET_REG;
-    JIT_EMIT_GET_OP1_REGISTER(current_entry, reg*4);
-
     int cycles;
+
+    JIT_EMIT_GET_OP1_REGISTER(current_entry, reg*4);
     if (EA_MODE(opcode) == EA_ADDRESS_REG) {
         return op_ill(state, opcode);
     }
@@ -2244,6 +2267,7 @@ static int op_CHK(Q68State *state, uint32_t opcode)
 static int op_LEA(Q68State *state, uint32_t opcode)
 {
     INSN_GET_REG;
+    int cycles;
 
     /* Register, predecrement, postincrement, immediate modes are illegal */
     if (EA_MODE(opcode) == EA_DATA_REG
@@ -2255,7 +2279,7 @@ static int op_LEA(Q68State *state, uint32_t opcode)
         return op_ill(state, opcode);
     }
 
-    int cycles = ea_resolve(state, opcode, SIZE_W, ACCESS_READ);
+    cycles = ea_resolve(state, opcode, SIZE_W, ACCESS_READ);
     if (cycles < 0) {
         return op_ill(state, opcode);
     }
@@ -2278,19 +2302,21 @@ static int opADSQ(Q68State *state, uint32_t opcode)
     const int is_sub = opcode & 0x0100;
     INSN_GET_COUNT;
     INSN_GET_SIZE;
+    int cycles;
+    int do_cc;
+
     if (EA_MODE(opcode) == EA_ADDRESS_REG && size == 1) {
         size = 2;  // ADDQ.W #imm,An is equivalent to ADDQ.L #imm,An
     }
 
     JIT_EMIT_GET_OP1_IMMEDIATE(current_entry, count);
 
-    int cycles;
     ea_get(state, opcode, size, 1, &cycles, 2);
     if (cycles < 0) {
         return 1;
     }
 
-    const int do_cc = cc_needed(state, opcode);
+    do_cc = cc_needed(state, opcode);
     if (is_sub) {
         if (EA_MODE(opcode) == EA_ADDRESS_REG) {
             JIT_EMIT_SUB_L(current_entry);
@@ -2338,15 +2364,16 @@ static int opADSQ(Q68State *state, uint32_t opcode)
  */
 static int op_Scc(Q68State *state, uint32_t opcode)
 {
+    INSN_GET_COND;
+    int cycles;
+
     if (EA_MODE(opcode) == EA_ADDRESS_REG) {
         /* DBcc Dn,disp is coded as Scc An with an extension word */
         return opDBcc(state, opcode);
     }
 
-    INSN_GET_COND;
     /* From the cycle counts, it looks like this is a standard read/write
      * access rather than a write-only access */
-    int cycles;
     if (EA_MODE(opcode) == EA_DATA_REG) {
         cycles = 0;
     } else {
@@ -2398,11 +2425,12 @@ static int op_Bcc(Q68State *state, uint32_t opcode)
     INSN_GET_COND;
     INSN_GET_DISP8;
     int cycles = 0;
+    uint32_t target;
     if (disp == 0) {
         disp = (int16_t)IFETCH(state);
         cycles = 4;
     }
-    uint32_t target = state->current_PC + disp;
+    target = state->current_PC + disp;
     if (cond == COND_F) {
         /* BF is really BSR */
 #ifndef Q68_DISABLE_ADDRESS_ERROR
@@ -2462,8 +2490,9 @@ static int opMOVQ(Q68State *state, uint32_t opcode)
 {
     INSN_GET_REG;
     INSN_GET_IMM8;
+    int do_cc;
     JIT_EMIT_GET_OP1_IMMEDIATE(current_entry, imm8);
-    const int do_cc = cc_needed(state, opcode);
+    do_cc = cc_needed(state, opcode);
     JIT_EMIT_MOVE_L(current_entry);
     if (do_cc) JIT_EMIT_SETCC_LOGIC_L(current_entry);
     JIT_EMIT_SET_REGISTER_L(current_entry, reg*4);
@@ -2481,6 +2510,11 @@ static int op_alu(Q68State *state, uint32_t opcode)
 {
     INSN_GET_REG;
     INSN_GET_SIZE;
+    int ea_dest = opcode & 0x100;
+    int areg_dest = 0;  // For ADDA/SUBA/CMPA
+    enum {OR, AND, EOR, CMP, SUB, ADD} aluop;
+    int cycles;
+    int do_cc;
 
     /* Pass off special and invalid instructions early */
     if (size != 3) {
@@ -2506,10 +2540,6 @@ static int op_alu(Q68State *state, uint32_t opcode)
         }
     }
 
-    int ea_dest = opcode & 0x100;
-    int areg_dest = 0;  // For ADDA/SUBA/CMPA
-    enum {OR, AND, EOR, CMP, SUB, ADD} aluop;
-
     /* Find the instruction for the opcode group */
     switch (opcode>>12) {
         case 0x8: aluop = OR;  break;
@@ -2528,7 +2558,6 @@ static int op_alu(Q68State *state, uint32_t opcode)
 
     /* Retrieve the register and EA values; make sure to load operand 1
      * first, since operand 2 may be destroyed by memory operations */
-    int cycles;
     if (ea_dest) {
         JIT_EMIT_GET_OP1_REGISTER(current_entry, reg*4);
         ea_get(state, opcode, size, ea_dest, &cycles, 2);
@@ -2557,7 +2586,7 @@ static int op_alu(Q68State *state, uint32_t opcode)
     }
 
     /* Perform the actual computation */
-    const int do_cc = cc_needed(state, opcode);
+    do_cc = cc_needed(state, opcode);
     switch (aluop) {
         case OR:  if (size == SIZE_B) {
                       JIT_EMIT_OR_B(current_entry);
@@ -2709,15 +2738,16 @@ static int op_MUL(Q68State *state, uint32_t opcode)
 {
     INSN_GET_REG;
     const int sign = opcode & (1<<8);
-
     int cycles;
+    int do_cc;
+
     ea_get(state, opcode, SIZE_W, 0, &cycles, 1);
     if (cycles < 0) {
         return 1;
     }
     JIT_EMIT_GET_OP2_REGISTER(current_entry, reg*4);
 
-    const int do_cc = cc_needed(state, opcode);
+    do_cc = cc_needed(state, opcode);
     if (sign) {
         JIT_EMIT_MULS_W(current_entry);
     } else {
@@ -2890,6 +2920,8 @@ static int op4alu(Q68State *state, uint32_t opcode)
 {
     INSN_GET_SIZE;
     enum {NEGX = 0, CLR = 1, NEG = 2, NOT = 3, TST = 5} aluop;
+    int cycles;
+    int do_cc;
     aluop = opcode>>9 & 7;
 
     if (EA_MODE(opcode) == EA_ADDRESS_REG) {  // Address registers not allowed
@@ -2897,7 +2929,6 @@ static int op4alu(Q68State *state, uint32_t opcode)
     }
 
     /* Retrieve the EA value */
-    int cycles;
     ea_get(state, opcode, size, 1, &cycles, 1);
     if (cycles < 0) {
         return 1;
@@ -2921,7 +2952,7 @@ static int op4alu(Q68State *state, uint32_t opcode)
      *     n =  0 | n
      */
     JIT_EMIT_GET_OP2_IMMEDIATE(current_entry, aluop==NOT ? ~(uint32_t)0 : 0);
-    const int do_cc = cc_needed(state, opcode);
+    do_cc = cc_needed(state, opcode);
     switch (aluop) {
         case NEGX:if (size == SIZE_B) {
                       JIT_EMIT_SUBX_B(current_entry);
@@ -3000,6 +3031,7 @@ static int opMVSR(Q68State *state, uint32_t opcode)
     int is_CCR;
     int ea_dest;
     int cycles;
+    int cycles_tmp;
     switch (opcode>>9 & 3) {
       case 0:  // MOVE SR,<ea>
         is_CCR = 0;
@@ -3028,7 +3060,6 @@ static int opMVSR(Q68State *state, uint32_t opcode)
     /* Motorola docs say the address is read before being written, even
      * for the SR,<ea> format; also, the access size is a word even for
      * CCR operations. */
-    int cycles_tmp;
     ea_get(state, opcode, SIZE_W, ea_dest, &cycles_tmp, 1);
     if (cycles_tmp < 0) {
         return 1;
@@ -3068,11 +3099,12 @@ static int opMVSR(Q68State *state, uint32_t opcode)
  */
 static int opNBCD(Q68State *state, uint32_t opcode)
 {
+    int cycles;
+
     if (EA_MODE(opcode) == EA_ADDRESS_REG) {  // Address registers not allowed
         return op_ill(state, opcode);
     }
 
-    int cycles;
     ea_get(state, opcode, SIZE_B, 1, &cycles, 1);
     if (cycles < 0) {
         return 1;
@@ -3095,6 +3127,8 @@ static int opNBCD(Q68State *state, uint32_t opcode)
  */
 static int op_PEA(Q68State *state, uint32_t opcode)
 {
+    int cycles;
+
     /* SWAP is coded as PEA Dn */
     if (EA_MODE(opcode) == EA_DATA_REG) {
         return opSWAP(state, opcode);
@@ -3109,7 +3143,7 @@ static int op_PEA(Q68State *state, uint32_t opcode)
         return op_ill(state, opcode);
     }
 
-    int cycles = ea_resolve(state, opcode, SIZE_W, ACCESS_READ);
+    cycles = ea_resolve(state, opcode, SIZE_W, ACCESS_READ);
     if (cycles < 0) {
         return op_ill(state, opcode);
     }
@@ -3134,8 +3168,9 @@ static int op_PEA(Q68State *state, uint32_t opcode)
 static int opSWAP(Q68State *state, uint32_t opcode)
 {
     INSN_GET_REG0;
+    int do_cc;
     JIT_EMIT_GET_OP1_REGISTER(current_entry, reg0*4);
-    const int do_cc = cc_needed(state, opcode);
+    do_cc = cc_needed(state, opcode);
     JIT_EMIT_SWAP(current_entry);
     if (do_cc) JIT_EMIT_SETCC_LOGIC_L(current_entry);
     JIT_EMIT_SET_REGISTER_L(current_entry, reg0*4);
@@ -3151,11 +3186,12 @@ static int opSWAP(Q68State *state, uint32_t opcode)
  */
 static int op_TAS(Q68State *state, uint32_t opcode)
 {
+    int cycles;
+
     if (EA_MODE(opcode) == EA_ADDRESS_REG) {  // Address registers not allowed
         return op_ill(state, opcode);
     }
 
-    int cycles;
     ea_get(state, opcode, SIZE_B, 1, &cycles, 1);
     if (cycles < 0) {
         /* Note that the ILLEGAL instruction is coded as TAS #imm, so it
@@ -3177,8 +3213,9 @@ static int op_TAS(Q68State *state, uint32_t opcode)
 static int op_EXT(Q68State *state, uint32_t opcode)
 {
     INSN_GET_REG0;
+    int do_cc;
     JIT_EMIT_GET_OP1_REGISTER(current_entry, reg0*4);
-    const int do_cc = cc_needed(state, opcode);
+    do_cc = cc_needed(state, opcode);
     if (opcode & 0x0040) {
         JIT_EMIT_EXT_L(current_entry);
         if (do_cc) JIT_EMIT_SETCC_LOGIC_L(current_entry);
@@ -3200,13 +3237,18 @@ static int op_EXT(Q68State *state, uint32_t opcode)
  */
 static int op_STM(Q68State *state, uint32_t opcode)
 {
+    unsigned int regmask;
+    int size;
+    uint16_t safe_ea;
+    int cycles;
+
     /* EXT.* is coded as MOVEM.* reglist,Dn */
     if (EA_MODE(opcode) == EA_DATA_REG) {
         return op_EXT(state, opcode);
     }
 
-    unsigned int regmask = IFETCH(state);
-    int size = (opcode & 0x0040) ? SIZE_L : SIZE_W;
+    regmask = IFETCH(state);
+    size = (opcode & 0x0040) ? SIZE_L : SIZE_W;
     if (EA_MODE(opcode) <= EA_ADDRESS_REG
      || EA_MODE(opcode) == EA_POSTINCREMENT  // Not allowed for store
     ) {
@@ -3214,13 +3256,12 @@ static int op_STM(Q68State *state, uint32_t opcode)
     }
 
     /* Avoid modifying the register during address resolution */
-    uint16_t safe_ea;
     if (EA_MODE(opcode) == EA_PREDECREMENT) {
         safe_ea = EA_INDIRECT<<3 | EA_REG(opcode);
     } else {
         safe_ea = opcode;
     }
-    int cycles = ea_resolve(state, safe_ea, SIZE_W, ACCESS_WRITE);
+    cycles = ea_resolve(state, safe_ea, SIZE_W, ACCESS_WRITE);
     if (cycles < 0) {
         return op_ill(state, opcode);
     }
@@ -3275,6 +3316,9 @@ static int op_LDM(Q68State *state, uint32_t opcode)
 {
     unsigned int regmask = IFETCH(state);
     int size = (opcode & 0x0040) ? SIZE_L : SIZE_W;
+    uint16_t safe_ea;
+    int cycles;
+    int reg;
     if (EA_MODE(opcode) <= EA_ADDRESS_REG
      || EA_MODE(opcode) == EA_PREDECREMENT  // Not allowed for load
     ) {
@@ -3282,13 +3326,12 @@ static int op_LDM(Q68State *state, uint32_t opcode)
     }
 
     /* Avoid modifying the register during address resolution */
-    uint16_t safe_ea;
     if (EA_MODE(opcode) == EA_POSTINCREMENT) {
         safe_ea = EA_INDIRECT<<3 | EA_REG(opcode);
     } else {
         safe_ea = opcode;
     }
-    int cycles = ea_resolve(state, safe_ea, SIZE_W, ACCESS_READ);
+    cycles = ea_resolve(state, safe_ea, SIZE_W, ACCESS_READ);
     if (cycles < 0) {
         return op_ill(state, opcode);
     }
@@ -3299,7 +3342,6 @@ static int op_LDM(Q68State *state, uint32_t opcode)
 #endif
     }
 
-    int reg;
     for (reg = 0; reg < 16; reg++, regmask >>= 1) {
         if (regmask & 1) {
             if (size == SIZE_W) {
@@ -3398,8 +3440,8 @@ static int opUNLK(Q68State *state, uint32_t opcode)
  */
 static int opMUSP(Q68State *state, uint32_t opcode)
 {
-    JIT_EMIT_CHECK_SUPER(current_entry);
     INSN_GET_REG0;
+    JIT_EMIT_CHECK_SUPER(current_entry);
     if (opcode & 0x0008) {
         JIT_EMIT_MOVE_TO_USP(current_entry, reg0*4);
     } else {
@@ -3425,12 +3467,15 @@ static int op4E7x(Q68State *state, uint32_t opcode)
       case 1:  // $4E71 NOP
         JIT_EMIT_ADD_CYCLES(current_entry, 4);
         return 0;
-      case 2:  // $4E72 STOP
+      case 2: {  // $4E72 STOP
+        /* Fetch the new SR first so the PC update covers it */
+        const uint16_t new_SR = IFETCH(state);
         JIT_EMIT_CHECK_SUPER(current_entry);
         JIT_EMIT_ADD_CYCLES(current_entry, 4);
         advance_PC(state);
-        JIT_EMIT_STOP(current_entry, IFETCH(state));
+        JIT_EMIT_STOP(current_entry, new_SR);
         return 1;
+      }
       case 3: {  // $4E73 RTE
         JIT_EMIT_CHECK_SUPER(current_entry);
 #ifndef Q68_DISABLE_ADDRESS_ERROR
@@ -3586,10 +3631,11 @@ static int opADSX(Q68State *state, uint32_t opcode)
     const uint16_t dest_ea =
         (is_memory ? EA_PREDECREMENT : EA_DATA_REG) << 3 | reg;
     int dummy;
+    int do_cc;
     ea_get(state, src_ea,  size, 0, &dummy, 1);
     ea_get(state, dest_ea, size, 1, &dummy, 2);
 
-    const int do_cc = cc_needed(state, opcode);
+    do_cc = cc_needed(state, opcode);
     if (is_add) {
         if (size == SIZE_B) {
             JIT_EMIT_ADDX_B(current_entry);
@@ -3665,10 +3711,11 @@ static int opCMPM(Q68State *state, uint32_t opcode)
     const uint16_t src_ea  = EA_POSTINCREMENT<<3 | reg0;
     const uint16_t dest_ea = EA_POSTINCREMENT<<3 | reg;
     int dummy;
+    int do_cc;
     ea_get(state, src_ea,  size, 0, &dummy, 1);
     ea_get(state, dest_ea, size, 0, &dummy, 2);
 
-    const int do_cc = cc_needed(state, opcode);  // Just for consistency
+    do_cc = cc_needed(state, opcode);  // Just for consistency
     if (size == SIZE_B) {
         JIT_EMIT_SUB_B(current_entry);
         if (do_cc) JIT_EMIT_SETCC_CMP_B(current_entry);
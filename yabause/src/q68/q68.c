@@ -89,6 +89,12 @@ Q68State *q68_create_ex(void *(*malloc_func)(size_t size),
     state->malloc_func  = malloc_func;
     state->realloc_func = realloc_func;
     state->free_func    = free_func;
+    state->jit_malloc_func  = malloc_func;
+    state->jit_realloc_func = realloc_func;
+    state->jit_free_func    = free_func;
+
+    /* Dynamic translation is off until explicitly requested */
+    state->jit_enabled  = 0;
 
 #ifdef Q68_USE_JIT
     if (!q68_jit_init(state)) {
@@ -197,6 +203,65 @@ void q68_set_jit_flush_func(Q68State *state, void (*flush_func)(void))
     state->jit_flush   = flush_func;
 }
 
+/*-----------------------------------------------------------------------*/
+
+/**
+ * q68_set_jit_memory_funcs:  Set the functions used to allocate memory
+ * for translated code.  By default, the functions passed to q68_create_ex()
+ * are used.  Changing the functions discards all existing translations.
+ *
+ * [Parameters]
+ *            state: Processor state block
+ *      malloc_func: Function for allocating a memory block
+ *     realloc_func: Function for adjusting the size of a memory block
+ *        free_func: Function for freeing a memory block
+ * [Return value]
+ *     None
+ */
+void q68_set_jit_memory_funcs(Q68State *state,
+                              void *(*malloc_func)(size_t size),
+                              void *(*realloc_func)(void *ptr, size_t size),
+                              void (*free_func)(void *ptr))
+{
+#ifdef Q68_USE_JIT
+    q68_jit_reset(state);
+    state->jit_running = NULL;
+#endif
+    state->jit_malloc_func  = malloc_func;
+    state->jit_realloc_func = realloc_func;
+    state->jit_free_func    = free_func;
+}
+
+/*-----------------------------------------------------------------------*/
+
+/**
+ * q68_set_jit:  Enable or disable dynamic translation for the virtual
+ * processor.  Translation is disabled by default.  When enabling, the
+ * memory allocation functions for translated code (see
+ * q68_set_jit_memory_funcs()) must return memory which is executable by
+ * the native CPU.  Disabling discards all existing translations.
+ *
+ * [Parameters]
+ *      state: Processor state block
+ *     enable: Nonzero to enable dynamic translation, zero to disable
+ * [Return value]
+ *     Nonzero on success, zero if dynamic translation was requested but
+ *     is not supported in this build
+ */
+int q68_set_jit(Q68State *state, int enable)
+{
+#ifdef Q68_USE_JIT
+    if (!enable && state->jit_enabled) {
+        q68_jit_reset(state);
+        state->jit_running = NULL;
+    }
+    state->jit_enabled = (enable != 0);
+    return 1;
+#else
+    return !enable;
+#endif
+}
+
 /*************************************************************************/
 
 /**
@@ -153,6 +153,40 @@ extern void q68_set_writew_func(Q68State *state, Q68WriteFunc func);
  */
 extern void q68_set_jit_flush_func(Q68State *state, void (*flush_func)(void));
 
+/**
+ * q68_set_jit_memory_funcs:  Set the functions used to allocate memory
+ * for translated code.  By default, the functions passed to q68_create_ex()
+ * are used.  Changing the functions discards all existing translations.
+ *
+ * [Parameters]
+ *            state: Processor state block
+ *      malloc_func: Function for allocating a memory block
+ *     realloc_func: Function for adjusting the size of a memory block
+ *        free_func: Function for freeing a memory block
+ * [Return value]
+ *     None
+ */
+extern void q68_set_jit_memory_funcs(Q68State *state,
+                                     void *(*malloc_func)(size_t size),
+                                     void *(*realloc_func)(void *ptr, size_t size),
+                                     void (*free_func)(void *ptr));
+
+/**
+ * q68_set_jit:  Enable or disable dynamic translation for the virtual
+ * processor.  Translation is disabled by default.  When enabling, the
+ * memory allocation functions for translated code (see
+ * q68_set_jit_memory_funcs()) must return memory which is executable by
+ * the native CPU.  Disabling discards all existing translations.
+ *
+ * [Parameters]
+ *      state: Processor state block
+ *     enable: Nonzero to enable dynamic translation, zero to disable
+ * [Return value]
+ *     Nonzero on success, zero if dynamic translation was requested but
+ *     is not supported in this build
+ */
+extern int q68_set_jit(Q68State *state, int enable);
+
 /*----------------------------------*/
 
 /**
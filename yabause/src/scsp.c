@@ -88,13 +88,21 @@
 #include <stdarg.h>
 #include <math.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "c68k/c68k.h"
 #include "cs2.h"
 #include "debug.h"
 #include "error.h"
 #include "memory.h"
 #include "m68kcore.h"
+#include "m68kidle.h"
 #include "scu.h"
+#include "threads.h"
 #include "yabause.h"
 #include "scsp.h"
 
@@ -213,15 +221,15 @@ typedef struct slot_t
   s32 sr;       // sustain rate
   s32 rr;       // release rate
 
-  s32 *arp;     // attack rate table pointer
-  s32 *drp;     // decay rate table pointer
-  s32 *srp;     // sustain rate table pointer
-  s32 *rrp;     // release rate table pointer
+  const s32 *arp;     // attack rate table pointer
+  const s32 *drp;     // decay rate table pointer
+  const s32 *srp;     // sustain rate table pointer
+  const s32 *rrp;     // release rate table pointer
 
   u32 krs;      // key rate scale
 
-  s32 *lfofmw;  // lfo frequency modulation waveform pointer
-  s32 *lfoemw;  // lfo envelope modulation waveform pointer
+  const s16 *lfofmw;  // lfo frequency modulation waveform pointer
+  const u16 *lfoemw;  // lfo envelope modulation waveform pointer
   u8 lfofms;    // lfo frequency modulation sensitivity
   u8 lfoems;    // lfo envelope modulation sensitivity
   u8 fsft;      // frequency shift (used for freq lfo)
@@ -289,6 +297,8 @@ typedef struct scsp_t
   u32 mcieb;            // allow main cpu interrupt
   u32 mcipd;            // pending main cpu interrupt
 
+  u32 slot_active;      // bitmask of slots that may have a running envelope
+
   u8 *scsp_ram;         // scsp ram pointer
   void (*mintf)(void);  // main cpu interupt function pointer
   void (*sintf)(u32);   // sound cpu interrupt function pointer
@@ -299,25 +309,20 @@ typedef struct scsp_t
 
 ////////////////////////////////////////////////////////////////
 
-static s32 scsp_env_table[SCSP_ENV_LEN * 2];  // envelope curve table (attack & decay)
-
-static s32 scsp_lfo_sawt_e[SCSP_LFO_LEN];     // lfo sawtooth waveform for envelope
-static s32 scsp_lfo_squa_e[SCSP_LFO_LEN];     // lfo square waveform for envelope
-static s32 scsp_lfo_tri_e[SCSP_LFO_LEN];      // lfo triangle waveform for envelope
-static s32 scsp_lfo_noi_e[SCSP_LFO_LEN];      // lfo noise waveform for envelope
-
-static s32 scsp_lfo_sawt_f[SCSP_LFO_LEN];     // lfo sawtooth waveform for frequency
-static s32 scsp_lfo_squa_f[SCSP_LFO_LEN];     // lfo square waveform for frequency
-static s32 scsp_lfo_tri_f[SCSP_LFO_LEN];      // lfo triangle waveform for frequency
-static s32 scsp_lfo_noi_f[SCSP_LFO_LEN];      // lfo noise waveform frequency
-
-static s32 scsp_attack_rate[0x40 + 0x20];     // envelope step for attack
-static s32 scsp_decay_rate[0x40 + 0x20];      // envelope step for decay
-static s32 scsp_null_rate[0x20];              // null envelope step
+// Lookup tables generated at build time by scsptab/genscsptab:
+//
+//   scsp_env_table    envelope curve table (attack & decay)
+//   scsp_lfo_*_e      lfo waveforms for envelope (sawtooth, square,
+//                     triangle, noise)
+//   scsp_lfo_*_f      lfo waveforms for frequency
+//   scsp_attack_rate  envelope step for attack
+//   scsp_decay_rate   envelope step for decay
+//   scsp_lfo_step     directly give the lfo counter step
+//   scsp_tl_table     table of values for total level attentuation
 
-static s32 scsp_lfo_step[32];                 // directly give the lfo counter step
+#include "scsp_tables.inc"
 
-static s32 scsp_tl_table[256];                // table of values for total level attentuation
+static const s32 scsp_null_rate[0x20];        // null envelope step
 
 static u8 scsp_reg[0x1000];
 
@@ -332,6 +337,8 @@ static u32 scsp_buf_pos;
 
 static scsp_t   scsp;                         // SCSP structure
 
+static u8 m68k_idle;   // 68K spins in an idle loop until the next event
+
 #define CDDA_NUM_BUFFERS	2*75
 
 static union {
@@ -354,16 +361,6 @@ static void scsp_slot_update_keyon(slot_t *slot);
 static int scsp_mute_flags = 0;
 static int scsp_volume = 100;
 
-////////////////////////////////////////////////////////////////
-// Misc
-
-static int
-scsp_round (double val)
-{
-  return (int)(val + 0.5);
-}
-
-
 ////////////////////////////////////////////////////////////////
 // Interrupts
 
@@ -400,6 +397,7 @@ scsp_main_interrupt (u32 id)
 
   scsp.mcipd |= id;
   WRITE_THROUGH (scsp.mcipd);
+  m68k_idle = 0;
 
   if (scsp.mcieb & id)
     scsp_trigger_main_interrupt (id);
@@ -414,6 +412,7 @@ scsp_sound_interrupt (u32 id)
 
   scsp.scipd |= id;
   WRITE_THROUGH (scsp.scipd);
+  m68k_idle = 0;
 
   if (scsp.scieb & id)
     scsp_trigger_sound_interrupt (id);
@@ -480,6 +479,8 @@ scsp_slot_keyon (slot_t *slot)
       slot->ecurp = SCSP_ENV_ATTACK;  // current envelope phase is attack
       slot->ecmp = SCSP_ENV_AE;       // limit reach to next event (Attack End)
       slot->enxt = scsp_attack_next;  // function pointer to next event
+
+      scsp.slot_active |= 1U << (slot - &(scsp.slot[0]));
     }
 }
 
@@ -498,6 +499,10 @@ scsp_slot_keyoff (slot_t *slot)
       slot->ecmp = SCSP_ENV_DE;
       slot->ecurp = SCSP_ENV_RELEASE;
       slot->enxt = scsp_release_next;
+
+      // converting a finished attack brings the slot back to life
+      if (slot->ecnt < SCSP_ENV_DE)
+        scsp.slot_active |= 1U << (slot - &(scsp.slot[0]));
     }
 }
 
@@ -1694,62 +1699,181 @@ scsp_slot_update_null (slot_t *slot)
 }
 
 ////////////////////////////////////////////////////////////////
-// Normal 8 bits
+// Block mixing
+//
+// Without LFO the phase and envelope counters advance by a constant step,
+// so we know in advance how many samples can be generated before the next
+// loop point or envelope event. Those runs are fetched into small scratch
+// buffers and mixed several samples at a time; the sample on which an event
+// happens goes through the usual per-sample code.
+
+#define SCSP_MIX_BLOCK    64                                        // samples per run
 
 static void
-scsp_slot_update_8B_L (slot_t *slot)
+scsp_mix_block (s32 *buf, const s16 *out, const s16 *env, u32 len, u32 shift)
 {
-  s32 out;
+  u32 i = 0;
 
-  for (; scsp_buf_pos < scsp_buf_len; scsp_buf_pos++)
+#if defined(__AVX2__)
+  __m128i cnt = _mm_cvtsi32_si128 (shift);
+
+  for (; i + 8 <= len; i += 8)
     {
-      // env = [0..0x3FF] - slot->tl
-      SCSP_GET_OUT_8B
-      SCSP_GET_ENV
+      __m256i o = _mm256_cvtepi16_epi32 (_mm_loadu_si128 ((const __m128i *)&out[i]));
+      __m256i e = _mm256_cvtepi16_epi32 (_mm_loadu_si128 ((const __m128i *)&env[i]));
+      __m256i b = _mm256_loadu_si256 ((const __m256i *)&buf[i]);
 
-      // don't waste time if no sound...
-      SCSP_OUT_8B_L
+      o = _mm256_sra_epi32 (_mm256_mullo_epi32 (o, e), cnt);
+      _mm256_storeu_si256 ((__m256i *)&buf[i], _mm256_add_epi32 (b, o));
+    }
+#elif defined(__SSE2__)
+  __m128i cnt = _mm_cvtsi32_si128 (shift);
 
-      // calculate new frequency (phase) counter and enveloppe counter
-      SCSP_UPDATE_PHASE
-      SCSP_UPDATE_ENV
+  for (; i + 8 <= len; i += 8)
+    {
+      __m128i o = _mm_loadu_si128 ((const __m128i *)&out[i]);
+      __m128i e = _mm_loadu_si128 ((const __m128i *)&env[i]);
+      __m128i lo = _mm_mullo_epi16 (o, e);
+      __m128i hi = _mm_mulhi_epi16 (o, e);
+      __m128i b0 = _mm_loadu_si128 ((const __m128i *)&buf[i]);
+      __m128i b1 = _mm_loadu_si128 ((const __m128i *)&buf[i + 4]);
+
+      b0 = _mm_add_epi32 (b0, _mm_sra_epi32 (_mm_unpacklo_epi16 (lo, hi), cnt));
+      b1 = _mm_add_epi32 (b1, _mm_sra_epi32 (_mm_unpackhi_epi16 (lo, hi), cnt));
+      _mm_storeu_si128 ((__m128i *)&buf[i], b0);
+      _mm_storeu_si128 ((__m128i *)&buf[i + 4], b1);
     }
+#endif
+
+  // env is never negative without LFO, so a plain multiply matches
+  // SCSP_OUT_*'s "out && env > 0" test
+  for (; i < len; i++)
+    buf[i] += ((s32)out[i] * env[i]) >> shift;
 }
 
-static void
-scsp_slot_update_8B_R (slot_t *slot)
+static INLINE u32
+scsp_slot_run_len (slot_t *slot, s32 einc)
 {
-  s32 out;
+  u32 len = scsp_buf_len - scsp_buf_pos;
+  u32 n;
 
-  for (; scsp_buf_pos < scsp_buf_len; scsp_buf_pos++)
-    {
-      SCSP_GET_OUT_8B
-      SCSP_GET_ENV
+  if (len > SCSP_MIX_BLOCK)
+    len = SCSP_MIX_BLOCK;
 
-      SCSP_OUT_8B_R
+  // samples left before the phase counter passes the loop end
+  if (slot->fcnt > slot->lea)
+    return 0;
+  if (slot->finc)
+    {
+      n = (slot->lea - slot->fcnt) / slot->finc;
+      if (n < len) len = n;
+    }
 
-      SCSP_UPDATE_PHASE
-      SCSP_UPDATE_ENV
+  // samples left before the next envelope phase
+  if (slot->ecnt >= slot->ecmp || einc < 0)
+    return 0;
+  if (einc)
+    {
+      n = (u32)(slot->ecmp - 1 - slot->ecnt) / (u32)einc;
+      if (n < len) len = n;
     }
+
+  return len;
 }
 
-static void
-scsp_slot_update_8B_LR(slot_t *slot)
+static INLINE void
+scsp_slot_update_block (slot_t *slot, int pcm8b, int left, int right)
 {
+  s16 blk_out[SCSP_MIX_BLOCK];
+  s16 blk_env[SCSP_MIX_BLOCK];
+  u32 shl = pcm8b ? slot->disll - 8 : slot->disll;
+  u32 shr = pcm8b ? slot->dislr - 8 : slot->dislr;
   s32 out;
 
-  for (; scsp_buf_pos < scsp_buf_len; scsp_buf_pos++)
+  while (scsp_buf_pos < scsp_buf_len)
     {
-      SCSP_GET_OUT_8B
+      s32 einc = slot->einc ? *slot->einc : 0;
+      u32 len = scsp_slot_run_len (slot, einc);
+
+      if (len)
+        {
+          u32 fcnt = slot->fcnt;
+          s32 ecnt = slot->ecnt;
+          u32 i;
+
+          for (i = 0; i < len; i++)
+            {
+              if (pcm8b)
+#ifdef WORDS_BIGENDIAN
+                blk_out[i] = slot->buf8[fcnt >> SCSP_FREQ_LB];
+#else
+                blk_out[i] = slot->buf8[(fcnt >> SCSP_FREQ_LB) ^ 1];
+#endif
+              else
+                blk_out[i] = slot->buf16[fcnt >> SCSP_FREQ_LB];
+              blk_env[i] = scsp_env_table[ecnt >> SCSP_ENV_LB] * slot->tl / 1024;
+
+              fcnt += slot->finc;
+              ecnt += einc;
+            }
+
+          if (left)
+            scsp_mix_block (&scsp_bufL[scsp_buf_pos], blk_out, blk_env, len, shl);
+          if (right)
+            scsp_mix_block (&scsp_bufR[scsp_buf_pos], blk_out, blk_env, len, shr);
+
+          slot->env = blk_env[len - 1];
+          slot->fcnt = fcnt;
+          slot->ecnt = ecnt;
+          scsp_buf_pos += len;
+          continue;
+        }
+
+      // a loop or envelope event happens on this sample
+      if (pcm8b)
+        {
+          SCSP_GET_OUT_8B
+        }
+      else
+        {
+          SCSP_GET_OUT_16B
+        }
       SCSP_GET_ENV
 
-      SCSP_OUT_8B_LR
+      if ((out) && (slot->env > 0))
+        {
+          out *= slot->env;
+          if (left) scsp_bufL[scsp_buf_pos] += out >> shl;
+          if (right) scsp_bufR[scsp_buf_pos] += out >> shr;
+        }
 
       SCSP_UPDATE_PHASE
       SCSP_UPDATE_ENV
+      scsp_buf_pos++;
     }
 }
 
+////////////////////////////////////////////////////////////////
+// Normal 8 bits
+
+static void
+scsp_slot_update_8B_L (slot_t *slot)
+{
+  scsp_slot_update_block (slot, 1, 1, 0);
+}
+
+static void
+scsp_slot_update_8B_R (slot_t *slot)
+{
+  scsp_slot_update_block (slot, 1, 0, 1);
+}
+
+static void
+scsp_slot_update_8B_LR(slot_t *slot)
+{
+  scsp_slot_update_block (slot, 1, 1, 1);
+}
+
 ////////////////////////////////////////////////////////////////
 // Envelope LFO modulation 8 bits
 
@@ -1926,52 +2050,19 @@ static void scsp_slot_update_F_E_8B_LR(slot_t *slot)
 static void
 scsp_slot_update_16B_L (slot_t *slot)
 {
-  s32 out;
-
-  for (; scsp_buf_pos < scsp_buf_len; scsp_buf_pos++)
-    {
-      SCSP_GET_OUT_16B
-      SCSP_GET_ENV
-
-      SCSP_OUT_16B_L
-
-      SCSP_UPDATE_PHASE
-      SCSP_UPDATE_ENV
-    }
+  scsp_slot_update_block (slot, 0, 1, 0);
 }
 
 static void
 scsp_slot_update_16B_R (slot_t *slot)
 {
-  s32 out;
-
-  for (; scsp_buf_pos < scsp_buf_len; scsp_buf_pos++)
-    {
-      SCSP_GET_OUT_16B
-      SCSP_GET_ENV
-
-      SCSP_OUT_16B_R
-
-      SCSP_UPDATE_PHASE
-      SCSP_UPDATE_ENV
-    }
+  scsp_slot_update_block (slot, 0, 0, 1);
 }
 
 static void
 scsp_slot_update_16B_LR (slot_t *slot)
 {
-  s32 out;
-
-  for (; scsp_buf_pos < scsp_buf_len; scsp_buf_pos++)
-    {
-      SCSP_GET_OUT_16B
-      SCSP_GET_ENV
-
-      SCSP_OUT_16B_LR
-
-      SCSP_UPDATE_PHASE
-      SCSP_UPDATE_ENV
-    }
+  scsp_slot_update_block (slot, 0, 1, 1);
 }
 
 ////////////////////////////////////////////////////////////////
@@ -2280,13 +2371,20 @@ void
 scsp_update (s32 *bufL, s32 *bufR, u32 len)
 {
   slot_t *slot;
+  u32 active;
 
   scsp_bufL = bufL;
   scsp_bufR = bufR;
 
-  for (slot = &(scsp.slot[0]); slot < &(scsp.slot[32]); slot++)
+  for (slot = &(scsp.slot[0]), active = scsp.slot_active; active;
+       slot++, active >>= 1)
     {
-      if (slot->ecnt >= SCSP_ENV_DE) continue; // enveloppe null...
+      if (!(active & 1)) continue;
+      if (slot->ecnt >= SCSP_ENV_DE) // enveloppe null...
+        {
+          scsp.slot_active &= ~(1U << (slot - &(scsp.slot[0])));
+          continue;
+        }
 
       if (slot->ssctl)
         {
@@ -2566,6 +2664,7 @@ scsp_midi_out_read (void)
 void FASTCALL
 scsp_w_b (u32 a, u8 d)
 {
+  m68k_idle = 0;
   a &= 0xFFF;
 
   if (a < 0x400)
@@ -2602,6 +2701,8 @@ scsp_w_b (u32 a, u8 d)
 void FASTCALL
 scsp_w_w (u32 a, u16 d)
 {
+  m68k_idle = 0;
+
   if (a & 1)
     {
       SCSPLOG ("ERROR: scsp w_w misaligned : %.8X\n", a);
@@ -2643,6 +2744,8 @@ scsp_w_w (u32 a, u16 d)
 void FASTCALL
 scsp_w_d (u32 a, u32 d)
 {
+  m68k_idle = 0;
+
   if (a & 3)
     {
       SCSPLOG ("ERROR: scsp w_d misaligned : %.8X\n", a);
@@ -2838,13 +2941,14 @@ scsp_reset (void)
 		slot->lfofmw = scsp_lfo_sawt_f;
 		slot->lfoemw = scsp_lfo_sawt_e;
     }
+
+  scsp.slot_active = 0;
 }
 
 void
 scsp_init (u8 *scsp_ram, void (*sint_hand)(u32), void (*mint_hand)(void))
 {
-  u32 i, j;
-  double x;
+  u32 i;
 
   scsp_shutdown ();
 
@@ -2856,100 +2960,6 @@ scsp_init (u8 *scsp_ram, void (*sint_hand)(u32), void (*mint_hand)(void))
   scsp.sintf = sint_hand;
   scsp.mintf = mint_hand;
 
-  for (i = 0; i < SCSP_ENV_LEN; i++)
-    {
-      // Attack Curve (x^7 ?)
-      x = pow (((double)(SCSP_ENV_MASK - i) / (double)SCSP_ENV_LEN), 7);
-      x *= (double)SCSP_ENV_LEN;
-      scsp_env_table[i] = SCSP_ENV_MASK - (s32)x;
-
-      // Decay curve (x = linear)
-      x = pow (((double)i / (double)SCSP_ENV_LEN), 1);
-      x *= (double)SCSP_ENV_LEN;
-      scsp_env_table[i + SCSP_ENV_LEN] = SCSP_ENV_MASK - (s32)x;
-    }
-
-  for (i = 0, j = 0; i < 32; i++)
-    {
-      j += 1 << (i >> 2);
-
-      // lfo freq
-      x = (SCSP_FREQ / 256.0) / (double)j;
-
-      // converting lfo freq in lfo step
-      scsp_lfo_step[31 - i] = scsp_round(x * ((double)SCSP_LFO_LEN /
-                                              (double)SCSP_FREQ) *
-                                         (double)(1 << SCSP_LFO_LB));
-    }
-
-  // Calculate LFO (modulation) values
-  for (i = 0; i < SCSP_LFO_LEN; i++)
-    {
-      // Envelope modulation
-      scsp_lfo_sawt_e[i] = SCSP_LFO_MASK - i;
-
-      if (i < (SCSP_LFO_LEN / 2))
-        scsp_lfo_squa_e[i] = SCSP_LFO_MASK;
-      else
-        scsp_lfo_squa_e[i] = 0;
-
-      if (i < (SCSP_LFO_LEN / 2))
-        scsp_lfo_tri_e[i] = SCSP_LFO_MASK - (i * 2);
-      else
-        scsp_lfo_tri_e[i] = (i - (SCSP_LFO_LEN / 2)) * 2;
-
-      scsp_lfo_noi_e[i] = rand() & SCSP_LFO_MASK;
-
-      // Frequency modulation
-      scsp_lfo_sawt_f[(i + 512) & SCSP_LFO_MASK] = i - (SCSP_LFO_LEN / 2);
-
-      if (i < (SCSP_LFO_LEN / 2))
-        scsp_lfo_squa_f[i] = SCSP_LFO_MASK - (SCSP_LFO_LEN / 2) - 128;
-      else
-        scsp_lfo_squa_f[i] = 0 - (SCSP_LFO_LEN / 2) + 128;
-
-      if (i < (SCSP_LFO_LEN / 2))
-        scsp_lfo_tri_f[(i + 768) & SCSP_LFO_MASK] = (i * 2) -
-                                                    (SCSP_LFO_LEN / 2);
-      else
-        scsp_lfo_tri_f[(i + 768) & SCSP_LFO_MASK] =
-          (SCSP_LFO_MASK - ((i - (SCSP_LFO_LEN / 2)) * 2)) -
-          (SCSP_LFO_LEN / 2) + 1;
-
-      scsp_lfo_noi_f[i] = scsp_lfo_noi_e[i] - (SCSP_LFO_LEN / 2);
-    }
-
-  for(i = 0; i < 4; i++)
-    {
-      scsp_attack_rate[i] = 0;
-      scsp_decay_rate[i] = 0;
-    }
-
-  for(i = 0; i < 60; i++)
-    {
-      x = 1.0 + ((i & 3) * 0.25);                  // bits 0-1 : x1.00, x1.25, x1.50, x1.75
-      x *= (double)(1 << ((i >> 2)));              // bits 2-5 : shift bits (x2^0 - x2^15)
-      x *= (double)(SCSP_ENV_LEN << SCSP_ENV_LB);  // adjust for table scsp_env_table
-
-      scsp_attack_rate[i + 4] = scsp_round(x / (double)SCSP_ATTACK_R);
-      scsp_decay_rate[i + 4] = scsp_round(x / (double)SCSP_DECAY_R);
-
-      if (scsp_attack_rate[i + 4] == 0) scsp_attack_rate[i + 4] = 1;
-      if (scsp_decay_rate[i + 4] == 0) scsp_decay_rate[i + 4] = 1;
-    }
-
-  scsp_attack_rate[63] = SCSP_ENV_AE;
-  scsp_decay_rate[61] = scsp_decay_rate[60];
-  scsp_decay_rate[62] = scsp_decay_rate[60];
-  scsp_decay_rate[63] = scsp_decay_rate[60];
-
-  for(i = 64; i < 96; i++)
-    {
-      scsp_attack_rate[i] = scsp_attack_rate[63];
-      scsp_decay_rate[i] = scsp_decay_rate[63];
-      scsp_null_rate[i - 64] = 0;
-    }
-
   for(i = 0; i < 96; i++)
     {
       SCSPLOG ("attack rate[%d] = %.8X -> %.8X\n", i, scsp_attack_rate[i],
@@ -2958,9 +2968,6 @@ scsp_init (u8 *scsp_ram, void (*sint_hand)(u32), void (*mint_hand)(void))
                scsp_decay_rate[i] >> SCSP_ENV_LB);
     }
 
-  for(i = 0; i < 256; i++)
-    scsp_tl_table[i] = scsp_round(pow(10, ((double)i * -0.3762) / 20) * 1024.0);
-
   scsp_reset();
 }
 
@@ -3010,6 +3017,88 @@ static u8 IsM68KRunning;
 static s32 FASTCALL (*m68kexecptr)(s32 cycles);  // M68K->Exec or M68KExecBP
 static s32 savedcycles;  // Cycles left over from the last M68KExec() call
 
+//////////////////////////////////////////////////////////////////////////////
+// Sound thread
+//
+// When yabsys.UseThreads is set, the 68K and all sample generation run on
+// their own thread (YAB_THREAD_SCSP) and the emulation thread never touches
+// the SCSP state directly. Instead it appends commands to a single-producer/
+// single-consumer ring:
+//
+//   - M68KExec() and ScspExec() push "run the 68K" and "end of line"
+//     commands, stamped with the emulation thread's line counter;
+//   - main CPU writes to SCSP registers and sound RAM are pushed in between,
+//     so the sound thread applies them at the same point relative to 68K
+//     execution as the synchronous code does.
+//
+// The sound thread is allowed to lag by at most SCSP_THREAD_MAX_LAG lines.
+// Main CPU register reads are answered from a shadow copy of the register
+// file, which the sound thread refreshes whenever it has caught up; sound
+// RAM reads first wait for queued sound RAM writes to land. Anything else
+// that needs the real state (save states, reset, debugger...) drains the
+// ring with ScspSyncThread() first.
+
+#define SCSP_RING_SIZE       4096                 // must be a power of 2
+#define SCSP_RING_MASK       (SCSP_RING_SIZE - 1)
+#define SCSP_THREAD_MAX_LAG  16                   // lines
+
+#ifdef __GNUC__
+# define SCSP_THREAD_SUPPORTED
+# define SCSP_BARRIER()  __sync_synchronize()
+# define SCSP_LOCK(l)    while (__sync_lock_test_and_set(&(l), 1)) YabThreadYield()
+# define SCSP_UNLOCK(l)  __sync_lock_release(&(l))
+#else
+// No way to order the ring accesses here, so ScspInit() never starts the
+// sound thread and these are never reached
+# define SCSP_BARRIER()  /*nothing*/
+# define SCSP_LOCK(l)    /*nothing*/
+# define SCSP_UNLOCK(l)  /*nothing*/
+#endif
+
+enum
+{
+  SCSP_CMD_EXEC68K,     // data = 68K cycles to run
+  SCSP_CMD_LINE,        // end of scanline
+  SCSP_CMD_REG_B,       // main CPU register writes
+  SCSP_CMD_REG_W,
+  SCSP_CMD_REG_L,
+  SCSP_CMD_RAM_B,       // main CPU sound RAM writes
+  SCSP_CMD_RAM_W,
+  SCSP_CMD_RAM_L
+};
+
+typedef struct
+{
+  u32 cmd;
+  u32 stamp;            // emulation thread line counter when pushed
+  u32 addr;
+  u32 data;
+} scsp_cmd_t;
+
+static scsp_cmd_t scsp_ring[SCSP_RING_SIZE];
+static volatile u32 scsp_ring_head;         // next entry to fill (emulation thread)
+static volatile u32 scsp_ring_tail;         // next entry to run (sound thread)
+static volatile u32 scsp_line_stamp;        // lines pushed
+static volatile u32 scsp_line_done;         // lines completed by the sound thread
+static volatile u32 scsp_ram_queued;        // sound RAM writes pushed
+static volatile u32 scsp_ram_done;          // sound RAM writes applied
+
+static volatile u8 scsp_thread_running;
+static volatile u8 scsp_thread_stopped;
+static volatile u8 scsp_thread_sleeping;
+static volatile u8 scsp_main_irq_pending;   // SCU interrupt raised by the sound thread
+
+static u8 scsp_shadow_isr[0x400];           // slot registers, same layout as scsp_isr
+static u8 scsp_shadow_ccr_b[0x40];          // scsp_r_b() results for $400-$43F
+static u16 scsp_shadow_ccr_w[0x20];         // scsp_r_w() results for $400-$43E
+static volatile int scsp_shadow_lock;
+
+static void ScspDoExec (void);
+static void M68KDoExec (s32 cycles);
+static void FASTCALL SoundRamWriteByteDirect (u32 addr, u8 val);
+static void FASTCALL SoundRamWriteWordDirect (u32 addr, u16 val);
+static void FASTCALL SoundRamWriteLongDirect (u32 addr, u32 val);
+
 //////////////////////////////////////////////////////////////////////////////
 
 static u32 FASTCALL
@@ -3069,15 +3158,250 @@ c68k_interrupt_handler (u32 level)
 static void
 scu_interrupt_handler (void)
 {
+  // the SCU belongs to the emulation thread, let it deliver the interrupt
+  if (scsp_thread_running)
+    {
+      scsp_main_irq_pending = 1;
+      return;
+    }
+
   // send interrupt to scu
   ScuSendSoundRequest ();
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
+static void
+scsp_thread_push (u32 cmd, u32 addr, u32 data)
+{
+  u32 head = scsp_ring_head;
+  scsp_cmd_t *c;
+
+  // wait for the sound thread to free an entry
+  while (head - scsp_ring_tail >= SCSP_RING_SIZE)
+    {
+      YabThreadWake (YAB_THREAD_SCSP);
+      YabThreadYield ();
+    }
+
+  c = &scsp_ring[head & SCSP_RING_MASK];
+  c->cmd = cmd;
+  c->stamp = scsp_line_stamp;
+  c->addr = addr;
+  c->data = data;
+
+  SCSP_BARRIER ();
+  scsp_ring_head = head + 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void
+scsp_thread_deliver_irq (void)
+{
+  if (scsp_main_irq_pending)
+    {
+      scsp_main_irq_pending = 0;
+      ScuSendSoundRequest ();
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Wait until the sound thread has run everything that was pushed. Once this
+// returns, the emulation thread may access the SCSP/68K state directly until
+// it pushes a new command.
+static void
+ScspSyncThread (void)
+{
+  while (scsp_ring_tail != scsp_ring_head)
+    {
+      YabThreadWake (YAB_THREAD_SCSP);
+      YabThreadYield ();
+    }
+
+  SCSP_BARRIER ();
+  scsp_thread_deliver_irq ();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Refresh the main CPU view of the registers. Only done when no main CPU
+// write is in flight, so a write followed by a read still returns the
+// written value.
+static void
+scsp_shadow_update (void)
+{
+  u32 a;
+
+  SCSP_LOCK (scsp_shadow_lock);
+
+  if (scsp_ring_tail == scsp_ring_head)
+    {
+      memcpy (scsp_shadow_isr, scsp_isr, sizeof(scsp_shadow_isr));
+
+      for (a = 0; a < 0x40; a++)
+        {
+          // MIDI buffers are consumed by the read, see ScspReadByte()
+          if (a >= 0x04 && a < 0x08)
+            continue;
+          scsp_shadow_ccr_b[a] = scsp_r_b (0x400 + a);
+          if (!(a & 1))
+            scsp_shadow_ccr_w[a >> 1] = scsp_r_w (0x400 + a);
+        }
+    }
+
+  SCSP_UNLOCK (scsp_shadow_lock);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Apply a main CPU byte write to $400-$43F to the shadow the way
+// scsp_set_b() would, so that reads don't return the old value until the
+// sound thread catches up (MCIPD right after an MCIRE acknowledge, for
+// instance). Called with scsp_shadow_lock held.
+static void
+scsp_shadow_ccr_write (u32 a, u8 d)
+{
+  u32 w;
+
+  a &= 0x3F;
+
+  switch (a)
+    {
+    case 0x04: // MIDI, read with a sync
+    case 0x05:
+    case 0x06:
+    case 0x07:
+    case 0x08: // CA/SGC/EG, not what was written
+    case 0x09:
+    case 0x20: // SCIPD(high byte)
+    case 0x2C: // MCIPD(high byte)
+      return;
+
+    case 0x01: // VER/MVOL
+      scsp_shadow_ccr_b[a] = d & 0x0F;
+      break;
+
+    case 0x21: // SCIPD(low byte)
+    case 0x2D: // MCIPD(low byte)
+      scsp_shadow_ccr_b[a] |= d & 0x20;
+      break;
+
+    case 0x22: // SCIRE
+    case 0x23:
+    case 0x2E: // MCIRE
+    case 0x2F:
+      scsp_shadow_ccr_b[a] = d;
+      scsp_shadow_ccr_b[a - 2] &= ~d;
+      w = (a - 2) & 0x3E;
+      scsp_shadow_ccr_w[w >> 1] = (scsp_shadow_ccr_b[w] << 8) | scsp_shadow_ccr_b[w + 1];
+      break;
+
+    default:
+      scsp_shadow_ccr_b[a] = d;
+      break;
+    }
+
+  w = a & 0x3E;
+  if (w == 0x18 || w == 0x1A || w == 0x1C)
+    scsp_shadow_ccr_w[w >> 1] = (scsp_shadow_ccr_b[w] & 7) << 8;  // TxCTL only
+  else
+    scsp_shadow_ccr_w[w >> 1] = (scsp_shadow_ccr_b[w] << 8) | scsp_shadow_ccr_b[w + 1];
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void
+ScspThread (UNUSED void *arg)
+{
+  while (scsp_thread_running)
+    {
+      u32 tail = scsp_ring_tail;
+      scsp_cmd_t *c;
+
+      if (tail == scsp_ring_head)
+        {
+          // caught up, publish the registers and wait for more work
+          scsp_shadow_update ();
+
+          scsp_thread_sleeping = 1;
+          SCSP_BARRIER ();
+          if (scsp_ring_tail == scsp_ring_head && scsp_thread_running)
+            YabThreadSleep ();
+          scsp_thread_sleeping = 0;
+          continue;
+        }
+
+      SCSP_BARRIER ();
+      c = &scsp_ring[tail & SCSP_RING_MASK];
+
+      switch (c->cmd)
+        {
+        case SCSP_CMD_EXEC68K:
+          M68KDoExec ((s32)c->data);
+          break;
+        case SCSP_CMD_LINE:
+          ScspDoExec ();
+          scsp_line_done = c->stamp;
+          break;
+        case SCSP_CMD_REG_B:
+          scsp_w_b (c->addr, (u8)c->data);
+          break;
+        case SCSP_CMD_REG_W:
+          scsp_w_w (c->addr, (u16)c->data);
+          break;
+        case SCSP_CMD_REG_L:
+          scsp_w_d (c->addr, c->data);
+          break;
+        case SCSP_CMD_RAM_B:
+          SoundRamWriteByteDirect (c->addr, (u8)c->data);
+          scsp_ram_done++;
+          break;
+        case SCSP_CMD_RAM_W:
+          SoundRamWriteWordDirect (c->addr, (u16)c->data);
+          scsp_ram_done++;
+          break;
+        case SCSP_CMD_RAM_L:
+          SoundRamWriteLongDirect (c->addr, c->data);
+          scsp_ram_done++;
+          break;
+        }
+
+      SCSP_BARRIER ();
+      scsp_ring_tail = tail + 1;
+    }
+
+  scsp_thread_stopped = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void
+ScspStopThread (void)
+{
+  if (!scsp_thread_running)
+    return;
+
+  ScspSyncThread ();
+
+  scsp_thread_running = 0;
+  while (!scsp_thread_stopped)
+    {
+      YabThreadWake (YAB_THREAD_SCSP);
+      YabThreadYield ();
+    }
+  YabThreadWait (YAB_THREAD_SCSP);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 u8 FASTCALL
 SoundRamReadByte (u32 addr)
 {
+  if (scsp_thread_running && scsp_ram_done != scsp_ram_queued)
+    ScspSyncThread ();
+
   addr &= 0xFFFFF;
 
   // If mem4b is set, mirror ram every 256k
@@ -3094,6 +3418,22 @@ SoundRamReadByte (u32 addr)
 void FASTCALL
 SoundRamWriteByte (u32 addr, u8 val)
 {
+  if (scsp_thread_running)
+    {
+      scsp_ram_queued++;
+      scsp_thread_push (SCSP_CMD_RAM_B, addr, val);
+      return;
+    }
+
+  SoundRamWriteByteDirect (addr, val);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void FASTCALL
+SoundRamWriteByteDirect (u32 addr, u8 val)
+{
+  m68k_idle = 0;
   addr &= 0xFFFFF;
 
   // If mem4b is set, mirror ram every 256k
@@ -3111,6 +3451,9 @@ SoundRamWriteByte (u32 addr, u8 val)
 u16 FASTCALL
 SoundRamReadWord (u32 addr)
 {
+  if (scsp_thread_running && scsp_ram_done != scsp_ram_queued)
+    ScspSyncThread ();
+
   addr &= 0xFFFFF;
 
   if (scsp.mem4b == 0)
@@ -3126,6 +3469,22 @@ SoundRamReadWord (u32 addr)
 void FASTCALL
 SoundRamWriteWord (u32 addr, u16 val)
 {
+  if (scsp_thread_running)
+    {
+      scsp_ram_queued++;
+      scsp_thread_push (SCSP_CMD_RAM_W, addr, val);
+      return;
+    }
+
+  SoundRamWriteWordDirect (addr, val);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void FASTCALL
+SoundRamWriteWordDirect (u32 addr, u16 val)
+{
+  m68k_idle = 0;
   addr &= 0xFFFFF;
 
   // If mem4b is set, mirror ram every 256k
@@ -3143,6 +3502,9 @@ SoundRamWriteWord (u32 addr, u16 val)
 u32 FASTCALL
 SoundRamReadLong (u32 addr)
 {
+  if (scsp_thread_running && scsp_ram_done != scsp_ram_queued)
+    ScspSyncThread ();
+
   addr &= 0xFFFFF;
 
   // If mem4b is set, mirror ram every 256k
@@ -3159,6 +3521,22 @@ SoundRamReadLong (u32 addr)
 void FASTCALL
 SoundRamWriteLong (u32 addr, u32 val)
 {
+  if (scsp_thread_running)
+    {
+      scsp_ram_queued++;
+      scsp_thread_push (SCSP_CMD_RAM_L, addr, val);
+      return;
+    }
+
+  SoundRamWriteLongDirect (addr, val);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void FASTCALL
+SoundRamWriteLongDirect (u32 addr, u32 val)
+{
+  m68k_idle = 0;
   addr &= 0xFFFFF;
 
   // If mem4b is set, mirror ram every 256k
@@ -3173,6 +3551,168 @@ SoundRamWriteLong (u32 addr, u32 val)
 
 //////////////////////////////////////////////////////////////////////////////
 
+u8 FASTCALL
+ScspReadByte (u32 addr)
+{
+  u32 a = addr & 0xFFF;
+  u8 val;
+
+  if (scsp_thread_running)
+    {
+      // MIDI buffers are consumed by the read, and nothing past $43F is
+      // shadowed: those go to the SCSP once the sound thread is idle
+      if (a >= 0x440 || (a >= 0x404 && a < 0x408))
+        ScspSyncThread ();
+      else
+        {
+          SCSP_LOCK (scsp_shadow_lock);
+          if (a < 0x400)
+            {
+              val = scsp_shadow_isr[a ^ 3];
+              if ((a & 0x1F) == 0x00) val &= 0xEF;  // Mask out keyonx
+            }
+          else
+            val = scsp_shadow_ccr_b[a & 0x3F];
+          SCSP_UNLOCK (scsp_shadow_lock);
+          return val;
+        }
+    }
+
+  return scsp_r_b (addr);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+u16 FASTCALL
+ScspReadWord (u32 addr)
+{
+  u32 a = addr & 0xFFE;
+  u16 val;
+
+  if (scsp_thread_running)
+    {
+      if (a >= 0x440 || (a >= 0x404 && a < 0x408))
+        ScspSyncThread ();
+      else
+        {
+          SCSP_LOCK (scsp_shadow_lock);
+          if (a < 0x400)
+            {
+              val = *(u16 *)&scsp_shadow_isr[a ^ 2];
+              if ((a & 0x1E) == 0x00) val &= 0xEFFF;
+            }
+          else
+            val = scsp_shadow_ccr_w[(a & 0x3E) >> 1];
+          SCSP_UNLOCK (scsp_shadow_lock);
+          return val;
+        }
+    }
+
+  return scsp_r_w (addr);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+u32 FASTCALL
+ScspReadLong (u32 addr)
+{
+  if (scsp_thread_running)
+    return ((u32)ScspReadWord (addr) << 16) | ScspReadWord (addr + 2);
+
+  return scsp_r_d (addr);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// The shadow is updated after the push, so that the sound thread can't
+// publish an older value over it once the write has been queued.
+
+void FASTCALL
+ScspWriteByte (u32 addr, u8 val)
+{
+  u32 a = addr & 0xFFF;
+
+  if (scsp_thread_running)
+    {
+      scsp_thread_push (SCSP_CMD_REG_B, addr, val);
+      if (a < 0x440)
+        {
+          SCSP_LOCK (scsp_shadow_lock);
+          if (a < 0x400)
+            scsp_shadow_isr[a ^ 3] = val;
+          else
+            scsp_shadow_ccr_write (a, val);
+          SCSP_UNLOCK (scsp_shadow_lock);
+        }
+      return;
+    }
+
+  scsp_w_b (addr, val);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void FASTCALL
+ScspWriteWord (u32 addr, u16 val)
+{
+  u32 a = addr & 0xFFE;
+
+  if (scsp_thread_running)
+    {
+      scsp_thread_push (SCSP_CMD_REG_W, addr, val);
+      if (a < 0x440)
+        {
+          SCSP_LOCK (scsp_shadow_lock);
+          if (a < 0x400)
+            *(u16 *)&scsp_shadow_isr[a ^ 2] = val;
+          else
+            {
+              scsp_shadow_ccr_write (a, val >> 8);
+              scsp_shadow_ccr_write (a + 1, val & 0xFF);
+            }
+          SCSP_UNLOCK (scsp_shadow_lock);
+        }
+      return;
+    }
+
+  scsp_w_w (addr, val);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void FASTCALL
+ScspWriteLong (u32 addr, u32 val)
+{
+  u32 a = addr & 0xFFC;
+
+  if (scsp_thread_running)
+    {
+      scsp_thread_push (SCSP_CMD_REG_L, addr, val);
+      if (a < 0x440)
+        {
+          SCSP_LOCK (scsp_shadow_lock);
+          if (a < 0x400)
+            {
+              *(u16 *)&scsp_shadow_isr[a ^ 2] = val >> 16;
+              *(u16 *)&scsp_shadow_isr[(a + 2) ^ 2] = val & 0xFFFF;
+            }
+          else
+            {
+              scsp_shadow_ccr_write (a, val >> 24);
+              scsp_shadow_ccr_write (a + 1, (val >> 16) & 0xFF);
+              scsp_shadow_ccr_write (a + 2, (val >> 8) & 0xFF);
+              scsp_shadow_ccr_write (a + 3, val & 0xFF);
+            }
+          SCSP_UNLOCK (scsp_shadow_lock);
+        }
+      return;
+    }
+
+  scsp_w_d (addr, val);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 int
 ScspInit (int coreid)
 {
@@ -3224,7 +3764,29 @@ ScspInit (int coreid)
   scspsoundoutleft = 0;
   scspframeaccurate = 0;
 
-  return ScspChangeSoundCore (coreid);
+  if (ScspChangeSoundCore (coreid) != 0)
+    return -1;
+
+#ifdef SCSP_THREAD_SUPPORTED
+  if (yabsys.UseThreads)
+    {
+      scsp_ring_head = scsp_ring_tail = 0;
+      scsp_line_stamp = scsp_line_done = 0;
+      scsp_ram_queued = scsp_ram_done = 0;
+      scsp_main_irq_pending = 0;
+      scsp_thread_stopped = 0;
+      scsp_shadow_update ();
+
+      scsp_thread_running = 1;
+      if (YabThreadStart (YAB_THREAD_SCSP, ScspThread, NULL) < 0)
+        {
+          SCSPLOG ("Failed to start SCSP thread, running synchronously\n");
+          scsp_thread_running = 0;
+        }
+    }
+#endif
+
+  return 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -3234,6 +3796,9 @@ ScspChangeSoundCore (int coreid)
 {
   int i;
 
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   // Make sure the old core is freed
   if (SNDCore)
     SNDCore->DeInit();
@@ -3293,6 +3858,8 @@ ScspSetFrameAccurate (int on)
 void
 ScspDeInit (void)
 {
+  ScspStopThread ();
+
   if (scspchannel[0].data32)
     free(scspchannel[0].data32);
   scspchannel[0].data32 = NULL;
@@ -3317,8 +3884,12 @@ ScspDeInit (void)
 void
 M68KStart (void)
 {
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   M68K->Reset ();
   savedcycles = 0;
+  m68k_idle = 0;
   IsM68KRunning = 1;
 }
 
@@ -3327,6 +3898,9 @@ M68KStart (void)
 void
 M68KStop (void)
 {
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   IsM68KRunning = 0;
 }
 
@@ -3335,7 +3909,13 @@ M68KStop (void)
 void
 ScspReset (void)
 {
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   scsp_reset();
+
+  if (scsp_thread_running)
+    scsp_shadow_update ();
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -3343,6 +3923,9 @@ ScspReset (void)
 int
 ScspChangeVideoFormat (int type)
 {
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   scspsoundlen = 44100 / (type ? 50 : 60);
   scsplines = type ? 313 : 263;
   scspsoundbufsize = scspsoundlen * scspsoundbufs;
@@ -3366,6 +3949,20 @@ static s32 FASTCALL M68KExecBP (s32 cycles);
 
 void
 M68KExec (s32 cycles)
+{
+  if (scsp_thread_running)
+    {
+      scsp_thread_push (SCSP_CMD_EXEC68K, 0, (u32)cycles);
+      return;
+    }
+
+  M68KDoExec (cycles);
+}
+
+//----------------------------------------------------------------------------
+
+static void
+M68KDoExec (s32 cycles)
 {
   s32 newcycles = savedcycles - cycles;
   if (LIKELY(IsM68KRunning))
@@ -3373,7 +3970,20 @@ M68KExec (s32 cycles)
       if (LIKELY(newcycles < 0))
         {
           s32 cyclestoexec = -newcycles;
-          newcycles += (*m68kexecptr)(cyclestoexec);
+          s32 idlecycles;
+
+          if (m68k_idle)
+            newcycles = 0;
+          else
+            {
+              newcycles += (*m68kexecptr)(cyclestoexec);
+              // breakpoints need every instruction to be executed
+              if (m68kexecptr == M68K->Exec)
+                {
+                  m68k_idle = M68KIdleCheck (&idlecycles);
+                  newcycles += idlecycles;
+                }
+            }
         }
       savedcycles = newcycles;
     }
@@ -3415,6 +4025,9 @@ M68KExecBP (s32 cycles)
 void
 M68KStep (void)
 {
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   M68K->Exec(1);
 }
 
@@ -3424,6 +4037,10 @@ M68KStep (void)
 void
 M68KSync (void)
 {
+  // the sound thread owns the 68K, and is kept in check by ScspExec()
+  if (scsp_thread_running)
+    return;
+
   M68K->Sync();
 }
 
@@ -3465,6 +4082,9 @@ ScspConvert32uto16s (s32 *srcL, s32 *srcR, s16 *dst, u32 len)
 void
 ScspReceiveCDDA (const u8 *sector)
 {	
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
    // If buffer is half empty or less, boost timing for a bit until we've buffered a few sectors
    if (cdda_out_left < (sizeof(cddabuf.data) / 2))
    {
@@ -3499,6 +4119,33 @@ ScspReceiveCDDA (const u8 *sector)
 
 void
 ScspExec ()
+{
+  if (scsp_thread_running)
+    {
+      scsp_thread_push (SCSP_CMD_LINE, 0, 0);
+      scsp_line_stamp++;
+
+      if (scsp_thread_sleeping)
+        YabThreadWake (YAB_THREAD_SCSP);
+
+      // don't let the sound thread fall too far behind
+      while (scsp_line_stamp - scsp_line_done > SCSP_THREAD_MAX_LAG)
+        {
+          YabThreadWake (YAB_THREAD_SCSP);
+          YabThreadYield ();
+        }
+
+      scsp_thread_deliver_irq ();
+      return;
+    }
+
+  ScspDoExec ();
+}
+
+//----------------------------------------------------------------------------
+
+static void
+ScspDoExec (void)
 {
   u32 audiosize;
 
@@ -3594,9 +4241,27 @@ ScspExec ()
 
 //////////////////////////////////////////////////////////////////////////////
 
+// Called before sound RAM is written directly rather than through
+// SoundRamWrite*() (SCU DMA). Queued writes must land first so they don't
+// overwrite the new data later, and the sound thread stays idle until the
+// next command, so the 68K doesn't run while the RAM is being written.
+void
+M68KWritePrepare (void)
+{
+  if (scsp_thread_running)
+    ScspSyncThread ();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void
 M68KWriteNotify (u32 address, u32 size)
 {
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
+  // the 68K may be idling on a poll of the RAM that was just written
+  m68k_idle = 0;
   M68K->WriteNotify (address, size);
 }
 
@@ -3607,6 +4272,9 @@ M68KGetRegisters (m68kregs_struct *regs)
 {
   int i;
 
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   if (regs != NULL)
     {
       for (i = 0; i < 8; i++)
@@ -3627,6 +4295,9 @@ M68KSetRegisters (m68kregs_struct *regs)
 {
   int i;
 
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   if (regs != NULL)
     {
       for (i = 0; i < 8; i++)
@@ -3675,6 +4346,9 @@ ScspSetVolume (int volume)
 void
 M68KSetBreakpointCallBack (void (*func)(u32))
 {
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   ScspInternalVars->BreakpointCallBack = func;
 }
 
@@ -3685,6 +4359,9 @@ M68KAddCodeBreakpoint (u32 addr)
 {
   int i;
 
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   if (ScspInternalVars->numcodebreakpoints < MAX_BREAKPOINTS)
     {
       // Make sure it isn't already on the list
@@ -3697,6 +4374,7 @@ M68KAddCodeBreakpoint (u32 addr)
       ScspInternalVars->codebreakpoint[i].addr = addr;
       ScspInternalVars->numcodebreakpoints++;
       m68kexecptr = M68KExecBP;
+      m68k_idle = 0;
 
       return 0;
     }
@@ -3734,6 +4412,10 @@ int
 M68KDelCodeBreakpoint (u32 addr)
 {
   int i;
+
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   if (ScspInternalVars->numcodebreakpoints > 0)
     {
       for (i = 0; i < ScspInternalVars->numcodebreakpoints; i++)
@@ -3767,6 +4449,10 @@ void
 M68KClearCodeBreakpoints ()
 {
   int i;
+
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   for (i = 0; i < MAX_BREAKPOINTS; i++)
     ScspInternalVars->codebreakpoint[i].addr = 0xFFFFFFFF;
 
@@ -3784,6 +4470,9 @@ SoundSaveState (FILE *fp)
   u8 nextphase;
   IOCheck_struct check;
 
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   offset = StateWriteHeader (fp, "SCSP", 2);
 
   // Save 68k registers first
@@ -3903,8 +4592,12 @@ SoundLoadState (FILE *fp, int version, int size)
   u8 nextphase;
   IOCheck_struct check;
 
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   // Read 68k registers first
   yread (&check, (void *)&IsM68KRunning, 1, 1, fp);
+  m68k_idle = 0;
 
   for (i = 0; i < 8; i++)
     {
@@ -4053,6 +4746,17 @@ SoundLoadState (FILE *fp, int version, int size)
       yread (&check, (void *)scsp.stack, 4, 32 * 2, fp);
     }
 
+  // Rebuild the active slot list
+  scsp.slot_active = 0;
+  for (i = 0; i < 32; i++)
+    {
+      if (scsp.slot[i].ecnt < SCSP_ENV_DE)
+        scsp.slot_active |= 1U << i;
+    }
+
+  if (scsp_thread_running)
+    scsp_shadow_update ();
+
   return size;
 }
 
@@ -4128,6 +4832,9 @@ ScspSlotDebugStats (u8 slotnum, char *outstring)
 {
   u32 slotoffset = slotnum * 0x20;
 
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   AddString (outstring, "Sound Source = ");
   switch (scsp.slot[slotnum].ssctl)
     {
@@ -4255,6 +4962,9 @@ ScspSlotDebugStats (u8 slotnum, char *outstring)
 void
 ScspCommonControlRegisterDebugStats (char *outstring)
 {
+   if (scsp_thread_running)
+      ScspSyncThread ();
+
    AddString (outstring, "Memory: %s\r\n", scsp.mem4b ? "4 Mbit" : "2 Mbit");
    AddString (outstring, "Master volume: %ld\r\n", (unsigned long)scsp.mvol);
    AddString (outstring, "Ring buffer length: %ld\r\n", (unsigned long)scsp.rbl);
@@ -4305,6 +5015,9 @@ ScspSlotDebugSaveRegisters (u8 slotnum, const char *filename)
   int i;
   IOCheck_struct check;
 
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   if ((fp = fopen (filename, "wb")) == NULL)
     return -1;
 
@@ -4410,6 +5123,9 @@ ScspSlotDebugAudioSaveWav (u8 slotnum, const char *filename)
   long length;
   IOCheck_struct check;
 
+  if (scsp_thread_running)
+    ScspSyncThread ();
+
   if (scsp.slot[slotnum].lea == 0)
     return 0;
 
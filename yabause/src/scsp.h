@@ -87,6 +87,13 @@ void FASTCALL SoundRamWriteByte(u32 addr, u8 val);
 void FASTCALL SoundRamWriteWord(u32 addr, u16 val);
 void FASTCALL SoundRamWriteLong(u32 addr, u32 val);
 
+u8 FASTCALL ScspReadByte(u32 addr);
+u16 FASTCALL ScspReadWord(u32 addr);
+u32 FASTCALL ScspReadLong(u32 addr);
+void FASTCALL ScspWriteByte(u32 addr, u8 val);
+void FASTCALL ScspWriteWord(u32 addr, u16 val);
+void FASTCALL ScspWriteLong(u32 addr, u32 val);
+
 int ScspInit(int coreid);
 int ScspChangeSoundCore(int coreid);
 void ScspSetFrameAccurate(int on);
@@ -132,6 +139,7 @@ u32 FASTCALL c68k_word_read(const u32 adr);
 
 void M68KStep(void);
 void M68KSync(void);
+void M68KWritePrepare(void);
 void M68KWriteNotify(u32 address, u32 size);
 void M68KGetRegisters(m68kregs_struct *regs);
 void M68KSetRegisters(m68kregs_struct *regs);
@@ -30,12 +30,8 @@
 #include "threads.h"
 #include "yabause.h"
 
-#include <math.h>
 #include <stdlib.h>
 
-#undef round  // In case math.h defines it
-#define round(x)  ((int) (floor((x) + 0.5)))
-
 #undef ScspInit  // Disable compatibility alias
 
 extern SoundInterface_struct *SNDCoreList[];  // Defined by each port
@@ -320,8 +316,8 @@ typedef struct SlotState_struct
 
    u32  lfo_counter;    // LFO counter (fixed point index into LFO waveforms)
    s32  lfo_step;       // LFO counter increment, or -1 if in reset mode
-   s32  *lfo_fm_wave;   // LFO frequency modulation waveform pointer
-   s32  *lfo_am_wave;   // LFO amplitude modulation waveform pointer
+   const s16 *lfo_fm_wave; // LFO frequency modulation waveform pointer
+   const u16 *lfo_am_wave; // LFO amplitude modulation waveform pointer
    s8   lfo_fm_shift;   // LFO frequency modulation strength, -1 if disabled
    s8   lfo_am_shift;   // LFO amplitude modulation strength, -1 if disabled
 
@@ -448,22 +444,16 @@ u8 *SoundRam;
 //-------------------------------------------------------------------------
 // Lookup tables
 
-// Attack/decay envelope lookup table
-static s32 scsp_env_table[SCSP_ENV_LEN*2];
-
-// LFO waveforms for amplitude modulation
-static s32 scsp_lfo_wave_amp[4][SCSP_LFO_LEN];
-// LFO waveforms for frequency modulation
-static s32 scsp_lfo_wave_freq[4][SCSP_LFO_LEN];
-// LFO counter step values for each LFOF index
-static s32 scsp_lfo_step[32];
-
-// Envelope increments for each attack/decay rate (AR, DR, etc.)
-static s32 scsp_attack_rate[62+16];
-static s32 scsp_decay_rate[62+16];
-
-// Table of volume multipliers for TL (total level) register
-static s32 scsp_tl_table[256];
+// Generated at build time by scsptab/genscsptab:
+//    scsp_env_table      Attack/decay envelope lookup table
+//    scsp_lfo_wave_amp   LFO waveforms for amplitude modulation
+//    scsp_lfo_wave_freq  LFO waveforms for frequency modulation
+//    scsp_lfo_step       LFO counter step values for each LFOF index
+//    scsp_attack_rate    Envelope increments for each attack rate (AR)
+//    scsp_decay_rate     Envelope increments for each decay rate (DR, etc.)
+//    scsp_tl_table       Table of volume multipliers for TL (total level)
+//                        register
+#include "scsp2_tables.inc"
 
 //-------------------------------------------------------------------------
 // Other local data
@@ -808,106 +798,11 @@ static void (* FASTCALL scsp_audiogen_func_table[2][2][2][2][2])(SlotState *slot
 
 int ScspInit(int coreid, void (*interrupt_handler)(void))
 {
-   int i, j;
-   double x;
+   int i;
 
    if ((SoundRam = T2MemoryInit(0x80000)) == NULL)
       return -1;
 
-   // Fill in lookup tables
-
-   for (i = 0; i < SCSP_ENV_LEN; i++)
-   {
-      // Attack Curve (x^4 ?)
-      x = pow(((double) (SCSP_ENV_MASK - i) / SCSP_ENV_LEN), 4);
-      x *= (double) SCSP_ENV_LEN;
-      scsp_env_table[i] = SCSP_ENV_MASK - (s32) floor(x);
-
-      // Decay curve (x = linear)
-      scsp_env_table[i + SCSP_ENV_LEN] = SCSP_ENV_MASK - i;
-   }
-
-   for (i = 0, j = 0; i < 32; i++)
-   {
-      double lfo_frequency, lfo_step;
-      // Frequency divider follows the pattern 1,2,3,4, 6,8,10,12, 16,...
-      j += 1 << (i >> 2);
-      // Base LFO frequency is 44100/256 or ~172.3 Hz
-      lfo_frequency = (44100.0 / 256.0) / j;
-      // Calculate LFO address step per output sample; we use a literal
-      // 44100 above but OUTPUT_FREQ here in case anyone wants to try
-      // upsampling the audio output someday
-      lfo_step = (lfo_frequency / SCSP_OUTPUT_FREQ) * SCSP_LFO_LEN;
-      scsp_lfo_step[31 - i] = round(lfo_step * (1 << SCSP_LFO_LOW_BITS));
-   }
-
-   for (i = 0; i < SCSP_LFO_LEN; i++)
-   {
-      // Amplitude modulation uses unsigned values which are subtracted
-      // from the base envelope value
-      scsp_lfo_wave_amp[SCSP_LFO_SAWTOOTH][i] = i;
-      if (i < SCSP_LFO_LEN / 2)
-         scsp_lfo_wave_amp[SCSP_LFO_SQUARE][i] = 0;
-      else
-         scsp_lfo_wave_amp[SCSP_LFO_SQUARE][i] = SCSP_LFO_MASK;
-      if (i < SCSP_LFO_LEN / 2)
-         scsp_lfo_wave_amp[SCSP_LFO_TRIANGLE][i] = i*2;
-      else
-         scsp_lfo_wave_amp[SCSP_LFO_TRIANGLE][i] = SCSP_LFO_MASK - ((i - SCSP_LFO_LEN/2) * 2);
-      scsp_lfo_wave_amp[SCSP_LFO_NOISE][i] = rand() & SCSP_LFO_MASK;
-      // FIXME: note that the noise generator output should be independent
-      // of LFORE/LFOF
-
-      // Frequency modulation uses signed values which are added to the
-      // address counter
-      if (i < SCSP_LFO_LEN / 2)
-         scsp_lfo_wave_freq[SCSP_LFO_SAWTOOTH][i] = i;
-      else
-         scsp_lfo_wave_freq[SCSP_LFO_SAWTOOTH][i] = i - SCSP_LFO_LEN;
-      if (i < SCSP_LFO_LEN / 2)
-         scsp_lfo_wave_freq[SCSP_LFO_SQUARE][i] = SCSP_LFO_MASK - SCSP_LFO_LEN/2;
-      else
-         scsp_lfo_wave_freq[SCSP_LFO_SQUARE][i] = 0 - SCSP_LFO_LEN/2;
-      if (i < SCSP_LFO_LEN / 4)
-         scsp_lfo_wave_freq[SCSP_LFO_TRIANGLE][i] = i*2;
-      else if (i < SCSP_LFO_LEN * 3 / 4)
-         scsp_lfo_wave_freq[SCSP_LFO_TRIANGLE][i] = SCSP_LFO_MASK - i*2;
-      else
-         scsp_lfo_wave_freq[SCSP_LFO_TRIANGLE][i] = i*2 - SCSP_LFO_LEN*2;
-      scsp_lfo_wave_freq[SCSP_LFO_NOISE][i] = scsp_lfo_wave_amp[SCSP_LFO_NOISE][i] - SCSP_LFO_LEN/2;
-   }
-
-   for (i = 0; i < 4; i++)
-   {
-      scsp_attack_rate[i] = 0;
-      scsp_decay_rate[i] = 0;
-   }
-   for (i = 0; i < 60; i++)
-   {
-      x = 1.0 + ((i & 3) * 0.25);  // Bits 0-1: x1.00, x1.25, x1.50, x1.75
-      x *= 1 << (i >> 2);          // Bits 2-5: shift bits (x2^0 - x2^15)
-      x *= SCSP_ENV_LEN << SCSP_ENV_LOW_BITS; // Adjust for envelope table size
-
-      scsp_attack_rate[i + 4] = round(x / SCSP_ATTACK_TIME);
-      if (scsp_attack_rate[i + 4] == 0)
-         scsp_attack_rate[i + 4] = 1;
-      scsp_decay_rate[i + 4] = round(x / SCSP_DECAY_TIME);
-      if (scsp_decay_rate[i + 4] == 0)
-         scsp_decay_rate[i + 4] = 1;
-   }
-   scsp_attack_rate[63] = SCSP_ENV_ATTACK_END;
-   scsp_decay_rate[61] = scsp_decay_rate[60];
-   scsp_decay_rate[62] = scsp_decay_rate[60];
-   scsp_decay_rate[63] = scsp_decay_rate[60];
-   for (i = 64; i < 78; i++)
-   {
-      scsp_attack_rate[i] = scsp_attack_rate[63];
-      scsp_decay_rate[i] = scsp_decay_rate[63];
-   }
-
-   for (i = 0; i < 256; i++)
-      scsp_tl_table[i] = round(pow(2.0, -(i/16.0)) * (1 << SCSP_TL_BITS));
-
    // Initialize the SCSP state
 
    scsp_interrupt_handler = interrupt_handler;
@@ -3376,6 +3271,15 @@ void M68KStep(void)
 
 //-------------------------------------------------------------------------
 
+// M68KWritePrepare:  Called before an external agent writes to sound RAM
+// directly.  Nothing is pending here, so there's nothing to do.
+
+void M68KWritePrepare(void)
+{
+}
+
+//-------------------------------------------------------------------------
+
 // M68KWriteNotify:  Notify the M68K emulator that a region of sound RAM
 // has been written to by an external agent.
 
@@ -114,6 +114,7 @@ extern void ScspConvert32uto16s(s32 *srcL, s32 *srcR, s16 *dest, u32 len);
 extern void M68KStart(void);
 extern void M68KStop(void);
 extern void M68KStep(void);
+extern void M68KWritePrepare(void);
 extern void M68KWriteNotify(u32 address, u32 size);
 extern void M68KGetRegisters(M68KRegs *regs);
 extern void M68KSetRegisters(const M68KRegs *regs);
@@ -0,0 +1,360 @@
+/*  Copyright 2004 Stephane Dallongeville
+    Copyright 2004-2007 Theo Berkau
+    Copyright 2010 Andrew Church
+
+    This file is part of Yabause.
+
+    Yabause is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    Yabause is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Yabause; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
+*/
+
+/*********************************************************************************
+ * GENSCSPTAB.C :
+ *
+ * Build-time generator for the SCSP lookup tables.  Writes scsp_tables.inc
+ * (for scsp.c) and scsp2_tables.inc (for scsp2.c) into the current
+ * directory.  Each table is emitted as a const array of the smallest
+ * integer type that holds its range, so the emulator no longer computes
+ * them with floating point at startup.
+ *
+ * The constants below mirror the ones in scsp.c and scsp2.c and must be
+ * kept in sync with them.
+ *
+ ********************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* scsp.c */
+#define SCSP_FREQ         44100
+#define SCSP_ENV_LB       10
+#define SCSP_LFO_LB       10
+#define SCSP_ENV_LEN      (1 << 10)
+#define SCSP_ENV_MASK     (SCSP_ENV_LEN - 1)
+#define SCSP_LFO_LEN      (1 << 10)
+#define SCSP_LFO_MASK     (SCSP_LFO_LEN - 1)
+#define SCSP_ENV_DS       (SCSP_ENV_LEN << SCSP_ENV_LB)
+#define SCSP_ENV_AE       (SCSP_ENV_DS - 1)
+#define SCSP_ATTACK_R     (unsigned int) (8 * 44100)
+#define SCSP_DECAY_R      (unsigned int) (12 * SCSP_ATTACK_R)
+
+/* scsp2.c */
+#define SCSP2_OUTPUT_FREQ        44100
+#define SCSP2_ENV_LOW_BITS       10
+#define SCSP2_LFO_LOW_BITS       10
+#define SCSP2_TL_BITS            10
+#define SCSP2_ENV_ATTACK_END     (((1 << 10) << SCSP2_ENV_LOW_BITS) - 1)
+#define SCSP2_ATTACK_TIME        ((unsigned int) (8 * SCSP2_OUTPUT_FREQ))
+#define SCSP2_DECAY_TIME         ((unsigned int) (12 * SCSP2_ATTACK_TIME))
+
+#define round(x)  ((int) (floor((x) + 0.5)))
+
+static FILE *out;
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Noise source for the LFO noise waveform.  This is the portable rand()
+// from the C standard, so the generated tables are the same on every host.
+
+static unsigned long noise_seed;
+
+static int noise_next(void)
+{
+   noise_seed = (noise_seed * 1103515245 + 12345) & 0xFFFFFFFFUL;
+   return (int) ((noise_seed >> 16) & 0x7FFF);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void emit_table(const char *type, const char *name, const char *dim,
+                       const int *data, int len, int rows)
+{
+   int i;
+
+   fprintf(out, "static const %s %s[%s] = {", type, name, dim);
+   for (i = 0; i < len; i++)
+   {
+      if (rows > 1 && (i % (len / rows)) == 0)
+         fprintf(out, "%s\n {", i ? "\n }," : "");
+      if ((i & 7) == 0)
+         fprintf(out, "\n  ");
+      fprintf(out, "%d,%s", data[i], (i & 7) == 7 ? "" : " ");
+   }
+   fprintf(out, "%s\n};\n\n", rows > 1 ? "\n }" : "");
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void gen_scsp(void)
+{
+   static int env[SCSP_ENV_LEN * 2];
+   static int lfo_step[32];
+   static int sawt_e[SCSP_LFO_LEN], squa_e[SCSP_LFO_LEN];
+   static int tri_e[SCSP_LFO_LEN], noi_e[SCSP_LFO_LEN];
+   static int sawt_f[SCSP_LFO_LEN], squa_f[SCSP_LFO_LEN];
+   static int tri_f[SCSP_LFO_LEN], noi_f[SCSP_LFO_LEN];
+   static int attack[0x60], decay[0x60];
+   static int tl[256];
+   int i, j;
+   double x;
+
+   for (i = 0; i < SCSP_ENV_LEN; i++)
+   {
+      // Attack Curve (x^7 ?)
+      x = pow(((double)(SCSP_ENV_MASK - i) / (double)SCSP_ENV_LEN), 7);
+      x *= (double)SCSP_ENV_LEN;
+      env[i] = SCSP_ENV_MASK - (int)x;
+
+      // Decay curve (x = linear)
+      x = pow(((double)i / (double)SCSP_ENV_LEN), 1);
+      x *= (double)SCSP_ENV_LEN;
+      env[i + SCSP_ENV_LEN] = SCSP_ENV_MASK - (int)x;
+   }
+
+   for (i = 0, j = 0; i < 32; i++)
+   {
+      j += 1 << (i >> 2);
+
+      // lfo freq
+      x = (SCSP_FREQ / 256.0) / (double)j;
+
+      // converting lfo freq in lfo step
+      lfo_step[31 - i] = (int)(x * ((double)SCSP_LFO_LEN / (double)SCSP_FREQ) *
+                               (double)(1 << SCSP_LFO_LB) + 0.5);
+   }
+
+   noise_seed = 1;
+   for (i = 0; i < SCSP_LFO_LEN; i++)
+   {
+      // Envelope modulation
+      sawt_e[i] = SCSP_LFO_MASK - i;
+
+      if (i < (SCSP_LFO_LEN / 2))
+         squa_e[i] = SCSP_LFO_MASK;
+      else
+         squa_e[i] = 0;
+
+      if (i < (SCSP_LFO_LEN / 2))
+         tri_e[i] = SCSP_LFO_MASK - (i * 2);
+      else
+         tri_e[i] = (i - (SCSP_LFO_LEN / 2)) * 2;
+
+      noi_e[i] = noise_next() & SCSP_LFO_MASK;
+
+      // Frequency modulation
+      sawt_f[(i + 512) & SCSP_LFO_MASK] = i - (SCSP_LFO_LEN / 2);
+
+      if (i < (SCSP_LFO_LEN / 2))
+         squa_f[i] = SCSP_LFO_MASK - (SCSP_LFO_LEN / 2) - 128;
+      else
+         squa_f[i] = 0 - (SCSP_LFO_LEN / 2) + 128;
+
+      if (i < (SCSP_LFO_LEN / 2))
+         tri_f[(i + 768) & SCSP_LFO_MASK] = (i * 2) - (SCSP_LFO_LEN / 2);
+      else
+         tri_f[(i + 768) & SCSP_LFO_MASK] =
+            (SCSP_LFO_MASK - ((i - (SCSP_LFO_LEN / 2)) * 2)) -
+            (SCSP_LFO_LEN / 2) + 1;
+
+      noi_f[i] = noi_e[i] - (SCSP_LFO_LEN / 2);
+   }
+
+   for (i = 0; i < 4; i++)
+   {
+      attack[i] = 0;
+      decay[i] = 0;
+   }
+
+   for (i = 0; i < 60; i++)
+   {
+      x = 1.0 + ((i & 3) * 0.25);                  // bits 0-1 : x1.00, x1.25, x1.50, x1.75
+      x *= (double)(1 << ((i >> 2)));              // bits 2-5 : shift bits (x2^0 - x2^15)
+      x *= (double)(SCSP_ENV_LEN << SCSP_ENV_LB);  // adjust for table scsp_env_table
+
+      attack[i + 4] = (int)(x / (double)SCSP_ATTACK_R + 0.5);
+      decay[i + 4] = (int)(x / (double)SCSP_DECAY_R + 0.5);
+
+      if (attack[i + 4] == 0) attack[i + 4] = 1;
+      if (decay[i + 4] == 0) decay[i + 4] = 1;
+   }
+
+   attack[63] = SCSP_ENV_AE;
+   decay[61] = decay[60];
+   decay[62] = decay[60];
+   decay[63] = decay[60];
+
+   for (i = 64; i < 96; i++)
+   {
+      attack[i] = attack[63];
+      decay[i] = decay[63];
+   }
+
+   for (i = 0; i < 256; i++)
+      tl[i] = (int)(pow(10, ((double)i * -0.3762) / 20) * 1024.0 + 0.5);
+
+   fprintf(out, "/* Generated by genscsptab, do not edit */\n\n");
+   emit_table("u16", "scsp_env_table", "SCSP_ENV_LEN * 2", env, SCSP_ENV_LEN * 2, 1);
+   emit_table("u16", "scsp_lfo_sawt_e", "SCSP_LFO_LEN", sawt_e, SCSP_LFO_LEN, 1);
+   emit_table("u16", "scsp_lfo_squa_e", "SCSP_LFO_LEN", squa_e, SCSP_LFO_LEN, 1);
+   emit_table("u16", "scsp_lfo_tri_e", "SCSP_LFO_LEN", tri_e, SCSP_LFO_LEN, 1);
+   emit_table("u16", "scsp_lfo_noi_e", "SCSP_LFO_LEN", noi_e, SCSP_LFO_LEN, 1);
+   emit_table("s16", "scsp_lfo_sawt_f", "SCSP_LFO_LEN", sawt_f, SCSP_LFO_LEN, 1);
+   emit_table("s16", "scsp_lfo_squa_f", "SCSP_LFO_LEN", squa_f, SCSP_LFO_LEN, 1);
+   emit_table("s16", "scsp_lfo_tri_f", "SCSP_LFO_LEN", tri_f, SCSP_LFO_LEN, 1);
+   emit_table("s16", "scsp_lfo_noi_f", "SCSP_LFO_LEN", noi_f, SCSP_LFO_LEN, 1);
+   emit_table("s32", "scsp_attack_rate", "0x40 + 0x20", attack, 0x60, 1);
+   emit_table("s32", "scsp_decay_rate", "0x40 + 0x20", decay, 0x60, 1);
+   emit_table("u16", "scsp_lfo_step", "32", lfo_step, 32, 1);
+   emit_table("u16", "scsp_tl_table", "256", tl, 256, 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void gen_scsp2(void)
+{
+   static int env[SCSP_ENV_LEN * 2];
+   static int lfo_step[32];
+   static int amp[4 * SCSP_LFO_LEN], freq[4 * SCSP_LFO_LEN];
+   static int attack[62 + 16], decay[62 + 16];
+   static int tl[256];
+   int *saw_a = &amp[0 * SCSP_LFO_LEN], *squ_a = &amp[1 * SCSP_LFO_LEN];
+   int *tri_a = &amp[2 * SCSP_LFO_LEN], *noi_a = &amp[3 * SCSP_LFO_LEN];
+   int *saw_f = &freq[0 * SCSP_LFO_LEN], *squ_f = &freq[1 * SCSP_LFO_LEN];
+   int *tri_f = &freq[2 * SCSP_LFO_LEN], *noi_f = &freq[3 * SCSP_LFO_LEN];
+   int i, j;
+   double x;
+
+   for (i = 0; i < SCSP_ENV_LEN; i++)
+   {
+      // Attack Curve (x^4 ?)
+      x = pow(((double) (SCSP_ENV_MASK - i) / SCSP_ENV_LEN), 4);
+      x *= (double) SCSP_ENV_LEN;
+      env[i] = SCSP_ENV_MASK - (int) floor(x);
+
+      // Decay curve (x = linear)
+      env[i + SCSP_ENV_LEN] = SCSP_ENV_MASK - i;
+   }
+
+   for (i = 0, j = 0; i < 32; i++)
+   {
+      double lfo_frequency, lfo_step_f;
+      // Frequency divider follows the pattern 1,2,3,4, 6,8,10,12, 16,...
+      j += 1 << (i >> 2);
+      // Base LFO frequency is 44100/256 or ~172.3 Hz
+      lfo_frequency = (44100.0 / 256.0) / j;
+      lfo_step_f = (lfo_frequency / SCSP2_OUTPUT_FREQ) * SCSP_LFO_LEN;
+      lfo_step[31 - i] = round(lfo_step_f * (1 << SCSP2_LFO_LOW_BITS));
+   }
+
+   noise_seed = 1;
+   for (i = 0; i < SCSP_LFO_LEN; i++)
+   {
+      // Amplitude modulation uses unsigned values which are subtracted
+      // from the base envelope value
+      saw_a[i] = i;
+      if (i < SCSP_LFO_LEN / 2)
+         squ_a[i] = 0;
+      else
+         squ_a[i] = SCSP_LFO_MASK;
+      if (i < SCSP_LFO_LEN / 2)
+         tri_a[i] = i*2;
+      else
+         tri_a[i] = SCSP_LFO_MASK - ((i - SCSP_LFO_LEN/2) * 2);
+      noi_a[i] = noise_next() & SCSP_LFO_MASK;
+
+      // Frequency modulation uses signed values which are added to the
+      // address counter
+      if (i < SCSP_LFO_LEN / 2)
+         saw_f[i] = i;
+      else
+         saw_f[i] = i - SCSP_LFO_LEN;
+      if (i < SCSP_LFO_LEN / 2)
+         squ_f[i] = SCSP_LFO_MASK - SCSP_LFO_LEN/2;
+      else
+         squ_f[i] = 0 - SCSP_LFO_LEN/2;
+      if (i < SCSP_LFO_LEN / 4)
+         tri_f[i] = i*2;
+      else if (i < SCSP_LFO_LEN * 3 / 4)
+         tri_f[i] = SCSP_LFO_MASK - i*2;
+      else
+         tri_f[i] = i*2 - SCSP_LFO_LEN*2;
+      noi_f[i] = noi_a[i] - SCSP_LFO_LEN/2;
+   }
+
+   for (i = 0; i < 4; i++)
+   {
+      attack[i] = 0;
+      decay[i] = 0;
+   }
+   for (i = 0; i < 60; i++)
+   {
+      x = 1.0 + ((i & 3) * 0.25);  // Bits 0-1: x1.00, x1.25, x1.50, x1.75
+      x *= 1 << (i >> 2);          // Bits 2-5: shift bits (x2^0 - x2^15)
+      x *= SCSP_ENV_LEN << SCSP2_ENV_LOW_BITS; // Adjust for envelope table size
+
+      attack[i + 4] = round(x / SCSP2_ATTACK_TIME);
+      if (attack[i + 4] == 0)
+         attack[i + 4] = 1;
+      decay[i + 4] = round(x / SCSP2_DECAY_TIME);
+      if (decay[i + 4] == 0)
+         decay[i + 4] = 1;
+   }
+   attack[63] = SCSP2_ENV_ATTACK_END;
+   decay[61] = decay[60];
+   decay[62] = decay[60];
+   decay[63] = decay[60];
+   for (i = 64; i < 78; i++)
+   {
+      attack[i] = attack[63];
+      decay[i] = decay[63];
+   }
+
+   for (i = 0; i < 256; i++)
+      tl[i] = round(pow(2.0, -(i/16.0)) * (1 << SCSP2_TL_BITS));
+
+   fprintf(out, "/* Generated by genscsptab, do not edit */\n\n");
+   emit_table("u16", "scsp_env_table", "SCSP_ENV_LEN*2", env, SCSP_ENV_LEN * 2, 1);
+   emit_table("u16", "scsp_lfo_wave_amp", "4][SCSP_LFO_LEN", amp, 4 * SCSP_LFO_LEN, 4);
+   emit_table("s16", "scsp_lfo_wave_freq", "4][SCSP_LFO_LEN", freq, 4 * SCSP_LFO_LEN, 4);
+   emit_table("u16", "scsp_lfo_step", "32", lfo_step, 32, 1);
+   emit_table("s32", "scsp_attack_rate", "62+16", attack, 62 + 16, 1);
+   emit_table("s32", "scsp_decay_rate", "62+16", decay, 62 + 16, 1);
+   emit_table("u16", "scsp_tl_table", "256", tl, 256, 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int gen_file(const char *filename, void (*gen)(void))
+{
+   if ((out = fopen(filename, "w")) == NULL)
+   {
+      fprintf(stderr, "genscsptab: can't create %s\n", filename);
+      return -1;
+   }
+
+   gen();
+
+   fclose(out);
+   return 0;
+}
+
+int main(void)
+{
+   if (gen_file("scsp_tables.inc", gen_scsp) != 0)
+      return 1;
+   if (gen_file("scsp2_tables.inc", gen_scsp2) != 0)
+      return 1;
+   return 0;
+}
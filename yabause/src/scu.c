@@ -26,7 +26,9 @@
 #include "scu.h"
 #include "debug.h"
 #include "memory.h"
+#include "scsp.h"
 #include "sh2core.h"
+#include "vdp2.h"
 #include "yabause.h"
 
 #ifdef OPTIMIZED_DMA
@@ -276,6 +278,15 @@ static void DoDMA(u32 ReadAddress, unsigned int ReadAdd,
          // if possible.
          const u8 *source_ptr = DMAMemoryPointer(ReadAddress);
          u8 *dest_ptr = DMAMemoryPointer(WriteAddress);
+         if (dest_type == 0x12 || dest_type == 0x23) {
+            // The copies below bypass the VDP1/VDP2 write functions.
+            Vdp1WriteNotify(WriteAddress, TransferSize);
+            Vdp2WriteNotify(WriteAddress, TransferSize);
+         }
+         else if (dest_type == 0x22) {
+            // The copies below bypass the sound RAM write functions too.
+            M68KWritePrepare();
+         }
 # ifdef WORDS_BIGENDIAN
          if ((source_type & 0x30) && (dest_type & 0x30)) {
             // Source and destination are both directly accessible.
@@ -35,4 +35,6 @@ void YabThreadRemoteSleep(unsigned int id) {}
 
 void YabThreadWake(unsigned int id) {}
 
+int YabThreadGetNumCores(void) { return 1; }
+
 //////////////////////////////////////////////////////////////////////////////
@@ -104,3 +104,12 @@ void YabThreadWake(unsigned int id)
 }
 
 //////////////////////////////////////////////////////////////////////////////
+
+int YabThreadGetNumCores(void)
+{
+   long num = sysconf(_SC_NPROCESSORS_ONLN);
+
+   return (num > 0) ? (int)num : 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
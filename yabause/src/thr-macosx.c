@@ -22,6 +22,7 @@
 
 #include <pthread.h>
 #include <sched.h>
+#include <unistd.h>
 
 /* Thread handle structure. */
 struct thd_s {
@@ -133,3 +134,9 @@ void YabThreadWake(unsigned int id) {
 
     pthread_cond_signal(&thread_handle[id].cond);
 }
+
+int YabThreadGetNumCores(void) {
+    long num = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (num > 0) ? (int)num : 1;
+}
@@ -133,3 +133,13 @@ void YabThreadWake(unsigned int id)
 }
 
 //////////////////////////////////////////////////////////////////////////////
+
+int YabThreadGetNumCores(void)
+{
+   SYSTEM_INFO info;
+
+   GetSystemInfo(&info);
+   return (info.dwNumberOfProcessors > 0) ? (int)info.dwNumberOfProcessors : 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
@@ -25,6 +25,9 @@
 // Thread constants
 ///////////////////////////////////////////////////////////////////////////
 
+// Number of worker threads the software renderer may start
+#define YAB_NUM_VIDSOFT_WORKERS  7
+
 // Thread IDs
 enum {
    YAB_THREAD_SCSP = 0,
@@ -33,6 +36,9 @@ enum {
    YAB_THREAD_NETLINKLISTENER,
    YAB_THREAD_NETLINKCONNECT,
    YAB_THREAD_NETLINKCLIENT,
+   YAB_THREAD_VIDSOFT_WORKER0,  // followed by the other VIDSoft workers
+   YAB_THREAD_VIDSOFT_WORKER_LAST = YAB_THREAD_VIDSOFT_WORKER0 + YAB_NUM_VIDSOFT_WORKERS - 1,
+   YAB_THREAD_VIDSOFT_RENDER,   // VIDSoft pipelined frame rendering
    YAB_NUM_THREADS      // Total number of subthreads
 };
 
@@ -65,6 +71,10 @@ void YabThreadRemoteSleep(unsigned int id);
 // YabThreadWake:  Wake up the given thread if it is asleep.
 void YabThreadWake(unsigned int id);
 
+// YabThreadGetNumCores:  Return the number of processors available to run
+// threads on (at least 1).
+int YabThreadGetNumCores(void);
+
 ///////////////////////////////////////////////////////////////////////////
 
 #endif  // THREADS_H
@@ -20,27 +20,59 @@
 #include "titan.h"
 
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) && !defined(WORDS_BIGENDIAN)
+#include <emmintrin.h>
+/* the AVX2 line converter is built with a target attribute and only used
+   when cpuid reports AVX2, so the rest doesn't need -mavx2 */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define TITAN_AVX2
+#include <immintrin.h>
+#endif
+#endif
 
 /* private */
 typedef u32 (*TitanBlendFunc)(u32 top, u32 bottom);
 typedef int FASTCALL (*TitanTransFunc)(u32 pixel);
+typedef void (*TitanConvertFunc)(pixel_t * dst, const u32 * src, int width);
+
+/* Each priority has its own plane, but a plane only holds valid data where
+   the matching bit of layermask is set.  The mask is cleared line by line as
+   the frame is rendered, so the planes themselves never need clearing.  On
+   top of that, each line has a bitmap of the blocks of TITAN_BLOCK_SIZE
+   pixels that were drawn to, and rendering skips the mask of the others.
+   The back screen is a single color per line, so it doesn't need a plane. */
+#define TITAN_BLOCK_SIZE 32
 
 static struct TitanContext {
    int inited;
    u32 * vdp2framebuffer[8];
+   u8 * layermask;
+   u32 rowblocks[512];
+   u32 backscreen[512];
    u32 * linescreen[4];
    int vdp2width;
    int vdp2height;
+   int blend_mode;
    TitanBlendFunc blend;
    TitanTransFunc trans;
+   TitanConvertFunc convert;
 } tt_context = {
    0,
    { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL },
+   NULL,
+   { 0 },
+   { 0 },
    { NULL, NULL, NULL, NULL },
    320,
    224
 };
 
+/* highest priority set in a layer mask */
+static u8 tt_topbit[256];
+
 #if defined WORDS_BIGENDIAN
 #ifdef USE_RGB_555
 static INLINE u32 TitanFixAlpha(u32 pixel) { return (((pixel >> 16) & 0xF800) | ((pixel >> 13) & 0x7C0) | ((pixel >> 10) & 0x3E)); }
@@ -135,29 +167,255 @@ static INLINE int FASTCALL TitanTransBit(u32 pixel)
    return pixel & 0x80000000;
 }
 
-static u32 TitanDigPixel(int priority, int pos)
+/* Resolves the layers left in mask, from the highest priority down: a
+   transparent pixel is blended with whatever the layers below it resolve
+   to, an opaque one hides them.  The back screen is under everything and
+   is never blended. */
+static u32 TitanDigPixel(u32 mask, int pos, u32 back)
 {
-   u32 pixel = 0;
-   while((priority > -1) && (! pixel))
+   u32 stack[8];
+   u32 pixel;
+   int n = 0;
+
+   for (;;)
    {
-      pixel = tt_context.vdp2framebuffer[priority][pos];
-      priority--;
+      pixel = 0;
+      while (mask && ! pixel)
+      {
+         int priority = tt_topbit[mask];
+         mask ^= 1 << priority;
+         pixel = tt_context.vdp2framebuffer[priority][pos];
+      }
+      if (! pixel)
+      {
+         pixel = back;
+         break;
+      }
+      if (! tt_context.trans(pixel))
+         break;
+      stack[n++] = pixel;
    }
-   tt_context.vdp2framebuffer[priority + 1][pos] = 0;
-   if (priority == -1) return pixel;
 
-   if (tt_context.trans(pixel))
+   while (n > 0)
+      pixel = tt_context.blend(stack[--n], pixel);
+
+   return pixel;
+}
+
+#if defined(__SSE2__) && !defined(WORDS_BIGENDIAN)
+/* TitanBlendPixelsTop() on 4 pixels at once.  x / 0xFF is computed as
+   (x + 1 + (x >> 8)) >> 8, which is exact for the products of two bytes. */
+
+static INLINE __m128i TitanDiv255(__m128i x)
+{
+   return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, _mm_set1_epi16(1)), _mm_srli_epi16(x, 8)), 8);
+}
+
+static INLINE __m128i TitanBlendPixelsTop4(__m128i top, __m128i bottom)
+{
+   __m128i zero = _mm_setzero_si128();
+   __m128i alpha, ralpha, alphalo, alphahi, ralphalo, ralphahi, lo, hi;
+
+   alpha = _mm_and_si128(_mm_srli_epi32(top, 24), _mm_set1_epi32(0x3F));
+   alpha = _mm_add_epi32(_mm_slli_epi32(alpha, 2), _mm_set1_epi32(3));
+   alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+   ralpha = _mm_sub_epi16(_mm_set1_epi16(0xFF), alpha);
+
+   // one alpha per 16-bit channel
+   alphalo = _mm_unpacklo_epi32(alpha, alpha);
+   alphahi = _mm_unpackhi_epi32(alpha, alpha);
+   ralphalo = _mm_unpacklo_epi32(ralpha, ralpha);
+   ralphahi = _mm_unpackhi_epi32(ralpha, ralpha);
+
+   lo = _mm_add_epi16(TitanDiv255(_mm_mullo_epi16(_mm_unpacklo_epi8(top, zero), alphalo)),
+                      TitanDiv255(_mm_mullo_epi16(_mm_unpacklo_epi8(bottom, zero), ralphalo)));
+   hi = _mm_add_epi16(TitanDiv255(_mm_mullo_epi16(_mm_unpackhi_epi8(top, zero), alphahi)),
+                      TitanDiv255(_mm_mullo_epi16(_mm_unpackhi_epi8(bottom, zero), ralphahi)));
+
+   return _mm_or_si128(_mm_and_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(0x00FFFFFF)),
+                       _mm_set1_epi32(0x3F000000));
+}
+#endif
+
+/* Blends top[i] with bottom[i] wherever blend[i] is set, in place. */
+
+static void TitanBlendLine(u32 * top, const u32 * bottom, const u32 * blend, int width)
+{
+   int i = 0;
+
+   switch (tt_context.blend_mode)
    {
-      u32 bottom = TitanDigPixel(priority, pos);
-      pixel = tt_context.blend(pixel, bottom);
+      case TITAN_BLEND_BOTTOM:
+         for (; i < width; i++)
+            if (blend[i])
+               top[i] = TitanBlendPixelsBottom(top[i], bottom[i]);
+         break;
+      case TITAN_BLEND_ADD:
+         for (; i < width; i++)
+            if (blend[i])
+               top[i] = TitanBlendPixelsAdd(top[i], bottom[i]);
+         break;
+      default:
+#if defined(__SSE2__) && !defined(WORDS_BIGENDIAN)
+         for (; i + 4 <= width; i += 4)
+         {
+            __m128i mask = _mm_loadu_si128((const __m128i *)(blend + i));
+            __m128i t, b;
+
+            if (_mm_movemask_epi8(mask) == 0)
+               continue;
+
+            t = _mm_loadu_si128((const __m128i *)(top + i));
+            b = _mm_loadu_si128((const __m128i *)(bottom + i));
+            t = _mm_or_si128(_mm_and_si128(mask, TitanBlendPixelsTop4(t, b)), _mm_andnot_si128(mask, t));
+            _mm_storeu_si128((__m128i *)(top + i), t);
+         }
+#endif
+         for (; i < width; i++)
+            if (blend[i])
+               top[i] = TitanBlendPixelsTop(top[i], bottom[i]);
+         break;
    }
-   else while (priority > 0)
+}
+
+/* Converts a composited line to the display format.  Pixels that are 0 were
+   never drawn to, and leave whatever dispbuffer already holds there. */
+
+static void TitanConvertLine(pixel_t * dst, const u32 * src, int width)
+{
+   int i;
+
+   for (i = 0; i < width; i++)
+      if (src[i])
+         dst[i] = TitanFixAlpha(src[i]);
+}
+
+#if defined(__SSE2__) && !defined(WORDS_BIGENDIAN)
+/* TitanFixAlpha() on 4 pixels.  The 16-bit formats end up in the low half
+   of each lane. */
+
+static INLINE __m128i TitanFixAlpha4(__m128i p)
+{
+#ifdef USE_RGB_555
+   return _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 3), _mm_set1_epi32(0x1F)),
+                                    _mm_and_si128(_mm_srli_epi32(p, 6), _mm_set1_epi32(0x3E0))),
+                       _mm_and_si128(_mm_srli_epi32(p, 9), _mm_set1_epi32(0x7C00)));
+#elif USE_RGB_565
+   return _mm_or_si128(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(p, 3), _mm_set1_epi32(0x1F)),
+                                    _mm_and_si128(_mm_srli_epi32(p, 5), _mm_set1_epi32(0x7E0))),
+                       _mm_and_si128(_mm_srli_epi32(p, 8), _mm_set1_epi32(0xF800)));
+#else
+   return _mm_or_si128(_mm_add_epi32(_mm_slli_epi32(_mm_and_si128(p, _mm_set1_epi32(0x3F000000)), 2),
+                                     _mm_set1_epi32(0x03000000)),
+                       _mm_and_si128(p, _mm_set1_epi32(0x00FFFFFF)));
+#endif
+}
+
+#ifdef USE_16BPP
+/* Packs the low halves of 8 lanes.  _mm_packs_epi32() saturates signed
+   values, so they're moved down into its range and back. */
+
+static INLINE __m128i TitanPack16(__m128i lo, __m128i hi)
+{
+   __m128i bias = _mm_set1_epi32(0x8000);
+
+   return _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(lo, bias), _mm_sub_epi32(hi, bias)),
+                        _mm_set1_epi16((short)0x8000));
+}
+#endif
+
+static void TitanConvertLineSSE2(pixel_t * dst, const u32 * src, int width)
+{
+   __m128i zero = _mm_setzero_si128();
+   int i = 0;
+
+#ifdef USE_16BPP
+   for (; i + 8 <= width; i += 8)
    {
-      tt_context.vdp2framebuffer[priority][pos] = 0;
-      priority--;
+      __m128i lo = _mm_loadu_si128((const __m128i *)(src + i));
+      __m128i hi = _mm_loadu_si128((const __m128i *)(src + i + 4));
+      __m128i keep = _mm_packs_epi32(_mm_cmpeq_epi32(lo, zero), _mm_cmpeq_epi32(hi, zero));
+      __m128i out = TitanPack16(TitanFixAlpha4(lo), TitanFixAlpha4(hi));
+#else
+   for (; i + 4 <= width; i += 4)
+   {
+      __m128i p = _mm_loadu_si128((const __m128i *)(src + i));
+      __m128i keep = _mm_cmpeq_epi32(p, zero);
+      __m128i out = TitanFixAlpha4(p);
+#endif
+      int m = _mm_movemask_epi8(keep);
+
+      if (m == 0xFFFF)
+         continue;
+      if (m)
+         out = _mm_or_si128(_mm_and_si128(keep, _mm_loadu_si128((const __m128i *)(dst + i))),
+                            _mm_andnot_si128(keep, out));
+      _mm_storeu_si128((__m128i *)(dst + i), out);
    }
-   return pixel;
+
+   TitanConvertLine(dst + i, src + i, width - i);
+}
+#endif
+
+#ifdef TITAN_AVX2
+/* The same on 8 pixels.  The 256-bit packs work within each 128-bit half,
+   so the 16-bit results need their middle quarters swapped afterwards. */
+
+__attribute__((target("avx2")))
+static INLINE __m256i TitanFixAlpha8(__m256i p)
+{
+#ifdef USE_RGB_555
+   return _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(p, 3), _mm256_set1_epi32(0x1F)),
+                                          _mm256_and_si256(_mm256_srli_epi32(p, 6), _mm256_set1_epi32(0x3E0))),
+                          _mm256_and_si256(_mm256_srli_epi32(p, 9), _mm256_set1_epi32(0x7C00)));
+#elif USE_RGB_565
+   return _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(p, 3), _mm256_set1_epi32(0x1F)),
+                                          _mm256_and_si256(_mm256_srli_epi32(p, 5), _mm256_set1_epi32(0x7E0))),
+                          _mm256_and_si256(_mm256_srli_epi32(p, 8), _mm256_set1_epi32(0xF800)));
+#else
+   return _mm256_or_si256(_mm256_add_epi32(_mm256_slli_epi32(_mm256_and_si256(p, _mm256_set1_epi32(0x3F000000)), 2),
+                                           _mm256_set1_epi32(0x03000000)),
+                          _mm256_and_si256(p, _mm256_set1_epi32(0x00FFFFFF)));
+#endif
+}
+
+__attribute__((target("avx2")))
+static void TitanConvertLineAVX2(pixel_t * dst, const u32 * src, int width)
+{
+   __m256i zero = _mm256_setzero_si256();
+   int i = 0;
+
+#ifdef USE_16BPP
+   __m256i bias = _mm256_set1_epi32(0x8000);
+
+   for (; i + 16 <= width; i += 16)
+   {
+      __m256i lo = _mm256_loadu_si256((const __m256i *)(src + i));
+      __m256i hi = _mm256_loadu_si256((const __m256i *)(src + i + 8));
+      __m256i keep = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_cmpeq_epi32(lo, zero),
+                                                                 _mm256_cmpeq_epi32(hi, zero)), 0xD8);
+      __m256i out = _mm256_packs_epi32(_mm256_sub_epi32(TitanFixAlpha8(lo), bias),
+                                       _mm256_sub_epi32(TitanFixAlpha8(hi), bias));
+      out = _mm256_xor_si256(_mm256_permute4x64_epi64(out, 0xD8), _mm256_set1_epi16((short)0x8000));
+#else
+   for (; i + 8 <= width; i += 8)
+   {
+      __m256i p = _mm256_loadu_si256((const __m256i *)(src + i));
+      __m256i keep = _mm256_cmpeq_epi32(p, zero);
+      __m256i out = TitanFixAlpha8(p);
+#endif
+      int m = _mm256_movemask_epi8(keep);
+
+      if (m == -1)
+         continue;
+      if (m)
+         out = _mm256_blendv_epi8(out, _mm256_loadu_si256((const __m256i *)(dst + i)), keep);
+      _mm256_storeu_si256((__m256i *)(dst + i), out);
+   }
+
+   TitanConvertLineSSE2(dst + i, src + i, width - i);
 }
+#endif
 
 /* public */
 int TitanInit()
@@ -166,12 +424,16 @@ int TitanInit()
 
    if (! tt_context.inited)
    {
-      for(i = 0;i < 8;i++)
+      /* priority 0 is never drawn, so it has no plane */
+      for(i = 1;i < 8;i++)
       {
          if ((tt_context.vdp2framebuffer[i] = (u32 *)calloc(sizeof(u32), 704 * 512)) == NULL)
             return -1;
       }
 
+      if ((tt_context.layermask = (u8 *)calloc(sizeof(u8), 704 * 512)) == NULL)
+         return -1;
+
       /* linescreen 0 is not initialized as it's not used... */
       for(i = 1;i < 4;i++)
       {
@@ -179,11 +441,28 @@ int TitanInit()
             return -1;
       }
 
+      for(i = 1;i < 256;i++)
+      {
+         int priority = 7;
+         while (! (i & (1 << priority)))
+            priority--;
+         tt_topbit[i] = priority;
+      }
+
+#if defined(TITAN_AVX2)
+      tt_context.convert = __builtin_cpu_supports("avx2") ? TitanConvertLineAVX2 : TitanConvertLineSSE2;
+#elif defined(__SSE2__) && !defined(WORDS_BIGENDIAN)
+      tt_context.convert = TitanConvertLineSSE2;
+#else
+      tt_context.convert = TitanConvertLine;
+#endif
+
       tt_context.inited = 1;
    }
 
-   for(i = 0;i < 8;i++)
-      memset(tt_context.vdp2framebuffer[i], 0, sizeof(u32) * 704 * 512);
+   memset(tt_context.layermask, 0, sizeof(u8) * 704 * 512);
+   memset(tt_context.rowblocks, 0, sizeof(tt_context.rowblocks));
+   memset(tt_context.backscreen, 0, sizeof(tt_context.backscreen));
 
    for(i = 1;i < 4;i++)
       memset(tt_context.linescreen[i], 0, sizeof(u32) * 512);
@@ -195,9 +474,11 @@ int TitanDeInit()
 {
    int i;
 
-   for(i = 0;i < 8;i++)
+   for(i = 1;i < 8;i++)
       free(tt_context.vdp2framebuffer[i]);
 
+   free(tt_context.layermask);
+
    for(i = 1;i < 4;i++)
       free(tt_context.linescreen[i]);
 
@@ -218,6 +499,8 @@ void TitanGetResolution(int * width, int * height)
 
 void TitanSetBlendingMode(int blend_mode)
 {
+   tt_context.blend_mode = blend_mode;
+
    if (blend_mode == TITAN_BLEND_BOTTOM)
    {
       tt_context.blend = TitanBlendPixelsBottom;
@@ -237,11 +520,7 @@ void TitanSetBlendingMode(int blend_mode)
 
 void TitanPutBackHLine(s32 y, u32 color)
 {
-   u32 * buffer = tt_context.vdp2framebuffer[0] + (y * tt_context.vdp2width);
-   int i;
-
-   for (i = 0; i < tt_context.vdp2width; i++)
-      buffer[i] = color;
+   tt_context.backscreen[y] = color;
 }
 
 void TitanPutLineHLine(int linescreen, s32 y, u32 color)
@@ -261,11 +540,14 @@ void TitanPutPixel(int priority, s32 x, s32 y, u32 color, int linescreen)
    {
       int pos = (y * tt_context.vdp2width) + x;
       u32 * buffer = tt_context.vdp2framebuffer[priority] + pos;
+      u8 * mask = tt_context.layermask + pos;
       if (linescreen)
          color = TitanBlendPixelsTop(color, tt_context.linescreen[linescreen][y]);
-      if (tt_context.trans(color) && *buffer)
+      if (tt_context.trans(color) && (*mask & (1 << priority)) && *buffer)
          color = tt_context.blend(color, *buffer);
       *buffer = color;
+      *mask |= 1 << priority;
+      tt_context.rowblocks[y] |= 1 << (x / TITAN_BLOCK_SIZE);
    }
 }
 
@@ -275,10 +557,16 @@ void TitanPutHLine(int priority, s32 x, s32 y, s32 width, u32 color)
 
    {
       u32 * buffer = tt_context.vdp2framebuffer[priority] + (y * tt_context.vdp2width) + x;
+      u8 * mask = tt_context.layermask + (y * tt_context.vdp2width) + x;
       int i;
 
       for (i = 0; i < width; i++)
+      {
          buffer[i] = color;
+         mask[i] |= 1 << priority;
+      }
+      for (i = x / TITAN_BLOCK_SIZE; i <= (x + width - 1) / TITAN_BLOCK_SIZE; i++)
+         tt_context.rowblocks[y] |= 1 << i;
    }
 }
 
@@ -289,25 +577,86 @@ void TitanPutShadow(int priority, s32 x, s32 y)
    {
       int pos = (y * tt_context.vdp2width) + x;
       u32 * buffer = tt_context.vdp2framebuffer[priority] + pos;
-      *buffer = *buffer ? TitanBlendPixelsTop(0x20000000, *buffer) : 0x20000000;
+      u8 * mask = tt_context.layermask + pos;
+      *buffer = ((*mask & (1 << priority)) && *buffer) ? TitanBlendPixelsTop(0x20000000, *buffer) : 0x20000000;
+      *mask |= 1 << priority;
+      tt_context.rowblocks[y] |= 1 << (x / TITAN_BLOCK_SIZE);
    }
 }
 
-void TitanRender(pixel_t * dispbuffer)
+void TitanRenderLines(pixel_t * dispbuffer, int start, int end)
 {
-   u32 dot;
-   int i;
+   u32 top[704], bottom[704], blend[704];
+   int width = tt_context.vdp2width;
+   int i, y;
 
-   for (i = 0; i < (tt_context.vdp2width * tt_context.vdp2height); i++)
+   for (y = start; y < end; y++)
    {
-      dot = TitanDigPixel(7, i);
-      if (dot)
+      int pos = y * width;
+      u8 * mask = tt_context.layermask + pos;
+      u32 back = tt_context.backscreen[y];
+      u32 blocks = tt_context.rowblocks[y];
+      int blended = 0;
+      int x, next;
+
+      for (x = 0; x < width; x = next)
       {
-         dispbuffer[i] = TitanFixAlpha(dot);
+         next = (x | (TITAN_BLOCK_SIZE - 1)) + 1;
+         if (next > width)
+            next = width;
+
+         if (! (blocks & (1 << (x / TITAN_BLOCK_SIZE))))
+         {
+            // nothing was drawn there, only the back screen shows
+            for (i = x; i < next; i++)
+            {
+               top[i] = back;
+               blend[i] = 0;
+            }
+            continue;
+         }
+
+         // find the top pixel, and what's under it when it's transparent
+         for (i = x; i < next; i++)
+         {
+            u32 m = mask[i];
+            u32 pixel = 0;
+
+            while (m && ! pixel)
+            {
+               int priority = tt_topbit[m];
+               m ^= 1 << priority;
+               pixel = tt_context.vdp2framebuffer[priority][pos + i];
+            }
+
+            blend[i] = 0;
+            if (! pixel)
+               pixel = back;
+            else if (tt_context.trans(pixel))
+            {
+               bottom[i] = TitanDigPixel(m, pos + i, back);
+               blend[i] = 0xFFFFFFFF;
+               blended = 1;
+            }
+            top[i] = pixel;
+         }
+
+         memset(mask + x, 0, next - x);
       }
+      tt_context.rowblocks[y] = 0;
+
+      if (blended)
+         TitanBlendLine(top, bottom, blend, width);
+
+      tt_context.convert(dispbuffer + pos, top, width);
    }
 }
 
+void TitanRender(pixel_t * dispbuffer)
+{
+   TitanRenderLines(dispbuffer, 0, tt_context.vdp2height);
+}
+
 #ifdef WORDS_BIGENDIAN
 void TitanWriteColor(pixel_t * dispbuffer, s32 bufwidth, s32 x, s32 y, u32 color)
 {
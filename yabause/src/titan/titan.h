@@ -44,6 +44,7 @@ void TitanPutHLine(int priority, s32 x, s32 y, s32 width, u32 color);
 void TitanPutShadow(int priority, s32 x, s32 y);
 
 void TitanRender(pixel_t * dispbuffer);
+void TitanRenderLines(pixel_t * dispbuffer, int start, int end);
 
 void TitanWriteColor(pixel_t * dispbuffer, s32 bufwidth, s32 x, s32 y, u32 color);
 
@@ -25,6 +25,7 @@
 
 
 #include <stdlib.h>
+#include <string.h>
 #include "vdp1.h"
 #include "debug.h"
 #include "scu.h"
@@ -33,6 +34,12 @@
 u8 * Vdp1Ram;
 u8 * Vdp1FrameBuffer;
 
+// One bit per 256 bytes of VDP1 RAM, set on every write and cleared by
+// Vdp1CommandListUnchanged() or the video core
+u32 Vdp1RamDirty[0x80000 >> 13];
+
+#define Vdp1RamMarkDirty(addr) Vdp1RamDirty[(addr) >> 13] |= 1 << (((addr) >> 8) & 0x1F)
+
 VideoInterface_struct *VIDCore=NULL;
 extern VideoInterface_struct *VIDCoreList[];
 
@@ -61,6 +68,7 @@ u32 FASTCALL Vdp1RamReadLong(u32 addr) {
 
 void FASTCALL Vdp1RamWriteByte(u32 addr, u8 val) {
    addr &= 0x7FFFF;
+   Vdp1RamMarkDirty(addr);
    T1WriteByte(Vdp1Ram, addr, val);
 }
 
@@ -68,6 +76,7 @@ void FASTCALL Vdp1RamWriteByte(u32 addr, u8 val) {
 
 void FASTCALL Vdp1RamWriteWord(u32 addr, u16 val) {
    addr &= 0x7FFFF;
+   Vdp1RamMarkDirty(addr);
    T1WriteWord(Vdp1Ram, addr, val);
 }
 
@@ -75,13 +84,43 @@ void FASTCALL Vdp1RamWriteWord(u32 addr, u16 val) {
 
 void FASTCALL Vdp1RamWriteLong(u32 addr, u32 val) {
    addr &= 0x7FFFF;
+   Vdp1RamMarkDirty(addr);
    T1WriteLong(Vdp1Ram, addr, val);
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
+// For writes to VDP1 RAM that don't go through the functions above
+void Vdp1WriteNotify(u32 addr, u32 size) {
+   u32 end;
+
+   if (size == 0 || ((addr >> 19) & 0x3FF) != (0x05C00000 >> 19))
+      return;
+
+   if (size > 0x80000)
+      size = 0x80000;
+   end = (addr & 0x7FFFF) + size - 1;
+   for (addr &= 0x7FF00; addr <= end; addr += 0x100)
+      Vdp1RamMarkDirty(addr & 0x7FFFF);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Brings in the frame the video core read back from its own framebuffer,
+// if it has one the CPU hasn't seen yet
+static INLINE void Vdp1FrameBufferSync(void) {
+   if (Vdp1External.framebufferpending)
+   {
+      Vdp1External.framebufferpending = 0;
+      VIDCore->Vdp1ReadFrameBuffer(Vdp1FrameBuffer);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 u8 FASTCALL Vdp1FrameBufferReadByte(u32 addr) {
    addr &= 0x3FFFF;
+   Vdp1FrameBufferSync();
    return T1ReadByte(Vdp1FrameBuffer, addr);
 }
 
@@ -89,6 +128,7 @@ u8 FASTCALL Vdp1FrameBufferReadByte(u32 addr) {
 
 u16 FASTCALL Vdp1FrameBufferReadWord(u32 addr) {
    addr &= 0x3FFFF;
+   Vdp1FrameBufferSync();
    return T1ReadWord(Vdp1FrameBuffer, addr);
 }
 
@@ -96,6 +136,7 @@ u16 FASTCALL Vdp1FrameBufferReadWord(u32 addr) {
 
 u32 FASTCALL Vdp1FrameBufferReadLong(u32 addr) {
    addr &= 0x3FFFF;
+   Vdp1FrameBufferSync();
    return T1ReadLong(Vdp1FrameBuffer, addr);
 }
 
@@ -103,6 +144,7 @@ u32 FASTCALL Vdp1FrameBufferReadLong(u32 addr) {
 
 void FASTCALL Vdp1FrameBufferWriteByte(u32 addr, u8 val) {
    addr &= 0x3FFFF;
+   Vdp1FrameBufferSync();
    T1WriteByte(Vdp1FrameBuffer, addr, val);
 }
 
@@ -110,6 +152,7 @@ void FASTCALL Vdp1FrameBufferWriteByte(u32 addr, u8 val) {
 
 void FASTCALL Vdp1FrameBufferWriteWord(u32 addr, u16 val) {
    addr &= 0x3FFFF;
+   Vdp1FrameBufferSync();
    T1WriteWord(Vdp1FrameBuffer, addr, val);
 }
 
@@ -117,6 +160,7 @@ void FASTCALL Vdp1FrameBufferWriteWord(u32 addr, u16 val) {
 
 void FASTCALL Vdp1FrameBufferWriteLong(u32 addr, u32 val) {
    addr &= 0x3FFFF;
+   Vdp1FrameBufferSync();
    T1WriteLong(Vdp1FrameBuffer, addr, val);
 }
 
@@ -139,6 +183,8 @@ int Vdp1Init(void) {
       return -1;
 
    Vdp1External.disptoggle = 1;
+   Vdp1External.skipdraw = 0;
+   Vdp1WriteNotify(0x05C00000, 0x80000);
 
    return 0;
 }
@@ -210,6 +256,7 @@ void VideoDeInit(void) {
    if (VIDCore)
       VIDCore->DeInit();
    VIDCore = NULL;
+   Vdp1External.framebufferpending = 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -310,122 +357,80 @@ void FASTCALL Vdp1WriteLong(u32 addr, UNUSED u32 val) {
 
 //////////////////////////////////////////////////////////////////////////////
 
-void Vdp1Draw(void) {
-   u32 returnAddr;
-   u32 commandCounter;
-   u16 command;
+// Command tables visited by the last Vdp1ParseCommandList(), in execution
+// order. The list always ends with the table that stopped it: an end
+// command, an abort command or the one past the loop-protection limit.
+typedef struct
+{
+   u32 addr;
+   vdp1cmd_struct cmd;
+} vdp1cmdlist_struct;
 
-   VIDCore->Vdp1DrawStart();
+#define VDP1_MAX_COMMANDS 2000 // fix me
 
-   if (!Vdp1External.disptoggle)
-   {
-      Vdp1NoDraw();
-      return;
-   }
+static vdp1cmdlist_struct Vdp1CommandList[VDP1_MAX_COMMANDS + 1];
+static int Vdp1CommandListSize;
 
-   Vdp1Regs->addr = 0;
-   returnAddr = 0xFFFFFFFF;
-   commandCounter = 0;
+vdp1cmd_struct * Vdp1CurrentCommand;
 
-   // beginning of a frame
-   // BEF <- CEF
-   // CEF <- 0
-   Vdp1Regs->EDSR >>= 1;
-   /* this should be done after a frame change or a plot trigger */
-   Vdp1Regs->COPR = 0;
+//////////////////////////////////////////////////////////////////////////////
 
-   command = T1ReadWord(Vdp1Ram, Vdp1Regs->addr);
+static void Vdp1ParseCommandList(void) {
+   u32 addr = 0;
+   u32 returnAddr = 0xFFFFFFFF;
+   vdp1cmdlist_struct *entry;
+   u16 command;
+   int i;
 
-   while (!(command & 0x8000) && commandCounter < 2000) { // fix me
-      // First, process the command
-      if (!(command & 0x4000)) { // if (!skip)
-         switch (command & 0x000F) {
-            case 0: // normal sprite draw
-               VIDCore->Vdp1NormalSpriteDraw();
-               break;
-            case 1: // scaled sprite draw
-               VIDCore->Vdp1ScaledSpriteDraw();
-               break;
-            case 2: // distorted sprite draw
-            case 3: /* this one should be invalid, but some games
-                    (Hardcore 4x4 for instance) use it instead of 2 */
-               VIDCore->Vdp1DistortedSpriteDraw();
-               break;
-            case 4: // polygon draw
-               VIDCore->Vdp1PolygonDraw();
-               break;
-            case 5: // polyline draw
-            case 7: // undocumented mirror
-               VIDCore->Vdp1PolylineDraw();
-               break;
-            case 6: // line draw
-               VIDCore->Vdp1LineDraw();
-               break;
-            case 8: // user clipping coordinates
-            case 11: // undocumented mirror
-               VIDCore->Vdp1UserClipping();
-               break;
-            case 9: // system clipping coordinates
-               VIDCore->Vdp1SystemClipping();
-               break;
-            case 10: // local coordinate
-               VIDCore->Vdp1LocalCoordinate();
-               break;
-            default: // Abort
-               VDP1LOG("vdp1\t: Bad command: %x\n",  command);
-               Vdp1Regs->EDSR |= 2;
-               VIDCore->Vdp1DrawEnd();
-               Vdp1Regs->LOPR = Vdp1Regs->addr >> 3;
-               Vdp1Regs->COPR = Vdp1Regs->addr >> 3;
-               return;
-         }
-      }
+   for (i = 0; ; i++)
+   {
+      entry = &Vdp1CommandList[i];
+      entry->addr = addr;
+      Vdp1ReadCommand(&entry->cmd, addr);
+      command = entry->cmd.CMDCTRL;
+
+      if ((command & 0x8000) || i >= VDP1_MAX_COMMANDS)
+         break;
+      if (!(command & 0x4000) && (command & 0x000F) > 11) // Abort
+         break;
 
       // Next, determine where to go next
       switch ((command & 0x3000) >> 12) {
          case 0: // NEXT, jump to following table
-            Vdp1Regs->addr += 0x20;
+            addr += 0x20;
             break;
          case 1: // ASSIGN, jump to CMDLINK
-            Vdp1Regs->addr = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 2) * 8;
+            addr = entry->cmd.CMDLINK * 8;
             break;
          case 2: // CALL, call a subroutine
             if (returnAddr == 0xFFFFFFFF)
-               returnAddr = Vdp1Regs->addr + 0x20;
-	
-            Vdp1Regs->addr = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 2) * 8;
+               returnAddr = addr + 0x20;
+
+            addr = entry->cmd.CMDLINK * 8;
             break;
          case 3: // RETURN, return from subroutine
             if (returnAddr != 0xFFFFFFFF) {
-               Vdp1Regs->addr = returnAddr;
+               addr = returnAddr;
                returnAddr = 0xFFFFFFFF;
             }
             else
-               Vdp1Regs->addr += 0x20;
+               addr += 0x20;
             break;
       }
-
-      command = T1ReadWord(Vdp1Ram, Vdp1Regs->addr);
-      commandCounter++;    
    }
 
-   // we set two bits to 1
-   Vdp1Regs->EDSR |= 2;
-   Vdp1Regs->COPR = Vdp1Regs->addr >> 3;
-   ScuSendDrawEnd();
-   VIDCore->Vdp1DrawEnd();
+   Vdp1CommandListSize = i + 1;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
-void Vdp1NoDraw(void) {
-   u32 returnAddr;
-   u32 commandCounter;
+// Runs the parsed command list. Without draw, only the clipping and local
+// coordinate commands are passed to the video core. Returns 0 once the list
+// has ended, -1 if it was aborted.
+static int Vdp1ExecuteCommandList(int draw) {
+   vdp1cmdlist_struct *entry;
    u16 command;
-
-   Vdp1Regs->addr = 0;
-   returnAddr = 0xFFFFFFFF;
-   commandCounter = 0;
+   int i;
 
    // beginning of a frame (ST-013-R3-061694 page 53)
    // BEF <- CEF
@@ -434,93 +439,229 @@ void Vdp1NoDraw(void) {
    /* this should be done after a frame change or a plot trigger */
    Vdp1Regs->COPR = 0;
 
-   command = T1ReadWord(Vdp1Ram, Vdp1Regs->addr);
-
-   while (!(command & 0x8000) && commandCounter < 2000) { // fix me
-      // First, process the command
-      if (!(command & 0x4000)) { // if (!skip)
-         switch (command & 0x000F) {
-            case 0: // normal sprite draw
-            case 1: // scaled sprite draw
-            case 2: // distorted sprite draw
-            case 3: /* this one should be invalid, but some games
-                    (Hardcore 4x4 for instance) use it instead of 2 */
-            case 4: // polygon draw
-            case 5: // polyline draw
-            case 6: // line draw
-            case 7: // undocumented polyline draw mirror
-               break;
-            case 8: // user clipping coordinates
-            case 11: // undocumented mirror
-               VIDCore->Vdp1UserClipping();
-               break;
-            case 9: // system clipping coordinates
-               VIDCore->Vdp1SystemClipping();
-               break;
-            case 10: // local coordinate
-               VIDCore->Vdp1LocalCoordinate();
-               break;
-            default: // Abort
-               VDP1LOG("vdp1\t: Bad command: %x\n",  command);
-               Vdp1Regs->EDSR |= 2;
-               VIDCore->Vdp1DrawEnd();
-               Vdp1Regs->LOPR = Vdp1Regs->addr >> 3;
-               Vdp1Regs->COPR = Vdp1Regs->addr >> 3;
-               return;
-         }
-      }
+   for (i = 0; ; i++)
+   {
+      entry = &Vdp1CommandList[i];
+      command = entry->cmd.CMDCTRL;
+      Vdp1Regs->addr = entry->addr;
+      Vdp1CurrentCommand = &entry->cmd;
 
-      // Next, determine where to go next
-      switch ((command & 0x3000) >> 12) {
-         case 0: // NEXT, jump to following table
-            Vdp1Regs->addr += 0x20;
+      if ((command & 0x8000) || i >= VDP1_MAX_COMMANDS)
+         break;
+      if (command & 0x4000) // skip
+         continue;
+
+      switch (command & 0x000F) {
+         case 0: // normal sprite draw
+            if (draw) VIDCore->Vdp1NormalSpriteDraw();
             break;
-         case 1: // ASSIGN, jump to CMDLINK
-            Vdp1Regs->addr = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 2) * 8;
+         case 1: // scaled sprite draw
+            if (draw) VIDCore->Vdp1ScaledSpriteDraw();
             break;
-         case 2: // CALL, call a subroutine
-            if (returnAddr == 0xFFFFFFFF)
-               returnAddr = Vdp1Regs->addr + 0x20;
-	
-            Vdp1Regs->addr = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 2) * 8;
+         case 2: // distorted sprite draw
+         case 3: /* this one should be invalid, but some games
+                 (Hardcore 4x4 for instance) use it instead of 2 */
+            if (draw) VIDCore->Vdp1DistortedSpriteDraw();
             break;
-         case 3: // RETURN, return from subroutine
-            if (returnAddr != 0xFFFFFFFF) {
-               Vdp1Regs->addr = returnAddr;
-               returnAddr = 0xFFFFFFFF;
-            }
-            else
-               Vdp1Regs->addr += 0x20;
+         case 4: // polygon draw
+            if (draw) VIDCore->Vdp1PolygonDraw();
+            break;
+         case 5: // polyline draw
+         case 7: // undocumented mirror
+            if (draw) VIDCore->Vdp1PolylineDraw();
+            break;
+         case 6: // line draw
+            if (draw) VIDCore->Vdp1LineDraw();
+            break;
+         case 8: // user clipping coordinates
+         case 11: // undocumented mirror
+            VIDCore->Vdp1UserClipping();
+            break;
+         case 9: // system clipping coordinates
+            VIDCore->Vdp1SystemClipping();
+            break;
+         case 10: // local coordinate
+            VIDCore->Vdp1LocalCoordinate();
             break;
+         default: // Abort
+            VDP1LOG("vdp1\t: Bad command: %x\n",  command);
+            Vdp1Regs->EDSR |= 2;
+            Vdp1Regs->LOPR = Vdp1Regs->addr >> 3;
+            Vdp1Regs->COPR = Vdp1Regs->addr >> 3;
+            return -1;
       }
-
-      command = T1ReadWord(Vdp1Ram, Vdp1Regs->addr);
-      commandCounter++;    
    }
 
    // we set two bits to 1
    Vdp1Regs->EDSR |= 2;
+   Vdp1Regs->COPR = Vdp1Regs->addr >> 3;
    ScuSendDrawEnd();
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void Vdp1Draw(void) {
+   // skipped frame: keep the command table side effects but don't rasterize
+   if (Vdp1External.skipdraw)
+   {
+      Vdp1NoDraw();
+      return;
+   }
+
+   // parsed before Vdp1DrawStart() so the video core can look at the list
+   Vdp1ParseCommandList();
+
+   VIDCore->Vdp1DrawStart();
+   Vdp1ExecuteCommandList(Vdp1External.disptoggle);
+   VIDCore->Vdp1DrawEnd();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static vdp1cmd_struct Vdp1LastList[VDP1_MAX_COMMANDS + 1];
+static int Vdp1LastListSize = -1;
+
+static int Vdp1RamRangeDirty(u32 addr, u32 size) {
+   u32 end = addr + size - 1;
+
+   if (size == 0)
+      return 0;
+
+   for (addr &= ~0xFF; addr <= end; addr += 0x100)
+   {
+      u32 block = addr & 0x7FFFF;
+      if (Vdp1RamDirty[block >> 13] & (1 << ((block >> 8) & 0x1F)))
+         return 1;
+   }
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Returns 1 if anything a command table reads besides itself was written to
+static int Vdp1CommandDataDirty(const vdp1cmd_struct *cmd) {
+   u32 charaddr = (u32)cmd->CMDSRCA << 3;
+   u32 charsize = ((cmd->CMDSIZE >> 8) & 0x3F) * 8 * (cmd->CMDSIZE & 0xFF);
+
+   switch (cmd->CMDCTRL & 0x000F) {
+      case 0: // sprites
+      case 1:
+      case 2:
+      case 3:
+         switch ((cmd->CMDPMOD >> 3) & 0x7) {
+            case 0:
+               if (Vdp1RamRangeDirty(charaddr, charsize >> 1))
+                  return 1;
+               break;
+            case 1:
+               if (Vdp1RamRangeDirty(charaddr, charsize >> 1) ||
+                   Vdp1RamRangeDirty((u32)cmd->CMDCOLR << 3, 0x20))
+                  return 1;
+               break;
+            case 2:
+            case 3:
+            case 4:
+               if (Vdp1RamRangeDirty(charaddr, charsize))
+                  return 1;
+               break;
+            default:
+               if (Vdp1RamRangeDirty(charaddr, charsize * 2))
+                  return 1;
+               break;
+         }
+         // fall through
+      case 4: // polygons and lines
+      case 5:
+      case 6:
+      case 7:
+         if ((cmd->CMDPMOD & 0x4) || (cmd->CMDCTRL & 0x000F) >= 5)
+            return Vdp1RamRangeDirty((u32)cmd->CMDGRDA << 3, 8);
+         break;
+   }
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Compares the command list parsed by the running Vdp1Draw() with the one
+// seen by the last call. Returns 1 if the command tables are the same and
+// none of the character patterns, color lookup tables and gouraud tables
+// they use were written to since, meaning drawing it again gives the same
+// result. The writes seen are forgotten, so the next call only looks at
+// the ones made after this.
+int Vdp1CommandListUnchanged(void) {
+   int changed = 0;
+   u16 command;
+   int i;
+
+   for (i = 0; i < Vdp1CommandListSize; i++)
+   {
+      const vdp1cmd_struct *cmd = &Vdp1CommandList[i].cmd;
+
+      if (i >= Vdp1LastListSize || memcmp(&Vdp1LastList[i], cmd, sizeof(vdp1cmd_struct)))
+      {
+         Vdp1LastList[i] = *cmd;
+         changed = 1;
+      }
+
+      command = cmd->CMDCTRL;
+      if (!changed && !(command & 0x4000) && !(command & 0x8000))
+         changed = Vdp1CommandDataDirty(cmd);
+   }
+
+   if (Vdp1CommandListSize != Vdp1LastListSize)
+      changed = 1;
+   Vdp1LastListSize = Vdp1CommandListSize;
+   memset(Vdp1RamDirty, 0, sizeof(Vdp1RamDirty));
+
+   return !changed;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void Vdp1NoDraw(void) {
+   Vdp1ParseCommandList();
+   Vdp1ExecuteCommandList(0);
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
 void FASTCALL Vdp1ReadCommand(vdp1cmd_struct *cmd, u32 addr) {
-   cmd->CMDCTRL = T1ReadWord(Vdp1Ram, addr);
-   cmd->CMDLINK = T1ReadWord(Vdp1Ram, addr + 0x2);
-   cmd->CMDPMOD = T1ReadWord(Vdp1Ram, addr + 0x4);
-   cmd->CMDCOLR = T1ReadWord(Vdp1Ram, addr + 0x6);
-   cmd->CMDSRCA = T1ReadWord(Vdp1Ram, addr + 0x8);
-   cmd->CMDSIZE = T1ReadWord(Vdp1Ram, addr + 0xA);
-   cmd->CMDXA = T1ReadWord(Vdp1Ram, addr + 0xC);
-   cmd->CMDYA = T1ReadWord(Vdp1Ram, addr + 0xE);
-   cmd->CMDXB = T1ReadWord(Vdp1Ram, addr + 0x10);
-   cmd->CMDYB = T1ReadWord(Vdp1Ram, addr + 0x12);
-   cmd->CMDXC = T1ReadWord(Vdp1Ram, addr + 0x14);
-   cmd->CMDYC = T1ReadWord(Vdp1Ram, addr + 0x16);
-   cmd->CMDXD = T1ReadWord(Vdp1Ram, addr + 0x18);
-   cmd->CMDYD = T1ReadWord(Vdp1Ram, addr + 0x1A);
-   cmd->CMDGRDA = T1ReadWord(Vdp1Ram, addr + 0x1C);
+   u16 table[16];
+   int i;
+
+   // one bulk copy of the table, byte swapped in place afterwards
+   addr &= 0x7FFFF;
+   if (addr <= 0x80000 - sizeof(table))
+   {
+      memcpy(table, Vdp1Ram + addr, sizeof(table));
+#ifndef WORDS_BIGENDIAN
+      for (i = 0; i < 16; i++)
+         table[i] = BSWAP16L(table[i]);
+#endif
+   }
+   else
+   {
+      for (i = 0; i < 16; i++)
+         table[i] = T1ReadWord(Vdp1Ram, (addr + i * 2) & 0x7FFFF);
+   }
+
+   cmd->CMDCTRL = table[0];
+   cmd->CMDLINK = table[1];
+   cmd->CMDPMOD = table[2];
+   cmd->CMDCOLR = table[3];
+   cmd->CMDSRCA = table[4];
+   cmd->CMDSIZE = table[5];
+   cmd->CMDXA = table[6];
+   cmd->CMDYA = table[7];
+   cmd->CMDXB = table[8];
+   cmd->CMDYB = table[9];
+   cmd->CMDXC = table[10];
+   cmd->CMDYC = table[11];
+   cmd->CMDXD = table[12];
+   cmd->CMDYD = table[13];
+   cmd->CMDGRDA = table[14];
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -552,6 +693,7 @@ int Vdp1LoadState(FILE *fp, UNUSED int version, int size)
 
    // Read VDP1 ram
    yread(&check, (void *)Vdp1Ram, 0x80000, 1, fp);
+   Vdp1WriteNotify(0x05C00000, 0x80000);
 
    return size;
 }
@@ -937,31 +1079,15 @@ void Vdp1DebugCommand(u32 number, char *outstring)
 #define SAT2YAB2(alpha,dot1,dot2)       (alpha << 24 | ((dot1 & 0xFF) << 16) | (dot2 & 0xFF00) | (dot2 & 0xFF))
 #endif
 
+#if defined WORDS_BIGENDIAN
+#define CRAM2YAB(alpha,rgb)             BSWAP32((u32)(alpha) << 24 | ((rgb) & 0xFFFFFF))
+#else
+#define CRAM2YAB(alpha,rgb)             ((u32)(alpha) << 24 | ((rgb) & 0xFFFFFF))
+#endif
+
 static u32 ColorRamGetColor(u32 colorindex)
 {
-   switch(Vdp2Internal.ColorMode)
-   {
-      case 0:
-      case 1:
-      {
-         u32 tmp;
-         colorindex <<= 1;
-         tmp = T2ReadWord(Vdp2ColorRam, colorindex & 0xFFF);
-         return SAT2YAB1(0xFF, tmp);
-      }
-      case 2:
-      {
-         u32 tmp1, tmp2;
-         colorindex <<= 2;
-         colorindex &= 0xFFF;
-         tmp1 = T2ReadWord(Vdp2ColorRam, colorindex);
-         tmp2 = T2ReadWord(Vdp2ColorRam, colorindex+2);
-         return SAT2YAB2(0xFF, tmp1, tmp2);
-      }
-      default: break;
-   }
-
-   return 0;
+   return CRAM2YAB(0xFF, Vdp2ColorRamGetRGB(colorindex));
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1345,7 +1471,8 @@ VIDDummyVdp2Reset,
 VIDDummyVdp2DrawStart,
 VIDDummyVdp2DrawEnd,
 VIDDummyVdp2DrawScreens,
-VIDDummyGetGlSize
+VIDDummyGetGlSize,
+NULL
 };
 
 //////////////////////////////////////////////////////////////////////////////
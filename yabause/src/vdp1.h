@@ -53,6 +53,9 @@ typedef struct
    void (*Vdp2DrawEnd)(void);
    void (*Vdp2DrawScreens)(void);
    void (*GetGlSize)(int *width, int *height);
+   // Copies the last drawn frame into the VDP1 framebuffer memory, called
+   // on CPU access when Vdp1External.framebufferpending is set
+   void (*Vdp1ReadFrameBuffer)(u8 *framebuffer);
 } VideoInterface_struct;
 
 extern VideoInterface_struct *VIDCore;
@@ -72,6 +75,11 @@ u32 FASTCALL Vdp1FrameBufferReadLong(u32);
 void FASTCALL Vdp1FrameBufferWriteByte(u32, u8);
 void FASTCALL Vdp1FrameBufferWriteWord(u32, u16);
 void FASTCALL Vdp1FrameBufferWriteLong(u32, u32);
+void Vdp1WriteNotify(u32 addr, u32 size);
+
+// One bit per 256 bytes of VDP1 RAM, set on every write. Renderers caching
+// decoded data clear it when they pick it up.
+extern u32 Vdp1RamDirty[0x80000 >> 13];
 
 typedef struct {
    u16 TVMR;
@@ -110,6 +118,8 @@ typedef struct {
    int disptoggle;
    int manualerase;
    int manualchange;
+   int skipdraw; // walk the command table without calling the video core
+   int framebufferpending; // the video core has a frame for Vdp1FrameBuffer
 } Vdp1External_struct;
 
 extern Vdp1External_struct Vdp1External;
@@ -133,6 +143,9 @@ typedef struct
    u16 CMDGRDA;   
 } vdp1cmd_struct;
 
+// Command table being executed by Vdp1Draw(), already parsed
+extern vdp1cmd_struct * Vdp1CurrentCommand;
+
 int Vdp1Init(void);
 void Vdp1DeInit(void);
 int VideoInit(int coreid);
@@ -149,6 +162,7 @@ void FASTCALL	Vdp1WriteLong(u32, u32);
 
 void Vdp1Draw(void);
 void Vdp1NoDraw(void);
+int Vdp1CommandListUnchanged(void);
 void FASTCALL Vdp1ReadCommand(vdp1cmd_struct *cmd, u32 addr);
 
 int Vdp1SaveState(FILE *fp);
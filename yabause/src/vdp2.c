@@ -23,6 +23,7 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
 #include "vdp2.h"
 #include "debug.h"
 #include "peripheral.h"
@@ -36,14 +37,25 @@
 
 u8 * Vdp2Ram;
 u8 * Vdp2ColorRam;
+u32 Vdp2RamDirty[0x80000 >> 13];
+int Vdp2ColorRamDirty;
+u32 Vdp2ColorRamRGB[0x800];
 Vdp2 * Vdp2Regs;
 Vdp2Internal_struct Vdp2Internal;
 Vdp2External_struct Vdp2External;
 
 static Vdp2 Vdp2Lines[270];
 
+Vdp2 * Vdp2DrawRegs;
+u8 * Vdp2DrawRam;
+u32 * Vdp2DrawColorRamRGB;
+static Vdp2 * Vdp2DrawLines = Vdp2Lines;
+
+#define Vdp2RamMarkDirty(addr) Vdp2RamDirty[(addr) >> 13] |= 1 << (((addr) >> 8) & 0x1F)
+
 static int autoframeskipenab=0;
 static int throttlespeed=0;
+static int renderskip=0;
 u64 lastticks=0;
 static int fps;
 
@@ -73,6 +85,7 @@ u32 FASTCALL Vdp2RamReadLong(u32 addr) {
 void FASTCALL Vdp2RamWriteByte(u32 addr, u8 val) {
    addr &= 0x7FFFF;
    T1WriteByte(Vdp2Ram, addr, val);
+   Vdp2RamMarkDirty(addr);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -80,6 +93,7 @@ void FASTCALL Vdp2RamWriteByte(u32 addr, u8 val) {
 void FASTCALL Vdp2RamWriteWord(u32 addr, u16 val) {
    addr &= 0x7FFFF;
    T1WriteWord(Vdp2Ram, addr, val);
+   Vdp2RamMarkDirty(addr);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -87,6 +101,7 @@ void FASTCALL Vdp2RamWriteWord(u32 addr, u16 val) {
 void FASTCALL Vdp2RamWriteLong(u32 addr, u32 val) {
    addr &= 0x7FFFF;
    T1WriteLong(Vdp2Ram, addr, val);
+   Vdp2RamMarkDirty(addr);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -112,9 +127,45 @@ u32 FASTCALL Vdp2ColorRamReadLong(u32 addr) {
 
 //////////////////////////////////////////////////////////////////////////////
 
+static void Vdp2ColorRamUpdate(u32 addr) {
+   u32 tmp;
+
+   switch(Vdp2Internal.ColorMode)
+   {
+      case 0:
+      case 1:
+         tmp = T2ReadWord(Vdp2ColorRam, addr & 0xFFE);
+         Vdp2ColorRamRGB[(addr >> 1) & 0x7FF] = ((tmp & 0x1F) << 3) | ((tmp & 0x03E0) << 6) | ((tmp & 0x7C00) << 9) | ((tmp & 0x8000) << 16);
+         break;
+      case 2:
+         // only 1024 colors, mirrored so that lookups don't depend on the mode
+         addr &= 0xFFC;
+         tmp = T2ReadLong(Vdp2ColorRam, addr);
+         Vdp2ColorRamRGB[addr >> 2] = tmp;
+         Vdp2ColorRamRGB[(addr >> 2) | 0x400] = tmp;
+         break;
+      default: break;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void Vdp2ColorRamRebuild(void) {
+   u32 addr;
+
+   memset(Vdp2ColorRamRGB, 0, sizeof(Vdp2ColorRamRGB));
+   for (addr = 0; addr < 0x1000; addr += 2)
+      Vdp2ColorRamUpdate(addr);
+   Vdp2ColorRamDirty = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void FASTCALL Vdp2ColorRamWriteByte(u32 addr, u8 val) {
    addr &= 0xFFF;
    T2WriteByte(Vdp2ColorRam, addr, val);
+   Vdp2ColorRamUpdate(addr);
+   Vdp2ColorRamDirty = 1;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -122,6 +173,8 @@ void FASTCALL Vdp2ColorRamWriteByte(u32 addr, u8 val) {
 void FASTCALL Vdp2ColorRamWriteWord(u32 addr, u16 val) {
    addr &= 0xFFF;
    T2WriteWord(Vdp2ColorRam, addr, val);
+   Vdp2ColorRamUpdate(addr);
+   Vdp2ColorRamDirty = 1;
 //   if (Vdp2Internal.ColorMode == 0)
 //      T1WriteWord(Vdp2ColorRam, addr + 0x800, val);
 }
@@ -131,6 +184,35 @@ void FASTCALL Vdp2ColorRamWriteWord(u32 addr, u16 val) {
 void FASTCALL Vdp2ColorRamWriteLong(u32 addr, u32 val) {
    addr &= 0xFFF;
    T2WriteLong(Vdp2ColorRam, addr, val);
+   Vdp2ColorRamUpdate(addr);
+   Vdp2ColorRamUpdate(addr + 2);
+   Vdp2ColorRamDirty = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// For writes made straight to Vdp2Ram/Vdp2ColorRam (DMA fast paths, loading
+// a state).
+void Vdp2WriteNotify(u32 addr, u32 size) {
+   u32 end;
+
+   if (size == 0)
+      return;
+
+   switch ((addr >> 19) & 0x3FF)
+   {
+      case 0x05E00000 >> 19:
+      case 0x05E80000 >> 19:
+         if (size > 0x80000)
+            size = 0x80000;
+         end = (addr & 0x7FFFF) + size - 1;
+         for (addr &= 0x7FF00; addr <= end; addr += 0x100)
+            Vdp2RamMarkDirty(addr & 0x7FFFF);
+         break;
+      case 0x05F00000 >> 19:
+         Vdp2ColorRamRebuild();
+         break;
+   }
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -145,6 +227,9 @@ int Vdp2Init(void) {
    if ((Vdp2ColorRam = T2MemoryInit(0x1000)) == NULL)
       return -1;
 
+   Vdp2WriteNotify(0x05E00000, 0x80000);
+   Vdp2WriteNotify(0x05F00000, 0x1000);
+   Vdp2DrawCapture(NULL);
    Vdp2Reset();
    return 0;
 }
@@ -163,6 +248,8 @@ void Vdp2DeInit(void) {
    if (Vdp2ColorRam)
       T2MemoryDeInit(Vdp2ColorRam);
    Vdp2ColorRam = NULL;
+
+   Vdp2DrawCapture(NULL);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -247,6 +334,7 @@ void Vdp2Reset(void) {
 
    yabsys.VBlankLineCount = 224;
    Vdp2Internal.ColorMode = 0;
+   Vdp2ColorRamRebuild();
 
    Vdp2External.disptoggle = 0xFF;
 }
@@ -254,7 +342,8 @@ void Vdp2Reset(void) {
 //////////////////////////////////////////////////////////////////////////////
 
 void Vdp2VBlankIN(void) {
-   VIDCore->Vdp2DrawEnd();
+   if (!Vdp1External.skipdraw)
+      VIDCore->Vdp2DrawEnd();
    /* this should be done after a frame change or a plot trigger */
    Vdp1Regs->COPR = 0;
    /* I'm not 100% sure about this, but it seems that when using manual change
@@ -291,7 +380,82 @@ void Vdp2HBlankOUT(void) {
 //////////////////////////////////////////////////////////////////////////////
 
 Vdp2 * Vdp2RestoreRegs(int line) {
-   return line > 270 ? NULL : Vdp2Lines + line;
+   return line >= 270 ? NULL : Vdp2DrawLines + line;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int Vdp2CaptureInit(Vdp2Capture_struct * capture) {
+   if ((capture->ram = T1MemoryInit(0x80000)) == NULL)
+      return -1;
+
+   // the first capture only has to copy what changes after this
+   memcpy(capture->ram, Vdp2Ram, 0x80000);
+   memcpy(capture->colorramrgb, Vdp2ColorRamRGB, sizeof(Vdp2ColorRamRGB));
+   memset(capture->ramdirty, 0xFF, sizeof(capture->ramdirty));
+   capture->colorramdirty = 1;
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void Vdp2CaptureDeInit(Vdp2Capture_struct * capture) {
+   if (capture->ram)
+      T1MemoryDeInit(capture->ram);
+   capture->ram = NULL;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Brings capture up to date with the live state. Only the parts of RAM and
+// color RAM written since the last capture are copied; the dirty flags are
+// moved over to the capture for the renderer to pick up instead.
+void Vdp2Capture(Vdp2Capture_struct * capture) {
+   u32 dirty;
+   int i, j;
+
+   memcpy(&capture->regs, Vdp2Regs, sizeof(Vdp2));
+   memcpy(capture->lines, Vdp2Lines, sizeof(Vdp2Lines));
+
+   for (i = 0; i < (0x80000 >> 13); i++)
+   {
+      if ((dirty = Vdp2RamDirty[i]) == 0)
+         continue;
+
+      Vdp2RamDirty[i] = 0;
+      capture->ramdirty[i] |= dirty;
+      for (j = 0; j < 32; j++)
+      {
+         if (dirty & (1 << j))
+            memcpy(capture->ram + (i << 13) + (j << 8), Vdp2Ram + (i << 13) + (j << 8), 0x100);
+      }
+   }
+
+   if (Vdp2ColorRamDirty)
+   {
+      Vdp2ColorRamDirty = 0;
+      capture->colorramdirty = 1;
+      memcpy(capture->colorramrgb, Vdp2ColorRamRGB, sizeof(Vdp2ColorRamRGB));
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void Vdp2DrawCapture(Vdp2Capture_struct * capture) {
+   if (capture)
+   {
+      Vdp2DrawRegs = &capture->regs;
+      Vdp2DrawRam = capture->ram;
+      Vdp2DrawColorRamRGB = capture->colorramrgb;
+      Vdp2DrawLines = capture->lines;
+   }
+   else
+   {
+      Vdp2DrawRegs = Vdp2Regs;
+      Vdp2DrawRam = Vdp2Ram;
+      Vdp2DrawColorRamRGB = Vdp2ColorRamRGB;
+      Vdp2DrawLines = Vdp2Lines;
+   }
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -326,6 +490,18 @@ void SpeedThrottleDisable(void) {
 
 //////////////////////////////////////////////////////////////////////////////
 
+void RenderSkipEnable(void) {
+   renderskip = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void RenderSkipDisable(void) {
+   renderskip = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void Vdp2VBlankOUT(void) {
    static int framestoskip = 0;
    static int framesskipped = 0;
@@ -334,25 +510,19 @@ void Vdp2VBlankOUT(void) {
    static u64 diffticks = 0;
    static u32 framecount = 0;
    static u64 onesecondticks = 0;
-   static VideoInterface_struct * saved = NULL;
 
    Vdp2Regs->TVSTAT = (Vdp2Regs->TVSTAT & ~0x0008) | 0x0002;
 
-   if (skipnextframe && (! saved))
-   {
-      saved = VIDCore;
-      VIDCore = &VIDDummy;
-   }
-   else if (saved && (! skipnextframe))
-   {
-      VIDCore = saved;
-      saved = NULL;
-   }
+   // Skipped frames still run the VDP1 command table so that COPR, EDSR and
+   // the draw end interrupt behave as usual, only the video core is left out
+   Vdp1External.skipdraw = skipnextframe || renderskip;
 
-   VIDCore->Vdp2DrawStart();
+   if (!Vdp1External.skipdraw)
+      VIDCore->Vdp2DrawStart();
 
    if (Vdp2Regs->TVMD & 0x8000) {
-      VIDCore->Vdp2DrawScreens();
+      if (!Vdp1External.skipdraw)
+         VIDCore->Vdp2DrawScreens();
       if (Vdp1Regs->PTMR == 2) Vdp1Draw();
    }
    else
@@ -548,7 +718,11 @@ void FASTCALL Vdp2WriteWord(u32 addr, u16 val) {
          return;
       case 0x00E:
          Vdp2Regs->RAMCTL = val;
-         Vdp2Internal.ColorMode = (val >> 12) & 0x3;
+         if (Vdp2Internal.ColorMode != ((val >> 12) & 0x3))
+         {
+            Vdp2Internal.ColorMode = (val >> 12) & 0x3;
+            Vdp2ColorRamRebuild();
+         }
          return;
       case 0x010:
          Vdp2Regs->CYCA0L = val;
@@ -1017,6 +1191,9 @@ int Vdp2LoadState(FILE *fp, UNUSED int version, int size)
    // Read internal variables
    yread(&check, (void *)&Vdp2Internal, sizeof(Vdp2Internal_struct), 1, fp);
 
+   Vdp2WriteNotify(0x05E00000, 0x80000);
+   Vdp2WriteNotify(0x05F00000, 0x1000);
+
    return size;
 }
 
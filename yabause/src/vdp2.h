@@ -42,6 +42,23 @@ void FASTCALL   Vdp2ColorRamWriteByte(u32, u8);
 void FASTCALL   Vdp2ColorRamWriteWord(u32, u16);
 void FASTCALL   Vdp2ColorRamWriteLong(u32, u32);
 
+// One bit per 256 bytes of VDP2 RAM, and a flag for color RAM, set on every
+// write. Renderers caching decoded data clear them when they pick them up.
+extern u32 Vdp2RamDirty[0x80000 >> 13];
+extern int Vdp2ColorRamDirty;
+
+void Vdp2WriteNotify(u32 addr, u32 size);
+
+// Color RAM converted for the current color mode, kept up to date by the
+// write functions. Colors are 0x00BBGGRR, with the MSB in bit 31 in modes
+// 0 and 1 and the raw upper byte in mode 2.
+extern u32 Vdp2ColorRamRGB[0x800];
+
+static INLINE u32 Vdp2ColorRamGetRGB(u32 colorindex)
+{
+   return Vdp2ColorRamRGB[colorindex & 0x7FF];
+}
+
 typedef struct {
    u16 TVMD;   // 0x25F80000
    u16 EXTEN;  // 0x25F80002
@@ -379,6 +396,8 @@ void Vdp2VBlankOUT(void);
 void Vdp2SendExternalLatch(int hcnt, int vcnt);
 void SpeedThrottleEnable(void);
 void SpeedThrottleDisable(void);
+void RenderSkipEnable(void);
+void RenderSkipDisable(void);
 
 u8 FASTCALL     Vdp2ReadByte(u32);
 u16 FASTCALL    Vdp2ReadWord(u32);
@@ -401,4 +420,28 @@ void DisableAutoFrameSkip(void);
 
 Vdp2 * Vdp2RestoreRegs(int line);
 
+// A copy of everything the video cores read to draw the screens, so that a
+// frame can be drawn on another thread while emulation carries on.
+typedef struct {
+   Vdp2 regs;
+   Vdp2 lines[270];
+   u8 * ram;
+   u32 colorramrgb[0x800];
+   // what changed up to this capture, like Vdp2RamDirty/Vdp2ColorRamDirty
+   u32 ramdirty[0x80000 >> 13];
+   int colorramdirty;
+} Vdp2Capture_struct;
+
+// The registers, RAM and converted color RAM the video cores draw from, and
+// that Vdp2RestoreRegs() reads: the live state, or a capture once it's been
+// passed to Vdp2DrawCapture().
+extern Vdp2 * Vdp2DrawRegs;
+extern u8 * Vdp2DrawRam;
+extern u32 * Vdp2DrawColorRamRGB;
+
+int Vdp2CaptureInit(Vdp2Capture_struct * capture);
+void Vdp2CaptureDeInit(Vdp2Capture_struct * capture);
+void Vdp2Capture(Vdp2Capture_struct * capture);
+void Vdp2DrawCapture(Vdp2Capture_struct * capture);
+
 #endif
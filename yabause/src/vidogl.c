@@ -46,6 +46,12 @@
 #define SAT2YAB2(alpha,dot1,dot2)       (alpha << 24 | ((dot1 & 0xFF) << 16) | (dot2 & 0xFF00) | (dot2 & 0xFF))
 #endif
 
+#if defined WORDS_BIGENDIAN
+#define CRAM2YAB(alpha,rgb)             BSWAP32((u32)(alpha) << 24 | ((rgb) & 0xFFFFFF))
+#else
+#define CRAM2YAB(alpha,rgb)             ((u32)(alpha) << 24 | ((rgb) & 0xFFFFFF))
+#endif
+
 #define COLOR_ADDt(b)      (b>0xFF?0xFF:(b<0?0:b))
 #define COLOR_ADDb(b1,b2)   COLOR_ADDt((signed) (b1) + (b2))
 #ifdef WORDS_BIGENDIAN
@@ -82,6 +88,7 @@ void VIDOGLVdp2DrawEnd(void);
 void VIDOGLVdp2DrawScreens(void);
 void VIDOGLVdp2SetResolution(u16 TVMD);
 void YglGetGlSize(int *width, int *height);
+void VIDOGLVdp1ReadFrameBuffer(u8 *framebuffer);
 
 VideoInterface_struct VIDOGL = {
 VIDCORE_OGL,
@@ -106,7 +113,8 @@ VIDOGLVdp2Reset,
 VIDOGLVdp2DrawStart,
 VIDOGLVdp2DrawEnd,
 VIDOGLVdp2DrawScreens,
-YglGetGlSize
+YglGetGlSize,
+VIDOGLVdp1ReadFrameBuffer
 };
 
 float vdp1wratio=1;
@@ -168,6 +176,7 @@ vdp2rotationparameter_struct * FASTCALL vdp2RGetParamMode03WithK( vdp2draw_struc
 
 static void FASTCALL Vdp1ReadPriority(vdp1cmd_struct *cmd, int * priority, int * colorcl );
 static void FASTCALL Vdp1ReadTexture(vdp1cmd_struct *cmd, YglSprite *sprite, YglTexture *texture);
+static u32 FASTCALL DoColorOffset(void *info, u32 pixel);
 
 u32 FASTCALL Vdp2ColorRamGetColorCM01SC0(vdp2draw_struct * info, u32 colorindex, int alpha );
 u32 FASTCALL Vdp2ColorRamGetColorCM01SC1(vdp2draw_struct * info, u32 colorindex, int alpha );
@@ -786,69 +795,36 @@ static void Vdp1SetTextureRatio(int vdp2widthratio, int vdp2heightratio)
 
 static u32 Vdp2ColorRamGetColor(u32 colorindex, int alpha)
 {
-   switch(Vdp2Internal.ColorMode)
-   {
-      case 0:
-      case 1:
-      {
-         u32 tmp;
-         colorindex <<= 1;
-         tmp = T2ReadWord(Vdp2ColorRam, colorindex & 0xFFF);
-         return SAT2YAB1(alpha, tmp);
-      }
-      case 2:
-      {
-         u32 tmp1, tmp2;
-         colorindex <<= 2;
-         colorindex &= 0xFFF;
-         tmp1 = T2ReadWord(Vdp2ColorRam, colorindex);
-         tmp2 = T2ReadWord(Vdp2ColorRam, colorindex+2);
-         return SAT2YAB2(alpha, tmp1, tmp2);
-      }
-      default: break;
-   }
-
-   return 0;
+   return CRAM2YAB(alpha, Vdp2ColorRamGetRGB(colorindex));
 }
 
 u32 FASTCALL Vdp2ColorRamGetColorCM01SC0(vdp2draw_struct * info, u32 colorindex, int alpha )
 {
-   u32 tmp;
-   tmp = T2ReadWord(Vdp2ColorRam, (colorindex<<1) & 0xFFF);
-   return SAT2YAB1(alpha,tmp);
+   return CRAM2YAB(alpha, Vdp2ColorRamGetRGB(colorindex));
 }
 
 u32 FASTCALL Vdp2ColorRamGetColorCM01SC1(vdp2draw_struct * info, u32 colorindex, int alpha )
 {
-   u32 tmp;
-   tmp = T2ReadWord(Vdp2ColorRam, (colorindex<<1) & 0xFFF);   
    if( (info->specialcolorfunction & 1) == 0 )
    {
-      return SAT2YAB1(0xFF,tmp);
+      return CRAM2YAB(0xFF, Vdp2ColorRamGetRGB(colorindex));
    }
-   return SAT2YAB1(alpha,tmp);
+   return CRAM2YAB(alpha, Vdp2ColorRamGetRGB(colorindex));
 }
 
 u32 FASTCALL Vdp2ColorRamGetColorCM01SC3(vdp2draw_struct * info, u32 colorindex, int alpha )
 {
-   u32 tmp;
-   colorindex <<= 1;
-   tmp = T2ReadWord(Vdp2ColorRam, colorindex & 0xFFF);
-   if( ((tmp & 0x8000) == 0) )
+   u32 color = Vdp2ColorRamGetRGB(colorindex);
+   if( ((color & 0x80000000) == 0) )
    {
-      return SAT2YAB1(0xFF,tmp);
+      return CRAM2YAB(0xFF, color);
    }
-   return SAT2YAB1(alpha,tmp);
+   return CRAM2YAB(alpha, color);
 }
 
 u32 FASTCALL Vdp2ColorRamGetColorCM2(vdp2draw_struct * info, u32 colorindex, int alpha )
 {
-   u32 tmp1, tmp2;
-   colorindex <<= 2;
-   colorindex &= 0xFFF;
-   tmp1 = T2ReadWord(Vdp2ColorRam, colorindex);
-   tmp2 = T2ReadWord(Vdp2ColorRam, colorindex+2);
-   return SAT2YAB2(alpha, tmp1, tmp2);   
+   return CRAM2YAB(alpha, Vdp2ColorRamGetRGB(colorindex));
 }
 
 static int Vdp2SetGetColor( vdp2draw_struct * info )
@@ -1537,9 +1513,54 @@ static void FASTCALL Vdp2DrawCell(vdp2draw_struct *info, YglTexture *texture)
 
 //////////////////////////////////////////////////////////////////////////////
 
+static void Vdp2DrawPatternCells(vdp2draw_struct *info, YglTexture *texture)
+{
+   switch(info->patternwh)
+   {
+      case 1:
+         Vdp2DrawCell(info, texture);
+         break;
+      case 2:
+         texture->w += 8;
+         Vdp2DrawCell(info, texture);
+         texture->textdata -= (texture->w + 8) * 8 - 8;
+         Vdp2DrawCell(info, texture);
+         texture->textdata -= 8;
+         Vdp2DrawCell(info, texture);
+         texture->textdata -= (texture->w + 8) * 8 - 8;
+         Vdp2DrawCell(info, texture);
+         break;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Fills key with everything Vdp2DrawPatternCells() reads for info
+static void Vdp2PatternCacheKey(vdp2draw_struct *info, YglCacheKey *key)
+{
+   static const u32 bpp[8] = { 4, 8, 16, 16, 32, 0, 0, 0 };
+
+   memset(key, 0, sizeof(YglCacheKey));
+   key->addr = YGL_CACHE_VDP2 | info->charaddr;
+   key->w = key->h = info->patternpixelwh;
+   key->mode = info->colornumber | (info->transparencyenable << 3) | (info->patternwh << 4) |
+               (Vdp2Internal.ColorMode << 8) | (info->specialcolormode << 10) |
+               ((info->specialcolorfunction & 1) << 12) | ((info->alpha & 0xFF) << 16);
+   key->palette = (info->paladdr << 16) | info->coloroffset;
+   if (info->PostPixelFetchCalc == &DoColorOffset)
+      key->state = 0x80000000 | ((info->cor & 0x1FF) << 18) | ((info->cog & 0x1FF) << 9) | (info->cob & 0x1FF);
+   // Line scrolled RGB cells are read with this frame's scroll values
+   if (info->islinescroll && info->colornumber >= 3)
+      key->frame = YglTM->frame;
+   key->size = info->patternpixelwh * info->patternpixelwh * bpp[info->colornumber] / 8;
+   key->colorram = (info->colornumber < 3);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 static void Vdp2DrawPattern(vdp2draw_struct *info, YglTexture *texture)
 {
-   u32 cacheaddr = ((u32) (info->alpha >> 3) << 27) | (info->paladdr << 20) | info->charaddr;
+   YglCacheKey key;
    YglCache c;
    YglSprite tile;
    int winmode=0;
@@ -1586,7 +1607,8 @@ static void Vdp2DrawPattern(vdp2draw_struct *info, YglTexture *texture)
   
    }
    
-   if (1 == YglIsCached(cacheaddr,&c) )
+   Vdp2PatternCacheKey(info, &key);
+   if (1 == YglIsCached(&key,&c) )
    {
       YglCachedQuad(&tile, &c);
       info->x += tile.w;
@@ -1594,24 +1616,9 @@ static void Vdp2DrawPattern(vdp2draw_struct *info, YglTexture *texture)
       return;
    }
    YglQuad(&tile, texture,&c);
-   YglCacheAdd(cacheaddr,&c);
+   YglCacheAdd(&key,&c);
 
-   switch(info->patternwh)
-   {
-      case 1:
-         Vdp2DrawCell(info, texture);
-         break;
-      case 2:
-         texture->w += 8;
-         Vdp2DrawCell(info, texture);
-         texture->textdata -= (texture->w + 8) * 8 - 8;
-         Vdp2DrawCell(info, texture);
-         texture->textdata -= 8;
-         Vdp2DrawCell(info, texture);
-         texture->textdata -= (texture->w + 8) * 8 - 8;
-         Vdp2DrawCell(info, texture);
-         break;
-   }
+   Vdp2DrawPatternCells(info, texture);
    info->x += tile.w;
    info->y += tile.h;
 }
@@ -1698,6 +1705,318 @@ static void Vdp2PatternAddr(vdp2draw_struct *info)
    info->charaddr *= 0x20; // thanks Runik
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// Page cache
+//
+// Pages are decoded whole into a texture of their own and drawn as a single
+// quad for as long as the VRAM and color RAM they use stay untouched. A page
+// only gets a texture once it has been seen unchanged since the last time it
+// was drawn, so pages rewritten every frame keep going pattern by pattern.
+
+#define VDP2_PAGE_SIZE        512
+#define VDP2_PAGE_CACHE_SIZE  32
+
+typedef struct
+{
+   u32 addr;
+   int colornumber;
+   int pagewh;
+   int patternwh;
+   int patterndatasize;
+   int auxmode;
+   u16 supplementdata;
+   int charmask;
+   int alpha;
+   int coloroffset;
+   int transparencyenable;
+   u32 FASTCALL (*Vdp2ColorRamGetColor)(void *, u32 , int );
+   u32 FASTCALL (*PostPixelFetchCalc)(void *, u32);
+   s32 cor;
+   s32 cog;
+   s32 cob;
+} vdp2pagekey_struct;
+
+typedef struct
+{
+   vdp2pagekey_struct key;
+   u32 ramblocks[0x80000 >> 13]; // same layout as Vdp2RamDirty
+   int used;
+   int dirty;                    // ramblocks has to be read again
+   int built;                    // texture holds the current contents
+   u32 lastframe;
+   GLuint texture;
+} vdp2page_struct;
+
+static vdp2page_struct vdp2pages[VDP2_PAGE_CACHE_SIZE];
+static u32 vdp2pageframe;
+static int vdp2shaderdecode;   // asked for by VIDOGLSetShaderDecode
+static int vdp2decodeonshader; // and available, for this frame
+static int vdp2ramuploaded;    // shader decode has its copy of VDP2 RAM
+static unsigned int vdp2pagebuf[VDP2_PAGE_SIZE * VDP2_PAGE_SIZE];
+
+static void Vdp2PageCacheReset(void)
+{
+   int i;
+
+   for (i = 0; i < VDP2_PAGE_CACHE_SIZE; i++)
+      YglDeleteTexture(vdp2pages[i].texture);
+   memset(vdp2pages, 0, sizeof(vdp2pages));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Drops the textures of the pages whose VRAM or color RAM was written since
+// the last frame, and clears the dirty flags for the next one.
+static void Vdp2PageCacheUpdate(void)
+{
+   int i, j;
+
+   vdp2pageframe++;
+
+   vdp2decodeonshader = vdp2shaderdecode && YglCanDecodeVdp2Page();
+   if (vdp2decodeonshader)
+   {
+      YglUpdateVdp2Ram(vdp2ramuploaded ? Vdp2RamDirty : NULL);
+      if (Vdp2ColorRamDirty || !vdp2ramuploaded)
+         YglUpdateVdp2ColorRam();
+      vdp2ramuploaded = 1;
+   }
+
+   for (i = 0; i < VDP2_PAGE_CACHE_SIZE; i++)
+   {
+      vdp2page_struct * page = &vdp2pages[i];
+
+      if (!page->used || page->dirty)
+         continue;
+
+      // 16 and 32 BPP RGB don't go through color RAM
+      if (Vdp2ColorRamDirty && page->key.colornumber < 3)
+         page->dirty = 1;
+
+      for (j = 0; j < (0x80000 >> 13) && !page->dirty; j++)
+      {
+         if (page->ramblocks[j] & Vdp2RamDirty[j])
+            page->dirty = 1;
+      }
+
+      if (page->dirty)
+         page->built = 0;
+   }
+
+   memset(Vdp2RamDirty, 0, sizeof(Vdp2RamDirty));
+   Vdp2ColorRamDirty = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static vdp2page_struct * Vdp2PageCacheFind(vdp2pagekey_struct * key)
+{
+   vdp2page_struct * page = NULL;
+   int i;
+
+   for (i = 0; i < VDP2_PAGE_CACHE_SIZE; i++)
+   {
+      if (vdp2pages[i].used && memcmp(&vdp2pages[i].key, key, sizeof(vdp2pagekey_struct)) == 0)
+         return &vdp2pages[i];
+   }
+
+   // Take over the page drawn longest ago, but never one already queued for
+   // this frame as its texture is still to be rendered
+   for (i = 0; i < VDP2_PAGE_CACHE_SIZE; i++)
+   {
+      if (vdp2pages[i].used && vdp2pages[i].lastframe == vdp2pageframe)
+         continue;
+      if (page == NULL || !vdp2pages[i].used || vdp2pages[i].lastframe < page->lastframe)
+         page = &vdp2pages[i];
+      if (!page->used)
+         break;
+   }
+
+   if (page != NULL)
+   {
+      page->key = *key;
+      page->used = 1;
+      page->dirty = 1;
+      page->built = 0;
+   }
+   return page;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void Vdp2PageMarkRam(u32 * ramblocks, u32 addr, u32 size)
+{
+   u32 i;
+
+   for (i = addr >> 8; i <= (addr + size - 1) >> 8; i++)
+      ramblocks[(i >> 5) & 0x3F] |= 1 << (i & 0x1F);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Reads which VRAM the page uses and, if build is set, decodes it into the
+// page texture.
+static void Vdp2PageRead(vdp2draw_struct *info, vdp2page_struct *page, int build)
+{
+   static const u32 cellsize[] = { 0x20, 0x40, 0x80, 0x80, 0x100, 0x100, 0x100, 0x100 };
+   u32 pattern[16 * 16];
+   YglTexture texture;
+   u32 addr = info->addr;
+   int pixelwh = info->patternpixelwh;
+   int i, j, x, y;
+
+   memset(page->ramblocks, 0, sizeof(page->ramblocks));
+   Vdp2PageMarkRam(page->ramblocks, addr, info->pagewh * info->pagewh * info->patterndatasize * 2);
+
+   for (i = 0; i < info->pagewh; i++)
+   {
+      for (j = 0; j < info->pagewh; j++)
+      {
+         unsigned int * dst = vdp2pagebuf + i * pixelwh * VDP2_PAGE_SIZE + j * pixelwh;
+
+         Vdp2PatternAddr(info);
+         Vdp2PageMarkRam(page->ramblocks, info->charaddr & 0x7FFFF,
+                         cellsize[info->colornumber & 0x7] * info->patternwh * info->patternwh);
+         if (!build || vdp2decodeonshader)
+            continue;
+
+         texture.textdata = pattern;
+         texture.w = 0;
+         Vdp2DrawPatternCells(info, &texture);
+
+         for (y = 0; y < pixelwh; y++)
+         {
+            u32 * src = pattern + ((info->flipfunction & 0x2) ? pixelwh - 1 - y : y) * pixelwh;
+
+            if (info->flipfunction & 0x1)
+            {
+               for (x = 0; x < pixelwh; x++)
+                  dst[x] = src[pixelwh - 1 - x];
+            }
+            else
+               memcpy(dst, src, pixelwh * sizeof(u32));
+            dst += VDP2_PAGE_SIZE;
+         }
+      }
+   }
+
+   info->addr = addr;
+   page->dirty = 0;
+
+   if (build && vdp2decodeonshader)
+   {
+      YglVdp2Page decode;
+
+      decode.addr = addr;
+      decode.pagewh = info->pagewh;
+      decode.patternwh = info->patternwh;
+      decode.patterndatasize = info->patterndatasize;
+      decode.auxmode = info->auxmode;
+      decode.supplementdata = info->supplementdata;
+      decode.charmask = (Vdp2Regs->VRSIZE & 0x8000) ? 0x7FFF : 0x3FFF;
+      decode.colornumber = info->colornumber;
+      decode.coloroffset = info->coloroffset;
+      decode.transparencyenable = info->transparencyenable;
+      decode.alpha = info->alpha;
+      if (info->Vdp2ColorRamGetColor == (Vdp2ColorRamGetColor_func) Vdp2ColorRamGetColorCM01SC1)
+         decode.alphamode = 1;
+      else if (info->Vdp2ColorRamGetColor == (Vdp2ColorRamGetColor_func) Vdp2ColorRamGetColorCM01SC3)
+         decode.alphamode = 3;
+      else
+         decode.alphamode = 0;
+      decode.cor = decode.cog = decode.cob = 0;
+      if (info->PostPixelFetchCalc == &DoColorOffset)
+      {
+         decode.cor = info->cor;
+         decode.cog = info->cog;
+         decode.cob = info->cob;
+      }
+      page->texture = YglDecodeVdp2Page(page->texture, VDP2_PAGE_SIZE, VDP2_PAGE_SIZE, &decode);
+      page->built = 1;
+   }
+   else if (build)
+   {
+      page->texture = YglUploadTexture(page->texture, VDP2_PAGE_SIZE, VDP2_PAGE_SIZE, vdp2pagebuf);
+      page->built = 1;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Draws the page at info->addr from the page cache. Returns 0, with info left
+// as it was, when the page has to be drawn pattern by pattern instead.
+static int Vdp2DrawCachedPage(vdp2draw_struct *info)
+{
+   vdp2pagekey_struct key;
+   vdp2page_struct * page;
+   YglSprite tile;
+   int size = info->pagewh * info->patternpixelwh;
+
+   // Zoomed layers, per pattern priorities and line scroll aren't cached
+   if (info->coordincx != 1.0f || info->coordincy != 1.0f ||
+       info->specialprimode == 1 || info->islinescroll || size != VDP2_PAGE_SIZE ||
+       info->colornumber > 4)
+      return 0;
+
+   if (info->x + size > 0 && info->y + size > 0 &&
+       info->x < vdp2width && info->y < vdp2height)
+   {
+      memset(&key, 0, sizeof(key));
+      key.addr = info->addr;
+      key.colornumber = info->colornumber;
+      key.pagewh = info->pagewh;
+      key.patternwh = info->patternwh;
+      key.patterndatasize = info->patterndatasize;
+      key.auxmode = info->auxmode;
+      key.supplementdata = info->supplementdata;
+      key.charmask = Vdp2Regs->VRSIZE & 0x8000;
+      key.alpha = info->alpha;
+      key.coloroffset = info->coloroffset;
+      key.transparencyenable = info->transparencyenable;
+      key.Vdp2ColorRamGetColor = info->Vdp2ColorRamGetColor;
+      key.PostPixelFetchCalc = info->PostPixelFetchCalc;
+      if (info->PostPixelFetchCalc == &DoColorOffset)
+      {
+         key.cor = info->cor;
+         key.cog = info->cog;
+         key.cob = info->cob;
+      }
+
+      if ((page = Vdp2PageCacheFind(&key)) == NULL)
+         return 0;
+
+      page->lastframe = vdp2pageframe;
+      if (page->dirty)
+      {
+         Vdp2PageRead(info, page, 0);
+         return 0;
+      }
+      if (!page->built)
+         Vdp2PageRead(info, page, 1);
+
+      tile.vertices[0] = info->x;
+      tile.vertices[1] = info->y;
+      tile.vertices[2] = info->x + size;
+      tile.vertices[3] = info->y;
+      tile.vertices[4] = info->x + size;
+      tile.vertices[5] = info->y + size;
+      tile.vertices[6] = info->x;
+      tile.vertices[7] = info->y + size;
+      tile.w = tile.h = size;
+      tile.flip = 0;
+      tile.priority = info->priority;
+      tile.dst = 0;
+      tile.uclipmode = 0;
+      tile.blendmode = info->blendmode;
+      YglTextureQuad(&tile, page->texture);
+   }
+
+   info->addr += info->pagewh * info->pagewh * info->patterndatasize * 2;
+   info->x += size;
+   info->y += size;
+   return 1;
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 static void Vdp2DrawPage(vdp2draw_struct *info, YglTexture *texture)
@@ -1705,6 +2024,9 @@ static void Vdp2DrawPage(vdp2draw_struct *info, YglTexture *texture)
    int X, Y;
    int i, j;
 
+   if (Vdp2DrawCachedPage(info))
+      return;
+
    X = info->x;
    for(i = 0;i < info->pagewh;i++)
    {
@@ -2176,6 +2498,7 @@ int VIDOGLInit(void)
 
    vdp1wratio = 1;
    vdp1hratio = 1;
+   vdp2ramuploaded = 0;
 
    return 0;
 }
@@ -2184,7 +2507,9 @@ int VIDOGLInit(void)
 
 void VIDOGLDeInit(void)
 {
+   Vdp2PageCacheReset();
    YglDeInit();
+   vdp2ramuploaded = 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -2194,6 +2519,7 @@ int _VIDOGLIsFullscreen;
 void VIDOGLResize(unsigned int w, unsigned int h, int on)
 {
    glDeleteTextures(1, &_Ygl->texture);
+   Vdp2PageCacheReset();
 
    _VIDOGLIsFullscreen = on;
 
@@ -2223,6 +2549,58 @@ int VIDOGLVdp1Reset(void)
 
 //////////////////////////////////////////////////////////////////////////////
 
+// The VDP2 settings Vdp1ReadTexture() bakes into the texels. Sprite textures
+// are cached with the number of times they changed.
+static u16 vdp1cacheregs[12];
+static u32 vdp1cachestate;
+
+static void Vdp1SpriteCacheUpdate(void)
+{
+   u16 regs[12];
+
+   regs[0] = Vdp2Regs->CCCTL & 0x40;
+   regs[1] = Vdp2Regs->SPCTL;
+   regs[2] = Vdp2Regs->CRAOFB;
+   memcpy(regs + 3, &Vdp2Regs->PRISA, 4 * sizeof(u16));
+   memcpy(regs + 7, &Vdp2Regs->CCRSA, 4 * sizeof(u16));
+   regs[11] = Vdp2Internal.ColorMode;
+
+   if (memcmp(regs, vdp1cacheregs, sizeof(regs)))
+   {
+      memcpy(vdp1cacheregs, regs, sizeof(regs));
+      vdp1cachestate++;
+   }
+
+   YglCacheInvalidate(0, Vdp1RamDirty, 0);
+   memset(Vdp1RamDirty, 0, sizeof(Vdp1RamDirty));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Fills key with everything Vdp1ReadTexture() reads for cmd
+static void Vdp1SpriteCacheKey(vdp1cmd_struct *cmd, YglSprite *sprite, YglCacheKey *key)
+{
+   static const u32 bpp[8] = { 4, 4, 8, 8, 8, 16, 0, 0 };
+   int colormode = (cmd->CMDPMOD >> 3) & 0x7;
+
+   memset(key, 0, sizeof(YglCacheKey));
+   key->addr = (u32)cmd->CMDSRCA << 3;
+   key->w = sprite->w;
+   key->h = sprite->h;
+   key->mode = cmd->CMDPMOD;
+   key->palette = cmd->CMDCOLR;
+   key->state = vdp1cachestate;
+   key->size = sprite->w * sprite->h * bpp[colormode] / 8;
+   if (colormode == 1)
+   {
+      key->lutaddr = (u32)cmd->CMDCOLR << 3;
+      key->lutsize = 32;
+   }
+   key->colorram = (colormode != 5);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void VIDOGLVdp1DrawStart(void)
 {
    int i;
@@ -2230,7 +2608,7 @@ void VIDOGLVdp1DrawStart(void)
    int minpri;
    u8 *sprprilist = (u8 *)&Vdp2Regs->PRISA;
    
-   YglCacheReset();
+   Vdp1SpriteCacheUpdate();
    
 
    maxpri = 0x00;
@@ -2295,7 +2673,7 @@ void VIDOGLVdp1NormalSpriteDraw(void)
    YglSprite sprite;
    YglTexture texture;
    YglCache cash;
-   u32 tmp;
+   YglCacheKey key;
    s16 x, y;
    u16 CMDPMOD;
    u16 color2;
@@ -2303,7 +2681,7 @@ void VIDOGLVdp1NormalSpriteDraw(void)
    int i;
    
    
-   Vdp1ReadCommand(&cmd, Vdp1Regs->addr);
+   cmd = *Vdp1CurrentCommand;
    sprite.dst=0;
    sprite.blendmode=0;
 
@@ -2323,33 +2701,25 @@ void VIDOGLVdp1NormalSpriteDraw(void)
    sprite.vertices[6] = (int)((float)x * vdp1wratio);
    sprite.vertices[7] = (int)((float)(y + sprite.h) * vdp1hratio);
 
-   tmp = cmd.CMDSRCA;
-   tmp <<= 16;
-   tmp |= cmd.CMDCOLR;
+   Vdp1SpriteCacheKey(&cmd, &sprite, &key);
 
    sprite.priority = 8;
 
-   CMDPMOD = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x4);
+   CMDPMOD = cmd.CMDPMOD;
    
    sprite.uclipmode=(CMDPMOD>>9)&0x03;
    
    // Half trans parent to VDP1 Framebuffer
    if( (CMDPMOD & 0x7)==0x03 || (CMDPMOD & 0x100) )
    {
-      tmp |= 0x00010000;
       sprite.blendmode = 0x80;
    }
    
-   if((CMDPMOD & 0x8000) != 0)
-   {
-      tmp |= 0x00020000;
-   }
-
    if( (CMDPMOD & 4)  )
    {
       for (i=0; i<4; i++)
       {
-         color2 = T1ReadWord(Vdp1Ram, (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x1C) << 3) + (i << 1));
+         color2 = T1ReadWord(Vdp1Ram, (cmd.CMDGRDA << 3) + (i << 1));
          col[(i << 2) + 0] = (float)((color2 & 0x001F))/(float)(0x1F)-0.5f;
          col[(i << 2) + 1] = (float)((color2 & 0x03E0)>>5)/(float)(0x1F)-0.5f;
          col[(i << 2) + 2] = (float)((color2 & 0x7C00)>>10)/(float)(0x1F)-0.5f;
@@ -2358,14 +2728,14 @@ void VIDOGLVdp1NormalSpriteDraw(void)
      
       if (sprite.w > 0 && sprite.h > 1)
       {
-         if (1 == YglIsCached(tmp,&cash) )
+         if (1 == YglIsCached(&key,&cash) )
          {
             YglCacheQuadGrowShading(&sprite, col,&cash);
             return;
          }
 
          YglQuadGrowShading(&sprite, &texture,col,&cash);
-         YglCacheAdd(tmp,&cash);
+         YglCacheAdd(&key,&cash);
          Vdp1ReadTexture(&cmd, &sprite, &texture);
          return;
       }
@@ -2375,14 +2745,14 @@ void VIDOGLVdp1NormalSpriteDraw(void)
    {
       if (sprite.w > 0 && sprite.h > 1)
       {
-         if (1 == YglIsCached(tmp,&cash) )
+         if (1 == YglIsCached(&key,&cash) )
          {
             YglCachedQuad(&sprite, &cash);
             return;
          }
 
          YglQuad(&sprite, &texture,&cash);
-         YglCacheAdd(tmp,&cash);
+         YglCacheAdd(&key,&cash);
 
          Vdp1ReadTexture(&cmd, &sprite, &texture);
       }
@@ -2397,7 +2767,7 @@ void VIDOGLVdp1ScaledSpriteDraw(void)
    YglSprite sprite;
    YglTexture texture;
    YglCache cash;
-   u32 tmp;
+   YglCacheKey key;
    s16 rw=0, rh=0;
    s16 x, y;
    u16 CMDPMOD;
@@ -2405,7 +2775,7 @@ void VIDOGLVdp1ScaledSpriteDraw(void)
    float col[4*4];
    int i;
 
-   Vdp1ReadCommand(&cmd, Vdp1Regs->addr);
+   cmd = *Vdp1CurrentCommand;
    sprite.dst=0;
    sprite.blendmode=0;
    
@@ -2498,11 +2868,9 @@ void VIDOGLVdp1ScaledSpriteDraw(void)
    sprite.vertices[6] = (int)((float)x * vdp1wratio);
    sprite.vertices[7] = (int)((float)(y + rh) * vdp1hratio);
 
-   tmp = cmd.CMDSRCA;
-   tmp <<= 16;
-   tmp |= cmd.CMDCOLR;
+   Vdp1SpriteCacheKey(&cmd, &sprite, &key);
 
-   CMDPMOD = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x4);
+   CMDPMOD = cmd.CMDPMOD;
    sprite.uclipmode=(CMDPMOD>>9)&0x03;
    
    sprite.priority = 8;
@@ -2510,22 +2878,15 @@ void VIDOGLVdp1ScaledSpriteDraw(void)
    // Half trans parent to VDP1 Framebuffer
    if( (CMDPMOD & 0x7)==0x03 || (CMDPMOD & 0x100) )
    {
-      tmp |= 0x00010000;
       sprite.blendmode = 0x80;
    }  
    
-   // MSB
-   if((CMDPMOD & 0x8000) != 0)
-   {
-      tmp |= 0x00020000;
-   }
-   
    
    if ( (CMDPMOD & 4) )
    {
       for (i=0; i<4; i++)
       {
-         color2 = T1ReadWord(Vdp1Ram, (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x1C) << 3) + (i << 1));
+         color2 = T1ReadWord(Vdp1Ram, (cmd.CMDGRDA << 3) + (i << 1));
          col[(i << 2) + 0] = (float)((color2 & 0x001F))/(float)(0x1F)-0.5f;
          col[(i << 2) + 1] = (float)((color2 & 0x03E0)>>5)/(float)(0x1F)-0.5f;
          col[(i << 2) + 2] = (float)((color2 & 0x7C00)>>10)/(float)(0x1F)-0.5f;
@@ -2534,14 +2895,14 @@ void VIDOGLVdp1ScaledSpriteDraw(void)
      
       if (sprite.w > 0 && sprite.h > 1)
       {
-         if (1 == YglIsCached(tmp,&cash) )
+         if (1 == YglIsCached(&key,&cash) )
          {
             YglCacheQuadGrowShading(&sprite, col,&cash);
             return;
          }
 
          YglQuadGrowShading(&sprite, &texture,col,&cash);
-         YglCacheAdd(tmp,&cash);
+         YglCacheAdd(&key,&cash);
          Vdp1ReadTexture(&cmd, &sprite, &texture);
          return;
       }
@@ -2551,14 +2912,14 @@ void VIDOGLVdp1ScaledSpriteDraw(void)
    {
       if (sprite.w > 0 && sprite.h > 1)
       {
-         if (1 == YglIsCached(tmp,&cash) )
+         if (1 == YglIsCached(&key,&cash) )
          {
             YglCachedQuad(&sprite, &cash);
             return;
          }
 
          YglQuad(&sprite, &texture,&cash);
-         YglCacheAdd(tmp,&cash);
+         YglCacheAdd(&key,&cash);
 
          Vdp1ReadTexture(&cmd, &sprite, &texture);
       }
@@ -2575,14 +2936,14 @@ void VIDOGLVdp1DistortedSpriteDraw(void)
    YglSprite sprite;
    YglTexture texture;
    YglCache cash;
-   u32 tmp;
+   YglCacheKey key;
    u16 CMDPMOD;
    u16 color2;
    int i;
    float col[4*4];
    
 
-   Vdp1ReadCommand(&cmd, Vdp1Regs->addr);
+   cmd = *Vdp1CurrentCommand;
    sprite.blendmode=0;
    sprite.dst = 1;
    sprite.w = ((cmd.CMDSIZE >> 8) & 0x3F) * 8;
@@ -2599,12 +2960,9 @@ void VIDOGLVdp1DistortedSpriteDraw(void)
    sprite.vertices[6] = (s32)((float)(cmd.CMDXD + Vdp1Regs->localX) * vdp1wratio);
    sprite.vertices[7] = (s32)((float)((cmd.CMDYD) + Vdp1Regs->localY) * vdp1hratio);
 
-   tmp = cmd.CMDSRCA;
-
-   tmp <<= 16;
-   tmp |= cmd.CMDCOLR;
+   Vdp1SpriteCacheKey(&cmd, &sprite, &key);
 
-   CMDPMOD = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x4);
+   CMDPMOD = cmd.CMDPMOD;
    
    sprite.priority = 8;
    
@@ -2613,22 +2971,15 @@ void VIDOGLVdp1DistortedSpriteDraw(void)
    // Half trans parent to VDP1 Framebuffer
    if( (CMDPMOD & 0x7)==0x03 || (CMDPMOD & 0x100) )
    {
-      tmp |= 0x00010000;
       sprite.blendmode = 0x80;
    }   
 
-   // MSB
-   if((CMDPMOD & 0x8000) != 0)
-   {
-      tmp |= 0x00020000;
-   }
-   
    // Check if the Gouraud shading bit is set and the color mode is RGB
    if ( (CMDPMOD & 4) )
    {
       for (i=0; i<4; i++)
       {
-         color2 = T1ReadWord(Vdp1Ram, (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x1C) << 3) + (i << 1));
+         color2 = T1ReadWord(Vdp1Ram, (cmd.CMDGRDA << 3) + (i << 1));
          col[(i << 2) + 0] = (float)((color2 & 0x001F))/(float)(0x1F)-0.5f;
          col[(i << 2) + 1] = (float)((color2 & 0x03E0)>>5)/(float)(0x1F)-0.5f;
          col[(i << 2) + 2] = (float)((color2 & 0x7C00)>>10)/(float)(0x1F)-0.5f;
@@ -2637,7 +2988,7 @@ void VIDOGLVdp1DistortedSpriteDraw(void)
      
       if (sprite.w > 0 && sprite.h > 1)
       {
-         if (1 == YglIsCached(tmp,&cash) )
+         if (1 == YglIsCached(&key,&cash) )
          {
             YglCacheQuadGrowShading(&sprite, col,&cash);
             return;
@@ -2645,7 +2996,7 @@ void VIDOGLVdp1DistortedSpriteDraw(void)
 
          YglQuadGrowShading(&sprite, &texture,col,&cash);
          //YglQuad(&sprite, &texture,&c);
-         YglCacheAdd(tmp,&cash);
+         YglCacheAdd(&key,&cash);
          Vdp1ReadTexture(&cmd, &sprite, &texture);
          return;
       }
@@ -2655,14 +3006,14 @@ void VIDOGLVdp1DistortedSpriteDraw(void)
    {
       if (sprite.w > 0 && sprite.h > 1)
       {
-         if (1 == YglIsCached(tmp,&cash) )
+         if (1 == YglIsCached(&key,&cash) )
          {
             YglCachedQuad(&sprite, &cash);
             return;
          }
 
          YglQuad(&sprite, &texture,&cash);
-         YglCacheAdd(tmp,&cash);
+         YglCacheAdd(&key,&cash);
 
          Vdp1ReadTexture(&cmd, &sprite, &texture);
       }
@@ -2691,17 +3042,17 @@ void VIDOGLVdp1PolygonDraw(void)
 
    polygon.blendmode=0;
    polygon.dst = 0;
-   X[0] = Vdp1Regs->localX + T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0xC);
-   Y[0] = Vdp1Regs->localY + T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0xE);
-   X[1] = Vdp1Regs->localX + T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x10);
-   Y[1] = Vdp1Regs->localY + T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x12);
-   X[2] = Vdp1Regs->localX + T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x14);
-   Y[2] = Vdp1Regs->localY + T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x16);
-   X[3] = Vdp1Regs->localX + T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x18);
-   Y[3] = Vdp1Regs->localY + T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x1A);
-
-   color = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x6);
-   CMDPMOD = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x4);
+   X[0] = Vdp1Regs->localX + Vdp1CurrentCommand->CMDXA;
+   Y[0] = Vdp1Regs->localY + Vdp1CurrentCommand->CMDYA;
+   X[1] = Vdp1Regs->localX + Vdp1CurrentCommand->CMDXB;
+   Y[1] = Vdp1Regs->localY + Vdp1CurrentCommand->CMDYB;
+   X[2] = Vdp1Regs->localX + Vdp1CurrentCommand->CMDXC;
+   Y[2] = Vdp1Regs->localY + Vdp1CurrentCommand->CMDYC;
+   X[3] = Vdp1Regs->localX + Vdp1CurrentCommand->CMDXD;
+   Y[3] = Vdp1Regs->localY + Vdp1CurrentCommand->CMDYD;
+
+   color = Vdp1CurrentCommand->CMDCOLR;
+   CMDPMOD = Vdp1CurrentCommand->CMDPMOD;
    polygon.uclipmode=(CMDPMOD>>9)&0x03;
    
   
@@ -2717,7 +3068,7 @@ void VIDOGLVdp1PolygonDraw(void)
    {
       for (i=0; i<4; i++)
       {
-         color2 = T1ReadWord(Vdp1Ram, (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x1C) << 3) + (i << 1));
+         color2 = T1ReadWord(Vdp1Ram, (Vdp1CurrentCommand->CMDGRDA << 3) + (i << 1));
          col[(i << 2) + 0] = (float)((color2 & 0x001F))/(float)(0x1F)-0.5f;
          col[(i << 2) + 1] = (float)((color2 & 0x03E0)>>5)/(float)(0x1F)-0.5f;
          col[(i << 2) + 2] = (float)((color2 & 0x7C00)>>10)/(float)(0x1F)-0.5f;
@@ -2801,17 +3152,17 @@ void VIDOGLVdp1PolylineDraw(void)
 
    polygon.blendmode=0;   
    polygon.dst = 0;
-   X[0] = Vdp1Regs->localX + (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x0C) );
-   Y[0] = Vdp1Regs->localY + (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x0E) );
-   X[1] = Vdp1Regs->localX + (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x10) );
-   Y[1] = Vdp1Regs->localY + (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x12) );
-   X[2] = Vdp1Regs->localX + (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x14) );
-   Y[2] = Vdp1Regs->localY + (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x16) );
-   X[3] = Vdp1Regs->localX + (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x18) );
-   Y[3] = Vdp1Regs->localY + (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x1A) );
-
-   color = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x6);
-   CMDPMOD = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x4);
+   X[0] = Vdp1Regs->localX + Vdp1CurrentCommand->CMDXA;
+   Y[0] = Vdp1Regs->localY + Vdp1CurrentCommand->CMDYA;
+   X[1] = Vdp1Regs->localX + Vdp1CurrentCommand->CMDXB;
+   Y[1] = Vdp1Regs->localY + Vdp1CurrentCommand->CMDYB;
+   X[2] = Vdp1Regs->localX + Vdp1CurrentCommand->CMDXC;
+   Y[2] = Vdp1Regs->localY + Vdp1CurrentCommand->CMDYC;
+   X[3] = Vdp1Regs->localX + Vdp1CurrentCommand->CMDXD;
+   Y[3] = Vdp1Regs->localY + Vdp1CurrentCommand->CMDYD;
+
+   color = Vdp1CurrentCommand->CMDCOLR;
+   CMDPMOD = Vdp1CurrentCommand->CMDPMOD;
    polygon.uclipmode=(CMDPMOD>>9)&0x03;
    
 
@@ -2915,13 +3266,13 @@ void VIDOGLVdp1LineDraw(void)
    
    polygon.blendmode=0;
    polygon.dst = 0;
-   X[0] = Vdp1Regs->localX + (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x0C));
-   Y[0] = Vdp1Regs->localY + (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x0E));
-   X[1] = Vdp1Regs->localX + (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x10));
-   Y[1] = Vdp1Regs->localY + (T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x12));
+   X[0] = Vdp1Regs->localX + Vdp1CurrentCommand->CMDXA;
+   Y[0] = Vdp1Regs->localY + Vdp1CurrentCommand->CMDYA;
+   X[1] = Vdp1Regs->localX + Vdp1CurrentCommand->CMDXB;
+   Y[1] = Vdp1Regs->localY + Vdp1CurrentCommand->CMDYB;
 
-   color = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x6);
-   CMDPMOD = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x4);
+   color = Vdp1CurrentCommand->CMDCOLR;
+   CMDPMOD = Vdp1CurrentCommand->CMDPMOD;
    polygon.uclipmode=(CMDPMOD>>9)&0x03;
 
    // Half trans parent to VDP1 Framebuffer
@@ -2985,10 +3336,10 @@ void VIDOGLVdp1LineDraw(void)
 
 void VIDOGLVdp1UserClipping(void)
 {
-   Vdp1Regs->userclipX1 = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0xC);
-   Vdp1Regs->userclipY1 = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0xE);
-   Vdp1Regs->userclipX2 = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x14);
-   Vdp1Regs->userclipY2 = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x16);
+   Vdp1Regs->userclipX1 = Vdp1CurrentCommand->CMDXA;
+   Vdp1Regs->userclipY1 = Vdp1CurrentCommand->CMDYA;
+   Vdp1Regs->userclipX2 = Vdp1CurrentCommand->CMDXC;
+   Vdp1Regs->userclipY2 = Vdp1CurrentCommand->CMDYC;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -2997,16 +3348,62 @@ void VIDOGLVdp1SystemClipping(void)
 {
    Vdp1Regs->systemclipX1 = 0;
    Vdp1Regs->systemclipY1 = 0;
-   Vdp1Regs->systemclipX2 = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x14);
-   Vdp1Regs->systemclipY2 = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x16);
+   Vdp1Regs->systemclipX2 = Vdp1CurrentCommand->CMDXC;
+   Vdp1Regs->systemclipY2 = Vdp1CurrentCommand->CMDYC;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
 void VIDOGLVdp1LocalCoordinate(void)
 {
-   Vdp1Regs->localX = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0xC);
-   Vdp1Regs->localY = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0xE);
+   Vdp1Regs->localX = Vdp1CurrentCommand->CMDXA;
+   Vdp1Regs->localY = Vdp1CurrentCommand->CMDYA;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void VIDOGLVdp1ReadFrameBuffer(u8 *framebuffer)
+{
+   const u8 *pixels;
+   const u8 *src;
+   int width, height;
+   int fbwidth, fbheight;
+   float xscale, yscale;
+   int x, y, tx, ty;
+   u16 dot;
+
+   if ((pixels = YglMapVdp1Readback(&width, &height)) == NULL)
+      return;
+
+   // The readback is at window size, sample it once per VDP1 pixel
+   fbwidth = (int)(vdp2width / vdp1wratio);
+   fbheight = (int)(vdp2height / vdp1hratio);
+   if (fbwidth > 512) fbwidth = 512;
+   if (fbheight > 256) fbheight = 256;
+   xscale = vdp1wratio * width / vdp2width;
+   yscale = vdp1hratio * height / vdp2height;
+
+   for (y = 0; y < fbheight; y++)
+   {
+      ty = height - 1 - (int)((y + 0.5f) * yscale);
+      if (ty < 0) ty = 0;
+
+      for (x = 0; x < fbwidth; x++)
+      {
+         tx = (int)((x + 0.5f) * xscale);
+         if (tx >= width) tx = width - 1;
+
+         // Colors were stored as SAT2YAB1(), nothing drawn is all zero
+         src = pixels + (ty * width + tx) * 4;
+         if (src[0] | src[1] | src[2] | src[3])
+            dot = 0x8000 | (src[0] >> 3) | ((src[1] >> 3) << 5) | ((src[2] >> 3) << 10);
+         else
+            dot = 0;
+         T1WriteWord(framebuffer, (y * 512 + x) * 2, dot);
+      }
+   }
+
+   YglUnmapVdp1Readback();
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -3018,10 +3415,23 @@ int VIDOGLVdp2Reset(void)
 
 //////////////////////////////////////////////////////////////////////////////
 
+void VIDOGLSetShaderDecode(int on)
+{
+   if (vdp2shaderdecode == on)
+      return;
+
+   vdp2shaderdecode = on;
+   vdp2ramuploaded = 0;
+   Vdp2PageCacheReset();
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void VIDOGLVdp2DrawStart(void)
 {
    YglReset();
-   YglCacheReset();
+   YglCacheInvalidate(1, Vdp2RamDirty, Vdp2ColorRamDirty);
+   Vdp2PageCacheUpdate();
 }
 
 //////////////////////////////////////////////////////////////////////////////
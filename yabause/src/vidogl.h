@@ -27,6 +27,11 @@
 #define VIDCORE_OGL   1
 
 extern VideoInterface_struct VIDOGL;
+
+// Decodes VDP2 pages with a shader reading VDP2 RAM and color RAM uploaded
+// as they are, instead of on the CPU. Ignored where the shader can't be
+// built.
+void VIDOGLSetShaderDecode(int on);
 #endif
 
 #endif
@@ -31,22 +31,22 @@
 
 void FASTCALL Vdp2NBG0PlaneAddr(vdp2draw_struct *info, int i)
 {
-   u32 offset = (Vdp2Regs->MPOFN & 0x7) << 6;
+   u32 offset = (Vdp2DrawRegs->MPOFN & 0x7) << 6;
    u32 tmp=0;
 
    switch(i)
    {
       case 0:
-         tmp = offset | (Vdp2Regs->MPABN0 & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPABN0 & 0xFF);
          break;
       case 1:
-         tmp = offset | (Vdp2Regs->MPABN0 >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPABN0 >> 8);
          break;
       case 2:
-         tmp = offset | (Vdp2Regs->MPCDN0 & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPCDN0 & 0xFF);
          break;
       case 3:
-         tmp = offset | (Vdp2Regs->MPCDN0 >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPCDN0 >> 8);
          break;
    }
 
@@ -57,22 +57,22 @@ void FASTCALL Vdp2NBG0PlaneAddr(vdp2draw_struct *info, int i)
 
 void FASTCALL Vdp2NBG1PlaneAddr(vdp2draw_struct *info, int i)
 {
-   u32 offset = (Vdp2Regs->MPOFN & 0x70) << 2;
+   u32 offset = (Vdp2DrawRegs->MPOFN & 0x70) << 2;
    u32 tmp=0;
 
    switch(i)
    {
       case 0:
-         tmp = offset | (Vdp2Regs->MPABN1 & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPABN1 & 0xFF);
          break;
       case 1:
-         tmp = offset | (Vdp2Regs->MPABN1 >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPABN1 >> 8);
          break;
       case 2:
-         tmp = offset | (Vdp2Regs->MPCDN1 & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPCDN1 & 0xFF);
          break;
       case 3:
-         tmp = offset | (Vdp2Regs->MPCDN1 >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPCDN1 >> 8);
          break;
    }
 
@@ -83,22 +83,22 @@ void FASTCALL Vdp2NBG1PlaneAddr(vdp2draw_struct *info, int i)
 
 void FASTCALL Vdp2NBG2PlaneAddr(vdp2draw_struct *info, int i)
 {
-   u32 offset = (Vdp2Regs->MPOFN & 0x700) >> 2;
+   u32 offset = (Vdp2DrawRegs->MPOFN & 0x700) >> 2;
    u32 tmp=0;
 
    switch(i)
    {
       case 0:
-         tmp = offset | (Vdp2Regs->MPABN2 & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPABN2 & 0xFF);
          break;
       case 1:
-         tmp = offset | (Vdp2Regs->MPABN2 >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPABN2 >> 8);
          break;
       case 2:
-         tmp = offset | (Vdp2Regs->MPCDN2 & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPCDN2 & 0xFF);
          break;
       case 3:
-         tmp = offset | (Vdp2Regs->MPCDN2 >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPCDN2 >> 8);
          break;
    }
 
@@ -109,22 +109,22 @@ void FASTCALL Vdp2NBG2PlaneAddr(vdp2draw_struct *info, int i)
 
 void FASTCALL Vdp2NBG3PlaneAddr(vdp2draw_struct *info, int i)
 {
-   u32 offset = (Vdp2Regs->MPOFN & 0x7000) >> 6;
+   u32 offset = (Vdp2DrawRegs->MPOFN & 0x7000) >> 6;
    u32 tmp=0;
 
    switch(i)
    {
       case 0:
-         tmp = offset | (Vdp2Regs->MPABN3 & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPABN3 & 0xFF);
          break;
       case 1:
-         tmp = offset | (Vdp2Regs->MPABN3 >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPABN3 >> 8);
          break;
       case 2:
-         tmp = offset | (Vdp2Regs->MPCDN3 & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPCDN3 & 0xFF);
          break;
       case 3:
-         tmp = offset | (Vdp2Regs->MPCDN3 >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPCDN3 >> 8);
          break;
    }
 
@@ -138,141 +138,141 @@ void Vdp2ReadRotationTable(int which, vdp2rotationparameter_struct *parameter)
    s32 i;
    u32 addr;
 
-   addr = Vdp2Regs->RPTA.all << 1;
+   addr = Vdp2DrawRegs->RPTA.all << 1;
 
    if (which == 0)
    {
       // Rotation Parameter A
-      addr &= 0x000FFF7C;
-      parameter->coefenab = Vdp2Regs->KTCTL & 0x1;
-      parameter->screenover = (Vdp2Regs->PLSZ >> 10) & 0x3;
+      addr &= 0x0007FF7C;
+      parameter->coefenab = Vdp2DrawRegs->KTCTL & 0x1;
+      parameter->screenover = (Vdp2DrawRegs->PLSZ >> 10) & 0x3;
    }
    else
    {
       // Rotation Parameter B
-      addr = (addr & 0x000FFFFC) | 0x00000080;
-      parameter->coefenab = Vdp2Regs->KTCTL & 0x100;
-      parameter->screenover = (Vdp2Regs->PLSZ >> 14) & 0x3;
+      addr = (addr & 0x0007FFFC) | 0x00000080;
+      parameter->coefenab = Vdp2DrawRegs->KTCTL & 0x100;
+      parameter->screenover = (Vdp2DrawRegs->PLSZ >> 14) & 0x3;
    }
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->Xst = (float) (signed) ((i & 0x1FFFFFC0) | (i & 0x10000000 ? 0xF0000000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->Yst = (float) (signed) ((i & 0x1FFFFFC0) | (i & 0x10000000 ? 0xF0000000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->Zst = (float) (signed) ((i & 0x1FFFFFC0) | (i & 0x10000000 ? 0xF0000000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->deltaXst = (float) (signed) ((i & 0x0007FFC0) | (i & 0x00040000 ? 0xFFFC0000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->deltaYst = (float) (signed) ((i & 0x0007FFC0) | (i & 0x00040000 ? 0xFFFC0000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->deltaX = (float) (signed) ((i & 0x0007FFC0) | (i & 0x00040000 ? 0xFFFC0000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->deltaY = (float) (signed) ((i & 0x0007FFC0) | (i & 0x00040000 ? 0xFFFC0000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->A = (float) (signed) ((i & 0x000FFFC0) | (i & 0x00080000 ? 0xFFF80000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->B = (float) (signed) ((i & 0x000FFFC0) | ((i & 0x00080000) ? 0xFFF80000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->C = (float) (signed) ((i & 0x000FFFC0) | (i & 0x00080000 ? 0xFFF80000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->D = (float) (signed) ((i & 0x000FFFC0) | (i & 0x00080000 ? 0xFFF80000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->E = (float) (signed) ((i & 0x000FFFC0) | (i & 0x00080000 ? 0xFFF80000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->F = (float) (signed) ((i & 0x000FFFC0) | (i & 0x00080000 ? 0xFFF80000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadWord(Vdp2Ram, addr);
+   i = T1ReadWord(Vdp2DrawRam, addr);
    parameter->Px = (float) (signed) ((i & 0x3FFF) | (i & 0x2000 ? 0xFFF80000 : 0x00000000));
    addr += 2;
 
-   i = T1ReadWord(Vdp2Ram, addr);
+   i = T1ReadWord(Vdp2DrawRam, addr);
    parameter->Py = (float) (signed) ((i & 0x3FFF) | (i & 0x2000 ? 0xFFF80000 : 0x00000000));
    addr += 2;
 
-   i = T1ReadWord(Vdp2Ram, addr);
+   i = T1ReadWord(Vdp2DrawRam, addr);
    parameter->Pz = (float) (signed) ((i & 0x3FFF) | (i & 0x2000 ? 0xFFF80000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadWord(Vdp2Ram, addr);
+   i = T1ReadWord(Vdp2DrawRam, addr);
    parameter->Cx = (float) (signed) ((i & 0x3FFF) | (i & 0x2000 ? 0xFFF80000 : 0x00000000));
    addr += 2;
 
-   i = T1ReadWord(Vdp2Ram, addr);
+   i = T1ReadWord(Vdp2DrawRam, addr);
    parameter->Cy = (float) (signed) ((i & 0x3FFF) | (i & 0x2000 ? 0xFFF80000 : 0x00000000));
    addr += 2;
 
-   i = T1ReadWord(Vdp2Ram, addr);
+   i = T1ReadWord(Vdp2DrawRam, addr);
    parameter->Cz = (float) (signed) ((i & 0x3FFF) | (i & 0x2000 ? 0xFFF80000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->Mx = (float) (signed) ((i & 0x3FFFFFC0) | (i & 0x20000000 ? 0xE0000000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->My = (float) (signed) ((i & 0x3FFFFFC0) | (i & 0x20000000 ? 0xE0000000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->kx = (float) (signed) ((i & 0x00FFFFFF) | (i & 0x00800000 ? 0xFF800000 : 0x00000000)) / 65536;
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->ky = (float) (signed) ((i & 0x00FFFFFF) | (i & 0x00800000 ? 0xFF800000 : 0x00000000)) / 65536;
    addr += 4;
 
    if (parameter->coefenab)
    {
       // Read in coefficient values
-      i = T1ReadLong(Vdp2Ram, addr);
+      i = T1ReadLong(Vdp2DrawRam, addr);
       parameter->KAst = (float)(unsigned)(i & 0xFFFFFFC0) / 65536;
       addr += 4;
 
-      i = T1ReadLong(Vdp2Ram, addr);
+      i = T1ReadLong(Vdp2DrawRam, addr);
       parameter->deltaKAst = (float) (signed) ((i & 0x03FFFFC0) | (i & 0x02000000 ? 0xFE000000 : 0x00000000)) / 65536;
       addr += 4;     
 
-      i = T1ReadLong(Vdp2Ram, addr);
+      i = T1ReadLong(Vdp2DrawRam, addr);
       parameter->deltaKAx = (float) (signed) ((i & 0x03FFFFC0) | (i & 0x02000000 ? 0xFE000000 : 0x00000000)) / 65536;
       addr += 4;
 
       if (which == 0)
       {
-         parameter->coefdatasize = (Vdp2Regs->KTCTL & 0x2 ? 2 : 4);
-         parameter->coeftbladdr = ((Vdp2Regs->KTAOF & 0x7) * 0x10000 + (int)(parameter->KAst)) * parameter->coefdatasize;
-         parameter->coefmode = (Vdp2Regs->KTCTL >> 2) & 0x3;
+         parameter->coefdatasize = (Vdp2DrawRegs->KTCTL & 0x2 ? 2 : 4);
+         parameter->coeftbladdr = ((Vdp2DrawRegs->KTAOF & 0x7) * 0x10000 + (int)(parameter->KAst)) * parameter->coefdatasize;
+         parameter->coefmode = (Vdp2DrawRegs->KTCTL >> 2) & 0x3;
       }
       else
       {
-         parameter->coefdatasize = (Vdp2Regs->KTCTL & 0x200 ? 2 : 4);
-         parameter->coeftbladdr = (((Vdp2Regs->KTAOF >> 8) & 0x7) * 0x10000 + (int)(parameter->KAst)) * parameter->coefdatasize;
-         parameter->coefmode = (Vdp2Regs->KTCTL >> 10) & 0x3;
+         parameter->coefdatasize = (Vdp2DrawRegs->KTCTL & 0x200 ? 2 : 4);
+         parameter->coeftbladdr = (((Vdp2DrawRegs->KTAOF >> 8) & 0x7) * 0x10000 + (int)(parameter->KAst)) * parameter->coefdatasize;
+         parameter->coefmode = (Vdp2DrawRegs->KTCTL >> 10) & 0x3;
       }
    }
    
@@ -297,141 +297,141 @@ void Vdp2ReadRotationTableFP(int which, vdp2rotationparameterfp_struct *paramete
    s32 i;
    u32 addr;
 
-   addr = Vdp2Regs->RPTA.all << 1;
+   addr = Vdp2DrawRegs->RPTA.all << 1;
 
    if (which == 0)
    {
       // Rotation Parameter A
-      addr &= 0x000FFF7C;
-      parameter->coefenab = Vdp2Regs->KTCTL & 0x1;
-      parameter->screenover = (Vdp2Regs->PLSZ >> 10) & 0x3;
+      addr &= 0x0007FF7C;
+      parameter->coefenab = Vdp2DrawRegs->KTCTL & 0x1;
+      parameter->screenover = (Vdp2DrawRegs->PLSZ >> 10) & 0x3;
    }
    else
    {
       // Rotation Parameter B
-      addr = (addr & 0x000FFFFC) | 0x00000080;
-      parameter->coefenab = Vdp2Regs->KTCTL & 0x100;
-      parameter->screenover = (Vdp2Regs->PLSZ >> 14) & 0x3;
+      addr = (addr & 0x0007FFFC) | 0x00000080;
+      parameter->coefenab = Vdp2DrawRegs->KTCTL & 0x100;
+      parameter->screenover = (Vdp2DrawRegs->PLSZ >> 14) & 0x3;
    }
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->Xst = (signed) ((i & 0x1FFFFFC0) | (i & 0x10000000 ? 0xF0000000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->Yst = (signed) ((i & 0x1FFFFFC0) | (i & 0x10000000 ? 0xF0000000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->Zst = (signed) ((i & 0x1FFFFFC0) | (i & 0x10000000 ? 0xF0000000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->deltaXst = (signed) ((i & 0x0007FFC0) | (i & 0x00040000 ? 0xFFFC0000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->deltaYst = (signed) ((i & 0x0007FFC0) | (i & 0x00040000 ? 0xFFFC0000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->deltaX = (signed) ((i & 0x0007FFC0) | (i & 0x00040000 ? 0xFFFC0000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->deltaY = (signed) ((i & 0x0007FFC0) | (i & 0x00040000 ? 0xFFFC0000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->A = (signed) ((i & 0x000FFFC0) | (i & 0x00080000 ? 0xFFF80000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->B = (signed) ((i & 0x000FFFC0) | ((i & 0x00080000) ? 0xFFF80000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->C = (signed) ((i & 0x000FFFC0) | (i & 0x00080000 ? 0xFFF80000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->D = (signed) ((i & 0x000FFFC0) | (i & 0x00080000 ? 0xFFF80000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->E = (signed) ((i & 0x000FFFC0) | (i & 0x00080000 ? 0xFFF80000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->F = (signed) ((i & 0x000FFFC0) | (i & 0x00080000 ? 0xFFF80000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadWord(Vdp2Ram, addr);
+   i = T1ReadWord(Vdp2DrawRam, addr);
    parameter->Px = tofixed((signed) ((i & 0x3FFF) | (i & 0x2000 ? 0xFFF80000 : 0x00000000)));
    addr += 2;
 
-   i = T1ReadWord(Vdp2Ram, addr);
+   i = T1ReadWord(Vdp2DrawRam, addr);
    parameter->Py = tofixed((signed) ((i & 0x3FFF) | (i & 0x2000 ? 0xFFF80000 : 0x00000000)));
    addr += 2;
 
-   i = T1ReadWord(Vdp2Ram, addr);
+   i = T1ReadWord(Vdp2DrawRam, addr);
    parameter->Pz = tofixed((signed) ((i & 0x3FFF) | (i & 0x2000 ? 0xFFF80000 : 0x00000000)));
    addr += 4;
 
-   i = T1ReadWord(Vdp2Ram, addr);
+   i = T1ReadWord(Vdp2DrawRam, addr);
    parameter->Cx = tofixed((signed) ((i & 0x3FFF) | (i & 0x2000 ? 0xFFF80000 : 0x00000000)));
    addr += 2;
 
-   i = T1ReadWord(Vdp2Ram, addr);
+   i = T1ReadWord(Vdp2DrawRam, addr);
    parameter->Cy = tofixed((signed) ((i & 0x3FFF) | (i & 0x2000 ? 0xFFF80000 : 0x00000000)));
    addr += 2;
 
-   i = T1ReadWord(Vdp2Ram, addr);
+   i = T1ReadWord(Vdp2DrawRam, addr);
    parameter->Cz = tofixed((signed) ((i & 0x3FFF) | (i & 0x2000 ? 0xFFF80000 : 0x00000000)));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->Mx = (signed) ((i & 0x3FFFFFC0) | (i & 0x20000000 ? 0xE0000000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->My = (signed) ((i & 0x3FFFFFC0) | (i & 0x20000000 ? 0xE0000000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->kx = (signed) ((i & 0x00FFFFFF) | (i & 0x00800000 ? 0xFF800000 : 0x00000000));
    addr += 4;
 
-   i = T1ReadLong(Vdp2Ram, addr);
+   i = T1ReadLong(Vdp2DrawRam, addr);
    parameter->ky = (signed) ((i & 0x00FFFFFF) | (i & 0x00800000 ? 0xFF800000 : 0x00000000));
    addr += 4;
 
    if (parameter->coefenab)
    {
       // Read in coefficient values
-      i = T1ReadLong(Vdp2Ram, addr);
+      i = T1ReadLong(Vdp2DrawRam, addr);
       parameter->KAst = (unsigned)(i & 0xFFFFFFC0);
       addr += 4;
 
-      i = T1ReadLong(Vdp2Ram, addr);
+      i = T1ReadLong(Vdp2DrawRam, addr);
       parameter->deltaKAst = (signed) ((i & 0x03FFFFC0) | (i & 0x02000000 ? 0xFE000000 : 0x00000000));
       addr += 4;     
 
-      i = T1ReadLong(Vdp2Ram, addr);
+      i = T1ReadLong(Vdp2DrawRam, addr);
       parameter->deltaKAx = (signed) ((i & 0x03FFFFC0) | (i & 0x02000000 ? 0xFE000000 : 0x00000000));
       addr += 4;
 
       if (which == 0)
       {
-         parameter->coefdatasize = (Vdp2Regs->KTCTL & 0x2 ? 2 : 4);
-         parameter->coeftbladdr = ((Vdp2Regs->KTAOF & 0x7) * 0x10000 + touint(parameter->KAst)) * parameter->coefdatasize;
-         parameter->coefmode = (Vdp2Regs->KTCTL >> 2) & 0x3;
+         parameter->coefdatasize = (Vdp2DrawRegs->KTCTL & 0x2 ? 2 : 4);
+         parameter->coeftbladdr = ((Vdp2DrawRegs->KTAOF & 0x7) * 0x10000 + touint(parameter->KAst)) * parameter->coefdatasize;
+         parameter->coefmode = (Vdp2DrawRegs->KTCTL >> 2) & 0x3;
       }
       else
       {
-         parameter->coefdatasize = (Vdp2Regs->KTCTL & 0x200 ? 2 : 4);
-         parameter->coeftbladdr = (((Vdp2Regs->KTAOF >> 8) & 0x7) * 0x10000 + touint(parameter->KAst)) * parameter->coefdatasize;
-         parameter->coefmode = (Vdp2Regs->KTCTL >> 10) & 0x3;
+         parameter->coefdatasize = (Vdp2DrawRegs->KTCTL & 0x200 ? 2 : 4);
+         parameter->coeftbladdr = (((Vdp2DrawRegs->KTAOF >> 8) & 0x7) * 0x10000 + touint(parameter->KAst)) * parameter->coefdatasize;
+         parameter->coefmode = (Vdp2DrawRegs->KTCTL >> 10) & 0x3;
       }
    }
 
@@ -456,58 +456,58 @@ void Vdp2ReadRotationTableFP(int which, vdp2rotationparameterfp_struct *paramete
 
 void FASTCALL Vdp2ParameterAPlaneAddr(vdp2draw_struct *info, int i)
 {
-   u32 offset = (Vdp2Regs->MPOFR & 0x7) << 6;
+   u32 offset = (Vdp2DrawRegs->MPOFR & 0x7) << 6;
    u32 tmp=0;
 
    switch(i)
    {
       case 0:
-         tmp = offset | (Vdp2Regs->MPABRA & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPABRA & 0xFF);
          break;
       case 1:
-         tmp = offset | (Vdp2Regs->MPABRA >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPABRA >> 8);
          break;
       case 2:
-         tmp = offset | (Vdp2Regs->MPCDRA & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPCDRA & 0xFF);
          break;
       case 3:
-         tmp = offset | (Vdp2Regs->MPCDRA >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPCDRA >> 8);
          break;
       case 4:
-         tmp = offset | (Vdp2Regs->MPEFRA & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPEFRA & 0xFF);
          break;
       case 5:
-         tmp = offset | (Vdp2Regs->MPEFRA >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPEFRA >> 8);
          break;
       case 6:
-         tmp = offset | (Vdp2Regs->MPGHRA & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPGHRA & 0xFF);
          break;
       case 7:
-         tmp = offset | (Vdp2Regs->MPGHRA >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPGHRA >> 8);
          break;
       case 8:
-         tmp = offset | (Vdp2Regs->MPIJRA & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPIJRA & 0xFF);
          break;
       case 9:
-         tmp = offset | (Vdp2Regs->MPIJRA >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPIJRA >> 8);
          break;
       case 10:
-         tmp = offset | (Vdp2Regs->MPKLRA & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPKLRA & 0xFF);
          break;
       case 11:
-         tmp = offset | (Vdp2Regs->MPKLRA >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPKLRA >> 8);
          break;
       case 12:
-         tmp = offset | (Vdp2Regs->MPMNRA & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPMNRA & 0xFF);
          break;
       case 13:
-         tmp = offset | (Vdp2Regs->MPMNRA >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPMNRA >> 8);
          break;
       case 14:
-         tmp = offset | (Vdp2Regs->MPOPRA & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPOPRA & 0xFF);
          break;
       case 15:
-         tmp = offset | (Vdp2Regs->MPOPRA >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPOPRA >> 8);
          break;
    }
 
@@ -518,59 +518,59 @@ void FASTCALL Vdp2ParameterAPlaneAddr(vdp2draw_struct *info, int i)
 
 void FASTCALL Vdp2ParameterBPlaneAddr(vdp2draw_struct *info, int i)
 {
-   u32 offset = (Vdp2Regs->MPOFR & 0x70) << 2;
+   u32 offset = (Vdp2DrawRegs->MPOFR & 0x70) << 2;
    u32 tmp=0;
 
    // Parameter B
    switch(i)
    {
       case 0:
-         tmp = offset | (Vdp2Regs->MPABRB & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPABRB & 0xFF);
          break;
       case 1:
-         tmp = offset | (Vdp2Regs->MPABRB >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPABRB >> 8);
          break;
       case 2:
-         tmp = offset | (Vdp2Regs->MPCDRB & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPCDRB & 0xFF);
          break;
       case 3:
-         tmp = offset | (Vdp2Regs->MPCDRB >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPCDRB >> 8);
          break;
       case 4:
-         tmp = offset | (Vdp2Regs->MPEFRB & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPEFRB & 0xFF);
          break;
       case 5:
-         tmp = offset | (Vdp2Regs->MPEFRB >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPEFRB >> 8);
          break;
       case 6:
-         tmp = offset | (Vdp2Regs->MPGHRB & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPGHRB & 0xFF);
          break;
       case 7:
-         tmp = offset | (Vdp2Regs->MPGHRB >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPGHRB >> 8);
          break;
       case 8:
-         tmp = offset | (Vdp2Regs->MPIJRB & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPIJRB & 0xFF);
          break;
       case 9:
-         tmp = offset | (Vdp2Regs->MPIJRB >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPIJRB >> 8);
          break;
       case 10:
-         tmp = offset | (Vdp2Regs->MPKLRB & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPKLRB & 0xFF);
          break;
       case 11:
-         tmp = offset | (Vdp2Regs->MPKLRB >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPKLRB >> 8);
          break;
       case 12:
-         tmp = offset | (Vdp2Regs->MPMNRB & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPMNRB & 0xFF);
          break;
       case 13:
-         tmp = offset | (Vdp2Regs->MPMNRB >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPMNRB >> 8);
          break;
       case 14:
-         tmp = offset | (Vdp2Regs->MPOPRB & 0xFF);
+         tmp = offset | (Vdp2DrawRegs->MPOPRB & 0xFF);
          break;
       case 15:
-         tmp = offset | (Vdp2Regs->MPOPRB >> 8);
+         tmp = offset | (Vdp2DrawRegs->MPOPRB >> 8);
          break;
    }
 
@@ -586,14 +586,14 @@ float Vdp2ReadCoefficientMode0_2(vdp2rotationparameter_struct *parameter, u32 ad
    if (parameter->coefdatasize == 2)
    {
       addr &= 0x7FFFE;
-      i = T1ReadWord(Vdp2Ram, addr);
+      i = T1ReadWord(Vdp2DrawRam, addr);
       parameter->msb = (i >> 15) & 0x1;
       return (float) (signed) ((i & 0x7FFF) | (i & 0x4000 ? 0xFFFFC000 : 0x00000000)) / 1024;
    }
    else
    {
       addr &= 0x7FFFC;
-      i = T1ReadLong(Vdp2Ram, addr);
+      i = T1ReadLong(Vdp2DrawRam, addr);
       parameter->msb = (i >> 31) & 0x1;
       return (float) (signed) ((i & 0x00FFFFFF) | (i & 0x00800000 ? 0xFF800000 : 0x00000000)) / 65536;
    }
@@ -608,14 +608,14 @@ fixed32 Vdp2ReadCoefficientMode0_2FP(vdp2rotationparameterfp_struct *parameter,
    if (parameter->coefdatasize == 2)
    {
       addr &= 0x7FFFE;
-      i = T1ReadWord(Vdp2Ram, addr);
+      i = T1ReadWord(Vdp2DrawRam, addr);
       parameter->msb = (i >> 15) & 0x1;
       return (signed) ((i & 0x7FFF) | (i & 0x4000 ? 0xFFFFC000 : 0x00000000)) * 64;
    }
    else
    {
       addr &= 0x7FFFC;
-      i = T1ReadLong(Vdp2Ram, addr);
+      i = T1ReadLong(Vdp2DrawRam, addr);
       parameter->linescreen = (i >> 24) & 0x7F;
       parameter->msb = (i >> 31) & 0x1;
       return (signed) ((i & 0x00FFFFFF) | (i & 0x00800000 ? 0xFF800000 : 0x00000000));
@@ -623,3 +623,55 @@ fixed32 Vdp2ReadCoefficientMode0_2FP(vdp2rotationparameterfp_struct *parameter,
 }
 
 //////////////////////////////////////////////////////////////////////////////
+
+/* The window tests only compare x against the window edges, so the result
+   can only change at those edges. Each piece of the line between them is
+   tested once, at its first pixel. */
+void Vdp2ReadWindowSpans(int wctl, clipping_struct *clip, int y, int width, int xratio, int height, windowspans_struct *spans)
+{
+   int edge[6];
+   int count = 0;
+   int i, j;
+
+   edge[count++] = 0;
+   for (i = 0; i < 2; i++)
+   {
+      // first pixel at or past the start of the window, and past its end
+      edge[count++] = (clip[i].xstart + xratio - 1) / xratio;
+      edge[count++] = (clip[i].xend + xratio) / xratio;
+   }
+   edge[count++] = width;
+
+   for (i = 1; i < count; i++)
+   {
+      int tmp = edge[i];
+
+      if (tmp < 0)
+         tmp = 0;
+      else if (tmp > width)
+         tmp = width;
+      for (j = i; j > 0 && edge[j - 1] > tmp; j--)
+         edge[j] = edge[j - 1];
+      edge[j] = tmp;
+   }
+
+   spans->count = 0;
+   for (i = 0; i < count - 1; i++)
+   {
+      if (edge[i] == edge[i + 1])
+         continue;
+      if (!Vdp2TestBothWindow(wctl, clip, edge[i] * xratio, y, height))
+         continue;
+
+      if (spans->count > 0 && spans->end[spans->count - 1] == edge[i])
+         spans->end[spans->count - 1] = edge[i + 1];
+      else
+      {
+         spans->start[spans->count] = edge[i];
+         spans->end[spans->count] = edge[i + 1];
+         spans->count++;
+      }
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
@@ -235,6 +235,16 @@ typedef struct
    int xend, yend;
 } clipping_struct;
 
+// Visible parts of a line once windows are applied, as [start, end) ranges
+#define VDP2_WINDOW_MAX_SPANS 3
+
+typedef struct
+{
+   int count;
+   int start[VDP2_WINDOW_MAX_SPANS];
+   int end[VDP2_WINDOW_MAX_SPANS];
+} windowspans_struct;
+
 #define tofixed(v) ((v) * (1 << FP_SIZE))
 #define toint(v) ((v) >> FP_SIZE)
 #define touint(v) ((u16)((v) >> FP_SIZE))
@@ -253,6 +263,7 @@ void FASTCALL Vdp2ParameterAPlaneAddr(vdp2draw_struct *info, int i);
 void FASTCALL Vdp2ParameterBPlaneAddr(vdp2draw_struct *info, int i);
 float Vdp2ReadCoefficientMode0_2(vdp2rotationparameter_struct *parameter, u32 addr);
 fixed32 Vdp2ReadCoefficientMode0_2FP(vdp2rotationparameterfp_struct *parameter, u32 addr);
+void Vdp2ReadWindowSpans(int wctl, clipping_struct *clip, int y, int width, int xratio, int height, windowspans_struct *spans);
 
 //////////////////////////////////////////////////////////////////////////////
 
@@ -347,7 +358,7 @@ static INLINE void CalcPlaneAddr(vdp2draw_struct *info, u32 tmp)
    int deca = info->planeh + info->planew - 2;
    int multi = info->planeh * info->planew;
      
-   //if (Vdp2Regs->VRSIZE & 0x8000)
+   //if (Vdp2DrawRegs->VRSIZE & 0x8000)
    //{
       if (info->patterndatasize == 1)
       {
@@ -494,10 +505,10 @@ static INLINE void ReadPatternData(vdp2draw_struct *info, u16 pnc, int chctlwh)
 
 static INLINE void ReadMosaicData(vdp2draw_struct *info, u16 mask)
 {
-   if (Vdp2Regs->MZCTL & mask)
+   if (Vdp2DrawRegs->MZCTL & mask)
    {  
-      info->mosaicxmask = ((Vdp2Regs->MZCTL >> 8) & 0xF) + 1;
-      info->mosaicymask = (Vdp2Regs->MZCTL >> 12) + 1;
+      info->mosaicxmask = ((Vdp2DrawRegs->MZCTL >> 8) & 0xF) + 1;
+      info->mosaicymask = (Vdp2DrawRegs->MZCTL >> 12) + 1;
    }
    else
    {
@@ -531,21 +542,21 @@ static INLINE void ReadWindowCoordinates(int num, clipping_struct * clip)
    if (num == 0)
    {
       // Window 0
-      clip->xstart = Vdp2Regs->WPSX0;
-      clip->ystart = Vdp2Regs->WPSY0 & 0x1FF;
-      clip->xend = Vdp2Regs->WPEX0;
-      clip->yend = Vdp2Regs->WPEY0 & 0x1FF;
+      clip->xstart = Vdp2DrawRegs->WPSX0;
+      clip->ystart = Vdp2DrawRegs->WPSY0 & 0x1FF;
+      clip->xend = Vdp2DrawRegs->WPEX0;
+      clip->yend = Vdp2DrawRegs->WPEY0 & 0x1FF;
    }
    else
    {
       // Window 1
-      clip->xstart = Vdp2Regs->WPSX1;
-      clip->ystart = Vdp2Regs->WPSY1 & 0x1FF;
-      clip->xend = Vdp2Regs->WPEX1;
-      clip->yend = Vdp2Regs->WPEY1 & 0x1FF;
+      clip->xstart = Vdp2DrawRegs->WPSX1;
+      clip->ystart = Vdp2DrawRegs->WPSY1 & 0x1FF;
+      clip->xend = Vdp2DrawRegs->WPEX1;
+      clip->yend = Vdp2DrawRegs->WPEY1 & 0x1FF;
    }
 
-   switch ((Vdp2Regs->TVMD >> 1) & 0x3)
+   switch ((Vdp2DrawRegs->TVMD >> 1) & 0x3)
    {
       case 0: // Normal
          clip->xstart = (clip->xstart >> 1) & 0x1FF;
@@ -565,7 +576,7 @@ static INLINE void ReadWindowCoordinates(int num, clipping_struct * clip)
          break;
    }
 
-   if ((Vdp2Regs->TVMD & 0xC0) == 0xC0)
+   if ((Vdp2DrawRegs->TVMD & 0xC0) == 0xC0)
    {
       // Double-density interlace
       clip->ystart >>= 1;
@@ -602,15 +613,15 @@ static INLINE void ReadLineWindowData(int *islinewindow, int wctl, u32 *linewnd0
 {
    islinewindow[0] = 0;
 
-   if (wctl & 0x2 && Vdp2Regs->LWTA0.all & 0x80000000)
+   if (wctl & 0x2 && Vdp2DrawRegs->LWTA0.all & 0x80000000)
    {
       islinewindow[0] |= 0x1;
-      linewnd0addr[0] = (Vdp2Regs->LWTA0.all & 0x7FFFE) << 1;
+      linewnd0addr[0] = (Vdp2DrawRegs->LWTA0.all & 0x7FFFE) << 1;
    }
-   if (wctl & 0x8 && Vdp2Regs->LWTA1.all & 0x80000000)
+   if (wctl & 0x8 && Vdp2DrawRegs->LWTA1.all & 0x80000000)
    {
       islinewindow[0] |= 0x2;
-      linewnd1addr[0] = (Vdp2Regs->LWTA1.all & 0x7FFFE) << 1;
+      linewnd1addr[0] = (Vdp2DrawRegs->LWTA1.all & 0x7FFFE) << 1;
    }
 }
 
@@ -618,9 +629,9 @@ static INLINE void ReadLineWindowData(int *islinewindow, int wctl, u32 *linewnd0
 
 static INLINE void ReadOneLineWindowClip(clipping_struct *clip, u32 *linewndaddr)
 {
-   clip->xstart = T1ReadWord(Vdp2Ram, *linewndaddr);
+   clip->xstart = T1ReadWord(Vdp2DrawRam, *linewndaddr & 0x7FFFF);
    *linewndaddr += 2;
-   clip->xend = T1ReadWord(Vdp2Ram, *linewndaddr);
+   clip->xend = T1ReadWord(Vdp2DrawRam, *linewndaddr & 0x7FFFF);
    *linewndaddr += 2;
 
    /* Ok... that looks insane... but there's at least two games (3D Baseball and
@@ -636,7 +647,7 @@ static INLINE void ReadOneLineWindowClip(clipping_struct *clip, u32 *linewndaddr
    clip->xstart &= 0x3FF;
    clip->xend &= 0x3FF;
 
-   switch ((Vdp2Regs->TVMD >> 1) & 0x3)
+   switch ((Vdp2DrawRegs->TVMD >> 1) & 0x3)
    {
       case 0: // Normal
          clip->xstart = (clip->xstart >> 1) & 0x1FF;
@@ -673,6 +684,56 @@ static INLINE void ReadLineWindowClip(int islinewindow, clipping_struct *clip, u
 
 //////////////////////////////////////////////////////////////////////////////
 
+static INLINE int Vdp2TestWindow(int wctl, int enablemask, int inoutmask, clipping_struct *clip, int x, int y, int height)
+{
+   if (wctl & enablemask) 
+   {
+      if (wctl & inoutmask)
+      {
+         // Draw inside of window
+         if (x < clip->xstart || x > clip->xend ||
+             y < clip->ystart || y > clip->yend)
+            return 0;
+      }
+      else
+      {
+         // Draw outside of window
+         if (x >= clip->xstart && x <= clip->xend &&
+             y >= clip->ystart && y <= clip->yend)
+            return 0;
+
+		 //it seems to overflow vertically on hardware
+		 if(clip->yend > height && (x >= clip->xstart && x <= clip->xend ))
+			 return 0;
+      }
+      return 1; // return inactive;
+   }
+   return 3; // return disabled | inactive;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static INLINE int Vdp2TestBothWindow(int wctl, clipping_struct *clip, int x, int y, int height)
+{
+    int w0 = Vdp2TestWindow(wctl, 0x2, 0x1, &clip[0], x, y, height);
+    int w1 = Vdp2TestWindow(wctl, 0x8, 0x4, &clip[1], x, y, height);
+
+    /* if window 0 is disabled, return window 1 */
+    if (w0 & 2) return w1 & 1;
+    /* if window 1 is disabled, return window 0 */
+    if (w1 & 2) return w0 & 1;
+
+    /* if both windows are active */
+    if ((wctl & 0x80) == 0x80)
+        /* AND logic, returns 0 only if both the windows are active */
+        return w0 || w1;
+    else
+        /* OR logic, returns 0 if one of the windows is active */
+        return w0 && w1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 static INLINE int IsScreenRotated(vdp2rotationparameter_struct *parameter)
 {
   return (parameter->deltaXst == 0.0 &&
@@ -707,6 +768,9 @@ static INLINE int IsScreenRotatedFP(vdp2rotationparameterfp_struct *parameter)
 
 static INLINE void Vdp2ReadCoefficient(vdp2rotationparameter_struct *parameter, u32 addr)
 {
+   // the table wraps around VRAM like the rest of the VDP2 address space
+   addr &= 0x7FFFF;
+
    switch (parameter->coefmode)
    {
       case 0: // coefficient for kx and ky
@@ -724,13 +788,13 @@ static INLINE void Vdp2ReadCoefficient(vdp2rotationparameter_struct *parameter,
 
          if (parameter->coefdatasize == 2)
          {
-            i = T1ReadWord(Vdp2Ram, addr);
+            i = T1ReadWord(Vdp2DrawRam, addr);
             parameter->msb = (i >> 15) & 0x1;
             parameter->Xp = (float) (signed) ((i & 0x7FFF) | (i & 0x4000 ? 0xFFFFC000 : 0x00000000)) / 4;
          }
          else
          {
-            i = T1ReadLong(Vdp2Ram, addr);
+            i = T1ReadLong(Vdp2DrawRam, addr);
             parameter->msb = (i >> 31) & 0x1;
             parameter->Xp = (float) (signed) ((i & 0x007FFFFF) | (i & 0x00800000 ? 0xFF800000 : 0x00000000)) / 256;
          }
@@ -743,6 +807,9 @@ static INLINE void Vdp2ReadCoefficient(vdp2rotationparameter_struct *parameter,
 
 static INLINE void Vdp2ReadCoefficientFP(vdp2rotationparameterfp_struct *parameter, u32 addr)
 {
+   // the table wraps around VRAM like the rest of the VDP2 address space
+   addr &= 0x7FFFF;
+
    switch (parameter->coefmode)
    {
       case 0: // coefficient for kx and ky
@@ -760,13 +827,13 @@ static INLINE void Vdp2ReadCoefficientFP(vdp2rotationparameterfp_struct *paramet
 
          if (parameter->coefdatasize == 2)
          {
-            i = T1ReadWord(Vdp2Ram, addr);
+            i = T1ReadWord(Vdp2DrawRam, addr);
             parameter->msb = (i >> 15) & 0x1;
             parameter->Xp = (signed) ((i & 0x7FFF) | (i & 0x4000 ? 0xFFFFC000 : 0x00000000)) * 16384;
          }
          else
          {
-            i = T1ReadLong(Vdp2Ram, addr);
+            i = T1ReadLong(Vdp2DrawRam, addr);
             parameter->msb = (i >> 31) & 0x1;
             parameter->linescreen = (i >> 24) & 0x7F;
             parameter->Xp = (signed) ((i & 0x007FFFFF) | (i & 0x00800000 ? 0xFF800000 : 0x00000000)) * 256;
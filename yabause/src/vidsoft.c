@@ -19,8 +19,8 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA
 */
 
-/*! \file vidsoft.c
-    \brief Software video renderer interface.
+/*! \file vidsoft.c
+    \brief Software video renderer interface.
 */
 
 #include "vidsoft.h"
@@ -29,6 +29,8 @@
 #include "debug.h"
 #include "vdp2.h"
 #include "titan/titan.h"
+#include "threads.h"
+#include "yabause.h"
 
 #ifdef HAVE_LIBGL
 #define USE_OPENGL
@@ -43,6 +45,10 @@
 #include <stdlib.h>
 #include <limits.h>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 #if defined WORDS_BIGENDIAN
 static INLINE u32 COLSAT2YAB16(int priority,u32 temp)            { return (priority | (temp & 0x7C00) << 1 | (temp & 0x3E0) << 14 | (temp & 0x1F) << 27); }
 static INLINE u32 COLSAT2YAB32(int priority,u32 temp)            { return (((temp & 0xFF) << 24) | ((temp & 0xFF00) << 8) | ((temp & 0xFF0000) >> 8) | priority); }
@@ -71,6 +77,10 @@ static INLINE u32 COLSATSTRIPPRIORITY(u32 pixel) { return (0xFF000000 | pixel);
 
 static void PushUserClipping(int mode);
 static void PopUserClipping(void);
+static void Vdp1DrawFlush(void);
+static void Vdp1EraseWindow(int *x1, int *y1, int *x2, int *y2);
+static void Vdp2DrawLayers(void);
+static void Vdp2DrawScreensSetup(void);
 
 int VIDSoftInit(void);
 void VIDSoftDeInit(void);
@@ -130,6 +140,7 @@ VIDSoftVdp2DrawStart,
 VIDSoftVdp2DrawEnd,
 VIDSoftVdp2DrawScreens,
 VIDSoftGetGlSize,
+NULL,
 };
 
 pixel_t *dispbuffer=NULL;
@@ -146,6 +157,12 @@ static int vdp1clipystart;
 static int vdp1clipyend;
 static int vdp1pixelsize;
 static int vdp1spritetype;
+static int vdp1queueprims;
+static int vdp1primcount;
+static u16 *vdp1tileprims;
+static int vdp1tileprimsize;
+static int vdp1reuse;
+static int vdp1drawx1, vdp1drawy1, vdp1drawx2, vdp1drawy2;
 int vdp2width;
 int vdp2height;
 static int nbg0priority=0;
@@ -160,6 +177,359 @@ static int outputheight;
 static int resxratio;
 static int resyratio;
 
+//////////////////////////////////////////////////////////////////////////////
+// Worker pool
+//////////////////////////////////////////////////////////////////////////////
+
+// When yabsys.UseThreads is set, work that splits into independent jobs is
+// handed to a small pool of worker threads, with the emulation thread taking
+// jobs too. VidsoftRunJobs() only returns once every job has completed, so
+// the rest of the renderer stays single threaded. Jobs are told which thread
+// runs them (0 for the emulation thread), for per-thread caches.
+
+#ifdef __GNUC__
+# define VIDSOFT_BARRIER()  __sync_synchronize()
+# define VIDSOFT_LOCK(l)    while (__sync_lock_test_and_set(&(l), 1)) YabThreadYield()
+# define VIDSOFT_UNLOCK(l)  __sync_lock_release(&(l))
+#endif
+
+static int vidsoft_num_threads;          // including the emulation thread, 0 for one per processor
+static int vidsoft_num_workers;                            // worker threads started
+
+static volatile u8 vidsoft_workers_running;
+static volatile u8 vidsoft_worker_sleeping[YAB_NUM_VIDSOFT_WORKERS];
+static volatile u8 vidsoft_worker_stopped[YAB_NUM_VIDSOFT_WORKERS];
+
+static volatile int vidsoft_run_lock;      // held by the thread running jobs
+static volatile int vidsoft_job_lock;
+static volatile int vidsoft_job_active;    // workers inside VidsoftTakeJobs()
+static volatile u32 vidsoft_job_gen;       // bumped by every VidsoftRunJobs()
+static volatile u32 vidsoft_job_next;      // next job to hand out
+static volatile u32 vidsoft_job_done;      // jobs completed
+static u32 vidsoft_job_count;
+static void (*vidsoft_job_func)(int job, int thread);
+
+#ifdef __GNUC__
+
+static void VidsoftTakeJobs(int thread)
+{
+   u32 job;
+
+   while ((job = __sync_fetch_and_add(&vidsoft_job_next, 1)) < vidsoft_job_count)
+   {
+      vidsoft_job_func(job, thread);
+      __sync_fetch_and_add(&vidsoft_job_done, 1);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void VidsoftWorker(void *arg)
+{
+   int id = (int)(pointer)arg;
+   u32 gen = 0;
+
+   while (vidsoft_workers_running)
+   {
+      VIDSOFT_LOCK(vidsoft_job_lock);
+      if (vidsoft_job_gen == gen)
+      {
+         VIDSOFT_UNLOCK(vidsoft_job_lock);
+
+         vidsoft_worker_sleeping[id] = 1;
+         VIDSOFT_BARRIER();
+         if (vidsoft_job_gen == gen && vidsoft_workers_running)
+            YabThreadSleep();
+         vidsoft_worker_sleeping[id] = 0;
+         continue;
+      }
+
+      // once counted as active, the job list can't be replaced under us
+      gen = vidsoft_job_gen;
+      __sync_fetch_and_add(&vidsoft_job_active, 1);
+      VIDSOFT_UNLOCK(vidsoft_job_lock);
+
+      VidsoftTakeJobs(id + 1);
+      __sync_fetch_and_sub(&vidsoft_job_active, 1);
+   }
+
+   vidsoft_worker_stopped[id] = 1;
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void VidsoftStopWorkers(void)
+{
+   int i;
+
+   if (!vidsoft_num_workers)
+      return;
+
+#ifdef __GNUC__
+   vidsoft_workers_running = 0;
+   VIDSOFT_BARRIER();
+
+   for (i = 0; i < vidsoft_num_workers; i++)
+   {
+      while (!vidsoft_worker_stopped[i])
+      {
+         YabThreadWake(YAB_THREAD_VIDSOFT_WORKER0 + i);
+         YabThreadYield();
+      }
+      YabThreadWait(YAB_THREAD_VIDSOFT_WORKER0 + i);
+   }
+#endif
+
+   vidsoft_num_workers = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void VidsoftStartWorkers(void)
+{
+   int i, num;
+
+   VidsoftStopWorkers();
+
+   if (!yabsys.UseThreads)
+      return;
+
+   num = vidsoft_num_threads ? vidsoft_num_threads : YabThreadGetNumCores();
+
+#ifdef __GNUC__
+   vidsoft_workers_running = 1;
+
+   for (i = 0; i < num - 1 && i < YAB_NUM_VIDSOFT_WORKERS; i++)
+   {
+      vidsoft_worker_sleeping[i] = 0;
+      vidsoft_worker_stopped[i] = 0;
+      if (YabThreadStart(YAB_THREAD_VIDSOFT_WORKER0 + i, VidsoftWorker, (void *)(pointer)i) < 0)
+         break;
+      vidsoft_num_workers++;
+   }
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Calls func(job, thread) for jobs 0 to count - 1, in any order and from any
+// thread.
+static void VidsoftRunJobs(void (*func)(int job, int thread), int count)
+{
+   int i;
+
+   if (!vidsoft_num_workers || count <= 1)
+   {
+      for (i = 0; i < count; i++)
+         func(i, 0);
+      return;
+   }
+
+#ifdef __GNUC__
+   // the render thread and the emulation thread can both have jobs to run
+   VIDSOFT_LOCK(vidsoft_run_lock);
+
+   // a worker that joined late may still be scanning the previous list
+   VIDSOFT_LOCK(vidsoft_job_lock);
+   while (vidsoft_job_active)
+   {
+      VIDSOFT_UNLOCK(vidsoft_job_lock);
+      YabThreadYield();
+      VIDSOFT_LOCK(vidsoft_job_lock);
+   }
+
+   vidsoft_job_func = func;
+   vidsoft_job_count = count;
+   vidsoft_job_next = 0;
+   vidsoft_job_done = 0;
+   vidsoft_job_gen++;
+   VIDSOFT_UNLOCK(vidsoft_job_lock);
+
+   VIDSOFT_BARRIER();
+   for (i = 0; i < vidsoft_num_workers; i++)
+   {
+      if (vidsoft_worker_sleeping[i])
+         YabThreadWake(YAB_THREAD_VIDSOFT_WORKER0 + i);
+   }
+
+   VidsoftTakeJobs(0);
+
+   while (vidsoft_job_done < (u32)count)
+      YabThreadYield();
+   VIDSOFT_BARRIER();
+
+   VIDSOFT_UNLOCK(vidsoft_run_lock);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////
+// Render thread
+//////////////////////////////////////////////////////////////////////////////
+
+// The screens are drawn from a capture of the VDP2 state taken by
+// VIDSoftVdp2DrawStart(). In pipelined mode, VIDSoftVdp2DrawScreens() hands
+// them to a render thread while the emulation thread carries on with the
+// frame. VIDSoftVdp2DrawEnd() and anything else touching the screens waits
+// for it with VidsoftRenderWait() first.
+
+static int vidsoft_pipelined;
+static Vdp2Capture_struct vidsoft_capture;   // ram is allocated on first use
+static int vidsoft_captured;                 // the capture is this frame's
+
+// What the frame in dispbuffer was drawn from, to tell when the next one
+// would come out the same. The screens are compared by
+// VIDSoftVdp2DrawStart(), which puts off drawing them when they didn't
+// change, and the sprites by VIDSoftVdp2DrawEnd(), which then leaves
+// dispbuffer as it is if they didn't either.
+typedef struct
+{
+   Vdp2 regs;                  // the capture the screens were drawn from
+   Vdp2 lines[270];
+   int disptoggle;
+   Vdp2 spriteregs;            // the live state the sprites were drawn from
+   Vdp2 spritelines[270];
+   int vdp1disptoggle;
+   u16 TVMR;
+   int vdp1width, vdp1height, vdp1pixelsize;
+   u32 vdp1stamp;
+} vidsoftframe_struct;
+
+static vidsoftframe_struct vidsoft_frame;
+static int vidsoft_frame_valid;     // dispbuffer holds vidsoft_frame
+static int vidsoft_frame_kept;      // the screens are left undrawn this frame
+static int vidsoft_screens_pending; // and VIDSoftVdp2DrawScreens() was called
+
+static volatile u8 vidsoft_render_running;
+static volatile u8 vidsoft_render_sleeping;
+static volatile u8 vidsoft_render_stopped;
+static volatile u8 vidsoft_render_busy;     // set while a frame is being drawn
+
+#ifdef __GNUC__
+
+static void VidsoftRender(UNUSED void *arg)
+{
+   while (vidsoft_render_running)
+   {
+      if (!vidsoft_render_busy)
+      {
+         vidsoft_render_sleeping = 1;
+         VIDSOFT_BARRIER();
+         if (!vidsoft_render_busy && vidsoft_render_running)
+            YabThreadSleep();
+         vidsoft_render_sleeping = 0;
+         continue;
+      }
+
+      VIDSOFT_BARRIER();
+      Vdp2DrawLayers();
+      VIDSOFT_BARRIER();
+      vidsoft_render_busy = 0;
+   }
+
+   vidsoft_render_stopped = 1;
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Waits for the render thread to finish its frame, then points the renderer
+// back at the live VDP2 state.
+static void VidsoftRenderWait(void)
+{
+   if (!vidsoft_render_running)
+      return;
+
+#ifdef __GNUC__
+   while (vidsoft_render_busy)
+      YabThreadYield();
+   VIDSOFT_BARRIER();
+#endif
+
+   Vdp2DrawCapture(NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void VidsoftRenderStart(void)
+{
+#ifdef __GNUC__
+   vidsoft_render_busy = 1;
+   VIDSOFT_BARRIER();
+   if (vidsoft_render_sleeping)
+      YabThreadWake(YAB_THREAD_VIDSOFT_RENDER);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void VidsoftStopRender(void)
+{
+   if (!vidsoft_render_running)
+      return;
+
+   VidsoftRenderWait();
+
+#ifdef __GNUC__
+   vidsoft_render_running = 0;
+   VIDSOFT_BARRIER();
+
+   while (!vidsoft_render_stopped)
+   {
+      YabThreadWake(YAB_THREAD_VIDSOFT_RENDER);
+      YabThreadYield();
+   }
+   YabThreadWait(YAB_THREAD_VIDSOFT_RENDER);
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void VidsoftStartRender(void)
+{
+   VidsoftStopRender();
+
+   if (!yabsys.UseThreads || !vidsoft_pipelined)
+      return;
+
+#ifdef __GNUC__
+   vidsoft_render_busy = 0;
+   vidsoft_render_sleeping = 0;
+   vidsoft_render_stopped = 0;
+   vidsoft_render_running = 1;
+   if (YabThreadStart(YAB_THREAD_VIDSOFT_RENDER, VidsoftRender, NULL) < 0)
+      vidsoft_render_running = 0;
+#endif
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void VIDSoftSetNumThreads(int num)
+{
+   vidsoft_num_threads = (num > 0) ? num : 0;
+
+   // restart the pool if the core is already running
+   if (dispbuffer)
+   {
+      VidsoftRenderWait();
+      VidsoftStartWorkers();
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void VIDSoftSetPipelined(int on)
+{
+   vidsoft_pipelined = on;
+
+   if (dispbuffer)
+      VidsoftStartRender();
+}
+
 typedef struct { s16 x; s16 y; } vdp1vertex;
 
 typedef struct
@@ -178,33 +548,8 @@ typedef struct
 
 static INLINE u32 FASTCALL Vdp2ColorRamGetColor(u32 addr)
 {
-   switch(Vdp2Internal.ColorMode)
-   {
-      case 0:
-      {
-         u32 tmp;
-         addr <<= 1;
-         tmp = T2ReadWord(Vdp2ColorRam, addr & 0xFFF);
-         /* we preserve MSB for special color calculation mode 3 (see Vdp2 user's manual 3.4 and 12.3) */
-         return (((tmp & 0x1F) << 3) | ((tmp & 0x03E0) << 6) | ((tmp & 0x7C00) << 9)) | ((tmp & 0x8000) << 16);
-      }
-      case 1:
-      {
-         u32 tmp;
-         addr <<= 1;
-         tmp = T2ReadWord(Vdp2ColorRam, addr & 0xFFF);
-         /* we preserve MSB for special color calculation mode 3 (see Vdp2 user's manual 3.4 and 12.3) */
-         return (((tmp & 0x1F) << 3) | ((tmp & 0x03E0) << 6) | ((tmp & 0x7C00) << 9)) | ((tmp & 0x8000) << 16);
-      }
-      case 2:
-      {
-         addr <<= 2;   
-         return T2ReadLong(Vdp2ColorRam, addr & 0xFFF);
-      }
-      default: break;
-   }
-
-   return 0;
+   /* the MSB is preserved for special color calculation mode 3 (see Vdp2 user's manual 3.4 and 12.3) */
+   return Vdp2DrawColorRamRGB[addr & 0x7FF];
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -215,7 +560,7 @@ static INLINE void Vdp2PatternAddr(vdp2draw_struct *info)
    {
       case 1:
       {
-         u16 tmp = T1ReadWord(Vdp2Ram, info->addr);         
+         u16 tmp = T1ReadWord(Vdp2DrawRam, info->addr & 0x7FFFF);         
 
          info->addr += 2;
          info->specialfunction = (info->supplementdata >> 9) & 0x1;
@@ -264,8 +609,8 @@ static INLINE void Vdp2PatternAddr(vdp2draw_struct *info)
          break;
       }
       case 2: {
-         u16 tmp1 = T1ReadWord(Vdp2Ram, info->addr);
-         u16 tmp2 = T1ReadWord(Vdp2Ram, info->addr+2);
+         u16 tmp1 = T1ReadWord(Vdp2DrawRam, info->addr & 0x7FFFF);
+         u16 tmp2 = T1ReadWord(Vdp2DrawRam, (info->addr + 2) & 0x7FFFF);
          info->addr += 4;
          info->charaddr = tmp2 & 0x7FFF;
          info->flipfunction = (tmp1 & 0xC000) >> 14;
@@ -283,7 +628,7 @@ static INLINE void Vdp2PatternAddr(vdp2draw_struct *info)
       }
    }
 
-   if (!(Vdp2Regs->VRSIZE & 0x8000))
+   if (!(Vdp2DrawRegs->VRSIZE & 0x8000))
       info->charaddr &= 0x3FFF;
 
    info->charaddr *= 0x20; // selon Runik
@@ -360,7 +705,7 @@ static INLINE int Vdp2FetchPixel(vdp2draw_struct *info, int x, int y, u32 *color
    switch(info->colornumber)
    {
       case 0: // 4 BPP
-         *dot = T1ReadByte(Vdp2Ram, ((info->charaddr + ((y * info->cellw) + x) / 2) & 0x7FFFF));
+         *dot = T1ReadByte(Vdp2DrawRam, ((info->charaddr + ((y * info->cellw) + x) / 2) & 0x7FFFF));
          if (!(x & 0x1)) *dot >>= 4;
          if (!(*dot & 0xF) && info->transparencyenable) return 0;
          else
@@ -369,7 +714,7 @@ static INLINE int Vdp2FetchPixel(vdp2draw_struct *info, int x, int y, u32 *color
             return 1;
          }
       case 1: // 8 BPP
-         *dot = T1ReadByte(Vdp2Ram, ((info->charaddr + (y * info->cellw) + x) & 0x7FFFF));
+         *dot = T1ReadByte(Vdp2DrawRam, ((info->charaddr + (y * info->cellw) + x) & 0x7FFFF));
          if (!(*dot & 0xFF) && info->transparencyenable) return 0;
          else
          {
@@ -377,7 +722,7 @@ static INLINE int Vdp2FetchPixel(vdp2draw_struct *info, int x, int y, u32 *color
             return 1;
          }
       case 2: // 16 BPP(palette)
-         *dot = T1ReadWord(Vdp2Ram, ((info->charaddr + ((y * info->cellw) + x) * 2) & 0x7FFFF));
+         *dot = T1ReadWord(Vdp2DrawRam, ((info->charaddr + ((y * info->cellw) + x) * 2) & 0x7FFFF));
          if ((*dot == 0) && info->transparencyenable) return 0;
          else
          {
@@ -385,7 +730,7 @@ static INLINE int Vdp2FetchPixel(vdp2draw_struct *info, int x, int y, u32 *color
             return 1;
          }
       case 3: // 16 BPP(RGB)      
-         *dot = T1ReadWord(Vdp2Ram, ((info->charaddr + ((y * info->cellw) + x) * 2) & 0x7FFFF));
+         *dot = T1ReadWord(Vdp2DrawRam, ((info->charaddr + ((y * info->cellw) + x) * 2) & 0x7FFFF));
          if (!(*dot & 0x8000) && info->transparencyenable) return 0;
          else
          {
@@ -393,7 +738,7 @@ static INLINE int Vdp2FetchPixel(vdp2draw_struct *info, int x, int y, u32 *color
             return 1;
          }
       case 4: // 32 BPP
-         *dot = T1ReadLong(Vdp2Ram, ((info->charaddr + ((y * info->cellw) + x) * 4) & 0x7FFFF));
+         *dot = T1ReadLong(Vdp2DrawRam, ((info->charaddr + ((y * info->cellw) + x) * 4) & 0x7FFFF));
          if (!(*dot & 0x80000000) && info->transparencyenable) return 0;
          else
          {
@@ -405,54 +750,168 @@ static INLINE int Vdp2FetchPixel(vdp2draw_struct *info, int x, int y, u32 *color
    }
 }
 
+//////////////////////////////////////////////////////////////////////////////
+// Decoded cell cache
+//////////////////////////////////////////////////////////////////////////////
+
+// Tile layers keep decoding the same few cells, so each thread keeps the
+// last 8x8 cells it decoded, already converted to colors.  vdp2.c marks the
+// 256 byte pages of VDP2 RAM and color RAM that get written, and a cell is
+// only reused while the pages it was decoded from haven't changed.
+
+#define VDP2CELL_CACHE_SIZE 512
+#define VDP2CELL_BLANK      0x80   // dot is 0 (transparent)
+#define VDP2CELL_INVALID    0xFFFFFFFF
+
+typedef struct
+{
+   u32 addr;           // address | colornumber << 20
+   u32 palette;        // coloroffset << 16 | paladdr, 0 for RGB cells
+   u32 stamp;          // vdp2cellstamp when decoded
+   u32 color[64];
+   u8 dot[64];         // low nibble of the dot, and VDP2CELL_BLANK
+} vdp2cell_struct;
+
+typedef struct
+{
+   vdp2cell_struct *last;
+   vdp2cell_struct cells[VDP2CELL_CACHE_SIZE];
+} vdp2cellcache_struct;
+
+static vdp2cellcache_struct vdp2cellcache[YAB_NUM_VIDSOFT_WORKERS + 1];
+static vdp2cell_struct vdp2cellnone = { VDP2CELL_INVALID };
+static u32 vdp2cellstamp;
+static u32 vdp2cellpagestamp[0x80000 >> 8];
+static u32 vdp2cellcramstamp;
+
+static const u16 vdp2cellbytes[5] = { 32, 64, 128, 128, 256 };
+
 //////////////////////////////////////////////////////////////////////////////
 
-static INLINE int TestWindow(int wctl, int enablemask, int inoutmask, clipping_struct *clip, int x, int y)
+// Called before drawing, to pick up the writes made since the last frame.
+// ramdirty and colorramdirty are Vdp2RamDirty and Vdp2ColorRamDirty, or
+// their copies in the capture being drawn.
+static void Vdp2CellCacheUpdate(u32 *ramdirty, int *colorramdirty)
 {
-   if (wctl & enablemask) 
+   int i, j;
+
+   if (vdp2cellstamp == 0)
+   {
+      for (i = 0; i <= YAB_NUM_VIDSOFT_WORKERS; i++)
+         for (j = 0; j < VDP2CELL_CACHE_SIZE; j++)
+            vdp2cellcache[i].cells[j].addr = VDP2CELL_INVALID;
+   }
+
+   vdp2cellstamp++;
+
+   for (i = 0; i < (0x80000 >> 13); i++)
    {
-      if (wctl & inoutmask)
+      u32 dirty = ramdirty[i];
+
+      if (!dirty)
+         continue;
+
+      ramdirty[i] = 0;
+      for (j = 0; j < 32; j++)
       {
-         // Draw inside of window
-         if (x < clip->xstart || x > clip->xend ||
-             y < clip->ystart || y > clip->yend)
-            return 0;
+         if (dirty & (1 << j))
+            vdp2cellpagestamp[(i << 5) | j] = vdp2cellstamp;
       }
+   }
+
+   if (*colorramdirty)
+   {
+      *colorramdirty = 0;
+      vdp2cellcramstamp = vdp2cellstamp;
+   }
+
+   for (i = 0; i <= YAB_NUM_VIDSOFT_WORKERS; i++)
+      vdp2cellcache[i].last = &vdp2cellnone;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void Vdp2DecodeCell(vdp2cell_struct *cell, vdp2draw_struct *info, u32 addr)
+{
+   vdp2draw_struct cellinfo;
+   int i;
+
+   // decode it with the same code as uncached pixels
+   cellinfo.colornumber = info->colornumber;
+   cellinfo.coloroffset = info->coloroffset;
+   cellinfo.paladdr = info->paladdr;
+   cellinfo.charaddr = addr;
+   cellinfo.cellw = 8;
+   cellinfo.transparencyenable = 1;
+
+   for (i = 0; i < 64; i++)
+   {
+      u32 color, dot;
+
+      if (Vdp2FetchPixel(&cellinfo, i & 7, i >> 3, &color, &dot))
+         cell->dot[i] = dot & 0xF;
       else
       {
-         // Draw outside of window
-         if (x >= clip->xstart && x <= clip->xend &&
-             y >= clip->ystart && y <= clip->yend)
-            return 0;
-
-		 //it seems to overflow vertically on hardware
-		 if(clip->yend > vdp2height && (x >= clip->xstart && x <= clip->xend ))
-			 return 0;
+         // transparent dots still have a color when transparency is off
+         cellinfo.transparencyenable = 0;
+         Vdp2FetchPixel(&cellinfo, i & 7, i >> 3, &color, &dot);
+         cellinfo.transparencyenable = 1;
+         cell->dot[i] = (dot & 0xF) | VDP2CELL_BLANK;
       }
-      return 1; // return inactive;
+      cell->color[i] = color;
    }
-   return 3; // return disabled | inactive;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
-static INLINE int TestBothWindow(int wctl, clipping_struct *clip, int x, int y)
+// Same as Vdp2FetchPixel() for tile layers, with x and y inside the pattern
+// as returned by Vdp2MapCalcXY(). Only the low nibble of *dot is returned,
+// which is all GetAlpha() looks at.
+static INLINE int Vdp2FetchCellPixel(vdp2cellcache_struct *cache, vdp2draw_struct *info, int x, int y, u32 *color, u32 *dot)
 {
-    int w0 = TestWindow(wctl, 0x2, 0x1, &clip[0], x, y);
-    int w1 = TestWindow(wctl, 0x8, 0x4, &clip[1], x, y);
+   vdp2cell_struct *cell = cache->last;
+   u32 addr, key, palette;
+   int i;
 
-    /* if window 0 is disabled, return window 1 */
-    if (w0 & 2) return w1 & 1;
-    /* if window 1 is disabled, return window 0 */
-    if (w1 & 2) return w0 & 1;
+   if (info->colornumber > 4)
+      return 0;
 
-    /* if both windows are active */
-    if ((wctl & 0x80) == 0x80)
-        /* AND logic, returns 0 only if both the windows are active */
-        return w0 || w1;
-    else
-        /* OR logic, returns 0 if one of the windows is active */
-        return w0 && w1;
+   addr = (info->charaddr + (y >> 3) * vdp2cellbytes[info->colornumber]) & 0x7FFFF;
+   key = addr | (info->colornumber << 20);
+   palette = info->colornumber < 3 ? (info->coloroffset << 16) | info->paladdr : 0;
+
+   if (cell->addr != key || cell->palette != palette)
+   {
+      u32 last = (addr + vdp2cellbytes[info->colornumber] - 1) & 0x7FFFF;
+
+      cell = &cache->cells[((addr >> 5) ^ (info->paladdr >> 4) ^ (info->coloroffset >> 4)) & (VDP2CELL_CACHE_SIZE - 1)];
+      if (cell->addr != key || cell->palette != palette ||
+          vdp2cellpagestamp[addr >> 8] > cell->stamp ||
+          vdp2cellpagestamp[last >> 8] > cell->stamp ||
+          (info->colornumber < 3 && vdp2cellcramstamp > cell->stamp))
+      {
+         Vdp2DecodeCell(cell, info, addr);
+         cell->addr = key;
+         cell->palette = palette;
+         cell->stamp = vdp2cellstamp;
+      }
+      cache->last = cell;
+   }
+
+   i = ((y & 7) << 3) | x;
+   if ((cell->dot[i] & VDP2CELL_BLANK) && info->transparencyenable)
+      return 0;
+
+   *color = cell->color[i];
+   *dot = cell->dot[i] & 0xF;
+   return 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static INLINE int TestBothWindow(int wctl, clipping_struct *clip, int x, int y)
+{
+   return Vdp2TestBothWindow(wctl, clip, x, y, vdp2height);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -637,179 +1096,705 @@ static u8 FASTCALL GetAlpha(vdp2draw_struct * info, u32 color, u32 dot)
 
 //////////////////////////////////////////////////////////////////////////////
 
-static void FASTCALL Vdp2DrawScroll(vdp2draw_struct *info)
+/* The per-frame state of a scroll or rotation screen.  Each line only
+   depends on this and on its line number, so the lines are drawn as
+   independent jobs on the worker pool (see VidsoftRunJobs()). */
+
+typedef struct
 {
-   int i, j;
-   int x, y;
+   vdp2draw_struct *info;
+   screeninfo_struct sinfo;
    clipping_struct clip[2];
+   clipping_struct colorcalcwindow[2];
    u32 linewnd0addr, linewnd1addr;
-   screeninfo_struct sinfo;
    int scrolly;
-   int *mosaic_y, *mosaic_x;
-   clipping_struct colorcalcwindow[2];
-
-   info->coordincx *= (float)resxratio;
-   info->coordincy *= (float)resyratio;
+   int linescrollmult;
+   int *mosaic_x, *mosaic_y;
+
+   // rotation screens
+   vdp2rotationparameterfp_struct *p, *p2;
+   screeninfo_struct sinfo2;
+   fixed32 xmul, ymul, C, F;
+   fixed32 xmul2, ymul2, C2, F2;
+   clipping_struct rpwindow[2];
+   int userpwindow;
+   int isrplinewindow;
+   u32 rplinewnd0addr, rplinewnd1addr;
+   u32 lineAddr, lineInc;
+} vdp2screendraw_struct;
+
+static vdp2screendraw_struct vdp2screen;
+
+// Registers are only saved for the first 270 lines, the lines after that
+// keep the last ones
+#define Vdp2LoadLineParams(info, line) (info)->LoadLineParams((info), (line) > 269 ? 269 : (line))
 
-   SetupScreenVars(info, &sinfo, info->PlaneAddr);
+//////////////////////////////////////////////////////////////////////////////
 
-   scrolly = info->y;
+// The pixel loop of scroll screens, instantiated for each combination of
+// the settings that stay the same along a line, so that the loop itself
+// doesn't test them.  The flags are uppercase in the function names when
+// set:
+//   B: bitmap screen (tile screen otherwise)
+//   M: horizontal mosaic
+//   O: color offset
+//   W: color calculation window enabled
+//   S: special color calculation
+
+#define DEFINE_SCROLLPIXELS(tag,B,M,O,W,S)                                    \
+static void scrollpixels_##tag(vdp2draw_struct *info, screeninfo_struct *sinfo,\
+                               vdp2cellcache_struct *cache, int j, int Y,     \
+                               int linescrollx, int start, int end)           \
+{                                                                             \
+   int i;                                                                     \
+                                                                              \
+   for (i = start; i < end; i++)                                              \
+   {                                                                          \
+      u32 color, dot, pixel;                                                  \
+      int x, y = Y;                                                           \
+      u8 alpha;                                                               \
+                                                                              \
+      x = info->x + (M ? vdp2screen.mosaic_x[i] : i) * info->coordincx;       \
+      x &= sinfo->xmask;                                                      \
+                                                                              \
+      if (linescrollx)                                                        \
+      {                                                                       \
+         x += linescrollx;                                                    \
+         x &= 0x3FF;                                                          \
+      }                                                                       \
+                                                                              \
+      /* Fetch Pixel, if it isn't transparent, continue */                    \
+      if (!B)                                                                 \
+      {                                                                       \
+         Vdp2MapCalcXY(info, &x, &y, sinfo);                                  \
+         if (!Vdp2FetchCellPixel(cache, info, x, y, &color, &dot))            \
+            continue;                                                         \
+      }                                                                       \
+      else if (!Vdp2FetchPixel(info, x, y, &color, &dot))                     \
+         continue;                                                            \
+                                                                              \
+      /* if we're in the valid area of the color calculation window, */       \
+      /* don't do color calculation */                                        \
+      if (W && !TestBothWindow(Vdp2DrawRegs->WCTLD >> 8, vdp2screen.colorcalcwindow, i, j))\
+         alpha = 0x3F;                                                        \
+      else if (S)                                                             \
+         alpha = GetAlpha(info, color, dot);                                  \
+      else                                                                    \
+         alpha = info->alpha;                                                 \
+                                                                              \
+      pixel = COLSAT2YAB32(alpha, color);                                     \
+      if (O)                                                                  \
+         pixel = DoColorOffset(info, pixel);                                  \
+      TitanPutPixel(info->priority, i, j, pixel, info->linescreen);           \
+   }                                                                          \
+}
 
-   clip[0].xstart = clip[0].ystart = clip[0].xend = clip[0].yend = 0;
-   clip[1].xstart = clip[1].ystart = clip[1].xend = clip[1].yend = 0;
-   ReadWindowData(info->wctl, clip);
-   linewnd0addr = linewnd1addr = 0;
-   ReadLineWindowData(&info->islinewindow, info->wctl, &linewnd0addr, &linewnd1addr);
-   /* color calculation window: in => no color calc, out => color calc */
-   ReadWindowData(Vdp2Regs->WCTLD >> 8, colorcalcwindow);
-   {
-	   static int tables_initialized = 0;
-	   static int mosaic_table[16][1024];
-	   if(!tables_initialized)
-	   {
-		   tables_initialized = 1;
-			for(i=0;i<16;i++)
-			{
-				int m = i+1;
-				for(j=0;j<1024;j++)
-					mosaic_table[i][j] = j/m*m;
-			}
-	   }
-	   mosaic_x = mosaic_table[info->mosaicxmask-1];
-	   mosaic_y = mosaic_table[info->mosaicymask-1];
+DEFINE_SCROLLPIXELS(bmows, 0,0,0,0,0)
+DEFINE_SCROLLPIXELS(bmowS, 0,0,0,0,1)
+DEFINE_SCROLLPIXELS(bmoWs, 0,0,0,1,0)
+DEFINE_SCROLLPIXELS(bmoWS, 0,0,0,1,1)
+
+DEFINE_SCROLLPIXELS(bmOws, 0,0,1,0,0)
+DEFINE_SCROLLPIXELS(bmOwS, 0,0,1,0,1)
+DEFINE_SCROLLPIXELS(bmOWs, 0,0,1,1,0)
+DEFINE_SCROLLPIXELS(bmOWS, 0,0,1,1,1)
+
+DEFINE_SCROLLPIXELS(bMows, 0,1,0,0,0)
+DEFINE_SCROLLPIXELS(bMowS, 0,1,0,0,1)
+DEFINE_SCROLLPIXELS(bMoWs, 0,1,0,1,0)
+DEFINE_SCROLLPIXELS(bMoWS, 0,1,0,1,1)
+
+DEFINE_SCROLLPIXELS(bMOws, 0,1,1,0,0)
+DEFINE_SCROLLPIXELS(bMOwS, 0,1,1,0,1)
+DEFINE_SCROLLPIXELS(bMOWs, 0,1,1,1,0)
+DEFINE_SCROLLPIXELS(bMOWS, 0,1,1,1,1)
+
+DEFINE_SCROLLPIXELS(Bmows, 1,0,0,0,0)
+DEFINE_SCROLLPIXELS(BmowS, 1,0,0,0,1)
+DEFINE_SCROLLPIXELS(BmoWs, 1,0,0,1,0)
+DEFINE_SCROLLPIXELS(BmoWS, 1,0,0,1,1)
+
+DEFINE_SCROLLPIXELS(BmOws, 1,0,1,0,0)
+DEFINE_SCROLLPIXELS(BmOwS, 1,0,1,0,1)
+DEFINE_SCROLLPIXELS(BmOWs, 1,0,1,1,0)
+DEFINE_SCROLLPIXELS(BmOWS, 1,0,1,1,1)
+
+DEFINE_SCROLLPIXELS(BMows, 1,1,0,0,0)
+DEFINE_SCROLLPIXELS(BMowS, 1,1,0,0,1)
+DEFINE_SCROLLPIXELS(BMoWs, 1,1,0,1,0)
+DEFINE_SCROLLPIXELS(BMoWS, 1,1,0,1,1)
+
+DEFINE_SCROLLPIXELS(BMOws, 1,1,1,0,0)
+DEFINE_SCROLLPIXELS(BMOwS, 1,1,1,0,1)
+DEFINE_SCROLLPIXELS(BMOWs, 1,1,1,1,0)
+DEFINE_SCROLLPIXELS(BMOWS, 1,1,1,1,1)
+
+#undef DEFINE_SCROLLPIXELS
+
+static void (*scrollpixels_func_table[2][2][2][2][2])(vdp2draw_struct *, screeninfo_struct *, vdp2cellcache_struct *, int, int, int, int, int) =
+{
+   {  // B==0
+      {  // M==0
+         {{scrollpixels_bmows, scrollpixels_bmowS}, {scrollpixels_bmoWs, scrollpixels_bmoWS}},
+         {{scrollpixels_bmOws, scrollpixels_bmOwS}, {scrollpixels_bmOWs, scrollpixels_bmOWS}}
+      },
+      {  // M==1
+         {{scrollpixels_bMows, scrollpixels_bMowS}, {scrollpixels_bMoWs, scrollpixels_bMoWS}},
+         {{scrollpixels_bMOws, scrollpixels_bMOwS}, {scrollpixels_bMOWs, scrollpixels_bMOWS}}
+      }
+   },
+   {  // B==1
+      {  // M==0
+         {{scrollpixels_Bmows, scrollpixels_BmowS}, {scrollpixels_BmoWs, scrollpixels_BmoWS}},
+         {{scrollpixels_BmOws, scrollpixels_BmOwS}, {scrollpixels_BmOWs, scrollpixels_BmOWS}}
+      },
+      {  // M==1
+         {{scrollpixels_BMows, scrollpixels_BMowS}, {scrollpixels_BMoWs, scrollpixels_BMoWS}},
+         {{scrollpixels_BMOws, scrollpixels_BMOwS}, {scrollpixels_BMOWs, scrollpixels_BMOWS}}
+      }
    }
+};
 
-   for (j = 0; j < vdp2height; j++)
-   {
-      int Y;
-      int linescrollx = 0;
-      // precalculate the coordinate for the line(it's faster) and do line
-      // scroll
-      if (info->islinescroll)
-      {
-         if (info->islinescroll & 0x1)
-         {
-            linescrollx = (T1ReadLong(Vdp2Ram, info->linescrolltbl) >> 16) & 0x7FF;
-            info->linescrolltbl += 4;
-         }
-         if (info->islinescroll & 0x2)
-         {
-            info->y = ((T1ReadWord(Vdp2Ram, info->linescrolltbl) & 0x7FF) * resyratio) + scrolly;
-            info->linescrolltbl += 4;
-            y = info->y;
-         }
-         else
-            //y = info->y+((int)(info->coordincy *(float)(info->mosaicymask > 1 ? (j / info->mosaicymask * info->mosaicymask) : j)));
-			y = info->y + info->coordincy*mosaic_y[j];
-         if (info->islinescroll & 0x4)
-         {
-            info->coordincx = (T1ReadLong(Vdp2Ram, info->linescrolltbl) & 0x7FF00) / (float)65536.0;
-            info->coordincx *= resxratio;
-            info->linescrolltbl += 4;
-         }
+//////////////////////////////////////////////////////////////////////////////
+
+static void Vdp2DrawScrollLine(int j, int thread)
+{
+   vdp2cellcache_struct *cache = &vdp2cellcache[thread];
+   vdp2draw_struct lineinfo = *vdp2screen.info;
+   vdp2draw_struct *info = &lineinfo;
+   screeninfo_struct sinfo = vdp2screen.sinfo;
+   clipping_struct clip[2];
+   u32 linewnd0addr = vdp2screen.linewnd0addr + j * 4;
+   u32 linewnd1addr = vdp2screen.linewnd1addr + j * 4;
+   int k, y, Y;
+   int linescrollx = 0;
+   windowspans_struct spans;
+   void (*drawpixels)(vdp2draw_struct *, screeninfo_struct *, vdp2cellcache_struct *, int, int, int, int, int);
+
+   clip[0] = vdp2screen.clip[0];
+   clip[1] = vdp2screen.clip[1];
+
+   // precalculate the coordinate for the line(it's faster) and do line
+   // scroll
+   if (info->islinescroll)
+   {
+      // find this line in the line scroll table
+      info->linescrolltbl += vdp2screen.linescrollmult * (j << 2);
+
+      if (info->islinescroll & 0x1)
+      {
+         linescrollx = (T1ReadLong(Vdp2DrawRam, info->linescrolltbl & 0x7FFFF) >> 16) & 0x7FF;
+         info->linescrolltbl += 4;
+      }
+      if (info->islinescroll & 0x2)
+      {
+         info->y = ((T1ReadWord(Vdp2DrawRam, info->linescrolltbl & 0x7FFFF) & 0x7FF) * resyratio) + vdp2screen.scrolly;
+         info->linescrolltbl += 4;
+         y = info->y;
       }
       else
          //y = info->y+((int)(info->coordincy *(float)(info->mosaicymask > 1 ? (j / info->mosaicymask * info->mosaicymask) : j)));
-		 y = info->y + info->coordincy*mosaic_y[j];
+         y = info->y + info->coordincy*vdp2screen.mosaic_y[j];
+      if (info->islinescroll & 0x4)
+      {
+         info->coordincx = (T1ReadLong(Vdp2DrawRam, info->linescrolltbl & 0x7FFFF) & 0x7FF00) / (float)65536.0;
+         info->coordincx *= resxratio;
+         info->linescrolltbl += 4;
+      }
+   }
+   else
+      //y = info->y+((int)(info->coordincy *(float)(info->mosaicymask > 1 ? (j / info->mosaicymask * info->mosaicymask) : j)));
+      y = info->y + info->coordincy*vdp2screen.mosaic_y[j];
+
+   // if line window is enabled, adjust clipping values
+   ReadLineWindowClip(info->islinewindow, clip, &linewnd0addr, &linewnd1addr);
+   y &= sinfo.ymask;
+
+   if (info->isverticalscroll)
+   {
+      // this is *wrong*, vertical scroll use a different value per cell
+      // info->verticalscrolltbl should be incremented by info->verticalscrollinc
+      // each time there's a cell change and reseted at the end of the line...
+      // or something like that :)
+      y += T1ReadLong(Vdp2DrawRam, info->verticalscrolltbl & 0x7FFFF) >> 16;
+      y &= 0x1FF;
+   }
+
+   Y=y;
+
+   Vdp2LoadLineParams(info, j);
+
+   /* I'm really not sure about this... but I think the way we handle
+   high resolution gets in the way with window process. I may be wrong...
+   This was added for Cotton Boomerang */
+   Vdp2ReadWindowSpans(info->wctl, clip, j, vdp2width, resxratio, vdp2height, &spans);
+
+   // check special priority somewhere here
+
+   // Apply color offset and color calculation/special color calculation
+   // and then continue.
+   // We almost need to know well ahead of time what the top
+   // and second pixel is in order to work this.
+   drawpixels = scrollpixels_func_table[info->isbitmap != 0]
+                                       [info->mosaicxmask > 1]
+                                       [info->PostPixelFetchCalc == &DoColorOffset]
+                                       [((Vdp2DrawRegs->WCTLD >> 8) & 0xA) != 0]
+                                       [info->specialcolormode != 0];
+
+   for (k = 0; k < spans.count; k++)
+      drawpixels(info, &sinfo, cache, j, Y, linescrollx, spans.start[k], spans.end[k]);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void FASTCALL Vdp2DrawScroll(vdp2draw_struct *info)
+{
+   int i, j;
+
+   info->coordincx *= (float)resxratio;
+   info->coordincy *= (float)resyratio;
 
-      // if line window is enabled, adjust clipping values
-      ReadLineWindowClip(info->islinewindow, clip, &linewnd0addr, &linewnd1addr);
-      y &= sinfo.ymask;
+   SetupScreenVars(info, &vdp2screen.sinfo, info->PlaneAddr);
 
-      if (info->isverticalscroll)
+   vdp2screen.info = info;
+   vdp2screen.scrolly = info->y;
+   vdp2screen.linescrollmult = (info->islinescroll & 1) +
+      ((info->islinescroll & 2) >> 1) + ((info->islinescroll & 4) >> 2);
+
+   vdp2screen.clip[0].xstart = vdp2screen.clip[0].ystart = vdp2screen.clip[0].xend = vdp2screen.clip[0].yend = 0;
+   vdp2screen.clip[1].xstart = vdp2screen.clip[1].ystart = vdp2screen.clip[1].xend = vdp2screen.clip[1].yend = 0;
+   ReadWindowData(info->wctl, vdp2screen.clip);
+   vdp2screen.linewnd0addr = vdp2screen.linewnd1addr = 0;
+   ReadLineWindowData(&info->islinewindow, info->wctl, &vdp2screen.linewnd0addr, &vdp2screen.linewnd1addr);
+   /* color calculation window: in => no color calc, out => color calc */
+   ReadWindowData(Vdp2DrawRegs->WCTLD >> 8, vdp2screen.colorcalcwindow);
+   {
+	   static int tables_initialized = 0;
+	   static int mosaic_table[16][1024];
+	   if(!tables_initialized)
+	   {
+		   tables_initialized = 1;
+			for(i=0;i<16;i++)
+			{
+				int m = i+1;
+				for(j=0;j<1024;j++)
+					mosaic_table[i][j] = j/m*m;
+			}
+	   }
+	   vdp2screen.mosaic_x = mosaic_table[info->mosaicxmask-1];
+	   vdp2screen.mosaic_y = mosaic_table[info->mosaicymask-1];
+   }
+
+   VidsoftRunJobs(Vdp2DrawScrollLine, vdp2height);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static INLINE int Vdp2RotatedLineFits(fixed32 sp, fixed32 delta, int start, int end)
+{
+   s64 first = (s64)sp + (s64)delta * start;
+   s64 last = (s64)sp + (s64)delta * (end - 1);
+
+   return first >= INT_MIN && first <= INT_MAX && last >= INT_MIN && last <= INT_MAX;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Same as GenerateRotatedXPosFP()/GenerateRotatedYPosFP() for pixels start
+// to end - 1 of a line, for a parameter that doesn't change along the line.
+static void Vdp2GenerateRotatedLineFP(vdp2rotationparameterfp_struct *p, int start, int end, fixed32 xmul, fixed32 ymul, fixed32 C, fixed32 F, int *xs, int *ys)
+{
+   fixed32 Xsp = mulfixed(p->A, xmul) + mulfixed(p->B, ymul) + C;
+   fixed32 Ysp = mulfixed(p->D, xmul) + mulfixed(p->E, ymul) + F;
+   s64 accx, accy, stepx, stepy;
+   int i = start;
+
+   if (start >= end)
+      return;
+
+   // Xsp + dX * i wraps around on some lines, only the exact per pixel
+   // version gets those right
+   if (!Vdp2RotatedLineFits(Xsp, p->dX, start, end) ||
+       !Vdp2RotatedLineFits(Ysp, p->dY, start, end))
+   {
+      for (; i < end; i++)
       {
-         // this is *wrong*, vertical scroll use a different value per cell
-         // info->verticalscrolltbl should be incremented by info->verticalscrollinc
-         // each time there's a cell change and reseted at the end of the line...
-         // or something like that :)
-         y += T1ReadLong(Vdp2Ram, info->verticalscrolltbl) >> 16;
-         y &= 0x1FF;
+         xs[i] = GenerateRotatedXPosFP(p, i, xmul, ymul, C);
+         ys[i] = GenerateRotatedYPosFP(p, i, xmul, ymul, F);
       }
+      return;
+   }
 
-      Y=y;
+   // otherwise kx * (Xsp + dX * i) just goes up by kx * dX every pixel
+   accx = (s64)p->kx * ((s64)Xsp + (s64)p->dX * start);
+   accy = (s64)p->ky * ((s64)Ysp + (s64)p->dY * start);
+   stepx = (s64)p->kx * p->dX;
+   stepy = (s64)p->ky * p->dY;
 
-      info->LoadLineParams(info, j);
+#ifdef __SSE2__
+   if (end - i >= 4)
+   {
+      // two pixels per register, only bits 16-47 of the products are needed
+      __m128i x01 = _mm_set_epi64x(accx + stepx, accx);
+      __m128i x23 = _mm_set_epi64x(accx + stepx * 3, accx + stepx * 2);
+      __m128i y01 = _mm_set_epi64x(accy + stepy, accy);
+      __m128i y23 = _mm_set_epi64x(accy + stepy * 3, accy + stepy * 2);
+      __m128i step4x = _mm_set1_epi64x(stepx * 4);
+      __m128i step4y = _mm_set1_epi64x(stepy * 4);
+      __m128i xp = _mm_set1_epi32(p->Xp);
+      __m128i yp = _mm_set1_epi32(p->Yp);
+      __m128i mask = _mm_set1_epi32(0xFFFF);
+
+      for (; i + 4 <= end; i += 4)
+      {
+         __m128i x = _mm_unpacklo_epi64(_mm_shuffle_epi32(_mm_srli_epi64(x01, FP_SIZE), _MM_SHUFFLE(2, 0, 2, 0)),
+                                        _mm_shuffle_epi32(_mm_srli_epi64(x23, FP_SIZE), _MM_SHUFFLE(2, 0, 2, 0)));
+         __m128i y = _mm_unpacklo_epi64(_mm_shuffle_epi32(_mm_srli_epi64(y01, FP_SIZE), _MM_SHUFFLE(2, 0, 2, 0)),
+                                        _mm_shuffle_epi32(_mm_srli_epi64(y23, FP_SIZE), _MM_SHUFFLE(2, 0, 2, 0)));
+
+         x = _mm_and_si128(_mm_srli_epi32(_mm_add_epi32(x, xp), FP_SIZE), mask);
+         y = _mm_and_si128(_mm_srli_epi32(_mm_add_epi32(y, yp), FP_SIZE), mask);
+         _mm_storeu_si128((__m128i *)(xs + i), x);
+         _mm_storeu_si128((__m128i *)(ys + i), y);
+
+         x01 = _mm_add_epi64(x01, step4x);
+         x23 = _mm_add_epi64(x23, step4x);
+         y01 = _mm_add_epi64(y01, step4y);
+         y23 = _mm_add_epi64(y23, step4y);
+      }
+      accx += stepx * (i - start);
+      accy += stepy * (i - start);
+   }
+#endif
+
+   for (; i < end; i++)
+   {
+      xs[i] = (u16)(((u32)(accx >> FP_SIZE) + (u32)p->Xp) >> FP_SIZE);
+      ys[i] = (u16)(((u32)(accy >> FP_SIZE) + (u32)p->Yp) >> FP_SIZE);
+      accx += stepx;
+      accy += stepy;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void Vdp2DrawRotationLine(int j, int thread)
+{
+   vdp2cellcache_struct *cache = &vdp2cellcache[thread];
+   vdp2draw_struct lineinfo = *vdp2screen.info;
+   vdp2draw_struct *info = &lineinfo;
+   vdp2rotationparameterfp_struct *p = vdp2screen.p;
+   screeninfo_struct sinfo = vdp2screen.sinfo;
+   clipping_struct clip[2];
+   u32 linewnd0addr = vdp2screen.linewnd0addr + j * 4;
+   u32 linewnd1addr = vdp2screen.linewnd1addr + j * 4;
+   fixed32 xmul = vdp2screen.xmul + j * p->deltaXst;
+   fixed32 ymul = vdp2screen.ymul + j * p->deltaYst;
+   int i, k, x, y;
+   int xs[704], ys[704];
+   windowspans_struct spans;
 
-      for (i = 0; i < vdp2width; i++)
+   clip[0] = vdp2screen.clip[0];
+   clip[1] = vdp2screen.clip[1];
+
+   Vdp2LoadLineParams(info, j);
+   ReadLineWindowClip(info->islinewindow, clip, &linewnd0addr, &linewnd1addr);
+
+   // only draw the parts the windows let through
+   Vdp2ReadWindowSpans(info->wctl, clip, j, vdp2width, 1, vdp2height, &spans);
+
+   for (k = 0; k < spans.count; k++)
+   {
+      Vdp2GenerateRotatedLineFP(p, spans.start[k], spans.end[k], xmul, ymul, vdp2screen.C, vdp2screen.F, xs, ys);
+
+      for (i = spans.start[k]; i < spans.end[k]; i++)
       {
          u32 color, dot;
-         /* I'm really not sure about this... but I think the way we handle
-         high resolution gets in the way with window process. I may be wrong...
-         This was added for Cotton Boomerang */
-         int resxi = i * resxratio;
 
-         // See if screen position is clipped, if it isn't, continue
-         if (!TestBothWindow(info->wctl, clip, resxi, j))
-         {
-            continue;
-         }
+         x = xs[i] & sinfo.xmask;
+         y = ys[i] & sinfo.ymask;
 
-         //x = info->x+((int)(info->coordincx*(float)((info->mosaicxmask > 1) ? (i / info->mosaicxmask * info->mosaicxmask) : i)));
-		 x = info->x + mosaic_x[i]*info->coordincx;
-         x &= sinfo.xmask;
-		 
-         if (linescrollx) {
-            x += linescrollx;
-            x &= 0x3FF;
-         }
-
-         // Fetch Pixel, if it isn't transparent, continue
+         // Convert coordinates into graphics
          if (!info->isbitmap)
          {
             // Tile
-            y=Y;
             Vdp2MapCalcXY(info, &x, &y, &sinfo);
+            if (!Vdp2FetchCellPixel(cache, info, x, y, &color, &dot))
+               continue;
          }
-
-         if (!Vdp2FetchPixel(info, x, y, &color, &dot))
+         // Fetch pixel
+         else if (!Vdp2FetchPixel(info, x, y, &color, &dot))
          {
             continue;
          }
 
-         // check special priority somewhere here
+         TitanPutPixel(info->priority, i, j, info->PostPixelFetchCalc(info, COLSAT2YAB32(GetAlpha(info, color, dot), color)), info->linescreen);
+      }
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void Vdp2DrawRotationCoefLine(int j, int thread)
+{
+   vdp2cellcache_struct *cache = &vdp2cellcache[thread];
+   vdp2draw_struct lineinfo = *vdp2screen.info;
+   vdp2draw_struct *info = &lineinfo;
+   vdp2rotationparameterfp_struct lineparam, lineparam2;
+   vdp2rotationparameterfp_struct *p = &lineparam, *p2 = NULL;
+   screeninfo_struct sinfo = vdp2screen.sinfo;
+   screeninfo_struct sinfo2 = vdp2screen.sinfo2;
+   clipping_struct clip[2], rpwindow[2];
+   u32 linewnd0addr = vdp2screen.linewnd0addr + j * 4;
+   u32 linewnd1addr = vdp2screen.linewnd1addr + j * 4;
+   u32 rplinewnd0addr = vdp2screen.rplinewnd0addr + j * 4;
+   u32 rplinewnd1addr = vdp2screen.rplinewnd1addr + j * 4;
+   int userpwindow = vdp2screen.userpwindow;
+   fixed32 xmul, ymul, xmul2 = 0, ymul2 = 0;
+   u32 coefx, coefy, rcoefx, rcoefy;
+   u32 coefx2 = 0, coefy2 = 0, rcoefx2 = 0, rcoefy2 = 0;
+   u32 lineColor;
+   u16 lineColorAddr;
+   int i, k, x, y;
+   int xs[704], ys[704], xs2[704], ys2[704];
+   int linexy, linexy2;
+   windowspans_struct spans;
+
+   lineparam = *vdp2screen.p;
+   clip[0] = vdp2screen.clip[0];
+   clip[1] = vdp2screen.clip[1];
+   rpwindow[0] = vdp2screen.rpwindow[0];
+   rpwindow[1] = vdp2screen.rpwindow[1];
+
+   // the table positions just advance by a fixed amount every line
+   xmul = vdp2screen.xmul + j * p->deltaXst;
+   ymul = vdp2screen.ymul + j * p->deltaYst;
+   coefx = rcoefx = 0;
+   coefy = j * toint(p->deltaKAst);
+   rcoefy = j * decipart(p->deltaKAst);
+
+   if (vdp2screen.p2 != NULL)
+   {
+      lineparam2 = *vdp2screen.p2;
+      p2 = &lineparam2;
+      xmul2 = vdp2screen.xmul2 + j * p2->deltaXst;
+      ymul2 = vdp2screen.ymul2 + j * p2->deltaYst;
+      if (p2->coefenab)
+      {
+         coefy2 = j * toint(p2->deltaKAst);
+         rcoefy2 = j * decipart(p2->deltaKAst);
+      }
+   }
+
+   if (p->deltaKAx == 0)
+   {
+      Vdp2ReadCoefficientFP(p,
+                            p->coeftbladdr +
+                            (coefy + touint(rcoefy)) *
+                            p->coefdatasize);
+   }
+   else if (j > 0)
+   {
+      // the line color below uses the last coefficient of the previous line
+      u32 lastcoefy = (j - 1) * toint(p->deltaKAst);
+      u32 lastrcoefy = (j - 1) * decipart(p->deltaKAst);
+      u32 lastcoefx = (vdp2width - 1) * toint(p->deltaKAx);
+      u32 lastrcoefx = (vdp2width - 1) * decipart(p->deltaKAx);
+
+      Vdp2ReadCoefficientFP(p,
+                            p->coeftbladdr +
+                            (lastcoefy + lastcoefx + toint(lastrcoefx + lastrcoefy)) *
+                            p->coefdatasize);
+   }
+   if ((p2 != NULL) && p2->coefenab && (p2->deltaKAx == 0))
+   {
+      Vdp2ReadCoefficientFP(p2,
+                            p2->coeftbladdr +
+                            (coefy2 + touint(rcoefy2)) *
+                            p2->coefdatasize);
+   }
+
+   if (info->linescreen > 1)
+   {
+      u32 lineAddr = vdp2screen.lineAddr + j * vdp2screen.lineInc;
+
+      lineColorAddr = (T1ReadWord(Vdp2DrawRam, lineAddr & 0x7FFFF) & 0x780) | p->linescreen;
+      lineColor = Vdp2ColorRamGetColor(lineColorAddr);
+      TitanPutLineHLine(info->linescreen, j, COLSAT2YAB32(0x3F, lineColor));
+   }
+
+   Vdp2LoadLineParams(info, j);
+   ReadLineWindowClip(info->islinewindow, clip, &linewnd0addr, &linewnd1addr);
+
+   if (userpwindow)
+      ReadLineWindowClip(vdp2screen.isrplinewindow, rpwindow, &rplinewnd0addr, &rplinewnd1addr);
+
+   Vdp2ReadWindowSpans(info->wctl, clip, j, vdp2width, 1, vdp2height, &spans);
+
+   // parameters only read once per line give the coordinates for the whole
+   // line in one go, the second one only matters when the first is skipped
+   linexy = (p->deltaKAx == 0);
+   linexy2 = (p2 != NULL) && !(p2->coefenab && p2->deltaKAx != 0) &&
+             (userpwindow || !linexy || p->msb);
+
+   for (k = 0, i = 0; k < spans.count; k++)
+   {
+      // step the coefficient tables over the clipped pixels
+      int skip = spans.start[k] - i;
+
+      if (p->deltaKAx != 0)
+      {
+         coefx += skip * toint(p->deltaKAx);
+         rcoefx += skip * decipart(p->deltaKAx);
+      }
+      if ((p2 != NULL) && p2->coefenab && (p2->deltaKAx != 0))
+      {
+         coefx2 += skip * toint(p2->deltaKAx);
+         rcoefx2 += skip * decipart(p2->deltaKAx);
+      }
+
+      if (linexy)
+         Vdp2GenerateRotatedLineFP(p, spans.start[k], spans.end[k], xmul, ymul, vdp2screen.C, vdp2screen.F, xs, ys);
+      if (linexy2)
+         Vdp2GenerateRotatedLineFP(p2, spans.start[k], spans.end[k], xmul2, ymul2, vdp2screen.C2, vdp2screen.F2, xs2, ys2);
+
+      for (i = spans.start[k]; i < spans.end[k]; i++)
+      {
+         u32 color, dot;
+
+         if (p->deltaKAx != 0)
+         {
+            Vdp2ReadCoefficientFP(p,
+                                  p->coeftbladdr +
+                                  (coefy + coefx + toint(rcoefx + rcoefy)) *
+                                  p->coefdatasize);
+            coefx += toint(p->deltaKAx);
+            rcoefx += decipart(p->deltaKAx);
+         }
+         if ((p2 != NULL) && p2->coefenab && (p2->deltaKAx != 0))
+         {
+            Vdp2ReadCoefficientFP(p2,
+                                  p2->coeftbladdr +
+                                  (coefy2 + coefx2 + toint(rcoefx2 + rcoefy2)) *
+                                  p2->coefdatasize);
+            coefx2 += toint(p2->deltaKAx);
+            rcoefx2 += decipart(p2->deltaKAx);
+         }
+
+         if (((! userpwindow) && p->msb) || (userpwindow && (! TestBothWindow(Vdp2DrawRegs->WCTLD, rpwindow, i, j))))
+         {
+            if ((p2 == NULL) || (p2->coefenab && p2->msb)) continue;
 
-         // Apply color offset and color calculation/special color calculation
-         // and then continue.
-         // We almost need to know well ahead of time what the top
-         // and second pixel is in order to work this.
+            if (linexy2)
+            {
+               x = xs2[i];
+               y = ys2[i];
+            }
+            else
+            {
+               x = GenerateRotatedXPosFP(p2, i, xmul2, ymul2, vdp2screen.C2);
+               y = GenerateRotatedYPosFP(p2, i, xmul2, ymul2, vdp2screen.F2);
+            }
+
+            switch(p2->screenover) {
+               case 0:
+                  x &= sinfo2.xmask;
+                  y &= sinfo2.ymask;
+                  break;
+               case 1:
+                  VDP2LOG("Screen-over mode 1 not implemented");
+                  x &= sinfo2.xmask;
+                  y &= sinfo2.ymask;
+                  break;
+               case 2:
+                  if ((x > sinfo2.xmask) || (y > sinfo2.ymask)) continue;
+                  break;
+               case 3:
+                  if ((x > 512) || (y > 512)) continue;
+            }
 
+            // Convert coordinates into graphics
+            if (!info->isbitmap)
+            {
+               // Tile
+               Vdp2MapCalcXY(info, &x, &y, &sinfo2);
+            }
+         }
+         else if (p->msb) continue;
+         else
          {
-            u8 alpha;
-            /* if we're in the valid area of the color calculation window, don't do color calculation */
-            if (!TestBothWindow(Vdp2Regs->WCTLD >> 8, colorcalcwindow, i, j))
-               alpha = 0x3F;
+            if (linexy)
+            {
+               x = xs[i];
+               y = ys[i];
+            }
             else
-               alpha = GetAlpha(info, color, dot);
+            {
+               x = GenerateRotatedXPosFP(p, i, xmul, ymul, vdp2screen.C);
+               y = GenerateRotatedYPosFP(p, i, xmul, ymul, vdp2screen.F);
+            }
+
+            switch(p->screenover) {
+               case 0:
+                  x &= sinfo.xmask;
+                  y &= sinfo.ymask;
+                  break;
+               case 1:
+                  VDP2LOG("Screen-over mode 1 not implemented");
+                  x &= sinfo.xmask;
+                  y &= sinfo.ymask;
+                  break;
+               case 2:
+                  if ((x > sinfo.xmask) || (y > sinfo.ymask)) continue;
+                  break;
+               case 3:
+                  if ((x > 512) || (y > 512)) continue;
+            }
+
+            // Convert coordinates into graphics
+            if (!info->isbitmap)
+            {
+               // Tile
+               Vdp2MapCalcXY(info, &x, &y, &sinfo);
+            }
+         }
 
-            TitanPutPixel(info->priority, i, j, info->PostPixelFetchCalc(info, COLSAT2YAB32(alpha, color)), info->linescreen);
+         // Fetch pixel
+         if (!info->isbitmap)
+         {
+            if (!Vdp2FetchCellPixel(cache, info, x, y, &color, &dot))
+               continue;
          }
+         else if (!Vdp2FetchPixel(info, x, y, &color, &dot))
+         {
+            continue;
+         }
+
+         TitanPutPixel(info->priority, i, j, info->PostPixelFetchCalc(info, COLSAT2YAB32(GetAlpha(info, color, dot), color)), info->linescreen);
       }
-   }    
+   }
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
 static void FASTCALL Vdp2DrawRotationFP(vdp2draw_struct *info, vdp2rotationparameterfp_struct *parameter)
 {
-   int i, j;
-   int x, y;
-   screeninfo_struct sinfo;
    vdp2rotationparameterfp_struct *p=&parameter[info->rotatenum];
-   clipping_struct clip[2];
-   u32 linewnd0addr, linewnd1addr;
 
-   clip[0].xstart = clip[0].ystart = clip[0].xend = clip[0].yend = 0;
-   clip[1].xstart = clip[1].ystart = clip[1].xend = clip[1].yend = 0;
-   ReadWindowData(info->wctl, clip);
-   linewnd0addr = linewnd1addr = 0;
-   ReadLineWindowData(&info->islinewindow, info->wctl, &linewnd0addr, &linewnd1addr);
+   vdp2screen.info = info;
+   vdp2screen.p = p;
+   vdp2screen.p2 = NULL;
+
+   vdp2screen.clip[0].xstart = vdp2screen.clip[0].ystart = vdp2screen.clip[0].xend = vdp2screen.clip[0].yend = 0;
+   vdp2screen.clip[1].xstart = vdp2screen.clip[1].ystart = vdp2screen.clip[1].xend = vdp2screen.clip[1].yend = 0;
+   ReadWindowData(info->wctl, vdp2screen.clip);
+   vdp2screen.linewnd0addr = vdp2screen.linewnd1addr = 0;
+   ReadLineWindowData(&info->islinewindow, info->wctl, &vdp2screen.linewnd0addr, &vdp2screen.linewnd1addr);
 
    Vdp2ReadRotationTableFP(info->rotatenum, p);
 
    if (!p->coefenab)
    {
-      fixed32 xmul, ymul, C, F;
-
       // Since coefficients aren't being used, we can simplify the drawing process
       if (IsScreenRotatedFP(p))
       {
@@ -821,261 +1806,68 @@ static void FASTCALL Vdp2DrawRotationFP(vdp2draw_struct *info, vdp2rotationparam
       }
       else
       {
-         GenerateRotatedVarFP(p, &xmul, &ymul, &C, &F);
+         GenerateRotatedVarFP(p, &vdp2screen.xmul, &vdp2screen.ymul, &vdp2screen.C, &vdp2screen.F);
 
          // Do simple rotation
          CalculateRotationValuesFP(p);
 
-         SetupScreenVars(info, &sinfo, info->PlaneAddr);
-
-         for (j = 0; j < vdp2height; j++)
-         {
-            info->LoadLineParams(info, j);
-            ReadLineWindowClip(info->islinewindow, clip, &linewnd0addr, &linewnd1addr);
-
-            for (i = 0; i < vdp2width; i++)
-            {
-               u32 color, dot;
-
-               if (!TestBothWindow(info->wctl, clip, i, j))
-                  continue;
-
-               x = GenerateRotatedXPosFP(p, i, xmul, ymul, C) & sinfo.xmask;
-               y = GenerateRotatedYPosFP(p, i, xmul, ymul, F) & sinfo.ymask;
-
-               // Convert coordinates into graphics
-               if (!info->isbitmap)
-               {
-                  // Tile
-                  Vdp2MapCalcXY(info, &x, &y, &sinfo);
-               }
- 
-               // Fetch pixel
-               if (!Vdp2FetchPixel(info, x, y, &color, &dot))
-               {
-                  continue;
-               }
-
-               TitanPutPixel(info->priority, i, j, info->PostPixelFetchCalc(info, COLSAT2YAB32(GetAlpha(info, color, dot), color)), info->linescreen);
-            }
-            xmul += p->deltaXst;
-            ymul += p->deltaYst;
-         }
+         SetupScreenVars(info, &vdp2screen.sinfo, info->PlaneAddr);
 
+         VidsoftRunJobs(Vdp2DrawRotationLine, vdp2height);
          return;
       }
    }
    else
    {
-      fixed32 xmul, ymul, C, F;
-      u32 coefx, coefy;
-      u32 rcoefx, rcoefy;
-      u32 lineAddr, lineColor, lineInc;
-      u16 lineColorAddr;
-
-      fixed32 xmul2, ymul2, C2, F2;
-      u32 coefx2, coefy2;
-      u32 rcoefx2, rcoefy2;
-      screeninfo_struct sinfo2;
       vdp2rotationparameterfp_struct *p2 = NULL;
 
-      clipping_struct rpwindow[2];
-      int userpwindow = 0;
-      int isrplinewindow = 0;
-      u32 rplinewnd0addr, rplinewnd1addr;
+      vdp2screen.userpwindow = 0;
+      vdp2screen.isrplinewindow = 0;
+      vdp2screen.rplinewnd0addr = vdp2screen.rplinewnd1addr = 0;
 
-      if ((Vdp2Regs->RPMD & 3) == 2)
+      if ((Vdp2DrawRegs->RPMD & 3) == 2)
          p2 = &parameter[1 - info->rotatenum];
-      else if ((Vdp2Regs->RPMD & 3) == 3)
+      else if ((Vdp2DrawRegs->RPMD & 3) == 3)
       {
-         ReadWindowData(Vdp2Regs->WCTLD, rpwindow);
-         rplinewnd0addr = rplinewnd1addr = 0;
-         ReadLineWindowData(&isrplinewindow, Vdp2Regs->WCTLD, &rplinewnd0addr, &rplinewnd1addr);
-         userpwindow = 1;
+         ReadWindowData(Vdp2DrawRegs->WCTLD, vdp2screen.rpwindow);
+         ReadLineWindowData(&vdp2screen.isrplinewindow, Vdp2DrawRegs->WCTLD, &vdp2screen.rplinewnd0addr, &vdp2screen.rplinewnd1addr);
+         vdp2screen.userpwindow = 1;
          p2 = &parameter[1 - info->rotatenum];
       }
 
-      GenerateRotatedVarFP(p, &xmul, &ymul, &C, &F);
+      GenerateRotatedVarFP(p, &vdp2screen.xmul, &vdp2screen.ymul, &vdp2screen.C, &vdp2screen.F);
 
       // Rotation using Coefficient Tables(now this stuff just gets wacky. It
       // has to be done in software, no exceptions)
       CalculateRotationValuesFP(p);
 
-      SetupScreenVars(info, &sinfo, p->PlaneAddr);
-      coefx = coefy = 0;
-      rcoefx = rcoefy = 0;
+      SetupScreenVars(info, &vdp2screen.sinfo, p->PlaneAddr);
 
       if (p2 != NULL)
       {
          Vdp2ReadRotationTableFP(1 - info->rotatenum, p2);
-         GenerateRotatedVarFP(p2, &xmul2, &ymul2, &C2, &F2);
+         GenerateRotatedVarFP(p2, &vdp2screen.xmul2, &vdp2screen.ymul2, &vdp2screen.C2, &vdp2screen.F2);
          CalculateRotationValuesFP(p2);
-         SetupScreenVars(info, &sinfo2, p2->PlaneAddr);
-         coefx2 = coefy2 = 0;
-         rcoefx2 = rcoefy2 = 0;
+         SetupScreenVars(info, &vdp2screen.sinfo2, p2->PlaneAddr);
       }
+      vdp2screen.p2 = p2;
 
+      vdp2screen.lineAddr = vdp2screen.lineInc = 0;
       if (info->linescreen)
       {
-         if ((info->rotatenum == 0) && (Vdp2Regs->KTCTL & 0x10))
+         if ((info->rotatenum == 0) && (Vdp2DrawRegs->KTCTL & 0x10))
             info->linescreen = 2;
-         else if (Vdp2Regs->KTCTL & 0x1000)
+         else if (Vdp2DrawRegs->KTCTL & 0x1000)
             info->linescreen = 3;
-         if (Vdp2Regs->VRSIZE & 0x8000)
-            lineAddr = (Vdp2Regs->LCTA.all & 0x7FFFF) << 1;
+         if (Vdp2DrawRegs->VRSIZE & 0x8000)
+            vdp2screen.lineAddr = (Vdp2DrawRegs->LCTA.all & 0x7FFFF) << 1;
          else
-            lineAddr = (Vdp2Regs->LCTA.all & 0x3FFFF) << 1;
+            vdp2screen.lineAddr = (Vdp2DrawRegs->LCTA.all & 0x3FFFF) << 1;
 
-         lineInc = Vdp2Regs->LCTA.part.U & 0x8000 ? 2 : 0;
+         vdp2screen.lineInc = Vdp2DrawRegs->LCTA.part.U & 0x8000 ? 2 : 0;
       }
 
-      for (j = 0; j < vdp2height; j++)
-      {
-         if (p->deltaKAx == 0)
-         {
-            Vdp2ReadCoefficientFP(p,
-                                  p->coeftbladdr +
-                                  (coefy + touint(rcoefy)) *
-                                  p->coefdatasize);
-         }
-         if ((p2 != NULL) && p2->coefenab && (p2->deltaKAx == 0))
-         {
-            Vdp2ReadCoefficientFP(p2,
-                                  p2->coeftbladdr +
-                                  (coefy2 + touint(rcoefy2)) *
-                                  p2->coefdatasize);
-         }
-
-         if (info->linescreen > 1)
-         {
-            lineColorAddr = (T1ReadWord(Vdp2Ram, lineAddr) & 0x780) | p->linescreen;
-            lineColor = Vdp2ColorRamGetColor(lineColorAddr);
-            lineAddr += lineInc;
-            TitanPutLineHLine(info->linescreen, j, COLSAT2YAB32(0x3F, lineColor));
-         }
-
-         info->LoadLineParams(info, j);
-         ReadLineWindowClip(info->islinewindow, clip, &linewnd0addr, &linewnd1addr);
-
-         if (userpwindow)
-            ReadLineWindowClip(isrplinewindow, rpwindow, &rplinewnd0addr, &rplinewnd1addr);
-
-         for (i = 0; i < vdp2width; i++)
-         {
-            u32 color, dot;
-
-            if (p->deltaKAx != 0)
-            {
-               Vdp2ReadCoefficientFP(p,
-                                     p->coeftbladdr +
-                                     (coefy + coefx + toint(rcoefx + rcoefy)) *
-                                     p->coefdatasize);
-               coefx += toint(p->deltaKAx);
-               rcoefx += decipart(p->deltaKAx);
-            }
-            if ((p2 != NULL) && p2->coefenab && (p2->deltaKAx != 0))
-            {
-               Vdp2ReadCoefficientFP(p2,
-                                     p2->coeftbladdr +
-                                     (coefy2 + coefx2 + toint(rcoefx2 + rcoefy2)) *
-                                     p2->coefdatasize);
-               coefx2 += toint(p2->deltaKAx);
-               rcoefx2 += decipart(p2->deltaKAx);
-            }
-
-            if (!TestBothWindow(info->wctl, clip, i, j))
-               continue;
-
-            if (((! userpwindow) && p->msb) || (userpwindow && (! TestBothWindow(Vdp2Regs->WCTLD, rpwindow, i, j))))
-            {
-               if ((p2 == NULL) || (p2->coefenab && p2->msb)) continue;
-
-               x = GenerateRotatedXPosFP(p2, i, xmul2, ymul2, C2);
-               y = GenerateRotatedYPosFP(p2, i, xmul2, ymul2, F2);
-
-               switch(p2->screenover) {
-                  case 0:
-                     x &= sinfo2.xmask;
-                     y &= sinfo2.ymask;
-                     break;
-                  case 1:
-                     VDP2LOG("Screen-over mode 1 not implemented");
-                     x &= sinfo2.xmask;
-                     y &= sinfo2.ymask;
-                     break;
-                  case 2:
-                     if ((x > sinfo2.xmask) || (y > sinfo2.ymask)) continue;
-                     break;
-                  case 3:
-                     if ((x > 512) || (y > 512)) continue;
-               }
-
-               // Convert coordinates into graphics
-               if (!info->isbitmap)
-               {
-                  // Tile
-                  Vdp2MapCalcXY(info, &x, &y, &sinfo2);
-               }
-            }
-            else if (p->msb) continue;
-            else
-            {
-               x = GenerateRotatedXPosFP(p, i, xmul, ymul, C);
-               y = GenerateRotatedYPosFP(p, i, xmul, ymul, F);
-
-               switch(p->screenover) {
-                  case 0:
-                     x &= sinfo.xmask;
-                     y &= sinfo.ymask;
-                     break;
-                  case 1:
-                     VDP2LOG("Screen-over mode 1 not implemented");
-                     x &= sinfo.xmask;
-                     y &= sinfo.ymask;
-                     break;
-                  case 2:
-                     if ((x > sinfo.xmask) || (y > sinfo.ymask)) continue;
-                     break;
-                  case 3:
-                     if ((x > 512) || (y > 512)) continue;
-               }
-
-               // Convert coordinates into graphics
-               if (!info->isbitmap)
-               {
-                  // Tile
-                  Vdp2MapCalcXY(info, &x, &y, &sinfo);
-               }
-            }
-
-            // Fetch pixel
-            if (!Vdp2FetchPixel(info, x, y, &color, &dot))
-            {
-               continue;
-            }
-
-            TitanPutPixel(info->priority, i, j, info->PostPixelFetchCalc(info, COLSAT2YAB32(GetAlpha(info, color, dot), color)), info->linescreen);
-         }
-         xmul += p->deltaXst;
-         ymul += p->deltaYst;
-         coefx = 0;
-         rcoefx = 0;
-         coefy += toint(p->deltaKAst);
-         rcoefy += decipart(p->deltaKAst);
-
-         if (p2 != NULL)
-         {
-            xmul2 += p2->deltaXst;
-            ymul2 += p2->deltaYst;
-            if (p2->coefenab)
-            {
-               coefx2 = 0;
-               rcoefx2 = 0;
-               coefy2 += toint(p2->deltaKAst);
-               rcoefy2 += decipart(p2->deltaKAst);
-            }
-         }
-      }
+      VidsoftRunJobs(Vdp2DrawRotationCoefLine, vdp2height);
       return;
    }
 
@@ -1089,7 +1881,7 @@ static void Vdp2DrawBackScreen(void)
    int i, j;
 
    // Only draw black if TVMD's DISP and BDCLMD bits are cleared
-   if ((Vdp2Regs->TVMD & 0x8000) == 0 && (Vdp2Regs->TVMD & 0x100) == 0)
+   if ((Vdp2DrawRegs->TVMD & 0x8000) == 0 && (Vdp2DrawRegs->TVMD & 0x100) == 0)
    {
       // Draw Black
       for (j = 0; j < vdp2height; j++)
@@ -1101,17 +1893,17 @@ static void Vdp2DrawBackScreen(void)
       u32 scrAddr;
       u16 dot;
 
-      if (Vdp2Regs->VRSIZE & 0x8000)
-         scrAddr = (((Vdp2Regs->BKTAU & 0x7) << 16) | Vdp2Regs->BKTAL) * 2;
+      if (Vdp2DrawRegs->VRSIZE & 0x8000)
+         scrAddr = (((Vdp2DrawRegs->BKTAU & 0x7) << 16) | Vdp2DrawRegs->BKTAL) * 2;
       else
-         scrAddr = (((Vdp2Regs->BKTAU & 0x3) << 16) | Vdp2Regs->BKTAL) * 2;
+         scrAddr = (((Vdp2DrawRegs->BKTAU & 0x3) << 16) | Vdp2DrawRegs->BKTAL) * 2;
 
-      if (Vdp2Regs->BKTAU & 0x8000)
+      if (Vdp2DrawRegs->BKTAU & 0x8000)
       {
          // Per Line
          for (i = 0; i < vdp2height; i++)
          {
-            dot = T1ReadWord(Vdp2Ram, scrAddr);
+            dot = T1ReadWord(Vdp2DrawRam, scrAddr & 0x7FFFF);
             scrAddr += 2;
 
             TitanPutBackHLine(i, COLSAT2YAB16(0x3F, dot));
@@ -1120,7 +1912,7 @@ static void Vdp2DrawBackScreen(void)
       else
       {
          // Single Color
-         dot = T1ReadWord(Vdp2Ram, scrAddr);
+         dot = T1ReadWord(Vdp2DrawRam, scrAddr & 0x7FFFF);
 
          for (j = 0; j < vdp2height; j++)
             TitanPutBackHLine(j, COLSAT2YAB16(0x3F, dot));
@@ -1138,20 +1930,20 @@ static void Vdp2DrawLineScreen(void)
    int i;
 
    /* no need to go further if no screen is using the line screen */
-   if (Vdp2Regs->LNCLEN == 0)
+   if (Vdp2DrawRegs->LNCLEN == 0)
       return;
 
-   if (Vdp2Regs->VRSIZE & 0x8000)
-      scrAddr = (Vdp2Regs->LCTA.all & 0x7FFFF) << 1;
+   if (Vdp2DrawRegs->VRSIZE & 0x8000)
+      scrAddr = (Vdp2DrawRegs->LCTA.all & 0x7FFFF) << 1;
    else
-      scrAddr = (Vdp2Regs->LCTA.all & 0x3FFFF) << 1;
+      scrAddr = (Vdp2DrawRegs->LCTA.all & 0x3FFFF) << 1;
 
-   if (Vdp2Regs->LCTA.part.U & 0x8000)
+   if (Vdp2DrawRegs->LCTA.part.U & 0x8000)
    {
       /* per line */
       for (i = 0; i < vdp2height; i++)
       {
-         color = T1ReadWord(Vdp2Ram, scrAddr) & 0x7FF;
+         color = T1ReadWord(Vdp2DrawRam, scrAddr & 0x7FFFF) & 0x7FF;
          dot = Vdp2ColorRamGetColor(color);
          scrAddr += 2;
 
@@ -1161,7 +1953,7 @@ static void Vdp2DrawLineScreen(void)
    else
    {
       /* single color, implemented but not tested... */
-      color = T1ReadWord(Vdp2Ram, scrAddr) & 0x7FF;
+      color = T1ReadWord(Vdp2DrawRam, scrAddr & 0x7FFFF) & 0x7FF;
       dot = Vdp2ColorRamGetColor(color);
       for (i = 0; i < vdp2height; i++)
          TitanPutLineHLine(1, i, COLSAT2YAB32(0x3F, dot));
@@ -1190,117 +1982,117 @@ static void Vdp2DrawNBG0(void)
    parameter[0].PlaneAddr = (void FASTCALL (*)(void *, int))&Vdp2ParameterAPlaneAddr;
    parameter[1].PlaneAddr = (void FASTCALL (*)(void *, int))&Vdp2ParameterBPlaneAddr;
 
-   if (Vdp2Regs->BGON & 0x20)
+   if (Vdp2DrawRegs->BGON & 0x20)
    {
       // RBG1 mode
-      info.enable = Vdp2Regs->BGON & 0x20;
+      info.enable = Vdp2DrawRegs->BGON & 0x20;
 
       // Read in Parameter B
       Vdp2ReadRotationTableFP(1, &parameter[1]);
 
-      if((info.isbitmap = Vdp2Regs->CHCTLA & 0x2) != 0)
+      if((info.isbitmap = Vdp2DrawRegs->CHCTLA & 0x2) != 0)
       {
          // Bitmap Mode
-         ReadBitmapSize(&info, Vdp2Regs->CHCTLA >> 2, 0x3);
+         ReadBitmapSize(&info, Vdp2DrawRegs->CHCTLA >> 2, 0x3);
 
-         info.charaddr = (Vdp2Regs->MPOFR & 0x70) * 0x2000;
-         info.paladdr = (Vdp2Regs->BMPNA & 0x7) << 8;
+         info.charaddr = (Vdp2DrawRegs->MPOFR & 0x70) * 0x2000;
+         info.paladdr = (Vdp2DrawRegs->BMPNA & 0x7) << 8;
          info.flipfunction = 0;
          info.specialfunction = 0;
-         info.specialcolorfunction = (Vdp2Regs->BMPNA & 0x10) >> 4;
+         info.specialcolorfunction = (Vdp2DrawRegs->BMPNA & 0x10) >> 4;
       }
       else
       {
          // Tile Mode
          info.mapwh = 4;
-         ReadPlaneSize(&info, Vdp2Regs->PLSZ >> 12);
-         ReadPatternData(&info, Vdp2Regs->PNCN0, Vdp2Regs->CHCTLA & 0x1);
+         ReadPlaneSize(&info, Vdp2DrawRegs->PLSZ >> 12);
+         ReadPatternData(&info, Vdp2DrawRegs->PNCN0, Vdp2DrawRegs->CHCTLA & 0x1);
       }
 
       info.rotatenum = 1;
       info.rotatemode = 0;
       info.PlaneAddr = (void FASTCALL (*)(void *, int))&Vdp2ParameterBPlaneAddr;
    }
-   else if (Vdp2Regs->BGON & 0x1)
+   else if (Vdp2DrawRegs->BGON & 0x1)
    {
       // NBG0 mode
-      info.enable = Vdp2Regs->BGON & 0x1;
+      info.enable = Vdp2DrawRegs->BGON & 0x1;
 
-      if((info.isbitmap = Vdp2Regs->CHCTLA & 0x2) != 0)
+      if((info.isbitmap = Vdp2DrawRegs->CHCTLA & 0x2) != 0)
       {
          // Bitmap Mode
-         ReadBitmapSize(&info, Vdp2Regs->CHCTLA >> 2, 0x3);
+         ReadBitmapSize(&info, Vdp2DrawRegs->CHCTLA >> 2, 0x3);
 
-         info.x = Vdp2Regs->SCXIN0 & 0x7FF;
-         info.y = Vdp2Regs->SCYIN0 & 0x7FF;
+         info.x = Vdp2DrawRegs->SCXIN0 & 0x7FF;
+         info.y = Vdp2DrawRegs->SCYIN0 & 0x7FF;
 
-         info.charaddr = (Vdp2Regs->MPOFN & 0x7) * 0x20000;
-         info.paladdr = (Vdp2Regs->BMPNA & 0x7) << 8;
+         info.charaddr = (Vdp2DrawRegs->MPOFN & 0x7) * 0x20000;
+         info.paladdr = (Vdp2DrawRegs->BMPNA & 0x7) << 8;
          info.flipfunction = 0;
          info.specialfunction = 0;
-         info.specialcolorfunction = (Vdp2Regs->BMPNA & 0x10) >> 4;
+         info.specialcolorfunction = (Vdp2DrawRegs->BMPNA & 0x10) >> 4;
       }
       else
       {
          // Tile Mode
          info.mapwh = 2;
 
-         ReadPlaneSize(&info, Vdp2Regs->PLSZ);
+         ReadPlaneSize(&info, Vdp2DrawRegs->PLSZ);
 
-         info.x = Vdp2Regs->SCXIN0 & 0x7FF;
-         info.y = Vdp2Regs->SCYIN0 & 0x7FF;
-         ReadPatternData(&info, Vdp2Regs->PNCN0, Vdp2Regs->CHCTLA & 0x1);
+         info.x = Vdp2DrawRegs->SCXIN0 & 0x7FF;
+         info.y = Vdp2DrawRegs->SCYIN0 & 0x7FF;
+         ReadPatternData(&info, Vdp2DrawRegs->PNCN0, Vdp2DrawRegs->CHCTLA & 0x1);
       }
 
-      info.coordincx = (Vdp2Regs->ZMXN0.all & 0x7FF00) / (float) 65536;
-      info.coordincy = (Vdp2Regs->ZMYN0.all & 0x7FF00) / (float) 65536;
+      info.coordincx = (Vdp2DrawRegs->ZMXN0.all & 0x7FF00) / (float) 65536;
+      info.coordincy = (Vdp2DrawRegs->ZMYN0.all & 0x7FF00) / (float) 65536;
       info.PlaneAddr = (void FASTCALL (*)(void *, int))&Vdp2NBG0PlaneAddr;
    }
    else
       // Not enabled
       return;
 
-   info.transparencyenable = !(Vdp2Regs->BGON & 0x100);
-   info.specialprimode = Vdp2Regs->SFPRMD & 0x3;
+   info.transparencyenable = !(Vdp2DrawRegs->BGON & 0x100);
+   info.specialprimode = Vdp2DrawRegs->SFPRMD & 0x3;
 
-   info.colornumber = (Vdp2Regs->CHCTLA & 0x70) >> 4;
+   info.colornumber = (Vdp2DrawRegs->CHCTLA & 0x70) >> 4;
 
-   if (Vdp2Regs->CCCTL & 0x201)
-      info.alpha = ((~Vdp2Regs->CCRNA & 0x1F) << 1) + 1;
+   if (Vdp2DrawRegs->CCCTL & 0x201)
+      info.alpha = ((~Vdp2DrawRegs->CCRNA & 0x1F) << 1) + 1;
    else
       info.alpha = 0x3F;
-   if ((Vdp2Regs->CCCTL & 0x201) == 0x201) info.alpha |= 0x80;
-   else if ((Vdp2Regs->CCCTL & 0x101) == 0x101) info.alpha |= 0x80;
-   info.specialcolormode = Vdp2Regs->SFCCMD & 0x3;
-   if (Vdp2Regs->SFSEL & 0x1)
-      info.specialcode = Vdp2Regs->SFCODE >> 8;
+   if ((Vdp2DrawRegs->CCCTL & 0x201) == 0x201) info.alpha |= 0x80;
+   else if ((Vdp2DrawRegs->CCCTL & 0x101) == 0x101) info.alpha |= 0x80;
+   info.specialcolormode = Vdp2DrawRegs->SFCCMD & 0x3;
+   if (Vdp2DrawRegs->SFSEL & 0x1)
+      info.specialcode = Vdp2DrawRegs->SFCODE >> 8;
    else
-      info.specialcode = Vdp2Regs->SFCODE & 0xFF;
+      info.specialcode = Vdp2DrawRegs->SFCODE & 0xFF;
    info.linescreen = 0;
-   if (Vdp2Regs->LNCLEN & 0x1)
+   if (Vdp2DrawRegs->LNCLEN & 0x1)
       info.linescreen = 1;
 
-   info.coloroffset = (Vdp2Regs->CRAOFA & 0x7) << 8;
-   ReadVdp2ColorOffset(Vdp2Regs, &info, 0x1, 0x1);
+   info.coloroffset = (Vdp2DrawRegs->CRAOFA & 0x7) << 8;
+   ReadVdp2ColorOffset(Vdp2DrawRegs, &info, 0x1, 0x1);
    info.priority = nbg0priority;
 
    if (!(info.enable & Vdp2External.disptoggle))
       return;
 
    ReadMosaicData(&info, 0x1);
-   ReadLineScrollData(&info, Vdp2Regs->SCRCTL & 0xFF, Vdp2Regs->LSTA0.all);
-   if (Vdp2Regs->SCRCTL & 1)
+   ReadLineScrollData(&info, Vdp2DrawRegs->SCRCTL & 0xFF, Vdp2DrawRegs->LSTA0.all);
+   if (Vdp2DrawRegs->SCRCTL & 1)
    {
       info.isverticalscroll = 1;
-      info.verticalscrolltbl = (Vdp2Regs->VCSTA.all & 0x7FFFE) << 1;
-      if (Vdp2Regs->SCRCTL & 0x100)
+      info.verticalscrolltbl = (Vdp2DrawRegs->VCSTA.all & 0x7FFFE) << 1;
+      if (Vdp2DrawRegs->SCRCTL & 0x100)
          info.verticalscrollinc = 8;
       else
          info.verticalscrollinc = 4;
    }
    else
       info.isverticalscroll = 0;
-   info.wctl = Vdp2Regs->WCTLA;
+   info.wctl = Vdp2DrawRegs->WCTLA;
 
    info.LoadLineParams = (void (*)(void *, int)) LoadLineParamsNBG0;
 
@@ -1334,83 +2126,83 @@ static void Vdp2DrawNBG1(void)
 {
    vdp2draw_struct info;
 
-   info.enable = Vdp2Regs->BGON & 0x2;
-   info.transparencyenable = !(Vdp2Regs->BGON & 0x200);
-   info.specialprimode = (Vdp2Regs->SFPRMD >> 2) & 0x3;
+   info.enable = Vdp2DrawRegs->BGON & 0x2;
+   info.transparencyenable = !(Vdp2DrawRegs->BGON & 0x200);
+   info.specialprimode = (Vdp2DrawRegs->SFPRMD >> 2) & 0x3;
 
-   info.colornumber = (Vdp2Regs->CHCTLA & 0x3000) >> 12;
+   info.colornumber = (Vdp2DrawRegs->CHCTLA & 0x3000) >> 12;
 
-   if((info.isbitmap = Vdp2Regs->CHCTLA & 0x200) != 0)
+   if((info.isbitmap = Vdp2DrawRegs->CHCTLA & 0x200) != 0)
    {
-      ReadBitmapSize(&info, Vdp2Regs->CHCTLA >> 10, 0x3);
+      ReadBitmapSize(&info, Vdp2DrawRegs->CHCTLA >> 10, 0x3);
 
-      info.x = Vdp2Regs->SCXIN1 & 0x7FF;
-      info.y = Vdp2Regs->SCYIN1 & 0x7FF;
+      info.x = Vdp2DrawRegs->SCXIN1 & 0x7FF;
+      info.y = Vdp2DrawRegs->SCYIN1 & 0x7FF;
 
-      info.charaddr = ((Vdp2Regs->MPOFN & 0x70) >> 4) * 0x20000;
-      info.paladdr = Vdp2Regs->BMPNA & 0x700;
+      info.charaddr = ((Vdp2DrawRegs->MPOFN & 0x70) >> 4) * 0x20000;
+      info.paladdr = Vdp2DrawRegs->BMPNA & 0x700;
       info.flipfunction = 0;
       info.specialfunction = 0;
-      info.specialcolorfunction = (Vdp2Regs->BMPNA & 0x1000) >> 12;
+      info.specialcolorfunction = (Vdp2DrawRegs->BMPNA & 0x1000) >> 12;
    }
    else
    {
       info.mapwh = 2;
 
-      ReadPlaneSize(&info, Vdp2Regs->PLSZ >> 2);
+      ReadPlaneSize(&info, Vdp2DrawRegs->PLSZ >> 2);
 
-      info.x = Vdp2Regs->SCXIN1 & 0x7FF;
-      info.y = Vdp2Regs->SCYIN1 & 0x7FF;
+      info.x = Vdp2DrawRegs->SCXIN1 & 0x7FF;
+      info.y = Vdp2DrawRegs->SCYIN1 & 0x7FF;
 
-      ReadPatternData(&info, Vdp2Regs->PNCN1, Vdp2Regs->CHCTLA & 0x100);
+      ReadPatternData(&info, Vdp2DrawRegs->PNCN1, Vdp2DrawRegs->CHCTLA & 0x100);
    }
 
-   if (Vdp2Regs->CCCTL & 0x202)
-      info.alpha = ((~Vdp2Regs->CCRNA & 0x1F00) >> 7) + 1;
+   if (Vdp2DrawRegs->CCCTL & 0x202)
+      info.alpha = ((~Vdp2DrawRegs->CCRNA & 0x1F00) >> 7) + 1;
    else
       info.alpha = 0x3F;
-   if ((Vdp2Regs->CCCTL & 0x202) == 0x202) info.alpha |= 0x80;
-   else if ((Vdp2Regs->CCCTL & 0x102) == 0x102) info.alpha |= 0x80;
-   info.specialcolormode = (Vdp2Regs->SFCCMD >> 2) & 0x3;
-   if (Vdp2Regs->SFSEL & 0x2)
-      info.specialcode = Vdp2Regs->SFCODE >> 8;
+   if ((Vdp2DrawRegs->CCCTL & 0x202) == 0x202) info.alpha |= 0x80;
+   else if ((Vdp2DrawRegs->CCCTL & 0x102) == 0x102) info.alpha |= 0x80;
+   info.specialcolormode = (Vdp2DrawRegs->SFCCMD >> 2) & 0x3;
+   if (Vdp2DrawRegs->SFSEL & 0x2)
+      info.specialcode = Vdp2DrawRegs->SFCODE >> 8;
    else
-      info.specialcode = Vdp2Regs->SFCODE & 0xFF;
+      info.specialcode = Vdp2DrawRegs->SFCODE & 0xFF;
    info.linescreen = 0;
-   if (Vdp2Regs->LNCLEN & 0x2)
+   if (Vdp2DrawRegs->LNCLEN & 0x2)
       info.linescreen = 1;
 
-   info.coloroffset = (Vdp2Regs->CRAOFA & 0x70) << 4;
-   ReadVdp2ColorOffset(Vdp2Regs, &info, 0x2, 0x2);
-   info.coordincx = (Vdp2Regs->ZMXN1.all & 0x7FF00) / (float) 65536;
-   info.coordincy = (Vdp2Regs->ZMYN1.all & 0x7FF00) / (float) 65536;
+   info.coloroffset = (Vdp2DrawRegs->CRAOFA & 0x70) << 4;
+   ReadVdp2ColorOffset(Vdp2DrawRegs, &info, 0x2, 0x2);
+   info.coordincx = (Vdp2DrawRegs->ZMXN1.all & 0x7FF00) / (float) 65536;
+   info.coordincy = (Vdp2DrawRegs->ZMYN1.all & 0x7FF00) / (float) 65536;
 
    info.priority = nbg1priority;
    info.PlaneAddr = (void FASTCALL (*)(void *, int))&Vdp2NBG1PlaneAddr;
 
    if (!(info.enable & Vdp2External.disptoggle) ||
-       (Vdp2Regs->BGON & 0x1 && (Vdp2Regs->CHCTLA & 0x70) >> 4 == 4)) // If NBG0 16M mode is enabled, don't draw
+       (Vdp2DrawRegs->BGON & 0x1 && (Vdp2DrawRegs->CHCTLA & 0x70) >> 4 == 4)) // If NBG0 16M mode is enabled, don't draw
       return;
 
    ReadMosaicData(&info, 0x2);
-   ReadLineScrollData(&info, Vdp2Regs->SCRCTL >> 8, Vdp2Regs->LSTA1.all);
-   if (Vdp2Regs->SCRCTL & 0x100)
+   ReadLineScrollData(&info, Vdp2DrawRegs->SCRCTL >> 8, Vdp2DrawRegs->LSTA1.all);
+   if (Vdp2DrawRegs->SCRCTL & 0x100)
    {
       info.isverticalscroll = 1;
-      if (Vdp2Regs->SCRCTL & 0x1)
+      if (Vdp2DrawRegs->SCRCTL & 0x1)
       {
-         info.verticalscrolltbl = 4 + ((Vdp2Regs->VCSTA.all & 0x7FFFE) << 1);
+         info.verticalscrolltbl = 4 + ((Vdp2DrawRegs->VCSTA.all & 0x7FFFE) << 1);
          info.verticalscrollinc = 8;
       }
       else
       {
-         info.verticalscrolltbl = (Vdp2Regs->VCSTA.all & 0x7FFFE) << 1;
+         info.verticalscrolltbl = (Vdp2DrawRegs->VCSTA.all & 0x7FFFE) << 1;
          info.verticalscrollinc = 4;
       }
    }
    else
       info.isverticalscroll = 0;
-   info.wctl = Vdp2Regs->WCTLA >> 8;
+   info.wctl = Vdp2DrawRegs->WCTLA >> 8;
 
    info.LoadLineParams = (void (*)(void *, int)) LoadLineParamsNBG1;
 
@@ -1435,48 +2227,48 @@ static void Vdp2DrawNBG2(void)
 {
    vdp2draw_struct info;
 
-   info.enable = Vdp2Regs->BGON & 0x4;
-   info.transparencyenable = !(Vdp2Regs->BGON & 0x400);
-   info.specialprimode = (Vdp2Regs->SFPRMD >> 4) & 0x3;
+   info.enable = Vdp2DrawRegs->BGON & 0x4;
+   info.transparencyenable = !(Vdp2DrawRegs->BGON & 0x400);
+   info.specialprimode = (Vdp2DrawRegs->SFPRMD >> 4) & 0x3;
 
-   info.colornumber = (Vdp2Regs->CHCTLB & 0x2) >> 1;	
+   info.colornumber = (Vdp2DrawRegs->CHCTLB & 0x2) >> 1;	
    info.mapwh = 2;
 
-   ReadPlaneSize(&info, Vdp2Regs->PLSZ >> 4);
-   info.x = Vdp2Regs->SCXN2 & 0x7FF;
-   info.y = Vdp2Regs->SCYN2 & 0x7FF;
-   ReadPatternData(&info, Vdp2Regs->PNCN2, Vdp2Regs->CHCTLB & 0x1);
+   ReadPlaneSize(&info, Vdp2DrawRegs->PLSZ >> 4);
+   info.x = Vdp2DrawRegs->SCXN2 & 0x7FF;
+   info.y = Vdp2DrawRegs->SCYN2 & 0x7FF;
+   ReadPatternData(&info, Vdp2DrawRegs->PNCN2, Vdp2DrawRegs->CHCTLB & 0x1);
     
-   if (Vdp2Regs->CCCTL & 0x204)
-      info.alpha = ((~Vdp2Regs->CCRNB & 0x1F) << 1) + 1;
+   if (Vdp2DrawRegs->CCCTL & 0x204)
+      info.alpha = ((~Vdp2DrawRegs->CCRNB & 0x1F) << 1) + 1;
    else
       info.alpha = 0x3F;
-   if ((Vdp2Regs->CCCTL & 0x204) == 0x204) info.alpha |= 0x80;
-   else if ((Vdp2Regs->CCCTL & 0x104) == 0x104) info.alpha |= 0x80;
-   info.specialcolormode = (Vdp2Regs->SFCCMD >> 4) & 0x3;
-   if (Vdp2Regs->SFSEL & 0x4)
-      info.specialcode = Vdp2Regs->SFCODE >> 8;
+   if ((Vdp2DrawRegs->CCCTL & 0x204) == 0x204) info.alpha |= 0x80;
+   else if ((Vdp2DrawRegs->CCCTL & 0x104) == 0x104) info.alpha |= 0x80;
+   info.specialcolormode = (Vdp2DrawRegs->SFCCMD >> 4) & 0x3;
+   if (Vdp2DrawRegs->SFSEL & 0x4)
+      info.specialcode = Vdp2DrawRegs->SFCODE >> 8;
    else
-      info.specialcode = Vdp2Regs->SFCODE & 0xFF;
+      info.specialcode = Vdp2DrawRegs->SFCODE & 0xFF;
    info.linescreen = 0;
-   if (Vdp2Regs->LNCLEN & 0x4)
+   if (Vdp2DrawRegs->LNCLEN & 0x4)
       info.linescreen = 1;
 
-   info.coloroffset = Vdp2Regs->CRAOFA & 0x700;
-   ReadVdp2ColorOffset(Vdp2Regs, &info, 0x4, 0x4);
+   info.coloroffset = Vdp2DrawRegs->CRAOFA & 0x700;
+   ReadVdp2ColorOffset(Vdp2DrawRegs, &info, 0x4, 0x4);
    info.coordincx = info.coordincy = 1;
 
    info.priority = nbg2priority;
    info.PlaneAddr = (void FASTCALL (*)(void *, int))&Vdp2NBG2PlaneAddr;
 
    if (!(info.enable & Vdp2External.disptoggle) ||
-      (Vdp2Regs->BGON & 0x1 && (Vdp2Regs->CHCTLA & 0x70) >> 4 >= 2)) // If NBG0 2048/32786/16M mode is enabled, don't draw
+      (Vdp2DrawRegs->BGON & 0x1 && (Vdp2DrawRegs->CHCTLA & 0x70) >> 4 >= 2)) // If NBG0 2048/32786/16M mode is enabled, don't draw
       return;
 
    ReadMosaicData(&info, 0x4);
    info.islinescroll = 0;
    info.isverticalscroll = 0;
-   info.wctl = Vdp2Regs->WCTLB;
+   info.wctl = Vdp2DrawRegs->WCTLB;
    info.isbitmap = 0;
 
    info.LoadLineParams = (void (*)(void *, int)) LoadLineParamsNBG2;
@@ -1502,50 +2294,50 @@ static void Vdp2DrawNBG3(void)
 {
    vdp2draw_struct info;
 
-   info.enable = Vdp2Regs->BGON & 0x8;
-   info.transparencyenable = !(Vdp2Regs->BGON & 0x800);
-   info.specialprimode = (Vdp2Regs->SFPRMD >> 6) & 0x3;
+   info.enable = Vdp2DrawRegs->BGON & 0x8;
+   info.transparencyenable = !(Vdp2DrawRegs->BGON & 0x800);
+   info.specialprimode = (Vdp2DrawRegs->SFPRMD >> 6) & 0x3;
 
-   info.colornumber = (Vdp2Regs->CHCTLB & 0x20) >> 5;
+   info.colornumber = (Vdp2DrawRegs->CHCTLB & 0x20) >> 5;
 	
    info.mapwh = 2;
 
-   ReadPlaneSize(&info, Vdp2Regs->PLSZ >> 6);
-   info.x = Vdp2Regs->SCXN3 & 0x7FF;
-   info.y = Vdp2Regs->SCYN3 & 0x7FF;
-   ReadPatternData(&info, Vdp2Regs->PNCN3, Vdp2Regs->CHCTLB & 0x10);
+   ReadPlaneSize(&info, Vdp2DrawRegs->PLSZ >> 6);
+   info.x = Vdp2DrawRegs->SCXN3 & 0x7FF;
+   info.y = Vdp2DrawRegs->SCYN3 & 0x7FF;
+   ReadPatternData(&info, Vdp2DrawRegs->PNCN3, Vdp2DrawRegs->CHCTLB & 0x10);
 
-   if (Vdp2Regs->CCCTL & 0x208)
-      info.alpha = ((~Vdp2Regs->CCRNB & 0x1F00) >> 7) + 1;
+   if (Vdp2DrawRegs->CCCTL & 0x208)
+      info.alpha = ((~Vdp2DrawRegs->CCRNB & 0x1F00) >> 7) + 1;
    else
       info.alpha = 0x3F;
-   if ((Vdp2Regs->CCCTL & 0x208) == 0x208) info.alpha |= 0x80;
-   else if ((Vdp2Regs->CCCTL & 0x108) == 0x108) info.alpha |= 0x80;
-   info.specialcolormode = (Vdp2Regs->SFCCMD >> 6) & 0x3;
-   if (Vdp2Regs->SFSEL & 0x8)
-      info.specialcode = Vdp2Regs->SFCODE >> 8;
+   if ((Vdp2DrawRegs->CCCTL & 0x208) == 0x208) info.alpha |= 0x80;
+   else if ((Vdp2DrawRegs->CCCTL & 0x108) == 0x108) info.alpha |= 0x80;
+   info.specialcolormode = (Vdp2DrawRegs->SFCCMD >> 6) & 0x3;
+   if (Vdp2DrawRegs->SFSEL & 0x8)
+      info.specialcode = Vdp2DrawRegs->SFCODE >> 8;
    else
-      info.specialcode = Vdp2Regs->SFCODE & 0xFF;
+      info.specialcode = Vdp2DrawRegs->SFCODE & 0xFF;
    info.linescreen = 0;
-   if (Vdp2Regs->LNCLEN & 0x8)
+   if (Vdp2DrawRegs->LNCLEN & 0x8)
       info.linescreen = 1;
 
-   info.coloroffset = (Vdp2Regs->CRAOFA & 0x7000) >> 4;
-   ReadVdp2ColorOffset(Vdp2Regs, &info, 0x8, 0x8);
+   info.coloroffset = (Vdp2DrawRegs->CRAOFA & 0x7000) >> 4;
+   ReadVdp2ColorOffset(Vdp2DrawRegs, &info, 0x8, 0x8);
    info.coordincx = info.coordincy = 1;
 
    info.priority = nbg3priority;
    info.PlaneAddr = (void FASTCALL (*)(void *, int))&Vdp2NBG3PlaneAddr;
 
    if (!(info.enable & Vdp2External.disptoggle) ||
-      (Vdp2Regs->BGON & 0x1 && (Vdp2Regs->CHCTLA & 0x70) >> 4 == 4) || // If NBG0 16M mode is enabled, don't draw
-      (Vdp2Regs->BGON & 0x2 && (Vdp2Regs->CHCTLA & 0x3000) >> 12 >= 2)) // If NBG1 2048/32786 is enabled, don't draw
+      (Vdp2DrawRegs->BGON & 0x1 && (Vdp2DrawRegs->CHCTLA & 0x70) >> 4 == 4) || // If NBG0 16M mode is enabled, don't draw
+      (Vdp2DrawRegs->BGON & 0x2 && (Vdp2DrawRegs->CHCTLA & 0x3000) >> 12 >= 2)) // If NBG1 2048/32786 is enabled, don't draw
       return;
 
    ReadMosaicData(&info, 0x8);
    info.islinescroll = 0;
    info.isverticalscroll = 0;
-   info.wctl = Vdp2Regs->WCTLB >> 8;
+   info.wctl = Vdp2DrawRegs->WCTLB >> 8;
    info.isbitmap = 0;
 
    info.LoadLineParams = (void (*)(void *, int)) LoadLineParamsNBG3;
@@ -1575,17 +2367,17 @@ static void Vdp2DrawRBG0(void)
    parameter[0].PlaneAddr = (void FASTCALL (*)(void *, int))&Vdp2ParameterAPlaneAddr;
    parameter[1].PlaneAddr = (void FASTCALL (*)(void *, int))&Vdp2ParameterBPlaneAddr;
 
-   info.enable = Vdp2Regs->BGON & 0x10;
+   info.enable = Vdp2DrawRegs->BGON & 0x10;
    info.priority = rbg0priority;
    if (!(info.enable & Vdp2External.disptoggle))
       return;
-   info.transparencyenable = !(Vdp2Regs->BGON & 0x1000);
-   info.specialprimode = (Vdp2Regs->SFPRMD >> 8) & 0x3;
+   info.transparencyenable = !(Vdp2DrawRegs->BGON & 0x1000);
+   info.specialprimode = (Vdp2DrawRegs->SFPRMD >> 8) & 0x3;
 
-   info.colornumber = (Vdp2Regs->CHCTLB & 0x7000) >> 12;
+   info.colornumber = (Vdp2DrawRegs->CHCTLB & 0x7000) >> 12;
 
    // Figure out which Rotation Parameter we're using
-   switch (Vdp2Regs->RPMD & 0x3)
+   switch (Vdp2DrawRegs->RPMD & 0x3)
    {
       case 0:
          // Parameter A
@@ -1605,29 +2397,29 @@ static void Vdp2DrawRBG0(void)
          // Parameter A+B switched via rotation parameter window
       default:
          info.rotatenum = 0;
-         info.rotatemode = 1 + (Vdp2Regs->RPMD & 0x1);
+         info.rotatemode = 1 + (Vdp2DrawRegs->RPMD & 0x1);
          info.PlaneAddr = (void FASTCALL (*)(void *, int))&Vdp2ParameterAPlaneAddr;
          break;
    }
 
    Vdp2ReadRotationTableFP(info.rotatenum, &parameter[info.rotatenum]);
 
-   if((info.isbitmap = Vdp2Regs->CHCTLB & 0x200) != 0)
+   if((info.isbitmap = Vdp2DrawRegs->CHCTLB & 0x200) != 0)
    {
       // Bitmap Mode
-      ReadBitmapSize(&info, Vdp2Regs->CHCTLB >> 10, 0x1);
+      ReadBitmapSize(&info, Vdp2DrawRegs->CHCTLB >> 10, 0x1);
 
       if (info.rotatenum == 0)
          // Parameter A
-         info.charaddr = (Vdp2Regs->MPOFR & 0x7) * 0x20000;
+         info.charaddr = (Vdp2DrawRegs->MPOFR & 0x7) * 0x20000;
       else
          // Parameter B
-         info.charaddr = (Vdp2Regs->MPOFR & 0x70) * 0x2000;
+         info.charaddr = (Vdp2DrawRegs->MPOFR & 0x70) * 0x2000;
 
-      info.paladdr = (Vdp2Regs->BMPNB & 0x7) << 8;
+      info.paladdr = (Vdp2DrawRegs->BMPNB & 0x7) << 8;
       info.flipfunction = 0;
       info.specialfunction = 0;
-      info.specialcolorfunction = (Vdp2Regs->BMPNB & 0x10) >> 4;
+      info.specialcolorfunction = (Vdp2DrawRegs->BMPNB & 0x10) >> 4;
    }
    else
    {
@@ -1636,38 +2428,38 @@ static void Vdp2DrawRBG0(void)
 
       if (info.rotatenum == 0)
          // Parameter A
-         ReadPlaneSize(&info, Vdp2Regs->PLSZ >> 8);
+         ReadPlaneSize(&info, Vdp2DrawRegs->PLSZ >> 8);
       else
          // Parameter B
-         ReadPlaneSize(&info, Vdp2Regs->PLSZ >> 12);
+         ReadPlaneSize(&info, Vdp2DrawRegs->PLSZ >> 12);
 
-      ReadPatternData(&info, Vdp2Regs->PNCR, Vdp2Regs->CHCTLB & 0x100);
+      ReadPatternData(&info, Vdp2DrawRegs->PNCR, Vdp2DrawRegs->CHCTLB & 0x100);
    }
 
-   if (Vdp2Regs->CCCTL & 0x210)
-      info.alpha = ((~Vdp2Regs->CCRR & 0x1F) << 1) + 1;
+   if (Vdp2DrawRegs->CCCTL & 0x210)
+      info.alpha = ((~Vdp2DrawRegs->CCRR & 0x1F) << 1) + 1;
    else
       info.alpha = 0x3F;
-   if ((Vdp2Regs->CCCTL & 0x210) == 0x210) info.alpha |= 0x80;
-   else if ((Vdp2Regs->CCCTL & 0x110) == 0x110) info.alpha |= 0x80;
-   info.specialcolormode = (Vdp2Regs->SFCCMD >> 8) & 0x3;
-   if (Vdp2Regs->SFSEL & 0x10)
-      info.specialcode = Vdp2Regs->SFCODE >> 8;
+   if ((Vdp2DrawRegs->CCCTL & 0x210) == 0x210) info.alpha |= 0x80;
+   else if ((Vdp2DrawRegs->CCCTL & 0x110) == 0x110) info.alpha |= 0x80;
+   info.specialcolormode = (Vdp2DrawRegs->SFCCMD >> 8) & 0x3;
+   if (Vdp2DrawRegs->SFSEL & 0x10)
+      info.specialcode = Vdp2DrawRegs->SFCODE >> 8;
    else
-      info.specialcode = Vdp2Regs->SFCODE & 0xFF;
+      info.specialcode = Vdp2DrawRegs->SFCODE & 0xFF;
    info.linescreen = 0;
-   if (Vdp2Regs->LNCLEN & 0x10)
+   if (Vdp2DrawRegs->LNCLEN & 0x10)
       info.linescreen = 1;
 
-   info.coloroffset = (Vdp2Regs->CRAOFB & 0x7) << 8;
+   info.coloroffset = (Vdp2DrawRegs->CRAOFB & 0x7) << 8;
 
-   ReadVdp2ColorOffset(Vdp2Regs, &info, 0x10, 0x10);
+   ReadVdp2ColorOffset(Vdp2DrawRegs, &info, 0x10, 0x10);
    info.coordincx = info.coordincy = 1;
 
    ReadMosaicData(&info, 0x10);
    info.islinescroll = 0;
    info.isverticalscroll = 0;
-   info.wctl = Vdp2Regs->WCTLC;
+   info.wctl = Vdp2DrawRegs->WCTLC;
 
    info.LoadLineParams = (void (*)(void *, int)) LoadLineParamsRBG0;
 
@@ -1707,6 +2499,10 @@ int VIDSoftInit(void)
    vdp1frontframebuffer = vdp1framebuffer[1];
    vdp2width = 320;
    vdp2height = 224;
+   vidsoft_frame_valid = 0;
+
+   VidsoftStartWorkers();
+   VidsoftStartRender();
 
 #ifdef USE_OPENGL
    glClear(GL_COLOR_BUFFER_BIT);
@@ -1729,6 +2525,10 @@ int VIDSoftInit(void)
 
 void VIDSoftDeInit(void)
 {
+   VidsoftStopRender();
+   VidsoftStopWorkers();
+   Vdp2CaptureDeInit(&vidsoft_capture);
+
    if (dispbuffer)
    {
       free(dispbuffer);
@@ -1740,6 +2540,13 @@ void VIDSoftDeInit(void)
 
    if (vdp1framebuffer[1])
       free(vdp1framebuffer[1]);
+
+   if (vdp1tileprims)
+   {
+      free(vdp1tileprims);
+      vdp1tileprims = NULL;
+      vdp1tileprimsize = 0;
+   }
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1787,6 +2594,74 @@ int VIDSoftVdp1Reset(void)
 
 //////////////////////////////////////////////////////////////////////////////
 
+/* Drawing the same command list again, into a framebuffer erased the same
+   way, gives the same dots. So when nothing it depends on changed, the
+   result of the last draw is reused: it's either still in the back
+   framebuffer, or the framebuffers were swapped since and it's copied back.
+   Only the erase window is copied, which is why the last draw must not have
+   touched anything outside it. The stamps tell VIDSoftVdp2DrawEnd() when
+   the front framebuffer's contents change. */
+
+typedef struct
+{
+   u16 TVMR, FBCR, EWDR, EWLR, EWRR;
+   u16 localX, localY;         // left over from the last list
+   u16 SPCTL;
+} vdp1drawregs_struct;
+
+static vdp1drawregs_struct vdp1lastregs;
+static u8 *vdp1lastdraw;	// framebuffer holding the result of the last draw
+static int vdp1lastinside;	// and it only touched the erase window
+static u32 vdp1frontstamp, vdp1backstamp, vdp1stamp;
+
+static int Vdp1DrawReuse(void)
+{
+   vdp1drawregs_struct regs;
+   int same;
+   int x1, y1, x2, y2, y;
+
+   // the list is looked at every time, for the writes it has to keep track of
+   same = Vdp1CommandListUnchanged();
+
+   memset(&regs, 0, sizeof(regs));
+   regs.TVMR = Vdp1Regs->TVMR;
+   regs.FBCR = Vdp1Regs->FBCR;
+   regs.EWDR = Vdp1Regs->EWDR;
+   regs.EWLR = Vdp1Regs->EWLR;
+   regs.EWRR = Vdp1Regs->EWRR;
+   regs.localX = Vdp1Regs->localX;
+   regs.localY = Vdp1Regs->localY;
+   regs.SPCTL = Vdp2Regs->SPCTL & 0x10;
+   if (memcmp(&regs, &vdp1lastregs, sizeof(regs)))
+      same = 0;
+   vdp1lastregs = regs;
+
+   // with manual erase, what's left of older frames shows through
+   if (!same || !vdp1lastinside || (Vdp1Regs->FBCR & 2) || !Vdp1External.disptoggle)
+      return 0;
+
+   if (vdp1lastdraw == vdp1frontframebuffer)
+   {
+      Vdp1EraseWindow(&x1, &y1, &x2, &y2);
+      for (y = y1; y < y2 && x1 < x2; y++)
+         memcpy(vdp1backframebuffer + (y * vdp1width + x1) * vdp1pixelsize,
+                vdp1frontframebuffer + (y * vdp1width + x1) * vdp1pixelsize,
+                (x2 - x1) * vdp1pixelsize);
+
+      if (memcmp(vdp1backframebuffer, vdp1frontframebuffer, vdp1width * vdp1height * vdp1pixelsize))
+         vdp1backstamp = ++vdp1stamp;
+      else
+         vdp1backstamp = vdp1frontstamp;
+   }
+   else if (vdp1lastdraw != vdp1backframebuffer)
+      return 0;
+
+   Vdp1External.manualerase = 0;
+   return 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void VIDSoftVdp1DrawStart(void)
 {
    if (Vdp1Regs->FBCR & 8)
@@ -1818,18 +2693,43 @@ void VIDSoftVdp1DrawStart(void)
       vdp1pixelsize = 2;
    }
 
-   VIDSoftVdp1EraseFrameBuffer();
+   vdp1reuse = Vdp1DrawReuse();
+   if (!vdp1reuse)
+   {
+      VIDSoftVdp1EraseFrameBuffer();
+      vdp1backstamp = ++vdp1stamp;
+   }
+   vdp1lastdraw = NULL;
+   vdp1drawx1 = vdp1width;
+   vdp1drawy1 = vdp1height;
+   vdp1drawx2 = vdp1drawy2 = -1;
 
    vdp1clipxstart = Vdp1Regs->userclipX1 = Vdp1Regs->systemclipX1 = 0;
    vdp1clipystart = Vdp1Regs->userclipY1 = Vdp1Regs->systemclipY1 = 0;
    vdp1clipxend = Vdp1Regs->userclipX2 = Vdp1Regs->systemclipX2 = vdp1width;
    vdp1clipyend = Vdp1Regs->userclipY2 = Vdp1Regs->systemclipY2 = vdp1height;
+
+   // with worker threads, commands are queued and drawn in VIDSoftVdp1DrawEnd()
+   vdp1queueprims = (vidsoft_num_workers != 0);
+   vdp1primcount = 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
 void VIDSoftVdp1DrawEnd(void)
 {
+   int x1, y1, x2, y2;
+
+   if (vdp1primcount)
+      Vdp1DrawFlush();
+
+   if (!vdp1reuse)
+   {
+      Vdp1EraseWindow(&x1, &y1, &x2, &y2);
+      vdp1lastinside = (vdp1drawx1 > vdp1drawx2) ||
+                       (vdp1drawx1 >= x1 && vdp1drawy1 >= y1 && vdp1drawx2 < x2 && vdp1drawy2 < y2);
+   }
+   vdp1lastdraw = vdp1backframebuffer;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -1868,155 +2768,277 @@ static INLINE u32 alphablend16(u32 d, u32 s, u32 level)
 {
 	int r,g,b,sr,sg,sb,dr,dg,db;
 
-	int invlevel = 256-level;
-	sr = s & 0x001f; dr = d & 0x001f; 
-	r = (sr*level + dr*invlevel)>>8; r&= 0x1f;
-	sg = s & 0x03e0; dg = d & 0x03e0;
-	g = (sg*level + dg*invlevel)>>8; g&= 0x03e0;
-	sb = s & 0x7c00; db = d & 0x7c00;
-	b = (sb*level + db*invlevel)>>8; b&= 0x7c00;
-	return r|g|b;
+	int invlevel = 256-level;
+	sr = s & 0x001f; dr = d & 0x001f; 
+	r = (sr*level + dr*invlevel)>>8; r&= 0x1f;
+	sg = s & 0x03e0; dg = d & 0x03e0;
+	g = (sg*level + dg*invlevel)>>8; g&= 0x03e0;
+	sb = s & 0x7c00; db = d & 0x7c00;
+	b = (sb*level + db*invlevel)>>8; b&= 0x7c00;
+	return r|g|b;
+}
+
+vdp1cmd_struct cmd;
+
+typedef union _COLOR { // xbgr x555
+	struct {
+#ifdef WORDS_BIGENDIAN
+	u16 x:1;
+	u16 b:5;
+	u16 g:5;
+	u16 r:5;
+#else
+     u16 r:5;
+     u16 g:5;
+     u16 b:5;
+     u16 x:1;
+#endif
+	};
+	u16 value;
+} COLOR;
+
+/* Per-command drawing state.  Everything that only depends on the command
+   is decoded once here instead of for every dot, and the dot loops below
+   are instantiated for each color mode/color calculation pair.  The struct
+   holds the whole command, so it can be queued and drawn later by a worker
+   thread (see VIDSoftVdp1DrawEnd()). */
+
+#define VDP1PRIM_QUAD 0
+#define VDP1PRIM_POLYLINE 1
+#define VDP1PRIM_LINE 2
+
+typedef struct
+{
+	int type;	// VDP1PRIM_*
+	int x[4], y[4];	// vertices, local coordinates applied
+	int gouraud;
+	COLOR gouraudtbl[4];
+	int width, height;	// character size
+	int bx1, by1, bx2, by2;	// framebuffer bounding box, inclusive
+
+	u32 charaddr;
+	u32 colorlut;
+	u16 colorbank;
+	u16 untextured;
+	u32 visible;	// dot bits that make it non-transparent
+	int colormode;	// 0-5, VDP1DOT_UNTEXTURED or VDP1DOT_INVALID
+	int ccmode;	// 0-4, VDP1CC_GOURAUD_BLEND for modes 5-7
+	int endcodes;
+	int spd;
+	int flip;
+	int mesh;
+	int msbon;
+	int palettegouraud;
+	int clipx1, clipy1, clipx2, clipy2;	// in framebuffer dots
+
+	u32 lineaddr;	// texture line being drawn
+	double r, g, b;	// gouraud color
+	double rstep, gstep, bstep;
+} vdp1draw_struct;
+
+typedef struct
+{
+	int i;		// dots walked so far
+	double ustep;	// texture columns per dot, u = i * width / length
+	int prevu;
+	int endcodes;
+} vdp1dotstep_struct;
+
+#define VDP1DOT_UNTEXTURED 6
+#define VDP1DOT_INVALID 7
+#define VDP1CC_GOURAUD_BLEND 5
+
+static vdp1draw_struct vdp1draw;
+
+static void Vdp1DrawSetup(vdp1draw_struct *info)
+{
+	static const u32 visible[6] = { 0xf, 0xffff, 0x3f, 0x7f, 0xff, 0xffff };
+	int shape = cmd.CMDCTRL & 0x7;
+	int colormode = (cmd.CMDPMOD >> 3) & 0x7;
+
+	info->width = ((cmd.CMDSIZE >> 8) & 0x3F) * 8;
+	info->height = cmd.CMDSIZE & 0xFF;
+
+	info->charaddr = cmd.CMDSRCA << 3;
+	info->colorbank = cmd.CMDCOLR;
+	info->colorlut = (u32)cmd.CMDCOLR << 3;
+	info->untextured = cmd.CMDCOLR;
+	info->spd = ((cmd.CMDPMOD & 0x40) != 0);//show the actual color of transparent pixels if 1 (they won't be drawn transparent)
+	info->endcodes = ((cmd.CMDPMOD & 0x80) == 0);
+	info->flip = (cmd.CMDCTRL & 0x30) >> 4;
+	info->mesh = ((cmd.CMDPMOD & 0x0100) != 0);
+	info->msbon = (cmd.CMDPMOD & (1 << 15)) && ((Vdp2Regs->SPCTL & 0x10) == 0);
+	info->palettegouraud = (colormode != 5) && (colormode != 1);
+	info->ccmode = cmd.CMDPMOD & 0x7;
+	if (info->ccmode > VDP1CC_GOURAUD_BLEND)
+		info->ccmode = VDP1CC_GOURAUD_BLEND;
+	info->visible = (colormode < 6) ? visible[colormode] : 0xffff;
+
+	//4 polygon, 5 polyline or 6 line
+	if (shape == 4 || shape == 5 || shape == 6)
+		info->colormode = VDP1DOT_UNTEXTURED;
+	else if (colormode > 5)
+		info->colormode = VDP1DOT_INVALID;
+	else
+		info->colormode = colormode;
+
+	if (cmd.CMDPMOD & 0x0400) PushUserClipping((cmd.CMDPMOD >> 9) & 0x1);
+
+	info->clipx1 = vdp1clipxstart;
+	info->clipx2 = vdp1clipxend;
+	info->clipy1 = vdp1clipystart;
+	info->clipy2 = vdp1clipyend;
+
+	if (cmd.CMDPMOD & 0x0400) PopUserClipping();
+
+	// nothing outside the framebuffer gets drawn
+	if (info->clipx1 < 0) info->clipx1 = 0;
+	if (info->clipy1 < 0) info->clipy1 = 0;
+	if (info->clipx2 > vdp1width) info->clipx2 = vdp1width;
+	if (info->clipy2 > vdp1height) info->clipy2 = vdp1height;
+
+	info->gouraud = (cmd.CMDPMOD & (1 << 2)) != 0;
+	if (info->gouraud || shape == 5 || shape == 6)
+	{
+		u32 gouraudTableAddress = (((unsigned int)cmd.CMDGRDA) << 3);
+		int i;
+
+		for (i = 0; i < 4; i++)
+			info->gouraudtbl[i].value = T1ReadWord(Vdp1Ram, gouraudTableAddress + i * 2);
+	}
+
+	info->lineaddr = info->charaddr;
+	info->r = info->g = info->b = 0;
+	info->rstep = info->gstep = info->bstep = 0;
 }
 
-typedef struct _COLOR_PARAMS
+/* Sets the vertices and works out which part of the framebuffer the
+   command can touch.  Every dot drawn lies within the vertices' bounding
+   box. */
+
+static void Vdp1DrawSetVertices(vdp1draw_struct *info, int type, const int *x, const int *y)
 {
-	double r,g,b;
-} COLOR_PARAMS;
+	int xdiv = (vdp1pixelsize == 2) ? 1 : 2;
+	int minx = x[0], maxx = x[0], miny = y[0], maxy = y[0];
+	int i, n = (type == VDP1PRIM_LINE) ? 2 : 4;
 
-COLOR_PARAMS leftColumnColor;
+	info->type = type;
 
-vdp1cmd_struct cmd;
+	for (i = 0; i < 4; i++)
+	{
+		info->x[i] = (i < n) ? x[i] : 0;
+		info->y[i] = (i < n) ? y[i] : 0;
+	}
 
-int currentPixel;
-int currentPixelIsVisible;
-int characterWidth;
-int characterHeight;
+	for (i = 1; i < n; i++)
+	{
+		if (x[i] < minx) minx = x[i];
+		if (x[i] > maxx) maxx = x[i];
+		if (y[i] < miny) miny = y[i];
+		if (y[i] > maxy) maxy = y[i];
+	}
 
-static int getpixel(int linenumber, int currentlineindex) {
-	
-	u32 characterAddress;
-	u32 colorlut;
-	u16 colorbank;
-	u8 SPD;
-	int endcode;
-	int endcodesEnabled;
-	int untexturedColor = 0;
-	int isTextured = 1;
-	int currentShape = cmd.CMDCTRL & 0x7;
-	int flip;
+	info->bx1 = minx / xdiv - 1;
+	info->bx2 = maxx / xdiv + 1;
+	info->by1 = miny / vdp1interlace - 1;
+	info->by2 = maxy / vdp1interlace + 1;
 
-	characterAddress = cmd.CMDSRCA << 3;
-	colorbank = cmd.CMDCOLR;
-	colorlut = (u32)colorbank << 3;
-	SPD = ((cmd.CMDPMOD & 0x40) != 0);//show the actual color of transparent pixels if 1 (they won't be drawn transparent)
-	endcodesEnabled = (( cmd.CMDPMOD & 0x80) == 0 )?1:0;
-	flip = (cmd.CMDCTRL & 0x30) >> 4;
+	if (info->bx1 < info->clipx1) info->bx1 = info->clipx1;
+	if (info->by1 < info->clipy1) info->by1 = info->clipy1;
+	if (info->bx2 >= info->clipx2) info->bx2 = info->clipx2 - 1;
+	if (info->by2 >= info->clipy2) info->by2 = info->clipy2 - 1;
+}
 
-	//4 polygon, 5 polyline or 6 line
-	if(currentShape == 4 || currentShape == 5 || currentShape == 6) {
-		isTextured = 0;
-		untexturedColor = cmd.CMDCOLR;
-	}
+static INLINE void Vdp1DrawSetLine(vdp1draw_struct *info, int linenumber)
+{
+	if (info->flip & 2)
+		linenumber = info->height - linenumber - 1;
 
-	switch( flip ) {
+	switch (info->colormode)
+	{
+		case 0:
 		case 1:
-			// Horizontal flipping
-			currentlineindex = characterWidth - currentlineindex-1;
+			info->lineaddr = info->charaddr + (linenumber*(info->width>>1));
 			break;
-		case 2:
-			// Vertical flipping
-			linenumber = characterHeight - linenumber-1;
-
+		case 5:
+			info->lineaddr = info->charaddr + (linenumber*info->width*2);
 			break;
-		case 3:
-			// Horizontal/Vertical flipping
-			linenumber = characterHeight - linenumber-1;
-			currentlineindex = characterWidth - currentlineindex-1;
+		default:
+			info->lineaddr = info->charaddr + (linenumber*info->width);
 			break;
 	}
+}
 
-	switch ((cmd.CMDPMOD >> 3) & 0x7)
+static INLINE int Vdp1GetDot(vdp1draw_struct *info, int u, u32 *dot, const int colormode)
+{
+	u32 p;
+
+	if (info->flip & 1)
+		u = info->width - u - 1;
+
+	switch (colormode)
 	{
 		case 0x0: //4bpp bank
-			endcode = 0xf;
-			currentPixel = Vdp1ReadPattern16( characterAddress + (linenumber*(characterWidth>>1)), currentlineindex );
-			if(isTextured && endcodesEnabled && currentPixel == endcode)
+			p = Vdp1ReadPattern16(info->lineaddr, u);
+			if (info->endcodes && p == 0xf)
 				return 1;
-			if (!((currentPixel == 0) && !SPD)) 
-				currentPixel = colorbank | currentPixel;
-			currentPixelIsVisible = 0xf;
+			if (p != 0 || info->spd)
+				p |= info->colorbank;
 			break;
-
-		case 0x1://4bpp lut
-			endcode = 0xf;
-			currentPixel = Vdp1ReadPattern16( characterAddress + (linenumber*(characterWidth>>1)), currentlineindex );
-			if(isTextured && endcodesEnabled && currentPixel == endcode)
+		case 0x1: //4bpp lut
+			p = Vdp1ReadPattern16(info->lineaddr, u);
+			if (info->endcodes && p == 0xf)
 				return 1;
-			if (!(currentPixel == 0 && !SPD))
-				currentPixel = T1ReadWord(Vdp1Ram, (currentPixel * 2 + colorlut) & 0x7FFFF);
-			currentPixelIsVisible = 0xffff;
+			if (p != 0 || info->spd)
+				p = T1ReadWord(Vdp1Ram, (p * 2 + info->colorlut) & 0x7FFFF);
 			break;
-		case 0x2://8pp bank (64 color)
+		case 0x2: //8pp bank (64 color)
 			//is there a hardware bug with endcodes in this color mode?
 			//there are white lines around some characters in scud
 			//using an endcode of 63 eliminates the white lines
 			//but also causes some dropout due to endcodes being triggered that aren't triggered on hardware
 			//the closest thing i can do to match the hardware is make all pixels with color index 63 transparent
 			//this needs more hardware testing
-
-			endcode = 63;
-			currentPixel = Vdp1ReadPattern64( characterAddress + (linenumber*(characterWidth)), currentlineindex );
-			if(isTextured && endcodesEnabled && currentPixel == endcode)
-				currentPixel = 0;
-		//		return 1;
-			if (!((currentPixel == 0) && !SPD)) 
-				currentPixel = colorbank | currentPixel;
-			currentPixelIsVisible = 0x3f;
+			p = Vdp1ReadPattern64(info->lineaddr, u);
+			if (info->endcodes && p == 63)
+				p = 0;
+			if (p != 0 || info->spd)
+				p |= info->colorbank;
 			break;
-		case 0x3://128 color
-			endcode = 0xff;
-			currentPixel = Vdp1ReadPattern128( characterAddress + (linenumber*characterWidth), currentlineindex );
-			if(isTextured && endcodesEnabled && currentPixel == endcode)
-				return 1;
-			if (!((currentPixel == 0) && !SPD)) 
-				currentPixel = colorbank | currentPixel;
-			currentPixelIsVisible = 0x7f;
+		case 0x3: //128 color
+			// masked to 7 bits, so the 0xff endcode can't match
+			p = Vdp1ReadPattern128(info->lineaddr, u);
+			if (p != 0 || info->spd)
+				p |= info->colorbank;
 			break;
-		case 0x4://256 color
-			endcode = 0xff;
-			currentPixel = Vdp1ReadPattern256( characterAddress + (linenumber*characterWidth), currentlineindex );
-			if(isTextured && endcodesEnabled && currentPixel == endcode)
+		case 0x4: //256 color
+			p = Vdp1ReadPattern256(info->lineaddr, u);
+			if (info->endcodes && p == 0xff)
 				return 1;
-			currentPixelIsVisible = 0xff;
-			if (!((currentPixel == 0) && !SPD)) 
-				currentPixel = colorbank | currentPixel;
+			if (p != 0 || info->spd)
+				p |= info->colorbank;
 			break;
-		case 0x5://16bpp bank
-			endcode = 0x7fff;
-			currentPixel = Vdp1ReadPattern64k( characterAddress + (linenumber*characterWidth*2), currentlineindex );
-			if(isTextured && endcodesEnabled && currentPixel == endcode)
+		case 0x5: //16bpp bank
+			p = Vdp1ReadPattern64k(info->lineaddr, u);
+			if (info->endcodes && p == 0x7fff)
 				return 1;
 
 			/* the transparent pixel in 16bpp is supposed to be 0x0000
 			but some games use pixels with invalid values and expect
 			them to be transparent (see vdp1 doc p. 92) */
-			if (!(currentPixel & 0x8000) && !SPD)
-				currentPixel = 0;
-
-			currentPixelIsVisible = 0xffff;
+			if (!(p & 0x8000) && !info->spd)
+				p = 0;
+			break;
+		default:
+			p = info->untextured;
 			break;
 	}
 
-	if(!isTextured)
-		currentPixel = untexturedColor;
-
-	//force the MSB to be on if MSBON is set
-	//currentPixel |= cmd.CMDPMOD & (1 << 15);
-
+	*dot = p;
 	return 0;
 }
 
-static int gouraudAdjust( int color, int tableValue )
+static INLINE int gouraudAdjust( int color, int tableValue )
 {
 	color += (tableValue - 0x10);
 
@@ -2026,146 +3048,423 @@ static int gouraudAdjust( int color, int tableValue )
 	return color;
 }
 
-static void putpixel8(int x, int y) {
-
-    int x2 = x / 2;
-    int y2 = y / vdp1interlace;
-    u8 * iPix = &vdp1backframebuffer[(y2 * vdp1width) + x2];
-    int mesh = cmd.CMDPMOD & 0x0100;
-    int SPD = ((cmd.CMDPMOD & 0x40) != 0);//show the actual color of transparent pixels if 1 (they won't be drawn transparent)
+#define COLOR(r,g,b)    (((r)&0x1F)|(((g)&0x1F)<<5)|(((b)&0x1F)<<10) |0x8000 )
 
-    if (iPix >= (vdp1backframebuffer + 0x40000))
-        return;
+static INLINE void Vdp1PutDot8(vdp1draw_struct *info, int x, int y, u32 dot)
+{
+	int x2 = x / 2;
+	int y2 = y / vdp1interlace;
+	int index = (y2 * vdp1width) + x2;
 
-    currentPixel &= 0xFF;
+	if (index >= 0x40000)
+		return;
 
-    if(mesh && ((x2 ^ y2) & 1)) {
-        return;
-    }
+	dot &= 0xFF;
 
-    {
-        int clipped;
+	if (info->mesh && ((x2 ^ y2) & 1))
+		return;
 
-        if (cmd.CMDPMOD & 0x0400) PushUserClipping((cmd.CMDPMOD >> 9) & 0x1);
+	if (x2 < info->clipx1 || x2 >= info->clipx2 ||
+	    y2 < info->clipy1 || y2 >= info->clipy2)
+		return;
 
-        clipped = ! (x2 >= vdp1clipxstart &&
-            x2 < vdp1clipxend &&
-            y2 >= vdp1clipystart &&
-            y2 < vdp1clipyend);
+	// only replace is supported in 8 bit modes
+	if (info->spd || (dot & info->visible))
+		vdp1backframebuffer[index] = dot;
+}
 
-        if (cmd.CMDPMOD & 0x0400) PopUserClipping();
+static INLINE void Vdp1PutDot16(vdp1draw_struct *info, int x, int y, u32 dot, const int ccmode)
+{
+	u16 *iPix;
+	int index;
 
-        if (clipped) return;
-    }
+	y /= vdp1interlace;
+	index = (y * vdp1width) + x;
 
-    if ( SPD || (currentPixel & currentPixelIsVisible))
-    {
-        switch( cmd.CMDPMOD & 0x7 )//we want bits 0,1,2
-        {
-        default:
-        case 0:	// replace
-            if (!((currentPixel == 0) && !SPD))
-                *(iPix) = currentPixel;
-            break;
-        }
-    }
-}
+	if (index >= 0x20000)
+		return;
 
-static void putpixel(int x, int y) {
+	if (info->mesh && ((x ^ y) & 1))
+		return;
 
-	u16* iPix;
-	int mesh = cmd.CMDPMOD & 0x0100;
-	int SPD = ((cmd.CMDPMOD & 0x40) != 0);//show the actual color of transparent pixels if 1 (they won't be drawn transparent)
+	if (x < info->clipx1 || x >= info->clipx2 ||
+	    y < info->clipy1 || y >= info->clipy2)
+		return;
 
-	y /= vdp1interlace;
-	iPix = &((u16 *)vdp1backframebuffer)[(y * vdp1width) + x];
+	iPix = &((u16 *)vdp1backframebuffer)[index];
 
-	if (iPix >= (u16*) (vdp1backframebuffer + 0x40000))
+	if (info->msbon && dot)
+	{
+		*iPix |= 0x8000;
 		return;
+	}
 
-	if(mesh && (x^y)&1)
+	if (!info->spd && !(dot & info->visible))
 		return;
 
+	switch (ccmode)
 	{
-		int clipped;
+	case 0:	// replace
+		*iPix = dot;
+		break;
+	case 1: // shadow
+		if (*iPix & (1 << 15)) // only if MSB of framebuffer data is set
+			*iPix = alphablend16(*iPix, 0, (1 << 7)) | (1 << 15);
+		break;
+	case 2: // half luminance
+		*iPix = ((dot & ~0x8421) >> 1) | (1 << 15);
+		break;
+	case 3: // half transparent
+		if (*iPix & (1 << 15))//only if MSB of framebuffer data is set
+			*iPix = alphablend16(*iPix, dot, (1 << 7)) | (1 << 15);
+		else
+			*iPix = dot;
+		break;
+	case 4: //gouraud
+		//handle the special case demonstrated in the sgl chrome demo
+		//if we are in a paletted bank mode and the other two colors are unused, adjust the index value instead of rgb
+		if (info->palettegouraud && (int)info->g == 16 && (int)info->b == 16)
+		{
+			int c = (int)(info->r - 0x10);
+			if (c < 0) c = 0;
+			*iPix = dot + c;
+			break;
+		}
+		*iPix = COLOR(
+			gouraudAdjust(dot & 0x001F, (int)info->r),
+			gouraudAdjust((dot & 0x03e0) >> 5, (int)info->g),
+			gouraudAdjust((dot & 0x7c00) >> 10, (int)info->b));
+		break;
+	default:
+		*iPix = alphablend16(COLOR((int)info->r, (int)info->g, (int)info->b), dot, (1 << 7)) | (1 << 15);
+		break;
+	}
+}
+
+static INLINE int Vdp1PlotDot(vdp1draw_struct *info, vdp1dotstep_struct *step, int x, int y,
+			      const int colormode, const int ccmode, const int pixelsize)
+{
+	int u = (int)(step->i++ * step->ustep);
+	u32 dot;
+
+	if (ccmode >= 4) {
+		info->r += info->rstep;
+		info->g += info->gstep;
+		info->b += info->bstep;
+	}
+
+	if (Vdp1GetDot(info, u, &dot, colormode)) {
+		if (u != step->prevu) {
+			step->prevu = u;
+			step->endcodes ++;
+		}
+	} else if (pixelsize == 2) {
+		Vdp1PutDot16(info, x, y, dot, ccmode);
+	} else {
+		Vdp1PutDot8(info, x, y, dot);
+	}
+
+	return step->endcodes == 2;
+}
+
+/* Same walk as iterateOverLine(), with the dot drawing inlined.  The
+   texture column advances by texwidth / length for every dot drawn. */
+
+static INLINE void Vdp1DrawLineGeneric(vdp1draw_struct *info, int x1, int y1, int x2, int y2,
+				       int greedy, int texwidth, int length,
+				       const int colormode, const int ccmode, const int pixelsize)
+{
+	vdp1dotstep_struct step;
+	int a, ax, ay, dx, dy;
+
+	step.i = 0;
+	step.ustep = (double)texwidth / length;
+	step.prevu = 123456789;
+	step.endcodes = 0;
 
-		if (cmd.CMDPMOD & 0x0400) PushUserClipping((cmd.CMDPMOD >> 9) & 0x1);
+#define PLOT(x, y) if (Vdp1PlotDot(info, &step, (x), (y), colormode, ccmode, pixelsize)) return;
+
+	a = 0;
+	dx = x2 - x1;
+	dy = y2 - y1;
+	ax = (dx >= 0) ? 1 : -1;
+	ay = (dy >= 0) ? 1 : -1;
+
+	if (abs(dx) > abs(dy)) {
+		if (ax != ay) dx = -dx;
+
+		for (; x1 != x2; x1 += ax) {
+			PLOT(x1, y1)
+
+			a += dy;
+			if (abs(a) >= abs(dx)) {
+				a -= dx;
+				y1 += ay;
+
+				// Make sure we 'fill holes' the same as the Saturn
+				if (greedy) {
+					if (ax == ay) {
+						PLOT(x1 + ax, y1 - ay)
+					} else {
+						PLOT(x1, y1)
+					}
+				}
+			}
+		}
+	} else {
+		if (ax != ay) dy = -dy;
 
-		clipped = ! (x >= vdp1clipxstart &&
-			x < vdp1clipxend &&
-			y >= vdp1clipystart &&
-			y < vdp1clipyend);
+		for (; y1 != y2; y1 += ay) {
+			PLOT(x1, y1)
 
-		if (cmd.CMDPMOD & 0x0400) PopUserClipping();
+			a += dx;
+			if (abs(a) >= abs(dy)) {
+				a -= dy;
+				x1 += ax;
 
-		if (clipped) return;
+				if (greedy) {
+					if (ay == ax) {
+						PLOT(x1, y1)
+					} else {
+						PLOT(x1 - ax, y1 + ay)
+					}
+				}
+			}
+		}
 	}
 
-	if ((cmd.CMDPMOD & (1 << 15)) && ((Vdp2Regs->SPCTL & 0x10) == 0))
+	// If the line isn't greedy here, we end up with gaps that don't occur on the Saturn
+	PLOT(x2, y2)
+
+#undef PLOT
+}
+
+typedef void (*vdp1drawline_func)(vdp1draw_struct *info, int x1, int y1, int x2, int y2,
+				  int greedy, int texwidth, int length);
+
+#define VDP1DRAWLINE(colormode, ccmode, pixelsize) \
+static void Vdp1DrawLine_##colormode##_##ccmode##_##pixelsize(vdp1draw_struct *info, \
+	int x1, int y1, int x2, int y2, int greedy, int texwidth, int length) \
+{ \
+	Vdp1DrawLineGeneric(info, x1, y1, x2, y2, greedy, texwidth, length, colormode, ccmode, pixelsize); \
+}
+
+#define VDP1DRAWLINE_MODE(colormode) \
+	VDP1DRAWLINE(colormode, 0, 2) \
+	VDP1DRAWLINE(colormode, 1, 2) \
+	VDP1DRAWLINE(colormode, 2, 2) \
+	VDP1DRAWLINE(colormode, 3, 2) \
+	VDP1DRAWLINE(colormode, 4, 2) \
+	VDP1DRAWLINE(colormode, 5, 2) \
+	VDP1DRAWLINE(colormode, 0, 1)
+
+VDP1DRAWLINE_MODE(0)
+VDP1DRAWLINE_MODE(1)
+VDP1DRAWLINE_MODE(2)
+VDP1DRAWLINE_MODE(3)
+VDP1DRAWLINE_MODE(4)
+VDP1DRAWLINE_MODE(5)
+VDP1DRAWLINE_MODE(6)
+
+#define VDP1DRAWLINE_ENTRY(colormode) { \
+	Vdp1DrawLine_##colormode##_0_2, Vdp1DrawLine_##colormode##_1_2, \
+	Vdp1DrawLine_##colormode##_2_2, Vdp1DrawLine_##colormode##_3_2, \
+	Vdp1DrawLine_##colormode##_4_2, Vdp1DrawLine_##colormode##_5_2, \
+	Vdp1DrawLine_##colormode##_0_1 }
+
+// indexed by color mode, then color calculation mode (6 for 8 bit framebuffers)
+static const vdp1drawline_func Vdp1DrawLineTable[7][7] = {
+	VDP1DRAWLINE_ENTRY(0),
+	VDP1DRAWLINE_ENTRY(1),
+	VDP1DRAWLINE_ENTRY(2),
+	VDP1DRAWLINE_ENTRY(3),
+	VDP1DRAWLINE_ENTRY(4),
+	VDP1DRAWLINE_ENTRY(5),
+	VDP1DRAWLINE_ENTRY(6),
+};
+
+static void DrawLine(vdp1draw_struct *info, int x1, int y1, int x2, int y2, int greedy, int texwidth, int length)
+{
+	//burning rangers tries to draw huge shapes
+	//this will at least let it run
+	if (abs(x2 - x1) > 999 || abs(y2 - y1) > 999)
+		return;
+
+	if (info->colormode == VDP1DOT_INVALID)
+		return;
+
+	Vdp1DrawLineTable[info->colormode][vdp1pixelsize == 2 ? info->ccmode : 6](
+		info, x1, y1, x2, y2, greedy, texwidth, length);
+}
+
+/* Horizontal lines on a 16 bit framebuffer are drawn as spans.  The
+   dots are fetched into a buffer first, walking the texture exactly like
+   Vdp1DrawLineGeneric() does, then the color calculation is done for the
+   whole span at once.  Gouraud shading and MSB on take the line path. */
+
+#define VDP1_MAX_SPAN 1024
+
+static void Vdp1BlendSpan(u16 *dst, const u16 *dots, const u16 *draw, int length, int ccmode)
+{
+	int i = 0;
+#ifdef __SSE2__
+	const __m128i msb = _mm_set1_epi16((short)0x8000);
+	const __m128i half = _mm_set1_epi16(0x3DEF);
+	const __m128i rmask = _mm_set1_epi16(0x001F);
+	const __m128i gmask = _mm_set1_epi16(0x03E0);
+	const __m128i bmask = _mm_set1_epi16(0x7C00);
+
+	for (; i + 8 <= length; i += 8)
 	{
-		if (currentPixel) {
-			*iPix |= 0x8000;
-			return;
+		__m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+		__m128i s = _mm_loadu_si128((const __m128i *)(dots + i));
+		__m128i m = _mm_loadu_si128((const __m128i *)(draw + i));
+		__m128i dmsb = _mm_srai_epi16(d, 15);
+		__m128i v;
+
+		switch (ccmode)
+		{
+		case 0: // replace
+			v = s;
+			break;
+		case 1: // shadow, only if MSB of framebuffer data is set
+			m = _mm_and_si128(m, dmsb);
+			v = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(d, 1), half), msb);
+			break;
+		case 2: // half luminance
+			v = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(s, 1), half), msb);
+			break;
+		default: // half transparent, blended only if MSB of framebuffer data is set
+			v = _mm_or_si128(_mm_or_si128(
+				_mm_srli_epi16(_mm_add_epi16(_mm_and_si128(s, rmask), _mm_and_si128(d, rmask)), 1),
+				_mm_and_si128(_mm_srli_epi16(_mm_add_epi16(_mm_and_si128(s, gmask), _mm_and_si128(d, gmask)), 1), gmask)),
+				_mm_and_si128(_mm_srli_epi16(_mm_add_epi16(_mm_and_si128(s, bmask), _mm_and_si128(d, bmask)), 1), bmask));
+			v = _mm_or_si128(_mm_and_si128(dmsb, _mm_or_si128(v, msb)), _mm_andnot_si128(dmsb, s));
+			break;
 		}
+
+		_mm_storeu_si128((__m128i *)(dst + i),
+			_mm_or_si128(_mm_and_si128(m, v), _mm_andnot_si128(m, d)));
 	}
+#endif
 
-	if ( SPD || (currentPixel & currentPixelIsVisible))
+	for (; i < length; i++)
 	{
-		switch( cmd.CMDPMOD & 0x7 )//we want bits 0,1,2
+		if (!draw[i])
+			continue;
+
+		switch (ccmode)
 		{
-		case 0:	// replace
-			if (!((currentPixel == 0) && !SPD)) 
-				*(iPix) = currentPixel;
+		case 0: // replace
+			dst[i] = dots[i];
 			break;
 		case 1: // shadow
-			if (*(iPix) & (1 << 15)) // only if MSB of framebuffer data is set
-				*(iPix) = alphablend16(*(iPix), 0, (1 << 7)) | (1 << 15);
+			if (dst[i] & (1 << 15))
+				dst[i] = alphablend16(dst[i], 0, (1 << 7)) | (1 << 15);
 			break;
 		case 2: // half luminance
-			*(iPix) = ((currentPixel & ~0x8421) >> 1) | (1 << 15);
+			dst[i] = ((dots[i] & ~0x8421) >> 1) | (1 << 15);
 			break;
-		case 3: // half transparent
-			if ( *(iPix) & (1 << 15) )//only if MSB of framebuffer data is set 
-				*(iPix) = alphablend16( *(iPix), currentPixel, (1 << 7) ) | (1 << 15);
+		default: // half transparent
+			if (dst[i] & (1 << 15))
+				dst[i] = alphablend16(dst[i], dots[i], (1 << 7)) | (1 << 15);
 			else
-				*(iPix) = currentPixel;
+				dst[i] = dots[i];
 			break;
-		case 4: //gouraud
-			#define COLOR(r,g,b)    (((r)&0x1F)|(((g)&0x1F)<<5)|(((b)&0x1F)<<10) |0x8000 )
-
-			//handle the special case demonstrated in the sgl chrome demo
-			//if we are in a paletted bank mode and the other two colors are unused, adjust the index value instead of rgb
-			if(
-				(((cmd.CMDPMOD >> 3) & 0x7) != 5) &&
-				(((cmd.CMDPMOD >> 3) & 0x7) != 1) && 
-				(int)leftColumnColor.g == 16 && 
-				(int)leftColumnColor.b == 16) 
+		}
+	}
+}
+
+static INLINE void Vdp1DrawSpanGeneric(vdp1draw_struct *info, int x1, int y1, int x2,
+				       int texwidth, const int colormode)
+{
+	u16 dots[VDP1_MAX_SPAN];
+	u16 draw[VDP1_MAX_SPAN];
+	int ax = (x2 >= x1) ? 1 : -1;
+	int length = abs(x2 - x1) + 1;
+	double ustep = (double)texwidth / length;
+	int y = y1 / vdp1interlace;
+	int sx1 = (x1 < x2) ? x1 : x2;
+	int sx2 = (x1 < x2) ? x2 + 1 : x1 + 1;
+	int i, ifirst, ilast, prevu = 123456789, endcodes = 0;
+
+	// only the part of the span inside the clipping rectangle gets drawn
+	if (y < info->clipy1 || y >= info->clipy2)
+		return;
+	if (sx1 < info->clipx1) sx1 = info->clipx1;
+	if (sx2 > info->clipx2) sx2 = info->clipx2;
+	if (sx1 >= sx2)
+		return;
+
+	ifirst = (ax > 0) ? sx1 - x1 : x1 - (sx2 - 1);
+	ilast = (ax > 0) ? sx2 - 1 - x1 : x1 - sx1;
+	memset(draw, 0, (sx2 - sx1) * sizeof(u16));
+
+	// dots before the visible part can still hold endcodes
+	for (i = info->endcodes ? 0 : ifirst; i <= ilast; i++)
+	{
+		int u = (int)(i * ustep);
+		int x, off;
+		u32 dot;
+
+		if (Vdp1GetDot(info, u, &dot, colormode))
+		{
+			if (u != prevu)
 			{
-				int c = (int)(leftColumnColor.r-0x10);
-				if(c < 0) c = 0;
-				currentPixel = currentPixel+c;
-				*(iPix) = currentPixel;
-				break;
+				prevu = u;
+				if (++endcodes == 2)
+					break;
 			}
-			*(iPix) = COLOR(
-				gouraudAdjust(
-				currentPixel&0x001F,
-				(int)leftColumnColor.r),
-
-				gouraudAdjust(
-				(currentPixel&0x03e0) >> 5,
-				(int)leftColumnColor.g),
-
-				gouraudAdjust(
-				(currentPixel&0x7c00) >> 10,
-				(int)leftColumnColor.b)
-				);
-			break;
-		default:
-			*(iPix) = alphablend16( COLOR((int)leftColumnColor.r,(int)leftColumnColor.g, (int)leftColumnColor.b), currentPixel, (1 << 7) ) | (1 << 15);
-			break;
+			continue;
 		}
+
+		if (i < ifirst)
+			continue;
+
+		x = x1 + i * ax;
+		if (info->mesh && ((x ^ y) & 1))
+			continue;
+
+		off = x - sx1;
+		dots[off] = dot;
+		draw[off] = (info->spd || (dot & info->visible)) ? 0xFFFF : 0;
 	}
+
+	Vdp1BlendSpan(&((u16 *)vdp1backframebuffer)[(y * vdp1width) + sx1],
+		      dots, draw, sx2 - sx1, info->ccmode);
+}
+
+typedef void (*vdp1drawspan_func)(vdp1draw_struct *info, int x1, int y1, int x2, int texwidth);
+
+#define VDP1DRAWSPAN(colormode) \
+static void Vdp1DrawSpan_##colormode(vdp1draw_struct *info, int x1, int y1, int x2, int texwidth) \
+{ \
+	Vdp1DrawSpanGeneric(info, x1, y1, x2, texwidth, colormode); \
+}
+
+VDP1DRAWSPAN(0)
+VDP1DRAWSPAN(1)
+VDP1DRAWSPAN(2)
+VDP1DRAWSPAN(3)
+VDP1DRAWSPAN(4)
+VDP1DRAWSPAN(5)
+VDP1DRAWSPAN(6)
+
+// indexed by color mode
+static const vdp1drawspan_func Vdp1DrawSpanTable[7] = {
+	Vdp1DrawSpan_0, Vdp1DrawSpan_1, Vdp1DrawSpan_2, Vdp1DrawSpan_3,
+	Vdp1DrawSpan_4, Vdp1DrawSpan_5, Vdp1DrawSpan_6,
+};
+
+static void DrawSpan(vdp1draw_struct *info, int x1, int y1, int x2, int texwidth)
+{
+	if (abs(x2 - x1) > 999)
+		return;
+
+	if (info->colormode == VDP1DOT_INVALID)
+		return;
+
+	Vdp1DrawSpanTable[info->colormode](info, x1, y1, x2, texwidth);
 }
 
 static int iterateOverLine(int x1, int y1, int x2, int y2, int greedy, void *data,
@@ -2250,245 +3549,352 @@ static int iterateOverLine(int x1, int y1, int x2, int y2, int greedy, void *dat
 	return i;
 }
 
-typedef struct {
-	double linenumber;
-	double texturestep;
-	double xredstep;
-	double xgreenstep;
-	double xbluestep;
-	int endcodesdetected;
-	int previousStep;
-} DrawLineData;
-
-static int DrawLineCallback(int x, int y, int i, void *data)
-{
-	int currentStep;
-	DrawLineData *linedata = data;
-
-	leftColumnColor.r += linedata->xredstep;
-	leftColumnColor.g += linedata->xgreenstep;
-	leftColumnColor.b += linedata->xbluestep;
 
-	currentStep = (int)i * linedata->texturestep;
-	if (getpixel(linedata->linenumber, currentStep)) {
-		if (currentStep != linedata->previousStep) {
-			linedata->previousStep = currentStep;
-			linedata->endcodesdetected ++;
-		}
-	} else if (vdp1pixelsize == 2) {
-		putpixel(x, y);
-	} else {
-		putpixel8(x, y);
-    }
+static int
+storeLineCoords(int x, int y, int i, void *arrays) {
+	int **intArrays = arrays;
 
-	if (linedata->endcodesdetected == 2) return -1;
+	intArrays[0][i] = x;
+	intArrays[1][i] = y;
 
 	return 0;
 }
 
-static int DrawLine( int x1, int y1, int x2, int y2, int greedy, double linenumber, double texturestep, double xredstep, double xgreenstep, double xbluestep)
+/* Returns 1 when no dot of the line can land inside the clipping
+   rectangle.  Dots never leave the bounding box of the end points. */
+
+static INLINE int Vdp1LineClipped(const vdp1draw_struct *info, int x1, int y1, int x2, int y2)
 {
-	DrawLineData data;
+	int xdiv = (vdp1pixelsize == 2) ? 1 : 2;
+	int minx = ((x1 < x2) ? x1 : x2) / xdiv;
+	int maxx = ((x1 < x2) ? x2 : x1) / xdiv;
+	int miny = ((y1 < y2) ? y1 : y2) / vdp1interlace;
+	int maxy = ((y1 < y2) ? y2 : y1) / vdp1interlace;
+
+	return maxx < info->clipx1 || minx >= info->clipx2 ||
+	       maxy < info->clipy1 || miny >= info->clipy2;
+}
+
+//a real vdp1 draws with arbitrary lines
+//this is why endcodes are possible
+//this is also the reason why half-transparent shading causes moire patterns
+//and the reason why gouraud shading can be applied to a single line draw command
+static void drawQuad(vdp1draw_struct *info){
 
-	data.linenumber = linenumber;
-	data.texturestep = texturestep;
-	data.xredstep = xredstep;
-	data.xgreenstep = xgreenstep;
-	data.xbluestep = xbluestep;
-	data.endcodesdetected = 0;
-	data.previousStep = 123456789;
+	int totalleft;
+	int totalright;
+	int total;
+	int i;
+	int *intarrays[2];
+	int xleft[1000];
+	int yleft[1000];
+	int xright[1000];
+	int yright[1000];
 
-	return iterateOverLine(x1, y1, x2, y2, greedy, &data, DrawLineCallback);
-}
+	//how quickly we step through the line arrays
+	double leftLineStep = 1;
+	double rightLineStep = 1;
+	double ytexturestep;
 
-static INLINE double interpolate(double start, double end, int numberofsteps) {
+	//a lookup table for the gouraud colors
+	COLOR colors[4];
+	double leftcolorstep[3] = {0, 0, 0}, rightcolorstep[3] = {0, 0, 0};
 
-	double stepvalue = 0;
+	//vertices are stored as top left, top right, bottom right, bottom left
+	intarrays[0] = xleft; intarrays[1] = yleft;
+	totalleft  = iterateOverLine(info->x[0], info->y[0], info->x[3], info->y[3], 0, intarrays, storeLineCoords);
+	intarrays[0] = xright; intarrays[1] = yright;
+	totalright  = iterateOverLine(info->x[1], info->y[1], info->x[2], info->y[2], 0, intarrays, storeLineCoords);
 
-	if(numberofsteps == 0)
-		return 1;
+	//just for now since burning rangers will freeze up trying to draw huge shapes
+	if(totalleft == INT_MAX || totalright == INT_MAX)
+		return;
 
-	stepvalue = (end - start) / numberofsteps;
+	total = totalleft > totalright ? totalleft : totalright;
 
-	return stepvalue;
-}
+	if(info->gouraud) {
+		colors[0] = info->gouraudtbl[0];
+		colors[1] = info->gouraudtbl[3];
+		colors[2] = info->gouraudtbl[1];
+		colors[3] = info->gouraudtbl[2];
 
-typedef union _COLOR { // xbgr x555
-	struct {
-#ifdef WORDS_BIGENDIAN
-	u16 x:1;
-	u16 b:5;
-	u16 g:5;
-	u16 r:5;
-#else
-     u16 r:5;
-     u16 g:5;
-     u16 b:5;
-     u16 x:1;
-#endif
-	};
-	u16 value;
-} COLOR;
+		leftcolorstep[0] = (double)(colors[1].r - colors[0].r) / total;
+		leftcolorstep[1] = (double)(colors[1].g - colors[0].g) / total;
+		leftcolorstep[2] = (double)(colors[1].b - colors[0].b) / total;
+
+		rightcolorstep[0] = (double)(colors[3].r - colors[2].r) / total;
+		rightcolorstep[1] = (double)(colors[3].g - colors[2].g) / total;
+		rightcolorstep[2] = (double)(colors[3].b - colors[2].b) / total;
+	}
+
+	//we have to step the equivalent of less than one pixel on the shorter side
+	//to make sure textures stretch properly and the shape is correct
+	if (totalleft > totalright)
+		rightLineStep = (double)totalright / totalleft;
+	else if (totalleft < totalright)
+		leftLineStep = (double)totalleft / totalright;
+
+	//now we need to interpolate the y texture coordinate across multiple lines
+	ytexturestep = (double)info->height / total;
+
+	for(i = 0; i < total; i++) {
+
+		int left = (int)(i * leftLineStep);
+		int right = (int)(i * rightLineStep);
+		int x1 = xleft[left], y1 = yleft[left];
+		int x2 = xright[right], y2 = yright[right];
+
+		//get the length of the line we are about to draw
+		int xlinelength = abs(x2 - x1) + abs(y2 - y1) + 1;
+
+		//every line works out its own texture row and colors, so the ones
+		//outside the clipping rectangle (or framebuffer tile) can be skipped
+		if (Vdp1LineClipped(info, x1, y1, x2, y2))
+			continue;
+
+		Vdp1DrawSetLine(info, (int)(ytexturestep * i));
+
+		//gouraud interpolation
+		if(info->gouraud) {
+
+			//for each new line we need to step once more through each column
+			//to get the current colors to use to interpolate across the line
+			double rightr = colors[2].r + rightcolorstep[0] * i;
+			double rightg = colors[2].g + rightcolorstep[1] * i;
+			double rightb = colors[2].b + rightcolorstep[2] * i;
+
+			info->r = colors[0].r + leftcolorstep[0] * i;
+			info->g = colors[0].g + leftcolorstep[1] * i;
+			info->b = colors[0].b + leftcolorstep[2] * i;
+
+			//interpolate colors across to get the right step values
+			info->rstep = (rightr - info->r) / xlinelength;
+			info->gstep = (rightg - info->g) / xlinelength;
+			info->bstep = (rightb - info->b) / xlinelength;
+		}
+
+		//so from 0 to the width of the texture / the length of the line is how far we need to step
+		if (y1 == y2 && vdp1pixelsize == 2 && info->ccmode < 4 && !info->msbon)
+			DrawSpan(info, x1, y1, x2, info->width);
+		else
+			DrawLine(info, x1, y1, x2, y2, 1, info->width, xlinelength);
+	}
+}
 
+static void gouraudLineSetup(vdp1draw_struct *info, int length, COLOR table1, COLOR table2) {
 
-COLOR gouraudA;
-COLOR gouraudB;
-COLOR gouraudC;
-COLOR gouraudD;
+	info->rstep = (double)(table2.r - table1.r) / length;
+	info->gstep = (double)(table2.g - table1.g) / length;
+	info->bstep = (double)(table2.b - table1.b) / length;
 
-static void gouraudTable(void)
-{
-	int gouraudTableAddress;
+	info->r = table1.r;
+	info->g = table1.g;
+	info->b = table1.b;
+}
 
-	Vdp1ReadCommand(&cmd, Vdp1Regs->addr);
+static void drawPolyline(vdp1draw_struct *info)
+{
+	int *X = info->x;
+	int *Y = info->y;
+	COLOR *g = info->gouraudtbl;
+	int length;
 
-	gouraudTableAddress = (((unsigned int)cmd.CMDGRDA) << 3);
+	length = iterateOverLine(X[0], Y[0], X[1], Y[1], 1, NULL, NULL);
+	gouraudLineSetup(info, length, g[0], g[1]);
+	DrawLine(info, X[0], Y[0], X[1], Y[1], 0, 0, length);
 
-	gouraudA.value = T1ReadWord(Vdp1Ram,gouraudTableAddress);
-	gouraudB.value = T1ReadWord(Vdp1Ram,gouraudTableAddress+2);
-	gouraudC.value = T1ReadWord(Vdp1Ram,gouraudTableAddress+4);
-	gouraudD.value = T1ReadWord(Vdp1Ram,gouraudTableAddress+6);
-}
+	length = iterateOverLine(X[1], Y[1], X[2], Y[2], 1, NULL, NULL);
+	gouraudLineSetup(info, length, g[1], g[2]);
+	DrawLine(info, X[1], Y[1], X[2], Y[2], 0, 0, length);
 
-int xleft[1000];
-int yleft[1000];
-int xright[1000];
-int yright[1000];
+	length = iterateOverLine(X[2], Y[2], X[3], Y[3], 1, NULL, NULL);
+	gouraudLineSetup(info, length, g[3], g[2]);
+	DrawLine(info, X[3], Y[3], X[2], Y[2], 0, 0, length);
 
-static int
-storeLineCoords(int x, int y, int i, void *arrays) {
-	int **intArrays = arrays;
+	length = iterateOverLine(X[3], Y[3], X[0], Y[0], 1, NULL, NULL);
+	gouraudLineSetup(info, length, g[0], g[3]);
+	DrawLine(info, X[0], Y[0], X[3], Y[3], 0, 0, length);
+}
 
-	intArrays[0][i] = x;
-	intArrays[1][i] = y;
+static void drawLine(vdp1draw_struct *info)
+{
+	int length;
 
-	return 0;
+	length = iterateOverLine(info->x[0], info->y[0], info->x[1], info->y[1], 1, NULL, NULL);
+	gouraudLineSetup(info, length, info->gouraudtbl[0], info->gouraudtbl[1]);
+	DrawLine(info, info->x[0], info->y[0], info->x[1], info->y[1], 0, 0, length);
 }
 
-//a real vdp1 draws with arbitrary lines
-//this is why endcodes are possible
-//this is also the reason why half-transparent shading causes moire patterns
-//and the reason why gouraud shading can be applied to a single line draw command
-static void drawQuad(s16 tl_x, s16 tl_y, s16 bl_x, s16 bl_y, s16 tr_x, s16 tr_y, s16 br_x, s16 br_y){
+/* Draws a command, only touching the dots inside the given rectangle. */
 
-	int totalleft;
-	int totalright;
-	int total;
-	int i;
-	int *intarrays[2];
+static void Vdp1DrawPrimitive(const vdp1draw_struct *prim, int clipx1, int clipy1, int clipx2, int clipy2)
+{
+	vdp1draw_struct info = *prim;
 
-	COLOR_PARAMS topLeftToBottomLeftColorStep = {0,0,0}, topRightToBottomRightColorStep = {0,0,0};
-		
-	//how quickly we step through the line arrays
-	double leftLineStep = 1;
-	double rightLineStep = 1; 
+	if (info.clipx1 < clipx1) info.clipx1 = clipx1;
+	if (info.clipy1 < clipy1) info.clipy1 = clipy1;
+	if (info.clipx2 > clipx2) info.clipx2 = clipx2;
+	if (info.clipy2 > clipy2) info.clipy2 = clipy2;
 
-	//a lookup table for the gouraud colors
-	COLOR colors[4];
+	switch (info.type)
+	{
+		case VDP1PRIM_QUAD:
+			drawQuad(&info);
+			break;
+		case VDP1PRIM_POLYLINE:
+			drawPolyline(&info);
+			break;
+		case VDP1PRIM_LINE:
+			drawLine(&info);
+			break;
+	}
+}
 
-	Vdp1ReadCommand(&cmd, Vdp1Regs->addr);
-	characterWidth = ((cmd.CMDSIZE >> 8) & 0x3F) * 8;
-	characterHeight = cmd.CMDSIZE & 0xFF;
+/* With worker threads running, commands are only decoded while Vdp1Draw()
+   walks the command table.  VIDSoftVdp1DrawEnd() then sorts them into
+   framebuffer tiles and each tile is drawn by a single thread, running
+   its commands in table order.  Dots outside the tile are clipped away,
+   so every dot still sees the commands in the same order as the
+   hardware, including for half-transparency and MSB on. */
 
-	intarrays[0] = xleft; intarrays[1] = yleft;
-	totalleft  = iterateOverLine(tl_x, tl_y, bl_x, bl_y, 0, intarrays, storeLineCoords);
-	intarrays[0] = xright; intarrays[1] = yright;
-	totalright  = iterateOverLine(tr_x, tr_y, br_x, br_y, 0, intarrays, storeLineCoords);
+#define VDP1_MAX_PRIMITIVES 2000	// Vdp1Draw() gives up after 2000 commands
+#define VDP1_TILE_SIZE 64
+#define VDP1_MAX_TILES ((1024 / VDP1_TILE_SIZE) * (512 / VDP1_TILE_SIZE))
 
-	//just for now since burning rangers will freeze up trying to draw huge shapes
-	if(totalleft == INT_MAX || totalright == INT_MAX)
-		return;
+static vdp1draw_struct vdp1prims[VDP1_MAX_PRIMITIVES];
+static int vdp1tilestart[VDP1_MAX_TILES + 1];	// where each tile's commands start in vdp1tileprims
+static int vdp1tilejobs[VDP1_MAX_TILES];
+static int vdp1tilesx;
 
-	total = totalleft > totalright ? totalleft : totalright;
+static void Vdp1DrawTile(int job, UNUSED int thread)
+{
+	int tile = vdp1tilejobs[job];
+	int x1 = (tile % vdp1tilesx) * VDP1_TILE_SIZE;
+	int y1 = (tile / vdp1tilesx) * VDP1_TILE_SIZE;
+	int i;
 
+	for (i = vdp1tilestart[tile]; i < vdp1tilestart[tile + 1]; i++)
+		Vdp1DrawPrimitive(&vdp1prims[vdp1tileprims[i]],
+				  x1, y1, x1 + VDP1_TILE_SIZE, y1 + VDP1_TILE_SIZE);
+}
 
-	if(cmd.CMDPMOD & (1 << 2)) {
+/* Counts the queued commands touching each tile or, given a list, files
+   them from the back of each tile's group so every group stays in table
+   order. */
 
-		gouraudTable();
+static void Vdp1DrawBinPrimitives(u16 *list)
+{
+	int i, x, y;
 
-		{ colors[0] = gouraudA; colors[1] = gouraudD; colors[2] = gouraudB; colors[3] = gouraudC; }
+	for (i = vdp1primcount - 1; i >= 0; i--)
+	{
+		vdp1draw_struct *prim = &vdp1prims[i];
 
-		topLeftToBottomLeftColorStep.r = interpolate(colors[0].r,colors[1].r,total);
-		topLeftToBottomLeftColorStep.g = interpolate(colors[0].g,colors[1].g,total);
-		topLeftToBottomLeftColorStep.b = interpolate(colors[0].b,colors[1].b,total);
+		if (prim->bx1 > prim->bx2 || prim->by1 > prim->by2)
+			continue;
 
-		topRightToBottomRightColorStep.r = interpolate(colors[2].r,colors[3].r,total);
-		topRightToBottomRightColorStep.g = interpolate(colors[2].g,colors[3].g,total);
-		topRightToBottomRightColorStep.b = interpolate(colors[2].b,colors[3].b,total);
-	}
+		for (y = prim->by1 / VDP1_TILE_SIZE; y <= prim->by2 / VDP1_TILE_SIZE; y++)
+		{
+			for (x = prim->bx1 / VDP1_TILE_SIZE; x <= prim->bx2 / VDP1_TILE_SIZE; x++)
+			{
+				int tile = y * vdp1tilesx + x;
 
-	//we have to step the equivalent of less than one pixel on the shorter side
-	//to make sure textures stretch properly and the shape is correct
-	if(total == totalleft && totalleft != totalright) {
-		//left side is larger
-		leftLineStep = 1;
-		rightLineStep = (double)totalright / totalleft;
-	}
-	else if(totalleft != totalright){
-		//right side is larger
-		rightLineStep = 1;
-		leftLineStep = (double)totalleft / totalright;
+				if (list)
+					list[--vdp1tilestart[tile]] = i;
+				else
+					vdp1tilestart[tile]++;
+			}
+		}
 	}
+}
 
-	for(i = 0; i < total; i++) {
+static void Vdp1DrawFlush(void)
+{
+	int tiles;
+	int i, jobs = 0;
 
-		int xlinelength;
+	vdp1tilesx = (vdp1width + VDP1_TILE_SIZE - 1) / VDP1_TILE_SIZE;
+	tiles = vdp1tilesx * ((vdp1height + VDP1_TILE_SIZE - 1) / VDP1_TILE_SIZE);
 
-		double xtexturestep;
-		double ytexturestep;
+	// each tile's count becomes the end of its group, then filling the
+	// groups from the back leaves vdp1tilestart[] at their starts
+	memset(vdp1tilestart, 0, sizeof(vdp1tilestart));
+	Vdp1DrawBinPrimitives(NULL);
+	for (i = 1; i <= tiles; i++)
+		vdp1tilestart[i] += vdp1tilestart[i - 1];
 
-		COLOR_PARAMS rightColumnColor;
+	if (vdp1tilestart[tiles] > vdp1tileprimsize)
+	{
+		u16 *list = (u16 *)realloc(vdp1tileprims, vdp1tilestart[tiles] * sizeof(u16));
 
-		COLOR_PARAMS leftToRightStep = {0,0,0};
+		if (list == NULL)
+		{
+			// out of memory, draw everything on this thread instead
+			for (i = 0; i < vdp1primcount; i++)
+				Vdp1DrawPrimitive(&vdp1prims[i], 0, 0, vdp1width, vdp1height);
+			vdp1primcount = 0;
+			return;
+		}
 
-		//get the length of the line we are about to draw
-		xlinelength = iterateOverLine(
-			xleft[(int)(i*leftLineStep)],
-			yleft[(int)(i*leftLineStep)],
-			xright[(int)(i*rightLineStep)],
-			yright[(int)(i*rightLineStep)],
-			1, NULL, NULL);
+		vdp1tileprims = list;
+		vdp1tileprimsize = vdp1tilestart[tiles];
+	}
 
-		//so from 0 to the width of the texture / the length of the line is how far we need to step
-		xtexturestep=interpolate(0,characterWidth,xlinelength);
+	Vdp1DrawBinPrimitives(vdp1tileprims);
 
-		//now we need to interpolate the y texture coordinate across multiple lines
-		ytexturestep=interpolate(0,characterHeight,total);
+	for (i = 0; i < tiles; i++)
+	{
+		if (vdp1tilestart[i] != vdp1tilestart[i + 1])
+			vdp1tilejobs[jobs++] = i;
+	}
 
-		//gouraud interpolation
-		if(cmd.CMDPMOD & (1 << 2)) {
+	VidsoftRunJobs(Vdp1DrawTile, jobs);
+	vdp1primcount = 0;
+}
 
-			//for each new line we need to step once more through each column
-			//and add the orignal color + the number of steps taken times the step value to the bottom of the shape
-			//to get the current colors to use to interpolate across the line
+/* Returns where the next command should be decoded to. */
 
-			leftColumnColor.r = colors[0].r +(topLeftToBottomLeftColorStep.r*i);
-			leftColumnColor.g = colors[0].g +(topLeftToBottomLeftColorStep.g*i);
-			leftColumnColor.b = colors[0].b +(topLeftToBottomLeftColorStep.b*i);
+static vdp1draw_struct *Vdp1DrawNewPrimitive(void)
+{
+	if (!vdp1queueprims)
+		return &vdp1draw;
 
-			rightColumnColor.r = colors[2].r +(topRightToBottomRightColorStep.r*i);
-			rightColumnColor.g = colors[2].g +(topRightToBottomRightColorStep.g*i);
-			rightColumnColor.b = colors[2].b +(topRightToBottomRightColorStep.b*i);
+	if (vdp1primcount == VDP1_MAX_PRIMITIVES)
+		Vdp1DrawFlush();
 
-			//interpolate colors across to get the right step values
-			leftToRightStep.r = interpolate(leftColumnColor.r,rightColumnColor.r,xlinelength);
-			leftToRightStep.g = interpolate(leftColumnColor.g,rightColumnColor.g,xlinelength);
-			leftToRightStep.b = interpolate(leftColumnColor.b,rightColumnColor.b,xlinelength);
-		}
+	return &vdp1prims[vdp1primcount];
+}
 
-		DrawLine(
-			xleft[(int)(i*leftLineStep)],
-			yleft[(int)(i*leftLineStep)],
-			xright[(int)(i*rightLineStep)],
-			yright[(int)(i*rightLineStep)],
-			1,
-			ytexturestep*i, 
-			xtexturestep,
-			leftToRightStep.r,
-			leftToRightStep.g,
-			leftToRightStep.b
-			);
+static void Vdp1DrawSubmit(vdp1draw_struct *prim)
+{
+	if (prim->bx1 <= prim->bx2 && prim->by1 <= prim->by2)
+	{
+		if (prim->bx1 < vdp1drawx1) vdp1drawx1 = prim->bx1;
+		if (prim->by1 < vdp1drawy1) vdp1drawy1 = prim->by1;
+		if (prim->bx2 > vdp1drawx2) vdp1drawx2 = prim->bx2;
+		if (prim->by2 > vdp1drawy2) vdp1drawy2 = prim->by2;
 	}
+
+	if (vdp1queueprims)
+		vdp1primcount++;
+	else
+		Vdp1DrawPrimitive(prim, 0, 0, vdp1width, vdp1height);
+}
+
+static void Vdp1DrawQuadCommand(int x0, int y0, int x1, int y1, int x2, int y2, int x3, int y3)
+{
+	vdp1draw_struct *prim = Vdp1DrawNewPrimitive();
+	int x[4], y[4];
+
+	// coordinates wrap the same way as the hardware's 16 bit registers
+	x[0] = (s16)x0; y[0] = (s16)y0;
+	x[1] = (s16)x1; y[1] = (s16)y1;
+	x[2] = (s16)x2; y[2] = (s16)y2;
+	x[3] = (s16)x3; y[3] = (s16)y3;
+
+	Vdp1DrawSetup(prim);
+	Vdp1DrawSetVertices(prim, VDP1PRIM_QUAD, x, y);
+	Vdp1DrawSubmit(prim);
 }
 
 void VIDSoftVdp1NormalSpriteDraw() {
@@ -2496,7 +3902,11 @@ void VIDSoftVdp1NormalSpriteDraw() {
 	s16 topLeftx,topLefty,topRightx,topRighty,bottomRightx,bottomRighty,bottomLeftx,bottomLefty;
 	int spriteWidth;
 	int spriteHeight;
-	Vdp1ReadCommand(&cmd, Vdp1Regs->addr);
+
+	if (vdp1reuse)
+		return;
+
+	cmd = *Vdp1CurrentCommand;
 
 	topLeftx = cmd.CMDXA + Vdp1Regs->localX;
 	topLefty = cmd.CMDYA + Vdp1Regs->localY;
@@ -2510,14 +3920,18 @@ void VIDSoftVdp1NormalSpriteDraw() {
 	bottomLeftx = topLeftx;
 	bottomLefty = topLefty + (spriteHeight - 1);
 
-	drawQuad(topLeftx,topLefty,bottomLeftx,bottomLefty,topRightx,topRighty,bottomRightx,bottomRighty);
+	Vdp1DrawQuadCommand(topLeftx,topLefty,topRightx,topRighty,bottomRightx,bottomRighty,bottomLeftx,bottomLefty);
 }
 
 void VIDSoftVdp1ScaledSpriteDraw(){
 
 	s32 topLeftx,topLefty,topRightx,topRighty,bottomRightx,bottomRighty,bottomLeftx,bottomLefty;
 	int x0,y0,x1,y1;
-	Vdp1ReadCommand(&cmd, Vdp1Regs->addr);
+
+	if (vdp1reuse)
+		return;
+
+	cmd = *Vdp1CurrentCommand;
 
 	x0 = cmd.CMDXA + Vdp1Regs->localX;
 	y0 = cmd.CMDYA + Vdp1Regs->localY;
@@ -2607,14 +4021,17 @@ void VIDSoftVdp1ScaledSpriteDraw(){
 	bottomLeftx = topLeftx;
 	bottomLefty = y1+y0 - 1;
 
-	drawQuad(topLeftx,topLefty,bottomLeftx,bottomLefty,topRightx,topRighty,bottomRightx,bottomRighty);
+	Vdp1DrawQuadCommand(topLeftx,topLefty,topRightx,topRighty,bottomRightx,bottomRighty,bottomLeftx,bottomLefty);
 }
 
 void VIDSoftVdp1DistortedSpriteDraw() {
 
 	s32 xa,ya,xb,yb,xc,yc,xd,yd;
 
-	Vdp1ReadCommand(&cmd, Vdp1Regs->addr);
+	if (vdp1reuse)
+		return;
+
+	cmd = *Vdp1CurrentCommand;
 
     xa = (s32)(cmd.CMDXA + Vdp1Regs->localX);
     ya = (s32)(cmd.CMDYA + Vdp1Regs->localY);
@@ -2628,83 +4045,63 @@ void VIDSoftVdp1DistortedSpriteDraw() {
     xd = (s32)(cmd.CMDXD + Vdp1Regs->localX);
     yd = (s32)(cmd.CMDYD + Vdp1Regs->localY);
 
-	drawQuad(xa,ya,xd,yd,xb,yb,xc,yc);
-}
-
-static void gouraudLineSetup(double * redstep, double * greenstep, double * bluestep, int length, COLOR table1, COLOR table2) {
-
-	gouraudTable();
-
-	*redstep =interpolate(table1.r,table2.r,length);
-	*greenstep =interpolate(table1.g,table2.g,length);
-	*bluestep =interpolate(table1.b,table2.b,length);
-
-	leftColumnColor.r = table1.r;
-	leftColumnColor.g = table1.g;
-	leftColumnColor.b = table1.b;
+	Vdp1DrawQuadCommand(xa,ya,xb,yb,xc,yc,xd,yd);
 }
 
 void VIDSoftVdp1PolylineDraw(void)
 {
+	vdp1draw_struct *prim = Vdp1DrawNewPrimitive();
 	int X[4];
 	int Y[4];
-	double redstep = 0, greenstep = 0, bluestep = 0;
-	int length;
 
-	Vdp1ReadCommand(&cmd, Vdp1Regs->addr);
-
-	X[0] = (int)Vdp1Regs->localX + (int)((s16)T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x0C));
-	Y[0] = (int)Vdp1Regs->localY + (int)((s16)T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x0E));
-	X[1] = (int)Vdp1Regs->localX + (int)((s16)T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x10));
-	Y[1] = (int)Vdp1Regs->localY + (int)((s16)T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x12));
-	X[2] = (int)Vdp1Regs->localX + (int)((s16)T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x14));
-	Y[2] = (int)Vdp1Regs->localY + (int)((s16)T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x16));
-	X[3] = (int)Vdp1Regs->localX + (int)((s16)T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x18));
-	Y[3] = (int)Vdp1Regs->localY + (int)((s16)T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x1A));
-
-	length = iterateOverLine(X[0], Y[0], X[1], Y[1], 1, NULL, NULL);
-	gouraudLineSetup(&redstep,&greenstep,&bluestep,length, gouraudA, gouraudB);
-	DrawLine(X[0], Y[0], X[1], Y[1], 0, 0,0,redstep,greenstep,bluestep);
+	if (vdp1reuse)
+		return;
 
-	length = iterateOverLine(X[1], Y[1], X[2], Y[2], 1, NULL, NULL);
-	gouraudLineSetup(&redstep,&greenstep,&bluestep,length, gouraudB, gouraudC);
-	DrawLine(X[1], Y[1], X[2], Y[2], 0, 0,0,redstep,greenstep,bluestep);
+	cmd = *Vdp1CurrentCommand;
+	Vdp1DrawSetup(prim);
 
-	length = iterateOverLine(X[2], Y[2], X[3], Y[3], 1, NULL, NULL);
-	gouraudLineSetup(&redstep,&greenstep,&bluestep,length, gouraudD, gouraudC);
-	DrawLine(X[3], Y[3], X[2], Y[2], 0, 0,0,redstep,greenstep,bluestep);
+	X[0] = (int)Vdp1Regs->localX + (int)cmd.CMDXA;
+	Y[0] = (int)Vdp1Regs->localY + (int)cmd.CMDYA;
+	X[1] = (int)Vdp1Regs->localX + (int)cmd.CMDXB;
+	Y[1] = (int)Vdp1Regs->localY + (int)cmd.CMDYB;
+	X[2] = (int)Vdp1Regs->localX + (int)cmd.CMDXC;
+	Y[2] = (int)Vdp1Regs->localY + (int)cmd.CMDYC;
+	X[3] = (int)Vdp1Regs->localX + (int)cmd.CMDXD;
+	Y[3] = (int)Vdp1Regs->localY + (int)cmd.CMDYD;
 
-	length = iterateOverLine(X[3], Y[3], X[0], Y[0], 1, NULL, NULL);
-	gouraudLineSetup(&redstep,&greenstep,&bluestep,length, gouraudA,gouraudD);
-	DrawLine(X[0], Y[0], X[3], Y[3], 0, 0,0,redstep,greenstep,bluestep);
+	Vdp1DrawSetVertices(prim, VDP1PRIM_POLYLINE, X, Y);
+	Vdp1DrawSubmit(prim);
 }
 
 void VIDSoftVdp1LineDraw(void)
 {
-	int x1, y1, x2, y2;
-	double redstep = 0, greenstep = 0, bluestep = 0;
-	int length;
+	vdp1draw_struct *prim = Vdp1DrawNewPrimitive();
+	int X[2];
+	int Y[2];
 
-	Vdp1ReadCommand(&cmd, Vdp1Regs->addr);
+	if (vdp1reuse)
+		return;
+
+	cmd = *Vdp1CurrentCommand;
+	Vdp1DrawSetup(prim);
 
-	x1 = (int)Vdp1Regs->localX + (int)((s16)T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x0C));
-	y1 = (int)Vdp1Regs->localY + (int)((s16)T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x0E));
-	x2 = (int)Vdp1Regs->localX + (int)((s16)T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x10));
-	y2 = (int)Vdp1Regs->localY + (int)((s16)T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x12));
+	X[0] = (int)Vdp1Regs->localX + (int)cmd.CMDXA;
+	Y[0] = (int)Vdp1Regs->localY + (int)cmd.CMDYA;
+	X[1] = (int)Vdp1Regs->localX + (int)cmd.CMDXB;
+	Y[1] = (int)Vdp1Regs->localY + (int)cmd.CMDYB;
 
-	length = iterateOverLine(x1, y1, x2, y2, 1, NULL, NULL);
-	gouraudLineSetup(&redstep,&bluestep,&greenstep,length, gouraudA, gouraudB);
-	DrawLine(x1, y1, x2, y2, 0, 0,0,redstep,greenstep,bluestep);
+	Vdp1DrawSetVertices(prim, VDP1PRIM_LINE, X, Y);
+	Vdp1DrawSubmit(prim);
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
 void VIDSoftVdp1UserClipping(void)
 {
-   Vdp1Regs->userclipX1 = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0xC);
-   Vdp1Regs->userclipY1 = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0xE);
-   Vdp1Regs->userclipX2 = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x14);
-   Vdp1Regs->userclipY2 = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x16);
+   Vdp1Regs->userclipX1 = Vdp1CurrentCommand->CMDXA;
+   Vdp1Regs->userclipY1 = Vdp1CurrentCommand->CMDYA;
+   Vdp1Regs->userclipX2 = Vdp1CurrentCommand->CMDXC;
+   Vdp1Regs->userclipY2 = Vdp1CurrentCommand->CMDYC;
 
 #if 0
    vdp1clipxstart = Vdp1Regs->userclipX1;
@@ -2788,8 +4185,8 @@ void VIDSoftVdp1SystemClipping(void)
 {
    Vdp1Regs->systemclipX1 = 0;
    Vdp1Regs->systemclipY1 = 0;
-   Vdp1Regs->systemclipX2 = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x14);
-   Vdp1Regs->systemclipY2 = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0x16);
+   Vdp1Regs->systemclipX2 = Vdp1CurrentCommand->CMDXC;
+   Vdp1Regs->systemclipY2 = Vdp1CurrentCommand->CMDYC;
 
    vdp1clipxstart = Vdp1Regs->systemclipX1;
    vdp1clipxend = Vdp1Regs->systemclipX2;
@@ -2801,8 +4198,8 @@ void VIDSoftVdp1SystemClipping(void)
 
 void VIDSoftVdp1LocalCoordinate(void)
 {
-   Vdp1Regs->localX = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0xC);
-   Vdp1Regs->localY = T1ReadWord(Vdp1Ram, Vdp1Regs->addr + 0xE);
+   Vdp1Regs->localX = Vdp1CurrentCommand->CMDXA;
+   Vdp1Regs->localY = Vdp1CurrentCommand->CMDYA;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -2814,11 +4211,90 @@ int VIDSoftVdp2Reset(void)
 
 //////////////////////////////////////////////////////////////////////////////
 
-void VIDSoftVdp2DrawStart(void)
+// Captures the VDP2 state for this frame's screens. Returns 1 if the frame
+// in dispbuffer was drawn from the same state.
+static int Vdp2FrameCapture(void)
+{
+   int same = 0;
+   int i;
+
+   vidsoft_captured = (vidsoft_capture.ram != NULL || Vdp2CaptureInit(&vidsoft_capture) == 0);
+   if (!vidsoft_captured)
+   {
+      // drawn from the live state then
+      Vdp2CellCacheUpdate(Vdp2RamDirty, &Vdp2ColorRamDirty);
+      vidsoft_frame_valid = 0;
+      return 0;
+   }
+
+   Vdp2Capture(&vidsoft_capture);
+
+   if (vidsoft_frame_valid && !vidsoft_capture.colorramdirty &&
+       vidsoft_frame.disptoggle == Vdp2External.disptoggle)
+   {
+      same = 1;
+      for (i = 0; i < (0x80000 >> 13) && same; i++)
+         same = (vidsoft_capture.ramdirty[i] == 0);
+      same = same &&
+             !memcmp(&vidsoft_frame.regs, &vidsoft_capture.regs, sizeof(Vdp2)) &&
+             !memcmp(vidsoft_frame.lines, vidsoft_capture.lines, sizeof(vidsoft_frame.lines));
+   }
+
+   Vdp2CellCacheUpdate(vidsoft_capture.ramdirty, &vidsoft_capture.colorramdirty);
+
+   if (!same)
+   {
+      memcpy(&vidsoft_frame.regs, &vidsoft_capture.regs, sizeof(Vdp2));
+      memcpy(vidsoft_frame.lines, vidsoft_capture.lines, sizeof(vidsoft_frame.lines));
+      vidsoft_frame.disptoggle = Vdp2External.disptoggle;
+      vidsoft_frame_valid = 0;
+   }
+
+   return same;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Checks the state the sprites are drawn from against the frame in
+// dispbuffer, and makes it the frame's if it changed. Returns 1 if it didn't.
+static int Vdp2FrameSpritesUnchanged(void)
+{
+   int same = vidsoft_frame_kept && !Vdp2ColorRamDirty &&
+              vidsoft_frame.vdp1disptoggle == Vdp1External.disptoggle &&
+              vidsoft_frame.TVMR == Vdp1Regs->TVMR &&
+              vidsoft_frame.vdp1width == vdp1width &&
+              vidsoft_frame.vdp1height == vdp1height &&
+              vidsoft_frame.vdp1pixelsize == vdp1pixelsize &&
+              vidsoft_frame.vdp1stamp == vdp1frontstamp;
+   int i;
+
+   for (i = 0; i < (0x80000 >> 13) && same; i++)
+      same = (Vdp2RamDirty[i] == 0);
+
+   if (same &&
+       !memcmp(&vidsoft_frame.spriteregs, Vdp2Regs, sizeof(Vdp2)) &&
+       !memcmp(vidsoft_frame.spritelines, Vdp2RestoreRegs(0), sizeof(vidsoft_frame.spritelines)))
+      return 1;
+
+   memcpy(&vidsoft_frame.spriteregs, Vdp2Regs, sizeof(Vdp2));
+   memcpy(vidsoft_frame.spritelines, Vdp2RestoreRegs(0), sizeof(vidsoft_frame.spritelines));
+   vidsoft_frame.vdp1disptoggle = Vdp1External.disptoggle;
+   vidsoft_frame.TVMR = Vdp1Regs->TVMR;
+   vidsoft_frame.vdp1width = vdp1width;
+   vidsoft_frame.vdp1height = vdp1height;
+   vidsoft_frame.vdp1pixelsize = vdp1pixelsize;
+   vidsoft_frame.vdp1stamp = vdp1frontstamp;
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void Vdp2DrawBackScreens(void)
 {
    int titanblendmode = TITAN_BLEND_TOP;
-   if (Vdp2Regs->CCCTL & 0x100) titanblendmode = TITAN_BLEND_ADD;
-   else if (Vdp2Regs->CCCTL & 0x200) titanblendmode = TITAN_BLEND_BOTTOM;
+
+   if (Vdp2DrawRegs->CCCTL & 0x100) titanblendmode = TITAN_BLEND_ADD;
+   else if (Vdp2DrawRegs->CCCTL & 0x200) titanblendmode = TITAN_BLEND_BOTTOM;
    TitanSetBlendingMode(titanblendmode);
 
    Vdp2DrawBackScreen();
@@ -2827,255 +4303,327 @@ void VIDSoftVdp2DrawStart(void)
 
 //////////////////////////////////////////////////////////////////////////////
 
-void VIDSoftVdp2DrawEnd(void)
+void VIDSoftVdp2DrawStart(void)
+{
+   // a skipped frame has no VIDSoftVdp2DrawEnd()
+   VidsoftRenderWait();
+
+   vidsoft_frame_kept = Vdp2FrameCapture();
+   vidsoft_screens_pending = 0;
+   if (vidsoft_frame_kept)
+      return;
+
+   if (vidsoft_captured)
+      Vdp2DrawCapture(&vidsoft_capture);
+   Vdp2DrawBackScreens();
+   Vdp2DrawCapture(NULL);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+/* The per-frame state of the sprite layer, drawn a line per job like the
+   scroll screens. */
+
+typedef struct
 {
-   int i, i2;
-   u16 pixel;
    u8 prioritytable[8];
+   u8 colorcalctable[8];
    u32 vdp1coloroffset;
-   int colormode = Vdp2Regs->SPCTL & 0x20;
+   int colormode;
+   int SPCCCS, SPCCN;
    vdp2draw_struct info;
    int islinewindow;
+   int wctl;
    clipping_struct clip[2];
    u32 linewnd0addr, linewnd1addr;
-   int wctl;
    clipping_struct colorcalcwindow[2];
+   vdp2rotationparameterfp_struct p;
+} vdp2spritedraw_struct;
 
-   // Figure out whether to draw vdp1 framebuffer or vdp2 framebuffer pixels
-   // based on priority
-   if (Vdp1External.disptoggle && (Vdp2Regs->TVMD & 0x8000))
-   {
-      int SPCCCS = (Vdp2Regs->SPCTL >> 12) & 0x3;
-      int SPCCN = (Vdp2Regs->SPCTL >> 8) & 0x7;
-      u8 colorcalctable[8];
-      vdp2rotationparameterfp_struct p;
-      int x, y;
-
-      prioritytable[0] = Vdp2Regs->PRISA & 0x7;
-      prioritytable[1] = (Vdp2Regs->PRISA >> 8) & 0x7;
-      prioritytable[2] = Vdp2Regs->PRISB & 0x7;
-      prioritytable[3] = (Vdp2Regs->PRISB >> 8) & 0x7;
-      prioritytable[4] = Vdp2Regs->PRISC & 0x7;
-      prioritytable[5] = (Vdp2Regs->PRISC >> 8) & 0x7;
-      prioritytable[6] = Vdp2Regs->PRISD & 0x7;
-      prioritytable[7] = (Vdp2Regs->PRISD >> 8) & 0x7;
-      colorcalctable[0] = ((~Vdp2Regs->CCRSA & 0x1F) << 1) + 1;
-      colorcalctable[1] = ((~Vdp2Regs->CCRSA >> 7) & 0x3E) + 1;
-      colorcalctable[2] = ((~Vdp2Regs->CCRSB & 0x1F) << 1) + 1;
-      colorcalctable[3] = ((~Vdp2Regs->CCRSB >> 7) & 0x3E) + 1;
-      colorcalctable[4] = ((~Vdp2Regs->CCRSC & 0x1F) << 1) + 1;
-      colorcalctable[5] = ((~Vdp2Regs->CCRSC >> 7) & 0x3E) + 1;
-      colorcalctable[6] = ((~Vdp2Regs->CCRSD & 0x1F) << 1) + 1;
-      colorcalctable[7] = ((~Vdp2Regs->CCRSD >> 7) & 0x3E) + 1;
-
-      vdp1coloroffset = (Vdp2Regs->CRAOFB & 0x70) << 4;
-      vdp1spritetype = Vdp2Regs->SPCTL & 0xF;
-
-      ReadVdp2ColorOffset(Vdp2Regs, &info, 0x40, 0x40);
-
-      wctl = Vdp2Regs->WCTLC >> 8;
-      clip[0].xstart = clip[0].ystart = clip[0].xend = clip[0].yend = 0;
-      clip[1].xstart = clip[1].ystart = clip[1].xend = clip[1].yend = 0;
-      ReadWindowData(wctl, clip);
-      linewnd0addr = linewnd1addr = 0;
-      ReadLineWindowData(&islinewindow, wctl, &linewnd0addr, &linewnd1addr);
+static vdp2spritedraw_struct vdp2sprite;
 
-      /* color calculation window: in => no color calc, out => color calc */
-      ReadWindowData(Vdp2Regs->WCTLD >> 8, colorcalcwindow);
+//////////////////////////////////////////////////////////////////////////////
 
-      if (Vdp1Regs->TVMR & 2)
-         Vdp2ReadRotationTableFP(0, &p);
+static void Vdp2DrawSpriteLine(int i2, UNUSED int thread)
+{
+   vdp2draw_struct info = vdp2sprite.info;
+   clipping_struct clip[2];
+   u32 linewnd0addr = vdp2sprite.linewnd0addr + i2 * 4;
+   u32 linewnd1addr = vdp2sprite.linewnd1addr + i2 * 4;
+   u16 pixel;
+   int i, k, x, y;
+   windowspans_struct spans;
 
-      for (i2 = 0; i2 < vdp2height; i2++)
-      {
-         ReadLineWindowClip(islinewindow, clip, &linewnd0addr, &linewnd1addr);
+   clip[0] = vdp2sprite.clip[0];
+   clip[1] = vdp2sprite.clip[1];
+   ReadLineWindowClip(vdp2sprite.islinewindow, clip, &linewnd0addr, &linewnd1addr);
 
-         LoadLineParamsSprite(&info, i2);
+   LoadLineParamsSprite(&info, i2 > 269 ? 269 : i2);
 
-         for (i = 0; i < vdp2width; i++)
+   // See which parts of the line aren't clipped
+   Vdp2ReadWindowSpans(vdp2sprite.wctl, clip, i2, vdp2width, resxratio, vdp2height, &spans);
+
+   for (k = 0; k < spans.count; k++)
+   {
+      for (i = spans.start[k]; i < spans.end[k]; i++)
+      {
+         if (Vdp1Regs->TVMR & 2) {
+            x = (touint(vdp2sprite.p.Xst + i * vdp2sprite.p.deltaX + i2 * vdp2sprite.p.deltaXst)) & (vdp1width - 1);
+            y = (touint(vdp2sprite.p.Yst + i * vdp2sprite.p.deltaY + i2 * vdp2sprite.p.deltaYst)) & (vdp1height - 1);
+         }
+         else
          {
-            // See if screen position is clipped, if it isn't, continue
-            if (!TestBothWindow(wctl, clip, i * resxratio, i2))
-            {
-               continue;
-            }
+            x = i;
+            y = i2;
+         }
 
-            if (Vdp1Regs->TVMR & 2) {
-               x = (touint(p.Xst + i * p.deltaX + i2 * p.deltaXst)) & (vdp1width - 1);
-               y = (touint(p.Yst + i * p.deltaY + i2 * p.deltaYst)) & (vdp1height - 1);
-            }
-            else
+         if (vdp1pixelsize == 2)
+         {
+            // 16-bit pixel size
+            pixel = ((u16 *)vdp1frontframebuffer)[(y * vdp1width) + x];
+
+            if (pixel == 0)
+               ;
+            else if (pixel & 0x8000 && vdp2sprite.colormode)
             {
-               x = i;
-               y = i2;
+               // 16 BPP               
+               u8 alpha = 0x3F;
+               if ((vdp2sprite.SPCCCS == 3) && TestBothWindow(Vdp2DrawRegs->WCTLD >> 8, vdp2sprite.colorcalcwindow, i, i2) && (Vdp2DrawRegs->CCCTL & 0x40))
+               {
+                  alpha = vdp2sprite.colorcalctable[0];
+                  if (Vdp2DrawRegs->CCCTL & 0x300) alpha |= 0x80;
+               }
+               // if pixel is 0x8000, only draw pixel if sprite window
+               // is disabled/sprite type 2-7. sprite types 0 and 1 are
+               // -always- drawn and sprite types 8-F are always
+               // transparent.
+               if (pixel != 0x8000 || vdp1spritetype < 2 || (vdp1spritetype < 8 && !(Vdp2DrawRegs->SPCTL & 0x10)))
+                  TitanPutPixel(vdp2sprite.prioritytable[0], i, i2, info.PostPixelFetchCalc(&info, COLSAT2YAB16(alpha, pixel)), 0);
             }
-
-            if (vdp1pixelsize == 2)
+            else
             {
-               // 16-bit pixel size
-               pixel = ((u16 *)vdp1frontframebuffer)[(y * vdp1width) + x];
+               // Color bank
+               spritepixelinfo_struct spi;
+               u8 alpha = 0x3F;
+               u32 dot;
 
-               if (pixel == 0)
-                  ;
-               else if (pixel & 0x8000 && colormode)
+               Vdp1GetSpritePixelInfo(vdp1spritetype, &pixel, &spi);
+               if (spi.normalshadow)
                {
-                  // 16 BPP               
-                  u8 alpha = 0x3F;
-                  if ((SPCCCS == 3) && TestBothWindow(Vdp2Regs->WCTLD >> 8, colorcalcwindow, i, i2) && (Vdp2Regs->CCCTL & 0x40))
-                  {
-                     alpha = colorcalctable[0];
-                     if (Vdp2Regs->CCCTL & 0x300) alpha |= 0x80;
-                  }
-                  // if pixel is 0x8000, only draw pixel if sprite window
-                  // is disabled/sprite type 2-7. sprite types 0 and 1 are
-                  // -always- drawn and sprite types 8-F are always
-                  // transparent.
-                  if (pixel != 0x8000 || vdp1spritetype < 2 || (vdp1spritetype < 8 && !(Vdp2Regs->SPCTL & 0x10)))
-                     TitanPutPixel(prioritytable[0], i, i2, info.PostPixelFetchCalc(&info, COLSAT2YAB16(alpha, pixel)), 0);
+                  TitanPutShadow(vdp2sprite.prioritytable[spi.priority], i, i2);
+                  continue;
                }
-               else
+               if (spi.msbshadow)
                {
-                  // Color bank
-                  spritepixelinfo_struct spi;
-                  u8 alpha = 0x3F;
-                  u32 dot;
-
-                  Vdp1GetSpritePixelInfo(vdp1spritetype, &pixel, &spi);
-                  if (spi.normalshadow)
-                  {
-                     TitanPutShadow(prioritytable[spi.priority], i, i2);
-                     continue;
-                  }
-                  if (spi.msbshadow)
-                  {
-                     if (Vdp2Regs->SPCTL & 0x10) {
-                        /* sprite window, not handled yet... we avoid displaying garbage */
-                     } else {
-                        /* msb shadow */
-                        if (pixel)
-                        {
-                            dot = Vdp2ColorRamGetColor(vdp1coloroffset + pixel);
-                            TitanPutPixel(prioritytable[spi.priority], i, i2, info.PostPixelFetchCalc(&info, COLSAT2YAB32(0x3F, dot)), 0);
-                        }
-                        TitanPutShadow(prioritytable[spi.priority], i, i2);
+                  if (Vdp2DrawRegs->SPCTL & 0x10) {
+                     /* sprite window, not handled yet... we avoid displaying garbage */
+                  } else {
+                     /* msb shadow */
+                     if (pixel)
+                     {
+                         dot = Vdp2ColorRamGetColor(vdp2sprite.vdp1coloroffset + pixel);
+                         TitanPutPixel(vdp2sprite.prioritytable[spi.priority], i, i2, info.PostPixelFetchCalc(&info, COLSAT2YAB32(0x3F, dot)), 0);
                      }
-                     continue;
+                     TitanPutShadow(vdp2sprite.prioritytable[spi.priority], i, i2);
                   }
+                  continue;
+               }
 
-                  dot = Vdp2ColorRamGetColor(vdp1coloroffset + pixel);
-
-                  if (TestBothWindow(Vdp2Regs->WCTLD >> 8, colorcalcwindow, i, i2) && (Vdp2Regs->CCCTL & 0x40))
-                  {
-                     int transparent = 0;
-
-                     /* Sprite color calculation */
-                     switch(SPCCCS) {
-                        case 0:
-                           if (prioritytable[spi.priority] <= SPCCN)
-                              transparent = 1;
-                           break;
-                        case 1:
-                           if (prioritytable[spi.priority] == SPCCN)
-                              transparent = 1;
-                           break;
-                        case 2:
-                           if (prioritytable[spi.priority] >= SPCCN)
-                              transparent = 1;
-                           break;
-                        case 3:
-                           if (dot & 0x80000000)
-                              transparent = 1;
-                           break;
-                     }
+               dot = Vdp2ColorRamGetColor(vdp2sprite.vdp1coloroffset + pixel);
 
-                     if (Vdp2Regs->CCCTL & 0x200) {
-                        /* "bottom" mode, the alpha channel will be used by another layer,
-                        so we set it regardless of whether sprites are transparent or not.
-                        The highest priority bit is only set if the sprite is transparent
-                        (in this case, it's the alpha channel of the lower priority layer
-                        that will be used. */
-                        alpha = colorcalctable[spi.colorcalc];
-                        if (transparent) alpha |= 0x80;
-                     } else if (transparent) {
-                        alpha = colorcalctable[spi.colorcalc];
-                        if (Vdp2Regs->CCCTL & 0x100) alpha |= 0x80;
-                     }
+               if (TestBothWindow(Vdp2DrawRegs->WCTLD >> 8, vdp2sprite.colorcalcwindow, i, i2) && (Vdp2DrawRegs->CCCTL & 0x40))
+               {
+                  int transparent = 0;
+
+                  /* Sprite color calculation */
+                  switch(vdp2sprite.SPCCCS) {
+                     case 0:
+                        if (vdp2sprite.prioritytable[spi.priority] <= vdp2sprite.SPCCN)
+                           transparent = 1;
+                        break;
+                     case 1:
+                        if (vdp2sprite.prioritytable[spi.priority] == vdp2sprite.SPCCN)
+                           transparent = 1;
+                        break;
+                     case 2:
+                        if (vdp2sprite.prioritytable[spi.priority] >= vdp2sprite.SPCCN)
+                           transparent = 1;
+                        break;
+                     case 3:
+                        if (dot & 0x80000000)
+                           transparent = 1;
+                        break;
                   }
 
-                  TitanPutPixel(prioritytable[spi.priority], i, i2, info.PostPixelFetchCalc(&info, COLSAT2YAB32(alpha, dot)), 0);
+                  if (Vdp2DrawRegs->CCCTL & 0x200) {
+                     /* "bottom" mode, the alpha channel will be used by another layer,
+                     so we set it regardless of whether sprites are transparent or not.
+                     The highest priority bit is only set if the sprite is transparent
+                     (in this case, it's the alpha channel of the lower priority layer
+                     that will be used. */
+                     alpha = vdp2sprite.colorcalctable[spi.colorcalc];
+                     if (transparent) alpha |= 0x80;
+                  } else if (transparent) {
+                     alpha = vdp2sprite.colorcalctable[spi.colorcalc];
+                     if (Vdp2DrawRegs->CCCTL & 0x100) alpha |= 0x80;
+                  }
                }
+
+               TitanPutPixel(vdp2sprite.prioritytable[spi.priority], i, i2, info.PostPixelFetchCalc(&info, COLSAT2YAB32(alpha, dot)), 0);
             }
-            else
+         }
+         else
+         {
+            // 8-bit pixel size
+            pixel = vdp1frontframebuffer[(y * vdp1width) + x];
+
+            if (pixel != 0)
             {
-               // 8-bit pixel size
-               pixel = vdp1frontframebuffer[(y * vdp1width) + x];
+               // Color bank(fix me)
+               spritepixelinfo_struct spi;
+               u8 alpha = 0x3F;
+               u32 dot;
 
-               if (pixel != 0)
+               Vdp1GetSpritePixelInfo(vdp1spritetype, &pixel, &spi);
+               if (spi.normalshadow)
                {
-                  // Color bank(fix me)
-                  spritepixelinfo_struct spi;
-                  u8 alpha = 0x3F;
-                  u32 dot;
-
-                  Vdp1GetSpritePixelInfo(vdp1spritetype, &pixel, &spi);
-                  if (spi.normalshadow)
-                  {
-                     TitanPutShadow(prioritytable[spi.priority], i, i2);
-                     continue;
-                  }
+                  TitanPutShadow(vdp2sprite.prioritytable[spi.priority], i, i2);
+                  continue;
+               }
 
-                  dot = Vdp2ColorRamGetColor(vdp1coloroffset + pixel);
-
-                  if (TestBothWindow(Vdp2Regs->WCTLD >> 8, colorcalcwindow, i, i2) && (Vdp2Regs->CCCTL & 0x40))
-                  {
-                     int transparent = 0;
-
-                     /* Sprite color calculation */
-                     switch(SPCCCS) {
-                        case 0:
-                           if (prioritytable[spi.priority] <= SPCCN)
-                              transparent = 1;
-                           break;
-                        case 1:
-                           if (prioritytable[spi.priority] == SPCCN)
-                              transparent = 1;
-                           break;
-                        case 2:
-                           if (prioritytable[spi.priority] >= SPCCN)
-                              transparent = 1;
-                           break;
-                        case 3:
-                           if (dot & 0x80000000)
-                              transparent = 1;
-                           break;
-                     }
+               dot = Vdp2ColorRamGetColor(vdp2sprite.vdp1coloroffset + pixel);
 
-                     if (Vdp2Regs->CCCTL & 0x200) {
-                        /* "bottom" mode, the alpha channel will be used by another layer,
-                        so we set it regardless of whether sprites are transparent or not.
-                        The highest priority bit is only set if the sprite is transparent
-                        (in this case, it's the alpha channel of the lower priority layer
-                        that will be used. */
-                        alpha = colorcalctable[spi.colorcalc];
-                        if (transparent) alpha |= 0x80;
-                     } else if (transparent) {
-                        alpha = colorcalctable[spi.colorcalc];
-                        if (Vdp2Regs->CCCTL & 0x100) alpha |= 0x80;
-                     }
+               if (TestBothWindow(Vdp2DrawRegs->WCTLD >> 8, vdp2sprite.colorcalcwindow, i, i2) && (Vdp2DrawRegs->CCCTL & 0x40))
+               {
+                  int transparent = 0;
+
+                  /* Sprite color calculation */
+                  switch(vdp2sprite.SPCCCS) {
+                     case 0:
+                        if (vdp2sprite.prioritytable[spi.priority] <= vdp2sprite.SPCCN)
+                           transparent = 1;
+                        break;
+                     case 1:
+                        if (vdp2sprite.prioritytable[spi.priority] == vdp2sprite.SPCCN)
+                           transparent = 1;
+                        break;
+                     case 2:
+                        if (vdp2sprite.prioritytable[spi.priority] >= vdp2sprite.SPCCN)
+                           transparent = 1;
+                        break;
+                     case 3:
+                        if (dot & 0x80000000)
+                           transparent = 1;
+                        break;
                   }
 
-                  TitanPutPixel(prioritytable[spi.priority], i, i2, info.PostPixelFetchCalc(&info, COLSAT2YAB32(alpha, dot)), 0);
+                  if (Vdp2DrawRegs->CCCTL & 0x200) {
+                     /* "bottom" mode, the alpha channel will be used by another layer,
+                     so we set it regardless of whether sprites are transparent or not.
+                     The highest priority bit is only set if the sprite is transparent
+                     (in this case, it's the alpha channel of the lower priority layer
+                     that will be used. */
+                     alpha = vdp2sprite.colorcalctable[spi.colorcalc];
+                     if (transparent) alpha |= 0x80;
+                  } else if (transparent) {
+                     alpha = vdp2sprite.colorcalctable[spi.colorcalc];
+                     if (Vdp2DrawRegs->CCCTL & 0x100) alpha |= 0x80;
+                  }
                }
+
+               TitanPutPixel(vdp2sprite.prioritytable[spi.priority], i, i2, info.PostPixelFetchCalc(&info, COLSAT2YAB32(alpha, dot)), 0);
             }
          }
       }
    }
-   TitanRender(dispbuffer);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void Vdp2RenderLine(int j, UNUSED int thread)
+{
+   TitanRenderLines(dispbuffer, j, j + 1);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void VIDSoftVdp2DrawEnd(void)
+{
+   int i;
+
+   VidsoftRenderWait();
+
+   if (Vdp2FrameSpritesUnchanged())
+      goto present;
+
+   if (vidsoft_frame_kept)
+   {
+      // the screens did change after all, with the sprites
+      Vdp2DrawCapture(&vidsoft_capture);
+      Vdp2DrawBackScreens();
+      if (vidsoft_screens_pending)
+      {
+         Vdp2DrawScreensSetup();
+         Vdp2DrawLayers();
+      }
+      Vdp2DrawCapture(NULL);
+   }
+
+   // Figure out whether to draw vdp1 framebuffer or vdp2 framebuffer pixels
+   // based on priority
+   if (Vdp1External.disptoggle && (Vdp2DrawRegs->TVMD & 0x8000))
+   {
+      vdp2sprite.SPCCCS = (Vdp2DrawRegs->SPCTL >> 12) & 0x3;
+      vdp2sprite.SPCCN = (Vdp2DrawRegs->SPCTL >> 8) & 0x7;
+      vdp2sprite.colormode = Vdp2DrawRegs->SPCTL & 0x20;
+
+      vdp2sprite.prioritytable[0] = Vdp2DrawRegs->PRISA & 0x7;
+      vdp2sprite.prioritytable[1] = (Vdp2DrawRegs->PRISA >> 8) & 0x7;
+      vdp2sprite.prioritytable[2] = Vdp2DrawRegs->PRISB & 0x7;
+      vdp2sprite.prioritytable[3] = (Vdp2DrawRegs->PRISB >> 8) & 0x7;
+      vdp2sprite.prioritytable[4] = Vdp2DrawRegs->PRISC & 0x7;
+      vdp2sprite.prioritytable[5] = (Vdp2DrawRegs->PRISC >> 8) & 0x7;
+      vdp2sprite.prioritytable[6] = Vdp2DrawRegs->PRISD & 0x7;
+      vdp2sprite.prioritytable[7] = (Vdp2DrawRegs->PRISD >> 8) & 0x7;
+      vdp2sprite.colorcalctable[0] = ((~Vdp2DrawRegs->CCRSA & 0x1F) << 1) + 1;
+      vdp2sprite.colorcalctable[1] = ((~Vdp2DrawRegs->CCRSA >> 7) & 0x3E) + 1;
+      vdp2sprite.colorcalctable[2] = ((~Vdp2DrawRegs->CCRSB & 0x1F) << 1) + 1;
+      vdp2sprite.colorcalctable[3] = ((~Vdp2DrawRegs->CCRSB >> 7) & 0x3E) + 1;
+      vdp2sprite.colorcalctable[4] = ((~Vdp2DrawRegs->CCRSC & 0x1F) << 1) + 1;
+      vdp2sprite.colorcalctable[5] = ((~Vdp2DrawRegs->CCRSC >> 7) & 0x3E) + 1;
+      vdp2sprite.colorcalctable[6] = ((~Vdp2DrawRegs->CCRSD & 0x1F) << 1) + 1;
+      vdp2sprite.colorcalctable[7] = ((~Vdp2DrawRegs->CCRSD >> 7) & 0x3E) + 1;
+
+      vdp2sprite.vdp1coloroffset = (Vdp2DrawRegs->CRAOFB & 0x70) << 4;
+      vdp1spritetype = Vdp2DrawRegs->SPCTL & 0xF;
+
+      ReadVdp2ColorOffset(Vdp2DrawRegs, &vdp2sprite.info, 0x40, 0x40);
+
+      vdp2sprite.wctl = Vdp2DrawRegs->WCTLC >> 8;
+      vdp2sprite.clip[0].xstart = vdp2sprite.clip[0].ystart = vdp2sprite.clip[0].xend = vdp2sprite.clip[0].yend = 0;
+      vdp2sprite.clip[1].xstart = vdp2sprite.clip[1].ystart = vdp2sprite.clip[1].xend = vdp2sprite.clip[1].yend = 0;
+      ReadWindowData(vdp2sprite.wctl, vdp2sprite.clip);
+      vdp2sprite.linewnd0addr = vdp2sprite.linewnd1addr = 0;
+      ReadLineWindowData(&vdp2sprite.islinewindow, vdp2sprite.wctl, &vdp2sprite.linewnd0addr, &vdp2sprite.linewnd1addr);
+
+      /* color calculation window: in => no color calc, out => color calc */
+      ReadWindowData(Vdp2DrawRegs->WCTLD >> 8, vdp2sprite.colorcalcwindow);
+
+      if (Vdp1Regs->TVMR & 2)
+         Vdp2ReadRotationTableFP(0, &vdp2sprite.p);
+
+      VidsoftRunJobs(Vdp2DrawSpriteLine, vdp2height);
+   }
+   VidsoftRunJobs(Vdp2RenderLine, vdp2height);
+   vidsoft_frame_valid = vidsoft_captured;
 
+present:
+   vidsoft_frame_kept = 0;
    VIDSoftVdp1SwapFrameBuffer();
 
-   if (OSDUseBuffer())
-      OSDDisplayMessages(dispbuffer, vdp2width, vdp2height);
+   // messages drawn over the frame make it a different one
+   if (OSDUseBuffer() && OSDDisplayMessages(dispbuffer, vdp2width, vdp2height))
+      vidsoft_frame_valid = 0;
 
 #ifdef USE_OPENGL	
 	if (vdp2height == 224)
@@ -3096,17 +4644,10 @@ void VIDSoftVdp2DrawEnd(void)
 
 //////////////////////////////////////////////////////////////////////////////
 
-void VIDSoftVdp2DrawScreens(void)
+static void Vdp2DrawLayers(void)
 {
    int i;
 
-   VIDSoftVdp2SetResolution(Vdp2Regs->TVMD);
-   VIDSoftVdp2SetPriorityNBG0(Vdp2Regs->PRINA & 0x7);
-   VIDSoftVdp2SetPriorityNBG1((Vdp2Regs->PRINA >> 8) & 0x7);
-   VIDSoftVdp2SetPriorityNBG2(Vdp2Regs->PRINB & 0x7);
-   VIDSoftVdp2SetPriorityNBG3((Vdp2Regs->PRINB >> 8) & 0x7);
-   VIDSoftVdp2SetPriorityRBG0(Vdp2Regs->PRIR & 0x7);
-
    for (i = 7; i > 0; i--)
    {   
       if (nbg3priority == i)
@@ -3124,14 +4665,51 @@ void VIDSoftVdp2DrawScreens(void)
 
 //////////////////////////////////////////////////////////////////////////////
 
+// Sets up for drawing the screens, pointing Vdp2DrawRegs and co. at the
+// capture if there is one.
+static void Vdp2DrawScreensSetup(void)
+{
+   if (vidsoft_captured)
+      Vdp2DrawCapture(&vidsoft_capture);
+
+   VIDSoftVdp2SetResolution(Vdp2DrawRegs->TVMD);
+   VIDSoftVdp2SetPriorityNBG0(Vdp2DrawRegs->PRINA & 0x7);
+   VIDSoftVdp2SetPriorityNBG1((Vdp2DrawRegs->PRINA >> 8) & 0x7);
+   VIDSoftVdp2SetPriorityNBG2(Vdp2DrawRegs->PRINB & 0x7);
+   VIDSoftVdp2SetPriorityNBG3((Vdp2DrawRegs->PRINB >> 8) & 0x7);
+   VIDSoftVdp2SetPriorityRBG0(Vdp2DrawRegs->PRIR & 0x7);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void VIDSoftVdp2DrawScreens(void)
+{
+   if (vidsoft_frame_kept)
+   {
+      // left for VIDSoftVdp2DrawEnd() to decide
+      vidsoft_screens_pending = 1;
+      return;
+   }
+
+   Vdp2DrawScreensSetup();
+   if (vidsoft_captured && vidsoft_render_running)
+      VidsoftRenderStart();
+   else
+   {
+      Vdp2DrawLayers();
+      Vdp2DrawCapture(NULL);
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void VIDSoftVdp2DrawScreen(int screen)
 {
-   VIDSoftVdp2SetResolution(Vdp2Regs->TVMD);
-   VIDSoftVdp2SetPriorityNBG0(Vdp2Regs->PRINA & 0x7);
-   VIDSoftVdp2SetPriorityNBG1((Vdp2Regs->PRINA >> 8) & 0x7);
-   VIDSoftVdp2SetPriorityNBG2(Vdp2Regs->PRINB & 0x7);
-   VIDSoftVdp2SetPriorityNBG3((Vdp2Regs->PRINB >> 8) & 0x7);
-   VIDSoftVdp2SetPriorityRBG0(Vdp2Regs->PRIR & 0x7);
+   // always drawn right away
+   VidsoftRenderWait();
+   Vdp2FrameCapture();
+   vidsoft_frame_valid = vidsoft_frame_kept = 0;
+   Vdp2DrawScreensSetup();
    switch(screen)
    {
       case 0:
@@ -3150,6 +4728,7 @@ void VIDSoftVdp2DrawScreen(int screen)
          Vdp2DrawRBG0();
          break;
    }
+   Vdp2DrawCapture(NULL);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -3268,39 +4847,53 @@ void VIDSoftVdp1SwapFrameBuffer(void)
    if (((Vdp1Regs->FBCR & 2) == 0) || Vdp1External.manualchange)
    {
       u8 *temp = vdp1frontframebuffer;
+      u32 stamp = vdp1frontstamp;
       vdp1frontframebuffer = vdp1backframebuffer;
       vdp1backframebuffer = temp;
+      vdp1frontstamp = vdp1backstamp;
+      vdp1backstamp = stamp;
       Vdp1External.manualchange = 0;
    }
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
+// The part of the framebuffer erased by VIDSoftVdp1EraseFrameBuffer(), x2
+// and y2 exclusive
+static void Vdp1EraseWindow(int *x1, int *y1, int *x2, int *y2)
+{
+   *x1 = (Vdp1Regs->EWLR >> 6) & 0x1F8;
+   *y1 = Vdp1Regs->EWLR & 0x1FF;
+   *x2 = ((Vdp1Regs->EWRR >> 6) & 0x3F8) + 8;
+   if (*x2 > vdp1width) *x2 = vdp1width;
+   *y2 = (Vdp1Regs->EWRR & 0x1FF) + 1;
+   if (*y2 > vdp1height) *y2 = vdp1height;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void VIDSoftVdp1EraseFrameBuffer(void)
 {   
    int i,i2;
-   int w,h;
+   int x1,y1,w,h;
 
    if (((Vdp1Regs->FBCR & 2) == 0) || Vdp1External.manualerase)
    {
-      h = (Vdp1Regs->EWRR & 0x1FF) + 1;
-      if (h > vdp1height) h = vdp1height;
-      w = ((Vdp1Regs->EWRR >> 6) & 0x3F8) + 8;
-      if (w > vdp1width) w = vdp1width;
+      Vdp1EraseWindow(&x1, &y1, &w, &h);
 
       if (vdp1pixelsize == 2)
       {
-         for (i2 = (Vdp1Regs->EWLR & 0x1FF); i2 < h; i2++)
+         for (i2 = y1; i2 < h; i2++)
          {
-            for (i = ((Vdp1Regs->EWLR >> 6) & 0x1F8); i < w; i++)
+            for (i = x1; i < w; i++)
                ((u16 *)vdp1backframebuffer)[(i2 * vdp1width) + i] = Vdp1Regs->EWDR;
          }
       }
       else
       {
-         for (i2 = (Vdp1Regs->EWLR & 0x1FF); i2 < h; i2++)
+         for (i2 = y1; i2 < h; i2++)
          {
-            for (i = ((Vdp1Regs->EWLR >> 6) & 0x1F8); i < w; i++)
+            for (i = x1; i < w; i++)
                vdp1backframebuffer[(i2 * vdp1width) + i] = Vdp1Regs->EWDR & 0xFF;
          }
       }
@@ -30,4 +30,13 @@ extern VideoInterface_struct VIDSoft;
 
 void VIDSoftVdp2DrawScreen(int screen);
 
+// Number of threads used for rendering, including the emulation thread.
+// Only used when threads are enabled; 0 picks one per processor.
+void VIDSoftSetNumThreads(int num);
+
+// Draws the screens of each frame on a thread of their own, from a copy of
+// the VDP2 state taken at VBlank, while the next frame is emulated. Only
+// used when threads are enabled.
+void VIDSoftSetPipelined(int on);
+
 #endif
@@ -107,6 +107,7 @@ void print_usage(const char *program_name) {
    printf("   -ns        --nosound              turn sound off\n");
    printf("   -a         --autostart            autostart emulation\n");
    printf("   -f         --fullscreen           start in fullscreen mode\n");
+   printf("              --no-render            emulate without drawing anything\n");
 }
 #endif
 
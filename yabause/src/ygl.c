@@ -26,6 +26,7 @@
 #ifdef HAVE_LIBGL
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #include "ygl.h"
 #include "yui.h"
 #include "vidshared.h"
@@ -40,14 +41,65 @@
 YglTextureManager * YglTM;
 Ygl * _Ygl;
 
+// The atlas is cut into shelves: bands of rows filled left to right with
+// textures of about the same height. Shelves with cached textures in them
+// stay from frame to frame, the least recently used one is given up when
+// there's no room left. The others are given back at the start of a frame.
 typedef struct
 {
-   u32 id;
+   unsigned int y;
+   unsigned int h;        // 0 if the slot isn't in use
+   unsigned int x;        // next free column
+   int isfree;            // vertical space nothing is allocated in
+   int entries;           // cache entries pointing in here
+   u32 gen;               // bumped when given back, stales those entries
+   u32 lastused;          // YglTM->frame
+   unsigned int dirtyx1;  // columns written since the last upload
+   unsigned int dirtyx2;
+} YglShelf;
+
+#define YGL_MAX_SHELVES 512
+
+static YglShelf shelves[YGL_MAX_SHELVES];
+static int lastshelf = -1; // shelf of the last allocation, for YglCacheAdd()
+
+// Textures that don't fit in the atlas are decoded here and thrown away
+static unsigned int * scratchtexture = NULL;
+static unsigned int scratchsize = 0;
+
+typedef struct
+{
+   YglCacheKey key;
    YglCache c;
+   int shelf;
+   u32 shelfgen;
+   u32 built;             // cacheepoch the texels were decoded in
+   u32 checked;           // last cacheepoch they were found up to date
+   int next;              // in the hash chain or the free list
 } cache_struct;
 
+#define YGL_CACHE_SIZE      0x8000
+#define YGL_CACHE_HASH_SIZE 0x2000
+
 static cache_struct *cachelist;
-static int cachelistsize=0;
+static int cachefree = -1;
+// first entry of each hash chain, -1 when empty
+static int cachehash[YGL_CACHE_HASH_SIZE];
+
+// Bumped each time dirty flags are picked up. Every 256 bytes of VDP1 and
+// VDP2 RAM, and color RAM, remember the last one they were written in.
+static u32 cacheepoch;
+static u32 cacheramepoch[2][0x80000 >> 8];
+static u32 cachecolorramepoch;
+
+#define YglCacheHash(key) (((key)->addr ^ ((key)->addr >> 13) ^ ((key)->w << 7) ^ ((key)->h << 11) ^ \
+                            (key)->palette ^ ((key)->palette >> 9) ^ ((key)->mode << 3) ^ (key)->state ^ \
+                            (key)->frame) & (YGL_CACHE_HASH_SIZE - 1))
+
+// Vertex/texture coordinate stream shared by every program in a frame. It's
+// orphaned at the start of YglRender and filled front to back, so the driver
+// never has to wait on a draw from the previous frame.
+#define YGL_VERTEX_BUFFER_SIZE 0x400000
 
 typedef struct
 {
@@ -126,6 +178,15 @@ PFNGLBLITFRAMEBUFFERPROC glBlitFramebuffer;
 PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC glRenderbufferStorageMultisample;
 PFNGLFRAMEBUFFERTEXTURELAYERPROC glFramebufferTextureLayer;
 
+//GL_ARB_vertex_buffer_object
+PFNGLGENBUFFERSPROC glGenBuffers;
+PFNGLDELETEBUFFERSPROC glDeleteBuffers;
+PFNGLBINDBUFFERPROC glBindBuffer;
+PFNGLBUFFERDATAPROC glBufferData;
+PFNGLBUFFERSUBDATAPROC glBufferSubData;
+PFNGLMAPBUFFERPROC glMapBuffer;
+PFNGLUNMAPBUFFERPROC glUnmapBuffer;
+
 PFNGLUNIFORM4FPROC glUniform4f;
 PFNGLUNIFORM1FPROC glUniform1f;
 PFNGLUNIFORMMATRIX4FVPROC glUniformMatrix4fv;
@@ -188,6 +249,13 @@ GLAPI void APIENTRY glGenerateMipmapdmy (GLenum target){}
 GLAPI void APIENTRY glBlitFramebufferdmy (GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter){}
 GLAPI void APIENTRY glRenderbufferStorageMultisampledmy (GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height){}
 GLAPI void APIENTRY glFramebufferTextureLayerdmy (GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer){}
+GLAPI void APIENTRY glGenBuffersdmy (GLsizei n, GLuint *buffers){*buffers=0;}
+GLAPI void APIENTRY glDeleteBuffersdmy (GLsizei n, const GLuint *buffers){}
+GLAPI void APIENTRY glBindBufferdmy (GLenum target, GLuint buffer){}
+GLAPI void APIENTRY glBufferDatadmy (GLenum target, GLsizeiptr size, const GLvoid *data, GLenum usage){}
+GLAPI void APIENTRY glBufferSubDatadmy (GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid *data){}
+GLAPI GLvoid* APIENTRY glMapBufferdmy (GLenum target, GLenum access){return NULL;}
+GLAPI GLboolean APIENTRY glUnmapBufferdmy (GLenum target){return GL_FALSE;}
 GLAPI void APIENTRY glUniform4fdmy(GLint location, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3){}
 GLAPI void APIENTRY glUniform1fdmy (GLint location, GLfloat v0){}
 GLAPI void APIENTRY glUniformMatrix4fvdmy (GLint location, GLsizei count, GLboolean transpose, const GLfloat *value){}
@@ -422,6 +490,12 @@ void YglTMInit(unsigned int w, unsigned int h) {
    YglTM->texture = (unsigned int *) malloc(sizeof(unsigned int) * w * h);
    YglTM->width = w;
    YglTM->height = h;
+   YglTM->frame = 0;
+
+   memset(shelves, 0, sizeof(shelves));
+   shelves[0].h = h;
+   shelves[0].isfree = 1;
+   lastshelf = -1;
 
    YglTMReset();
 }
@@ -431,41 +505,204 @@ void YglTMInit(unsigned int w, unsigned int h) {
 void YglTMDeInit(void) {
    free(YglTM->texture);
    free(YglTM);
+   free(scratchtexture);
+   scratchtexture = NULL;
+   scratchsize = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Gives a shelf back and merges it with the free space around it
+static void YglTMFreeShelf(int i) {
+   YglShelf * shelf = &shelves[i];
+   int j;
+
+   shelf->isfree = 1;
+   shelf->entries = 0;
+   shelf->gen++;
+   shelf->x = 0;
+   shelf->dirtyx1 = shelf->dirtyx2 = 0;
+   if (lastshelf == i)
+      lastshelf = -1;
+
+   for (j = 0; j < YGL_MAX_SHELVES; j++)
+   {
+      YglShelf * other = &shelves[j];
+
+      if (j == i || other->h == 0 || !other->isfree)
+         continue;
+
+      if (other->y == shelf->y + shelf->h)
+      {
+         shelf->h += other->h;
+         other->h = 0;
+      }
+      else if (other->y + other->h == shelf->y)
+      {
+         other->h += shelf->h;
+         shelf->h = 0;
+         shelf = other;
+         i = j;
+         j = -1; // look again for the space below
+      }
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Takes the smallest free space that fits a shelf h rows high, returns the
+// new shelf or -1
+static int YglTMNewShelf(unsigned int h) {
+   int best = -1;
+   int unused = -1;
+   int i;
+
+   for (i = 0; i < YGL_MAX_SHELVES; i++)
+   {
+      if (shelves[i].h == 0)
+      {
+         if (unused == -1)
+            unused = i;
+      }
+      else if (shelves[i].isfree && shelves[i].h >= h &&
+               (best == -1 || shelves[i].h < shelves[best].h))
+         best = i;
+   }
+
+   if (best == -1 || (shelves[best].h > h && unused == -1))
+      return -1;
+
+   if (shelves[best].h > h)
+   {
+      shelves[unused].y = shelves[best].y + h;
+      shelves[unused].h = shelves[best].h - h;
+      shelves[unused].isfree = 1;
+      shelves[unused].x = 0;
+      shelves[unused].entries = 0;
+      shelves[unused].dirtyx1 = shelves[unused].dirtyx2 = 0;
+      shelves[best].h = h;
+   }
+
+   shelves[best].isfree = 0;
+   shelves[best].x = 0;
+   shelves[best].entries = 0;
+   shelves[best].lastused = YglTM->frame;
+   return best;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Gives back the least recently used shelf, if one wasn't drawn from this
+// frame. Returns 0 when there was none.
+static int YglTMEvict(void) {
+   int lru = -1;
+   int i;
+
+   for (i = 0; i < YGL_MAX_SHELVES; i++)
+   {
+      if (shelves[i].h == 0 || shelves[i].isfree || shelves[i].lastused == YglTM->frame)
+         continue;
+      if (lru == -1 || (s32)(shelves[i].lastused - shelves[lru].lastused) < 0)
+         lru = i;
+   }
+
+   if (lru == -1)
+      return 0;
+   YglTMFreeShelf(lru);
+   return 1;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
 void YglTMReset(void) {
-   YglTM->currentX = 0;
-   YglTM->currentY = 0;
-   YglTM->yMax = 0;
+   int i;
+
+   YglTM->frame++;
+
+   // Textures no cache entry points to were for the last frame only
+   for (i = 0; i < YGL_MAX_SHELVES; i++)
+   {
+      if (shelves[i].h != 0 && !shelves[i].isfree && shelves[i].entries == 0)
+         YglTMFreeShelf(i);
+   }
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
 void YglTMAllocate(YglTexture * output, unsigned int w, unsigned int h, unsigned int * x, unsigned int * y) {
-   if ((YglTM->height - YglTM->currentY) < h) {
+   unsigned int shelfh;
+   int i;
+
+   // Shelves are a power of two up to 64 rows high, a multiple of 32 above
+   if (h <= 8)
+      shelfh = 8;
+   else if (h <= 64)
+   {
+      shelfh = 16;
+      while (shelfh < h)
+         shelfh <<= 1;
+   }
+   else
+      shelfh = (h + 31) & ~31;
+
+   for (i = 0; i < YGL_MAX_SHELVES; i++)
+   {
+      if (shelves[i].h == shelfh && !shelves[i].isfree && YglTM->width - shelves[i].x >= w)
+         break;
+   }
+
+   if (i == YGL_MAX_SHELVES && w <= YglTM->width)
+   {
+      while ((i = YglTMNewShelf(shelfh)) == -1 && YglTMEvict())
+         ;
+   }
+
+   if (i < 0 || i == YGL_MAX_SHELVES) {
       fprintf(stderr, "can't allocate texture: %dx%d\n", w, h);
       *x = *y = 0;
+      lastshelf = -1;
+      if (w * h > scratchsize)
+      {
+         scratchsize = w * h;
+         scratchtexture = (unsigned int *) realloc(scratchtexture, sizeof(unsigned int) * scratchsize);
+      }
       output->w = 0;
-      output->textdata = YglTM->texture;
+      output->textdata = scratchtexture;
       return;
    }
 
-   if ((YglTM->width - YglTM->currentX) >= w) {
-      *x = YglTM->currentX;
-      *y = YglTM->currentY;
-      output->w = YglTM->width - w;
-      output->textdata = YglTM->texture + YglTM->currentY * YglTM->width + YglTM->currentX;
-      YglTM->currentX += w;
-      if ((YglTM->currentY + h) > YglTM->yMax)
-         YglTM->yMax = YglTM->currentY + h;
-   }
-   else {
-      YglTM->currentX = 0;
-      YglTM->currentY = YglTM->yMax;
-      YglTMAllocate(output, w, h, x, y);
+   *x = shelves[i].x;
+   *y = shelves[i].y;
+   output->w = YglTM->width - w;
+   output->textdata = YglTM->texture + shelves[i].y * YglTM->width + shelves[i].x;
+
+   if (shelves[i].dirtyx1 == shelves[i].dirtyx2)
+      shelves[i].dirtyx1 = shelves[i].x;
+   shelves[i].x += w;
+   shelves[i].dirtyx2 = shelves[i].x;
+   shelves[i].lastused = YglTM->frame;
+   lastshelf = i;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Sends the parts of the atlas written since the last call to the texture
+void YglTMUpload(void) {
+   int i;
+
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, YglTM->width);
+   for (i = 0; i < YGL_MAX_SHELVES; i++)
+   {
+      YglShelf * shelf = &shelves[i];
+
+      if (shelf->h == 0 || shelf->dirtyx1 == shelf->dirtyx2)
+         continue;
+
+      glTexSubImage2D(GL_TEXTURE_2D, 0, shelf->dirtyx1, shelf->y, shelf->dirtyx2 - shelf->dirtyx1, shelf->h,
+                      GL_RGBA, GL_UNSIGNED_BYTE, YglTM->texture + shelf->y * YglTM->width + shelf->dirtyx1);
+      shelf->dirtyx1 = shelf->dirtyx2 = 0;
    }
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -701,6 +938,20 @@ int YglInit(int width, int height, unsigned int depth) {
    if( glRenderbufferStorageMultisample == NULL ) glRenderbufferStorageMultisample = glRenderbufferStorageMultisampledmy;
    glFramebufferTextureLayer = (PFNGLFRAMEBUFFERTEXTURELAYERPROC)yglGetProcAddress("glFramebufferTextureLayerEXT");   
    if( glFramebufferTextureLayer == NULL ) glFramebufferTextureLayer = glFramebufferTextureLayerdmy;
+   glGenBuffers = (PFNGLGENBUFFERSPROC)yglGetProcAddress("glGenBuffers");
+   if( glGenBuffers == NULL ) glGenBuffers = glGenBuffersdmy;
+   glDeleteBuffers = (PFNGLDELETEBUFFERSPROC)yglGetProcAddress("glDeleteBuffers");
+   if( glDeleteBuffers == NULL ) glDeleteBuffers = glDeleteBuffersdmy;
+   glBindBuffer = (PFNGLBINDBUFFERPROC)yglGetProcAddress("glBindBuffer");
+   if( glBindBuffer == NULL ) glBindBuffer = glBindBufferdmy;
+   glBufferData = (PFNGLBUFFERDATAPROC)yglGetProcAddress("glBufferData");
+   if( glBufferData == NULL ) glBufferData = glBufferDatadmy;
+   glBufferSubData = (PFNGLBUFFERSUBDATAPROC)yglGetProcAddress("glBufferSubData");
+   if( glBufferSubData == NULL ) glBufferSubData = glBufferSubDatadmy;
+   glMapBuffer = (PFNGLMAPBUFFERPROC)yglGetProcAddress("glMapBuffer");
+   if( glMapBuffer == NULL ) glMapBuffer = glMapBufferdmy;
+   glUnmapBuffer = (PFNGLUNMAPBUFFERPROC)yglGetProcAddress("glUnmapBuffer");
+   if( glUnmapBuffer == NULL ) glUnmapBuffer = glUnmapBufferdmy;
    glUniform4f = (PFNGLUNIFORM4FPROC)yglGetProcAddress("glUniform4f");
    if( glUniform4f == NULL ) glUniform4f = glUniform4fdmy;
    glUniformMatrix4fv = (PFNGLUNIFORMMATRIX4FVPROC)yglGetProcAddress("glUniformMatrix4fv");
@@ -751,11 +1002,34 @@ int YglInit(int width, int height, unsigned int depth) {
    
    glBindFramebuffer(GL_FRAMEBUFFER, 0 );   
    
+   if( YglGetProgramId(PG_VDP2_DECODEPAGE) != 0 )
+   {
+      _Ygl->vdp2ram = YglUploadTexture(0, 512, 256, NULL);
+      _Ygl->vdp2colorram = YglUploadTexture(0, 64, 32, NULL);
+      glGenFramebuffers(1, &_Ygl->vdp2fbo);
+   }
+
+   // Without buffer objects vertexbuffer stays 0 and programs are drawn
+   // straight from their client side arrays
+   glGenBuffers(1, &_Ygl->vertexbuffer);
+   if( _Ygl->vertexbuffer != 0 )
+   {
+      glBindBuffer(GL_ARRAY_BUFFER, _Ygl->vertexbuffer);
+      glBufferData(GL_ARRAY_BUFFER, YGL_VERTEX_BUFFER_SIZE, NULL, GL_STREAM_DRAW);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+   }
+   _Ygl->vertexbufferpos = 0;
+   
+   // Storage is given at each readback, the window size may have changed
+   glGenBuffers(2, _Ygl->vdp1pbo);
+   _Ygl->vdp1readback = -1;
+   
    _Ygl->st = 0;
 
    // This is probably wrong, but it'll have to do for now
-   if ((cachelist = (cache_struct *)malloc(0x100000 / 8 * sizeof(cache_struct))) == NULL)
+   if ((cachelist = (cache_struct *)malloc(YGL_CACHE_SIZE * sizeof(cache_struct))) == NULL)
       return -1;
+   YglCacheReset();
 
    return 0;
 }
@@ -790,6 +1064,17 @@ void YglDeInit(void) {
 
       free(_Ygl->messagebuf);
 
+      if (_Ygl->vertexbuffer)
+         glDeleteBuffers(1, &_Ygl->vertexbuffer);
+
+      if (_Ygl->vdp1pbo[0])
+         glDeleteBuffers(2, _Ygl->vdp1pbo);
+
+      YglDeleteTexture(_Ygl->vdp2ram);
+      YglDeleteTexture(_Ygl->vdp2colorram);
+      if (_Ygl->vdp2fbo)
+         glDeleteFramebuffers(1, &_Ygl->vdp2fbo);
+
       free(_Ygl);
    }
 
@@ -822,7 +1107,7 @@ void YglEndWindow( vdp2draw_struct * info )
 
 //////////////////////////////////////////////////////////////////////////////
 
-YglProgram * YglGetProgram( YglSprite * input, int prg )
+YglProgram * YglGetProgram( YglSprite * input, int prg, GLuint texture )
 {
    YglLevel   *level;
    YglProgram *program;
@@ -869,8 +1154,9 @@ YglProgram * YglGetProgram( YglSprite * input, int prg )
    
    }
    
-   if( level->prg[level->prgcurrent].prgid != prg ) {
+   if( level->prg[level->prgcurrent].prgid != prg || level->prg[level->prgcurrent].texture != texture ) {
       YglProgramChange(level,prg);
+      level->prg[level->prgcurrent].texture = texture;
    }
    program = &level->prg[level->prgcurrent];
    
@@ -879,7 +1165,6 @@ YglProgram * YglGetProgram( YglSprite * input, int prg )
       program->quads = (int *) realloc(program->quads, program->maxQuad * sizeof(int));
       program->textcoords = (float *) realloc(program->textcoords, program->maxQuad * sizeof(float) * 2);
       program->vertexAttribute = (float *) realloc(program->vertexAttribute, program->maxQuad * sizeof(float)*2);          
-      YglCacheReset();
    }
    
    return program;
@@ -905,7 +1190,7 @@ float * YglQuad(YglSprite * input, YglTexture * output, YglCache * c) {
       prg = PG_VFP1_HALFTRANS;
    }
 
-   program = YglGetProgram(input,prg);
+   program = YglGetProgram(input,prg,0);
    if( program == NULL ) return NULL;
    
    
@@ -1032,7 +1317,7 @@ int YglQuadGrowShading(YglSprite * input, YglTexture * output, float * colors,Yg
    }
    
    
-   program = YglGetProgram(input,prg);
+   program = YglGetProgram(input,prg,0);
    if( program == NULL ) return -1;
 
    // Vertex
@@ -1183,7 +1468,7 @@ void YglCachedQuad(YglSprite * input, YglCache * cache) {
       prg = PG_VFP1_HALFTRANS;
    }
   
-   program = YglGetProgram(input,prg);
+   program = YglGetProgram(input,prg,0);
    if( program == NULL ) return;
    
    x = cache->x;
@@ -1261,6 +1546,160 @@ void YglCachedQuad(YglSprite * input, YglCache * cache) {
 
 //////////////////////////////////////////////////////////////////////////////
 
+void YglTextureQuad(YglSprite * input, GLuint texture) {
+   YglProgram * program;
+   texturecoordinate_struct *tmp;
+   int prg = PG_NORMAL;
+   int * pos;
+   int i;
+
+   if( (input->blendmode&0x03) == 2 )
+   {
+      prg = PG_VDP2_ADDBLEND;
+   }
+
+   program = YglGetProgram(input,prg,texture);
+   if( program == NULL ) return;
+
+   // Vertex
+   pos = program->quads + program->currentQuad;
+   pos[0] = input->vertices[0];
+   pos[1] = input->vertices[1];
+   pos[2] = input->vertices[2];
+   pos[3] = input->vertices[3];   
+   pos[4] = input->vertices[4];
+   pos[5] = input->vertices[5];   
+   pos[6] = input->vertices[0];
+   pos[7] = input->vertices[1];
+   pos[8] = input->vertices[4];
+   pos[9] = input->vertices[5];   
+   pos[10] = input->vertices[6];
+   pos[11] = input->vertices[7]; 
+
+   tmp = (texturecoordinate_struct *)(program->textcoords + (program->currentQuad * 2));
+
+   program->currentQuad += 12;
+
+   // The texture matrix is set up for the atlas, so the whole texture spans
+   // the atlas size whatever its own size is
+   tmp[0].s = tmp[3].s = tmp[5].s = 0.0f;
+   tmp[1].s = tmp[2].s = tmp[4].s = (float)YglTM->width;
+   tmp[0].t = tmp[1].t = tmp[3].t = 0.0f;
+   tmp[2].t = tmp[4].t = tmp[5].t = (float)YglTM->height;
+
+   for (i = 0; i < 6; i++)
+   {
+      tmp[i].r = 0;
+      tmp[i].q = 1.0f;
+   }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+GLuint YglUploadTexture(GLuint texture, unsigned int w, unsigned int h, const unsigned int * data) {
+   if (texture == 0)
+   {
+      glGenTextures(1, &texture);
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+      glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST );
+      glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST );
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+   }
+   else
+   {
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, data);
+   }
+   glBindTexture(GL_TEXTURE_2D, _Ygl->texture);
+   return texture;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void YglDeleteTexture(GLuint texture) {
+   if (texture != 0)
+      glDeleteTextures(1, &texture);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int YglCanDecodeVdp2Page(void) {
+   return YglGetProgramId(PG_VDP2_DECODEPAGE) != 0 && _Ygl->vdp2fbo != 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Uploads the 8KB blocks of VDP2 RAM set in dirty, laid out as
+// Vdp2RamDirty, or all of it if dirty is NULL.
+void YglUpdateVdp2Ram(const u32 * dirty) {
+   int i;
+
+   glBindTexture(GL_TEXTURE_2D, _Ygl->vdp2ram);
+   if (dirty == NULL)
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 512, 256, GL_RGBA, GL_UNSIGNED_BYTE, Vdp2Ram);
+   else
+   {
+      for (i = 0; i < (0x80000 >> 13); i++)
+      {
+         if (dirty[i])
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, i * 4, 512, 4, GL_RGBA, GL_UNSIGNED_BYTE, Vdp2Ram + (i << 13));
+      }
+   }
+   glBindTexture(GL_TEXTURE_2D, _Ygl->texture);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void YglUpdateVdp2ColorRam(void) {
+   glBindTexture(GL_TEXTURE_2D, _Ygl->vdp2colorram);
+   glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 64, 32, GL_RGBA, GL_UNSIGNED_BYTE, Vdp2ColorRamRGB);
+   glBindTexture(GL_TEXTURE_2D, _Ygl->texture);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Draws page into texture, creating it if it's 0, with the page decode
+// shader reading the VDP2 RAM and color RAM last uploaded.
+GLuint YglDecodeVdp2Page(GLuint texture, unsigned int w, unsigned int h, const YglVdp2Page * page) {
+   static const int vertices[] = { -1, -1, 1, -1, 1, 1, -1, 1 };
+   GLint fbo;
+
+   if (texture == 0)
+      texture = YglUploadTexture(0, w, h, NULL);
+
+   glGetIntegerv(GL_FRAMEBUFFER_BINDING, &fbo);
+   glPushAttrib(GL_ENABLE_BIT | GL_VIEWPORT_BIT);
+   glBindFramebuffer(GL_FRAMEBUFFER, _Ygl->vdp2fbo);
+   glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+   glViewport(0, 0, w, h);
+   glDisable(GL_BLEND);
+   glDisable(GL_ALPHA_TEST);
+   glDisable(GL_DEPTH_TEST);
+   glDisable(GL_STENCIL_TEST);
+
+   Ygl_uniformVDP2DecodePage(page);
+   glBindTexture(GL_TEXTURE_2D, _Ygl->vdp2ram);
+   glActiveTexture(GL_TEXTURE1);
+   glBindTexture(GL_TEXTURE_2D, _Ygl->vdp2colorram);
+
+   glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+   glVertexPointer(2, GL_INT, 0, vertices);
+   glDrawArrays(GL_QUADS, 0, 4);
+   glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+   glBindTexture(GL_TEXTURE_2D, 0);
+   glActiveTexture(GL_TEXTURE0);
+   glBindTexture(GL_TEXTURE_2D, _Ygl->texture);
+   glUseProgram(0);
+   glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+   glPopAttrib();
+   return texture;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void YglCacheQuadGrowShading(YglSprite * input, float * colors,YglCache * cache) {
    YglProgram * program;
    unsigned int x,y;
@@ -1278,7 +1717,7 @@ void YglCacheQuadGrowShading(YglSprite * input, float * colors,YglCache * cache)
       prg = PG_VFP1_GOURAUDSAHDING_HALFTRANS;
    }
 
-   program = YglGetProgram(input,prg);
+   program = YglGetProgram(input,prg,0);
    if( program == NULL ) return;
    
    x = cache->x;
@@ -1386,6 +1825,92 @@ void YglCacheQuadGrowShading(YglSprite * input, float * colors,YglCache * cache)
 }
 
 //////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////
+
+static void YglSetVertexPointers(YglProgram * prg) {
+   GLsizeiptr vsize = prg->currentQuad * sizeof(int);
+   GLsizeiptr tsize = prg->currentQuad * sizeof(float) * 2;
+   GLintptr pos;
+
+   if( _Ygl->vertexbuffer == 0 || prg->currentQuad == 0 || vsize + tsize > YGL_VERTEX_BUFFER_SIZE )
+   {
+      glVertexPointer(2, GL_INT, 0, prg->quads);
+      glTexCoordPointer(4, GL_FLOAT, 0, prg->textcoords);
+      return;
+   }
+
+   glBindBuffer(GL_ARRAY_BUFFER, _Ygl->vertexbuffer);
+   if( _Ygl->vertexbufferpos + vsize + tsize > YGL_VERTEX_BUFFER_SIZE )
+   {
+      glBufferData(GL_ARRAY_BUFFER, YGL_VERTEX_BUFFER_SIZE, NULL, GL_STREAM_DRAW);
+      _Ygl->vertexbufferpos = 0;
+   }
+   pos = _Ygl->vertexbufferpos;
+   glBufferSubData(GL_ARRAY_BUFFER, pos, vsize, prg->quads);
+   glBufferSubData(GL_ARRAY_BUFFER, pos + vsize, tsize, prg->textcoords);
+   glVertexPointer(2, GL_INT, 0, (const GLvoid *)pos);
+   glTexCoordPointer(4, GL_FLOAT, 0, (const GLvoid *)(pos + vsize));
+   _Ygl->vertexbufferpos = (pos + vsize + tsize + 15) & ~15;
+
+   // The pointers above keep the buffer; unbinding it leaves the attribute
+   // arrays set up by setupUniform and the other client arrays unaffected
+   glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Starts copying the VDP1 framebuffer just drawn into its pixel buffer
+// object. The copy runs alongside the rest of the frame and is only waited
+// for once the CPU reads the VDP1 framebuffer, see YglMapVdp1Readback().
+static void YglStartVdp1Readback(void) {
+   int buf = _Ygl->drawframe;
+
+   if( _Ygl->vdp1pbo[buf] == 0 ) return;
+
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, _Ygl->vdp1pbo[buf]);
+   glBufferData(GL_PIXEL_PACK_BUFFER, GlWidth * GlHeight * 4, NULL, GL_STREAM_READ);
+   glReadPixels(0, 0, GlWidth, GlHeight, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+   _Ygl->vdp1readback = buf;
+   _Ygl->vdp1readwidth = GlWidth;
+   _Ygl->vdp1readheight = GlHeight;
+   Vdp1External.framebufferpending = 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Maps the last VDP1 framebuffer read back, bottom row first. Returns NULL if
+// there is none. Must be followed by YglUnmapVdp1Readback() when not NULL.
+const u8 * YglMapVdp1Readback(int * width, int * height) {
+   const u8 * pixels;
+
+   if( _Ygl->vdp1readback < 0 ) return NULL;
+
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, _Ygl->vdp1pbo[_Ygl->vdp1readback]);
+   pixels = (const u8 *)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+   if( pixels == NULL )
+   {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+      _Ygl->vdp1readback = -1;
+      return NULL;
+   }
+
+   *width = _Ygl->vdp1readwidth;
+   *height = _Ygl->vdp1readheight;
+   return pixels;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+void YglUnmapVdp1Readback(void) {
+   glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+   _Ygl->vdp1readback = -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
 void YglRenderVDP1(void) {
   
    YglLevel * level;
@@ -1430,8 +1955,7 @@ void YglRenderVDP1(void) {
          glUseProgram(level->prg[j].prg);
       }
       
-      glVertexPointer(2, GL_INT, 0, level->prg[j].quads);
-      glTexCoordPointer(4, GL_FLOAT, 0, level->prg[j].textcoords);
+      YglSetVertexPointers(&level->prg[j]);
       
       if(level->prg[j].setupUniform) 
       {
@@ -1450,6 +1974,8 @@ void YglRenderVDP1(void) {
    }
    level->prgcurrent = 0;
    
+   YglStartVdp1Readback();
+   
    _Ygl->drawframe=(_Ygl->drawframe^0x01)&0x01;
    
    // glFlush(); need??
@@ -1646,7 +2172,15 @@ void YglRender(void) {
    glShadeModel(GL_SMOOTH);
 
    glBindTexture(GL_TEXTURE_2D, _Ygl->texture);
-   glTexSubImage2D (GL_TEXTURE_2D, 0, 0, 0, YglTM->width, YglTM->yMax, GL_RGBA, GL_UNSIGNED_BYTE, YglTM->texture);
+   YglTMUpload();
+
+   if( _Ygl->vertexbuffer != 0 )
+   {
+      glBindBuffer(GL_ARRAY_BUFFER, _Ygl->vertexbuffer);
+      glBufferData(GL_ARRAY_BUFFER, YGL_VERTEX_BUFFER_SIZE, NULL, GL_STREAM_DRAW);
+      glBindBuffer(GL_ARRAY_BUFFER, 0);
+      _Ygl->vertexbufferpos = 0;
+   }
 
    if(_Ygl->st) {
       int vertices [] = { 0, 0, 320, 0, 320, 224, 0, 224 };
@@ -1692,15 +2226,18 @@ void YglRender(void) {
                cprg = level->prg[j].prgid;
                glUseProgram(level->prg[j].prg);
             }
-            glVertexPointer(2, GL_INT, 0, level->prg[j].quads);
-            glTexCoordPointer(4, GL_FLOAT, 0, level->prg[j].textcoords);
+            YglSetVertexPointers(&level->prg[j]);
             if(level->prg[j].setupUniform) 
             {
                level->prg[j].setupUniform((void*)&level->prg[j]);
             }
             if( level->prg[j].currentQuad != 0 )
             {
+               if( level->prg[j].texture != 0 )
+                  glBindTexture(GL_TEXTURE_2D, level->prg[j].texture);
                glDrawArrays(GL_TRIANGLES, 0, level->prg[j].currentQuad/2);
+               if( level->prg[j].texture != 0 )
+                  glBindTexture(GL_TEXTURE_2D, _Ygl->texture);
             }
             if( level->prg[j].cleanupUniform )
             {
@@ -1796,35 +2333,181 @@ void YglChangeResolution(int w, int h) {
 
 //////////////////////////////////////////////////////////////////////////////
 
-int YglIsCached(u32 addr, YglCache * c ) {
-   int i = 0;
+// Returns 1 if any of size bytes from addr was written after epoch
+static int YglCacheRangeWritten(const u32 * ramepoch, u32 addr, u32 size, u32 epoch) {
+   u32 blocks;
+   u32 i;
 
-   for (i = 0; i < cachelistsize; i++)
+   if (size == 0)
+      return 0;
+
+   blocks = ((addr & 0xFF) + size + 0xFF) >> 8;
+   if (blocks > (0x80000 >> 8))
+      blocks = 0x80000 >> 8;
+   for (i = 0; i < blocks; i++)
    {
-      if (addr == cachelist[i].id)
-     {
-         c->x=cachelist[i].c.x;
-       c->y=cachelist[i].c.y;
-       return 1;
+      if ((s32)(ramepoch[((addr >> 8) + i) & 0x7FF] - epoch) > 0)
+         return 1;
+   }
+   return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static int YglCacheEntryValid(cache_struct * entry) {
+   const u32 * ramepoch = cacheramepoch[(entry->key.addr & YGL_CACHE_VDP2) ? 1 : 0];
+
+   if (shelves[entry->shelf].gen != entry->shelfgen)
+      return 0;
+   if (entry->key.frame != 0 && entry->key.frame != YglTM->frame)
+      return 0;
+   if (entry->checked == cacheepoch)
+      return 1;
+
+   if (entry->key.colorram && (s32)(cachecolorramepoch - entry->built) > 0)
+      return 0;
+   if (YglCacheRangeWritten(ramepoch, entry->key.addr & 0x7FFFF, entry->key.size, entry->built) ||
+       YglCacheRangeWritten(ramepoch, entry->key.lutaddr & 0x7FFFF, entry->key.lutsize, entry->built))
+      return 0;
+
+   entry->checked = cacheepoch;
+   return 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+static void YglCacheFreeEntry(int i) {
+   cache_struct * entry = &cachelist[i];
+
+   if (shelves[entry->shelf].gen == entry->shelfgen)
+      shelves[entry->shelf].entries--;
+   entry->next = cachefree;
+   cachefree = i;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Drops the entries that can't be used anymore
+static void YglCacheSweep(void) {
+   int hash;
+
+   for (hash = 0; hash < YGL_CACHE_HASH_SIZE; hash++)
+   {
+      int * link = &cachehash[hash];
+      int i;
+
+      while ((i = *link) != -1)
+      {
+         if (YglCacheEntryValid(&cachelist[i]))
+            link = &cachelist[i].next;
+         else
+         {
+            *link = cachelist[i].next;
+            YglCacheFreeEntry(i);
+         }
       }
    }
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+int YglIsCached(const YglCacheKey * key, YglCache * c ) {
+   int * link = &cachehash[YglCacheHash(key)];
+   int i;
+
+   while ((i = *link) != -1)
+   {
+      cache_struct * entry = &cachelist[i];
+
+      if (!YglCacheEntryValid(entry))
+      {
+         *link = entry->next;
+         YglCacheFreeEntry(i);
+         continue;
+      }
+
+      if (memcmp(&entry->key, key, sizeof(YglCacheKey)) == 0)
+      {
+         c->x=entry->c.x;
+         c->y=entry->c.y;
+         shelves[entry->shelf].lastused = YglTM->frame;
+         return 1;
+      }
+      link = &entry->next;
+   }
 
    return 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
-void YglCacheAdd(u32 addr, YglCache * c) {
-   cachelist[cachelistsize].id = addr;
-   cachelist[cachelistsize].c.x = c->x;
-   cachelist[cachelistsize].c.y = c->y;
-   cachelistsize++;
+// Keeps the texture YglQuad() or YglQuadGrowShading() just allocated at c
+void YglCacheAdd(const YglCacheKey * key, YglCache * c) {
+   u32 hash = YglCacheHash(key);
+   cache_struct * entry;
+   int i;
+
+   if (lastshelf == -1 || c->y != shelves[lastshelf].y || c->x + key->w != shelves[lastshelf].x)
+      return;
+
+   if (cachefree == -1)
+      YglCacheSweep();
+   if (cachefree == -1)
+      return;
+
+   i = cachefree;
+   entry = &cachelist[i];
+   cachefree = entry->next;
+
+   entry->key = *key;
+   entry->c.x = c->x;
+   entry->c.y = c->y;
+   entry->shelf = lastshelf;
+   entry->shelfgen = shelves[lastshelf].gen;
+   entry->built = entry->checked = cacheepoch;
+   entry->next = cachehash[hash];
+   cachehash[hash] = i;
+   shelves[lastshelf].entries++;
+   lastshelf = -1;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+
+// Takes in the dirty flags of VDP1 (vdp2 = 0) or VDP2 RAM, and color RAM.
+// The entries decoded from what was written are dropped when next looked up.
+void YglCacheInvalidate(int vdp2, const u32 * ramdirty, int colorramdirty) {
+   u32 * ramepoch = cacheramepoch[vdp2 ? 1 : 0];
+   int i, j;
+
+   cacheepoch++;
+
+   for (i = 0; i < (0x80000 >> 13); i++)
+   {
+      if (ramdirty[i] == 0)
+         continue;
+      for (j = 0; j < 32; j++)
+      {
+         if (ramdirty[i] & (1 << j))
+            ramepoch[(i << 5) + j] = cacheepoch;
+      }
+   }
+
+   if (colorramdirty)
+      cachecolorramepoch = cacheepoch;
 }
 
 //////////////////////////////////////////////////////////////////////////////
 
 void YglCacheReset(void) {
-   cachelistsize = 0;
+   int i;
+
+   for (i = 0; i < YGL_CACHE_SIZE; i++)
+      cachelist[i].next = i + 1 < YGL_CACHE_SIZE ? i + 1 : -1;
+   cachefree = 0;
+   memset(cachehash, 0xFF, sizeof(cachehash));
+
+   for (i = 0; i < YGL_MAX_SHELVES; i++)
+      shelves[i].entries = 0;
 }
 
 //////////////////////////////////////////////////////////////////////////////
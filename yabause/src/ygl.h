@@ -63,6 +63,25 @@ typedef struct {
 	float y;
 } YglCache;
 
+// What a texture in the atlas was decoded from. Two textures with the same
+// key have the same texels; the entry is dropped once any of the RAM it was
+// read from is written to.
+typedef struct {
+	u32 addr;        // YGL_CACHE_VDP2 is set for VDP2 RAM, VDP1 RAM otherwise
+	u32 w;
+	u32 h;
+	u32 mode;        // color mode and the rest of the decode settings
+	u32 palette;     // color bank, lookup table or palette
+	u32 state;       // register state the texels depend on
+	u32 frame;       // only valid during this frame if not 0
+	u32 size;        // bytes read from addr
+	u32 lutaddr;     // VDP1 RAM lookup table read, if lutsize isn't 0
+	u32 lutsize;
+	u32 colorram;    // colors were looked up in color RAM
+} YglCacheKey;
+
+#define YGL_CACHE_VDP2 0x80000000
+
 typedef struct {
 	unsigned int * textdata;
 	unsigned int w;
@@ -70,12 +89,10 @@ typedef struct {
 
 
 typedef struct {
-	unsigned int currentX;
-	unsigned int currentY;
-	unsigned int yMax;
 	unsigned int * texture;
 	unsigned int width;
 	unsigned int height;
+	u32 frame;       // counted by YglTMReset()
 } YglTextureManager;
 
 extern YglTextureManager * YglTM;
@@ -84,6 +101,7 @@ void YglTMInit(unsigned int, unsigned int);
 void YglTMDeInit(void);
 void YglTMReset(void);
 void YglTMAllocate(YglTexture *, unsigned int, unsigned int, unsigned int *, unsigned int *);
+void YglTMUpload(void);
 
 enum
 {
@@ -97,6 +115,7 @@ enum
    PG_VDP2_DRAWFRAMEBUFF,    
    PG_VDP2_STARTWINDOW,
    PG_VDP2_ENDWINDOW,    
+   PG_VDP2_DECODEPAGE,
    PG_MAX,
 };
 
@@ -113,10 +132,28 @@ typedef struct {
    short ux1,uy1,ux2,uy2;
    int blendmode;
    int bwin0,logwin0,bwin1,logwin1,winmode;
+   GLuint texture; // texture the quads sample instead of the atlas, 0 if none
    int (*setupUniform)(void *);
    int (*cleanupUniform)(void *);
 } YglProgram;
 
+// What the page decode shader needs to know about a VDP2 page
+typedef struct {
+   u32 addr;
+   int pagewh;
+   int patternwh;
+   int patterndatasize;
+   int auxmode;
+   int supplementdata;
+   int charmask;           // 0x3FFF or 0x7FFF, depending on VRSIZE
+   int colornumber;
+   int coloroffset;
+   int transparencyenable;
+   int alpha;
+   int alphamode;          // 0 always alpha, 1 per pattern, 3 per color MSB
+   int cor, cog, cob;
+} YglVdp2Page;
+
 typedef struct {
    int prgcount;
    int prgcurrent;
@@ -157,6 +194,23 @@ typedef struct {
    int win1v[512*4];
    int win1_vertexcnt;
 
+   // Vertex buffer object for program vertices, 0 if unsupported
+   GLuint vertexbuffer;
+   GLintptr vertexbufferpos;
+
+   // Pixel buffer objects the VDP1 framebuffers are read back into, one
+   // per vdp1FrameBuff, 0 if unsupported
+   GLuint vdp1pbo[2];
+   int vdp1readback; // buffer of the readback still to map, -1 if none
+   int vdp1readwidth;
+   int vdp1readheight;
+
+   // Raw VDP2 RAM and color RAM for the page decode shader, and the
+   // framebuffer object pages are decoded through
+   GLuint vdp2ram;
+   GLuint vdp2colorram;
+   GLuint vdp2fbo;
+
    YglLevel * levels;
 }  Ygl;
 
@@ -168,28 +222,40 @@ int YglInit(int, int, unsigned int);
 void YglDeInit(void);
 float * YglQuad(YglSprite *, YglTexture *,YglCache * c);
 void YglCachedQuad(YglSprite *, YglCache *);
+void YglTextureQuad(YglSprite *, GLuint);
+GLuint YglUploadTexture(GLuint, unsigned int, unsigned int, const unsigned int *);
+void YglDeleteTexture(GLuint);
+int YglCanDecodeVdp2Page(void);
+void YglUpdateVdp2Ram(const u32 *);
+void YglUpdateVdp2ColorRam(void);
+GLuint YglDecodeVdp2Page(GLuint, unsigned int, unsigned int, const YglVdp2Page *);
 void YglRender(void);
 void YglReset(void);
 void YglShowTexture(void);
 void YglChangeResolution(int, int);
+const u8 * YglMapVdp1Readback(int * width, int * height);
+void YglUnmapVdp1Readback(void);
 void YglCacheQuadGrowShading(YglSprite * input, float * colors, YglCache * cache);
 int YglQuadGrowShading(YglSprite * input, YglTexture * output, float * colors,YglCache * c);
 
 void YglStartWindow( vdp2draw_struct * info, int win0, int logwin0, int win1, int logwin1, int mode );
 void YglEndWindow( vdp2draw_struct * info );
 
-int YglIsCached(u32,YglCache *);
-void YglCacheAdd(u32,YglCache *);
+int YglIsCached(const YglCacheKey *,YglCache *);
+void YglCacheAdd(const YglCacheKey *,YglCache *);
+void YglCacheInvalidate(int vdp2, const u32 * ramdirty, int colorramdirty);
 void YglCacheReset(void);
 
 // 0.. no belnd, 1.. Alpha, 2.. Add 
 int YglSetLevelBlendmode( int pri, int mode );
 
 int Ygl_uniformVDP2DrawFramebuffer( float from, float to , float * offsetcol );
+int Ygl_uniformVDP2DecodePage( const YglVdp2Page * page );
 
 void YglNeedToUpdateWindow();
 
 int YglProgramInit();
+int YglGetProgramId( int prg );
 int YglProgramChange( YglLevel * level, int prgid );
 
 #if 1  // Does anything need this?  It breaks a bunch of prototypes if
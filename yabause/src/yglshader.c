@@ -424,6 +424,134 @@ int Ygl_uniformVDP2DrawFramebuffer( float from, float to , float * offsetcol )
 }
  
 
+/*------------------------------------------------------------------------------------
+ *  VDP2 Page Decode Operation
+ *
+ *  Draws a whole page straight from VDP2 RAM and color RAM, which are
+ *  uploaded as they are: RAM as 512x256 texels of four bytes, color RAM as
+ *  the 0x800 converted colors in 64x32 texels. Only float arithmetic is
+ *  used so that it runs on plain GLSL 1.10.
+ * ----------------------------------------------------------------------------------*/
+static int iddecoderam;
+static int iddecodecolorram;
+static int iddecodepage;
+static int iddecodepattern;
+static int iddecodecolor;
+static int iddecodecoloradd;
+
+const GLchar Yglprg_vdp2_decodepage_v[] = \
+"void main() {\n" \
+" gl_Position = gl_Vertex;\n" \
+"}\n";
+const GLchar * pYglprg_vdp2_decodepage_v[] = {Yglprg_vdp2_decodepage_v, NULL};
+
+const GLchar Yglprg_vdp2_decodepage_f[] = \
+"uniform sampler2D vdp2ram;\n" \
+"uniform sampler2D vdp2colorram;\n" \
+"uniform vec4 page;     // address, patterns per line, cells per pattern side, words per pattern\n" \
+"uniform vec4 pattern;  // aux mode, supplement data, character number range, color number\n" \
+"uniform vec4 color;    // color RAM offset, transparency enable, alpha, alpha mode\n" \
+"uniform vec4 coloradd;\n" \
+"float bits(float v, float shift, float count) {\n" \
+"  return mod(floor(v / exp2(shift)), exp2(count));\n" \
+"}\n" \
+"float ramByte(float addr) {\n" \
+"  float texel;\n" \
+"  float b;\n" \
+"  vec4 bytes;\n" \
+"  addr = mod(addr, 524288.0);\n" \
+"  texel = floor(addr / 4.0);\n" \
+"  bytes = texture2D(vdp2ram, vec2((mod(texel, 512.0) + 0.5) / 512.0, (floor(texel / 512.0) + 0.5) / 256.0));\n" \
+"  b = addr - texel * 4.0;\n" \
+"  return floor((b < 1.0 ? bytes.r : b < 2.0 ? bytes.g : b < 3.0 ? bytes.b : bytes.a) * 255.0 + 0.5);\n" \
+"}\n" \
+"float ramWord(float addr) {\n" \
+"  return ramByte(addr) * 256.0 + ramByte(addr + 1.0);\n" \
+"}\n" \
+"void main() {\n" \
+"  float pixelwh = page.z * 8.0;\n" \
+"  vec2 pos = floor(gl_FragCoord.xy);\n" \
+"  vec2 patternpos = floor(pos / pixelwh);\n" \
+"  vec2 pix = pos - patternpos * pixelwh;\n" \
+"  float addr = page.x + (patternpos.y * page.y + patternpos.x) * page.w * 2.0;\n" \
+"  float supp = pattern.y;\n" \
+"  float paladdr, charaddr, flip, special, cell, d, index;\n" \
+"  vec4 rgba = vec4(0.0);\n" \
+"  bool transparent;\n" \
+"  if (page.w == 1.0) {\n" \
+"    float tmp = ramWord(addr);\n" \
+"    special = bits(supp, 8.0, 1.0);\n" \
+"    if (pattern.w == 0.0) paladdr = bits(tmp, 12.0, 4.0) + bits(supp, 5.0, 3.0) * 16.0;\n" \
+"    else paladdr = bits(tmp, 12.0, 3.0) * 16.0;\n" \
+"    if (pattern.x == 0.0) {\n" \
+"      flip = bits(tmp, 10.0, 2.0);\n" \
+"      if (page.z == 1.0) charaddr = bits(tmp, 0.0, 10.0) + bits(supp, 0.0, 5.0) * 1024.0;\n" \
+"      else charaddr = bits(tmp, 0.0, 10.0) * 4.0 + bits(supp, 0.0, 2.0) + bits(supp, 2.0, 3.0) * 4096.0;\n" \
+"    } else {\n" \
+"      flip = 0.0;\n" \
+"      if (page.z == 1.0) charaddr = bits(tmp, 0.0, 12.0) + bits(supp, 2.0, 3.0) * 4096.0;\n" \
+"      else charaddr = bits(tmp, 0.0, 12.0) * 4.0 + bits(supp, 0.0, 2.0) + bits(supp, 4.0, 1.0) * 16384.0;\n" \
+"    }\n" \
+"  } else {\n" \
+"    float tmp1 = ramWord(addr);\n" \
+"    float tmp2 = ramWord(addr + 2.0);\n" \
+"    charaddr = bits(tmp2, 0.0, 15.0);\n" \
+"    flip = bits(tmp1, 14.0, 2.0);\n" \
+"    if (pattern.w == 0.0) paladdr = bits(tmp1, 0.0, 7.0);\n" \
+"    else paladdr = bits(tmp1, 4.0, 3.0) * 16.0;\n" \
+"    special = bits(tmp1, 12.0, 1.0);\n" \
+"  }\n" \
+"  charaddr = mod(charaddr, pattern.z) * 32.0;\n" \
+"  if (mod(flip, 2.0) == 1.0) pix.x = pixelwh - 1.0 - pix.x;\n" \
+"  if (flip >= 2.0) pix.y = pixelwh - 1.0 - pix.y;\n" \
+"  cell = floor(pix.y / 8.0) * 2.0 + floor(pix.x / 8.0);\n" \
+"  pix = mod(pix, 8.0);\n" \
+"  if (pattern.w == 0.0) {\n" \
+"    d = ramByte(charaddr + cell * 32.0 + pix.y * 4.0 + floor(pix.x / 2.0));\n" \
+"    d = mod(pix.x, 2.0) == 0.0 ? floor(d / 16.0) : mod(d, 16.0);\n" \
+"    index = paladdr * 16.0 + d;\n" \
+"  } else if (pattern.w == 1.0) {\n" \
+"    d = ramByte(charaddr + cell * 64.0 + pix.y * 8.0 + pix.x);\n" \
+"    index = paladdr * 16.0 + d;\n" \
+"  } else if (pattern.w < 4.0) {\n" \
+"    d = ramWord(charaddr + cell * 128.0 + pix.y * 16.0 + pix.x * 2.0);\n" \
+"    index = d;\n" \
+"  }\n" \
+"  if (pattern.w < 3.0) {\n" \
+"    vec4 c;\n" \
+"    float alpha = color.z;\n" \
+"    transparent = (d == 0.0 && color.y != 0.0);\n" \
+"    index = mod(color.x + index, 2048.0);\n" \
+"    c = texture2D(vdp2colorram, vec2((mod(index, 64.0) + 0.5) / 64.0, (floor(index / 64.0) + 0.5) / 32.0));\n" \
+"    if ((color.w == 1.0 && special == 0.0) || (color.w == 3.0 && c.a < 0.5)) alpha = 255.0;\n" \
+"    rgba = vec4(c.rgb, alpha / 255.0);\n" \
+"  } else if (pattern.w == 3.0) {\n" \
+"    transparent = (d < 32768.0 && color.y != 0.0);\n" \
+"    rgba = vec4(vec3(bits(d, 0.0, 5.0), bits(d, 5.0, 5.0), bits(d, 10.0, 5.0)) * 8.0, 255.0) / 255.0;\n" \
+"  } else {\n" \
+"    float d1 = ramWord(charaddr + cell * 256.0 + pix.y * 32.0 + pix.x * 4.0);\n" \
+"    float d2 = ramWord(charaddr + cell * 256.0 + pix.y * 32.0 + pix.x * 4.0 + 2.0);\n" \
+"    transparent = (d1 < 32768.0 && color.y != 0.0);\n" \
+"    rgba = vec4(mod(d2, 256.0), floor(d2 / 256.0), mod(d1, 256.0), color.z) / 255.0;\n" \
+"  }\n" \
+"  if (transparent) gl_FragColor = vec4(0.0);\n" \
+"  else gl_FragColor = vec4(clamp(rgba.rgb + coloradd.rgb, 0.0, 1.0), rgba.a);\n" \
+"}\n";
+const GLchar * pYglprg_vdp2_decodepage_f[] = {Yglprg_vdp2_decodepage_f, NULL};
+
+int Ygl_uniformVDP2DecodePage( const YglVdp2Page * page )
+{
+   glUseProgram(_prgid[PG_VDP2_DECODEPAGE]);
+   glUniform1i(iddecoderam, 0);
+   glUniform1i(iddecodecolorram, 1);
+   glUniform4f(iddecodepage, (float)page->addr, (float)page->pagewh, (float)page->patternwh, (float)page->patterndatasize);
+   glUniform4f(iddecodepattern, (float)page->auxmode, (float)page->supplementdata, (float)(page->charmask + 1), (float)page->colornumber);
+   glUniform4f(iddecodecolor, (float)page->coloroffset, (float)page->transparencyenable, (float)page->alpha, (float)page->alphamode);
+   glUniform4f(iddecodecoloradd, page->cor / 255.0f, page->cog / 255.0f, page->cob / 255.0f, 0.0f);
+   return 0;
+}
+
+
 /*------------------------------------------------------------------------------------
  *  VDP2 Add Blend operaiotn 
  * ----------------------------------------------------------------------------------*/
@@ -530,6 +658,17 @@ int YglProgramInit()
    id_fbo = glGetUniformLocation(_prgid[PG_VFP1_GOURAUDSAHDING_HALFTRANS], (const GLchar *)"fbo");
    id_fbowidth = glGetUniformLocation(_prgid[PG_VFP1_GOURAUDSAHDING_HALFTRANS], (const GLchar *)"fbowidth");
    id_fboheight = glGetUniformLocation(_prgid[PG_VFP1_GOURAUDSAHDING_HALFTRANS], (const GLchar *)"fbohegiht");
+
+   // Optional, pages are decoded on the CPU if this one doesn't build
+   if( YglInitShader( PG_VDP2_DECODEPAGE, pYglprg_vdp2_decodepage_v, pYglprg_vdp2_decodepage_f ) != 0 )
+      return 0;
+
+   iddecoderam = glGetUniformLocation(_prgid[PG_VDP2_DECODEPAGE], (const GLchar *)"vdp2ram");
+   iddecodecolorram = glGetUniformLocation(_prgid[PG_VDP2_DECODEPAGE], (const GLchar *)"vdp2colorram");
+   iddecodepage = glGetUniformLocation(_prgid[PG_VDP2_DECODEPAGE], (const GLchar *)"page");
+   iddecodepattern = glGetUniformLocation(_prgid[PG_VDP2_DECODEPAGE], (const GLchar *)"pattern");
+   iddecodecolor = glGetUniformLocation(_prgid[PG_VDP2_DECODEPAGE], (const GLchar *)"color");
+   iddecodecoloradd = glGetUniformLocation(_prgid[PG_VDP2_DECODEPAGE], (const GLchar *)"coloradd");
   
    return 0;
 }
@@ -564,6 +703,7 @@ int YglProgramChange( YglLevel * level, int prgid )
 
    level->prg[level->prgcurrent].prgid=prgid;
    level->prg[level->prgcurrent].prg=_prgid[prgid];
+   level->prg[level->prgcurrent].texture=0;
    
    if( prgid == PG_VFP1_GOURAUDSAHDING )
    {